@@ -0,0 +1,354 @@
+/*
+ * Closed-Loop KPI Suite (host)
+ *
+ * Runs the firmware controller core against the simulated heater in a set
+ * of standard scenarios and reports step-response KPIs as JSON lines:
+ *
+ *   rise_time_s      10%-90% of the setpoint step
+ *   overshoot_c      Peak above the setpoint after the event
+ *   settling_time_s  Last time the error left the band (max(1°C, 2% of step))
+ *   iae              Integral of |error| (°C*s)
+ *   itae             Integral of t*|error| (°C*s^2)
+ *   effort           Total variation of the duty, in full-scale units
+ *   energy_wh        Heater energy over the evaluation window
+ *
+ * All KPIs are lower-is-better and measured on the true drum temperature
+ * from the event time (setpoint step, disturbance or dropout) onwards.
+ *
+ * Usage: control_kpi [--baseline FILE] [--tolerance PCT] [--kp X] [--ki X] [--kd X]
+ *                    [--no-feedforward] [--no-estimator]
+ * With --baseline, exits with status 1 if any KPI is worse than the
+ * baseline by more than the tolerance. Redirect stdout to refresh it.
+ */
+
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal_sim.h"
+#include "controller.h"
+#include "estimator.h"
+
+#define KPI_PERIOD_MS        250
+#define KPI_DEFAULT_TOL_PCT  5.0
+
+typedef struct {
+    const char *name;
+    double warmup_s;          // Settle at setpoint_before first (not evaluated)
+    double duration_s;        // Evaluation window after the event
+    float setpoint_before;
+    float setpoint_after;
+    float disturbance_w_per_k;// Extra drum losses applied at the event
+    double dropout_s;         // Open thermocouple for this long at the event
+    double bus_error_s;       // SPI timeouts for this long at the event
+    uint32_t jitter_max_ms;   // Uniform random delay added to every tick
+    uint32_t stall_every;     // Every N ticks ...
+    uint32_t stall_ms;        // ... the tick is late by this much (WiFi/HTTP bursts)
+} kpi_scenario_t;
+
+typedef struct {
+    double rise_time_s;
+    double overshoot_c;
+    double settling_time_s;
+    double iae;
+    double itae;
+    double effort;
+    double energy_wh;
+} kpi_result_t;
+
+typedef struct {
+    const char *name;
+    size_t offset;
+    double abs_tol;           // Absolute slack on top of the relative tolerance
+} kpi_metric_t;
+
+static const kpi_scenario_t s_scenarios[] = {
+    { .name = "step_25_200", .duration_s = 1200, .setpoint_before = 25, .setpoint_after = 200 },
+    { .name = "step_200_300", .warmup_s = 1800, .duration_s = 1200, .setpoint_before = 200, .setpoint_after = 300 },
+    { .name = "step_300_150", .warmup_s = 2400, .duration_s = 1800, .setpoint_before = 300, .setpoint_after = 150 },
+    { .name = "load_disturbance", .warmup_s = 1800, .duration_s = 1200, .setpoint_before = 200,
+      .setpoint_after = 200, .disturbance_w_per_k = 0.1f },
+    { .name = "sensor_dropout", .warmup_s = 1800, .duration_s = 900, .setpoint_before = 200,
+      .setpoint_after = 200, .dropout_s = 10 },
+    { .name = "bus_timeout", .warmup_s = 1800, .duration_s = 900, .setpoint_before = 200,
+      .setpoint_after = 200, .bus_error_s = 10 },
+    { .name = "scheduling_jitter", .duration_s = 1200, .setpoint_before = 25, .setpoint_after = 200,
+      .jitter_max_ms = 50, .stall_every = 40, .stall_ms = 600 },
+};
+
+static const kpi_metric_t s_metrics[] = {
+    { "rise_time_s", offsetof(kpi_result_t, rise_time_s), 0.5 },
+    { "overshoot_c", offsetof(kpi_result_t, overshoot_c), 0.25 },
+    { "settling_time_s", offsetof(kpi_result_t, settling_time_s), 1.0 },
+    { "iae", offsetof(kpi_result_t, iae), 5.0 },
+    { "itae", offsetof(kpi_result_t, itae), 500.0 },
+    { "effort", offsetof(kpi_result_t, effort), 0.05 },
+    { "energy_wh", offsetof(kpi_result_t, energy_wh), 0.05 },
+};
+
+#define NUM_SCENARIOS  (sizeof(s_scenarios) / sizeof(s_scenarios[0]))
+#define NUM_METRICS    (sizeof(s_metrics) / sizeof(s_metrics[0]))
+
+static float s_kp = 2.0f;
+static float s_ki = 0.02f;
+static float s_kd = 5.0f;
+static bool s_feedforward = true;     // As in the firmware (CONTROL_DEFAULT_FEEDFORWARD)
+static bool s_estimator = true;       // As in the firmware (CONTROL_DEFAULT_ESTIMATOR)
+
+static double metric_value(const kpi_result_t *result, const kpi_metric_t *metric)
+{
+    return *(const double *)((const char *)result + metric->offset);
+}
+
+static void run_scenario(const kpi_scenario_t *sc, kpi_result_t *result)
+{
+    plant_params_t params = PLANT_PARAMS_DEFAULT();
+    hal_sim_t sim;
+    hal_sensor_t sensor;
+    hal_actuator_t heater;
+    hal_sim_init(&sim, &params, 1);
+    hal_sim_bind(&sim, &sensor, &heater);
+
+    pid_fixed_config_t pid_config = {
+        .kp = s_kp,
+        .ki = s_ki,
+        .kd = s_kd,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = KPI_PERIOD_MS,
+        .full_scale = (int32_t)heater.max_duty,
+        .output_min = 0,
+        .output_max = (int32_t)heater.max_duty,
+    };
+    controller_t controller;
+    controller_init(&controller, &pid_config);
+    feedforward_t ff;
+    if (s_feedforward) {
+        feedforward_init(&ff, &params, pid_config.full_scale);
+        ff.calibrate = true;
+        controller_set_feedforward(&controller, &ff);
+    }
+    controller_set_setpoint(&controller, controller_celsius_to_units(sc->setpoint_before));
+    controller_set_mode(&controller, CONTROL_MODE_AUTO);
+    estimator_t est;
+    estimator_init(&est, &params);
+
+    const uint64_t event_us = (uint64_t)(sc->warmup_s * 1e6);
+    const uint64_t end_us = event_us + (uint64_t)(sc->duration_s * 1e6);
+    const float step = sc->setpoint_after - sc->setpoint_before;
+    const float band = fmaxf(1.0f, 0.02f * fabsf(step));
+    const float sp = sc->setpoint_after;
+
+    memset(result, 0, sizeof(*result));
+    bool event_done = false;
+    bool reached_10 = false;
+    bool reached_90 = false;
+    double t10 = 0.0;
+    double energy_start = 0.0;
+    uint32_t prev_duty = 0;
+    uint32_t rng = 12345;
+    uint64_t tick = 0;
+
+    while (sim.plant.now_us < end_us) {
+        uint64_t now_us = sim.plant.now_us;
+
+        if (!event_done && now_us >= event_us) {
+            controller_set_setpoint(&controller, controller_celsius_to_units(sc->setpoint_after));
+            sim.plant.extra_loss_w_per_k = sc->disturbance_w_per_k;
+            energy_start = sim.plant.energy_j;
+            event_done = true;
+        }
+        sim.plant.open_thermocouple = event_done && sc->dropout_s > 0 &&
+                                      now_us < event_us + (uint64_t)(sc->dropout_s * 1e6);
+        sim.bus_error = event_done && sc->bus_error_s > 0 &&
+                        now_us < event_us + (uint64_t)(sc->bus_error_s * 1e6);
+
+        hal_sensor_reading_t reading;
+        esp_err_t ret = hal_sensor_read(&sensor, &reading, 1);
+        if (ret == ESP_OK) {
+            ret = reading.status;
+        }
+        int32_t measurement = reading.raw >> 3;
+        if (s_estimator && ret == ESP_OK) {
+            estimator_update(&est, reading.temperature, reading.timestamp_us);
+            measurement = controller_celsius_to_units(estimator_predict(&est, (int64_t)now_us));
+        }
+        uint32_t duty = controller_step(&controller, ret, measurement, NULL);
+        hal_actuator_set_duty(&heater, 0, duty);
+        estimator_set_duty(&est, (float)duty / (float)heater.max_duty);
+
+        uint64_t interval_us = KPI_PERIOD_MS * 1000ULL;
+        if (sc->jitter_max_ms > 0) {
+            rng = rng * 1103515245u + 12345u;
+            interval_us += (uint64_t)((rng >> 16) % (sc->jitter_max_ms + 1)) * 1000;
+        }
+        if (sc->stall_every > 0 && tick % sc->stall_every == sc->stall_every - 1) {
+            interval_us += (uint64_t)sc->stall_ms * 1000;
+        }
+        tick++;
+
+        if (event_done) {
+            double t = (double)(now_us - event_us) / 1e6;
+            double dt = (double)interval_us / 1e6;
+            float error = sim.plant.drum_c - sp;
+            float progress = (step != 0.0f) ? (sim.plant.drum_c - sc->setpoint_before) / step : 1.0f;
+
+            if (!reached_10 && progress >= 0.1f) {
+                reached_10 = true;
+                t10 = t;
+            }
+            if (!reached_90 && progress >= 0.9f) {
+                reached_90 = true;
+                result->rise_time_s = (step != 0.0f) ? t - t10 : 0.0;
+            }
+
+            float above = (step >= 0.0f) ? error : -error;
+            if (above > result->overshoot_c) {
+                result->overshoot_c = above;
+            }
+            if (fabsf(error) > band) {
+                result->settling_time_s = t + dt;
+            }
+            result->iae += fabs(error) * dt;
+            result->itae += t * fabs(error) * dt;
+            result->effort += fabs((double)duty - (double)prev_duty) / heater.max_duty;
+        }
+        prev_duty = duty;
+
+        hal_sim_advance(&sim, interval_us);
+    }
+
+    if (step != 0.0f && !reached_90) {
+        result->rise_time_s = sc->duration_s;  // Never got there
+    }
+    result->energy_wh = (sim.plant.energy_j - energy_start) / 3600.0;
+}
+
+static void print_result(FILE *out, const char *name, const kpi_result_t *result)
+{
+    fprintf(out, "{\"scenario\":\"%s\"", name);
+    for (size_t m = 0; m < NUM_METRICS; m++) {
+        fprintf(out, ",\"%s\":%.4f", s_metrics[m].name, metric_value(result, &s_metrics[m]));
+    }
+    fprintf(out, "}\n");
+}
+
+// Finds "key":<number> in a JSON line written by print_result()
+static bool json_line_number(const char *line, const char *key, double *value)
+{
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(line, pattern);
+    if (p == NULL) {
+        return false;
+    }
+    *value = strtod(p + strlen(pattern), NULL);
+    return true;
+}
+
+static bool load_baseline(const char *path, const char *scenario, kpi_result_t *baseline)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return false;
+    }
+
+    char pattern[96];
+    snprintf(pattern, sizeof(pattern), "\"scenario\":\"%s\"", scenario);
+
+    char line[1024];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), f) != NULL) {
+        if (strstr(line, pattern) == NULL) {
+            continue;
+        }
+        found = true;
+        for (size_t m = 0; m < NUM_METRICS; m++) {
+            double value = 0.0;
+            if (!json_line_number(line, s_metrics[m].name, &value)) {
+                found = false;
+                break;
+            }
+            *(double *)((char *)baseline + s_metrics[m].offset) = value;
+        }
+    }
+
+    fclose(f);
+    return found;
+}
+
+static int compare(const char *scenario, const kpi_result_t *result, const kpi_result_t *baseline,
+                   double tolerance_pct)
+{
+    int regressions = 0;
+    for (size_t m = 0; m < NUM_METRICS; m++) {
+        double now = metric_value(result, &s_metrics[m]);
+        double base = metric_value(baseline, &s_metrics[m]);
+        double limit = base * (1.0 + tolerance_pct / 100.0) + s_metrics[m].abs_tol;
+        if (now > limit) {
+            fprintf(stderr, "REGRESSION %s.%s: %.4f -> %.4f (limit %.4f)\n",
+                    scenario, s_metrics[m].name, base, now, limit);
+            regressions++;
+        } else if (now < base - s_metrics[m].abs_tol) {
+            fprintf(stderr, "improved   %s.%s: %.4f -> %.4f\n", scenario, s_metrics[m].name, base, now);
+        }
+    }
+    return regressions;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option long_options[] = {
+        {"baseline", required_argument, NULL, 'b'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"kp", required_argument, NULL, 'p'},
+        {"ki", required_argument, NULL, 'i'},
+        {"kd", required_argument, NULL, 'd'},
+        {"no-feedforward", no_argument, NULL, 'f'},
+        {"no-estimator", no_argument, NULL, 'e'},
+        {NULL, 0, NULL, 0},
+    };
+
+    const char *baseline_path = NULL;
+    double tolerance_pct = KPI_DEFAULT_TOL_PCT;
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'b': baseline_path = optarg; break;
+        case 't': tolerance_pct = atof(optarg); break;
+        case 'p': s_kp = (float)atof(optarg); break;
+        case 'i': s_ki = (float)atof(optarg); break;
+        case 'd': s_kd = (float)atof(optarg); break;
+        case 'f': s_feedforward = false; break;
+        case 'e': s_estimator = false; break;
+        default:
+            fprintf(stderr, "usage: %s [--baseline FILE] [--tolerance PCT] [--kp X] [--ki X] [--kd X]\n"
+                            "          [--no-feedforward] [--no-estimator]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int regressions = 0;
+    for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+        kpi_result_t result;
+        run_scenario(&s_scenarios[i], &result);
+        print_result(stdout, s_scenarios[i].name, &result);
+
+        if (baseline_path != NULL) {
+            kpi_result_t baseline;
+            if (!load_baseline(baseline_path, s_scenarios[i].name, &baseline)) {
+                fprintf(stderr, "MISSING    %s: no baseline entry\n", s_scenarios[i].name);
+                regressions++;
+                continue;
+            }
+            regressions += compare(s_scenarios[i].name, &result, &baseline, tolerance_pct);
+        }
+    }
+
+    if (baseline_path != NULL) {
+        fprintf(stderr, "%s: %d regression(s)\n", regressions ? "FAIL" : "PASS", regressions);
+    }
+    return regressions ? 1 : 0;
+}
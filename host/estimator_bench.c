@@ -0,0 +1,221 @@
+/*
+ * Estimator Benchmark (host)
+ *
+ * Runs the firmware controller against the simulated heater through
+ * setpoint steps and a load disturbance, feeds the MAX6675 readings and the
+ * applied duty to the state estimator, and compares it with the raw
+ * readings against the true probe temperature:
+ *
+ *   - temperature error at each reading
+ *   - rate of change error (raw: difference of consecutive readings)
+ *   - error half-way between conversions (raw: last reading held)
+ *   - injected single-sample spikes dropped, good readings dropped
+ *
+ * then measures the cost of estimator_update() and estimator_predict() on
+ * the recorded readings.
+ *
+ * Usage: estimator_bench [repetitions]
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hal_sim.h"
+#include "controller.h"
+#include "estimator.h"
+
+#define BENCH_PERIOD_MS      250
+#define BENCH_DURATION_S     6000
+#define BENCH_SPIKE_EVERY    397      // Readings between injected spikes (prime, drifts through the cycle)
+#define BENCH_SPIKE_C        30.0f
+#define BENCH_DEFAULT_REPS   200
+#define BENCH_SAMPLES        (BENCH_DURATION_S * 1000 / BENCH_PERIOD_MS)
+
+typedef struct {
+    float temperature;
+    int64_t timestamp_us;
+    float duty;
+} bench_sample_t;
+
+typedef struct {
+    double sum_sq;
+    double max_abs;
+    long count;
+} error_stats_t;
+
+static bench_sample_t s_samples[BENCH_SAMPLES];
+
+// Volatile sink so the compiler cannot drop the loops
+static volatile float s_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void add_error(error_stats_t *stats, double error)
+{
+    stats->sum_sq += error * error;
+    stats->max_abs = fmax(stats->max_abs, fabs(error));
+    stats->count++;
+}
+
+static double rms(const error_stats_t *stats)
+{
+    return stats->count > 0 ? sqrt(stats->sum_sq / stats->count) : 0.0;
+}
+
+static float setpoint_at(double t)
+{
+    if (t < 1800.0) return 200.0f;
+    if (t < 3600.0) return 300.0f;
+    return 150.0f;
+}
+
+int main(int argc, char **argv)
+{
+    long reps = (argc > 1) ? strtol(argv[1], NULL, 10) : BENCH_DEFAULT_REPS;
+    if (reps <= 0) {
+        fprintf(stderr, "usage: %s [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    plant_params_t params = PLANT_PARAMS_DEFAULT();
+    hal_sim_t sim;
+    hal_sensor_t sensor;
+    hal_actuator_t heater;
+    hal_sim_init(&sim, &params, 1);
+    hal_sim_bind(&sim, &sensor, &heater);
+
+    pid_fixed_config_t pid_config = {
+        .kp = 2.0f,
+        .ki = 0.02f,
+        .kd = 5.0f,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = BENCH_PERIOD_MS,
+        .full_scale = (int32_t)heater.max_duty,
+        .output_min = 0,
+        .output_max = (int32_t)heater.max_duty,
+    };
+    controller_t controller;
+    controller_init(&controller, &pid_config);
+    feedforward_t ff;
+    feedforward_init(&ff, &params, pid_config.full_scale);
+    ff.calibrate = true;
+    controller_set_feedforward(&controller, &ff);
+    controller_set_mode(&controller, CONTROL_MODE_AUTO);
+
+    estimator_t est;
+    estimator_init(&est, &params);
+
+    error_stats_t raw_temp = { 0 }, est_temp = { 0 };
+    error_stats_t raw_rate = { 0 }, est_rate = { 0 };
+    error_stats_t raw_mid = { 0 }, est_mid = { 0 };
+    long spikes_injected = 0;
+    long spikes_dropped = 0;
+    long good_dropped = 0;
+    float prev_raw = NAN;
+    const uint64_t half_us = BENCH_PERIOD_MS * 500ULL;
+
+    for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+        double t = (double)sim.plant.now_us / 1e6;
+        controller_set_setpoint(&controller, controller_celsius_to_units(setpoint_at(t)));
+        sim.plant.extra_loss_w_per_k = (t >= 4800.0) ? 0.1f : 0.0f;
+
+        hal_sensor_reading_t reading;
+        esp_err_t ret = hal_sensor_read(&sensor, &reading, 1);
+        if (ret == ESP_OK) {
+            ret = reading.status;
+        }
+
+        // The controller sees the clean reading; only the estimator gets the spikes
+        float measured = reading.temperature;
+        bool spike = (i > 0 && i % BENCH_SPIKE_EVERY == 0);
+        if (spike) {
+            measured += (i & 1) ? BENCH_SPIKE_C : -BENCH_SPIKE_C;
+            spikes_injected++;
+        }
+
+        esp_err_t est_ret = estimator_update(&est, measured, reading.timestamp_us);
+        if (est_ret == ESP_ERR_INVALID_RESPONSE) {
+            if (spike) {
+                spikes_dropped++;
+            } else {
+                good_dropped++;
+            }
+        }
+
+        uint32_t duty = controller_step(&controller, ret, reading.raw >> 3, NULL);
+        hal_actuator_set_duty(&heater, 0, duty);
+        float duty_frac = (float)duty / (float)heater.max_duty;
+        estimator_set_duty(&est, duty_frac);
+        s_samples[i] = (bench_sample_t) { measured, reading.timestamp_us, duty_frac };
+
+        // Skip the first minute while the filter converges
+        const plant_model_t *plant = &sim.plant;
+        bool scored = (t >= 60.0 && !spike);
+        if (scored) {
+            estimator_output_t out;
+            estimator_get(&est, &out);
+            float true_rate = (plant->drum_c - plant->probe_c) / params.thermocouple_tau_s;
+
+            add_error(&raw_temp, reading.temperature - plant->probe_c);
+            add_error(&est_temp, out.temperature - plant->probe_c);
+            if (!isnan(prev_raw)) {
+                add_error(&raw_rate, (reading.temperature - prev_raw) / (BENCH_PERIOD_MS / 1000.0f) - true_rate);
+            }
+            add_error(&est_rate, out.rate - true_rate);
+        }
+        prev_raw = spike ? prev_raw : reading.temperature;
+
+        hal_sim_advance(&sim, half_us);
+        if (scored) {
+            float predicted = estimator_predict(&est, (int64_t)sim.plant.now_us);
+            add_error(&raw_mid, reading.temperature - sim.plant.probe_c);
+            add_error(&est_mid, predicted - sim.plant.probe_c);
+        }
+        hal_sim_advance(&sim, BENCH_PERIOD_MS * 1000ULL - half_us);
+    }
+
+    const uint32_t restarts = est.restarts;
+
+    // Cost on the recorded readings
+    double start = now_ns();
+    for (long r = 0; r < reps; r++) {
+        estimator_init(&est, &params);
+        for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+            estimator_update(&est, s_samples[i].temperature, s_samples[i].timestamp_us);
+            estimator_set_duty(&est, s_samples[i].duty);
+        }
+        s_sink = est.x[0];
+    }
+    double update_ns = (now_ns() - start) / ((double)reps * BENCH_SAMPLES);
+
+    start = now_ns();
+    float acc = 0.0f;
+    for (long r = 0; r < reps; r++) {
+        for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+            acc += estimator_predict(&est, est.timestamp_us + (int64_t)(i % 250) * 1000);
+        }
+    }
+    s_sink = acc;
+    double predict_ns = (now_ns() - start) / ((double)reps * BENCH_SAMPLES);
+
+    printf("readings: %d (%d s at %d ms), 200 -> 300 -> 150°C, +0.1 W/K loss at 4800 s\n",
+           BENCH_SAMPLES, BENCH_DURATION_S, BENCH_PERIOD_MS);
+    printf("                        raw      estimator   (rms / max, vs true probe)\n");
+    printf("temperature °C:     %6.3f/%-6.2f %6.3f/%-6.2f\n",
+           rms(&raw_temp), raw_temp.max_abs, rms(&est_temp), est_temp.max_abs);
+    printf("rate °C/s:          %6.3f/%-6.2f %6.3f/%-6.2f\n",
+           rms(&raw_rate), raw_rate.max_abs, rms(&est_rate), est_rate.max_abs);
+    printf("between readings °C:%6.3f/%-6.2f %6.3f/%-6.2f\n",
+           rms(&raw_mid), raw_mid.max_abs, rms(&est_mid), est_mid.max_abs);
+    printf("spikes: %ld injected, %ld dropped, %ld good readings dropped, %u restarts\n",
+           spikes_injected, spikes_dropped, good_dropped, (unsigned)restarts);
+    printf("estimator_update:  %.1f ns/reading\n", update_ns);
+    printf("estimator_predict: %.1f ns/call\n", predict_ns);
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * Safety Interlock Fault Matrix (host)
+ *
+ * Runs the firmware interlock checks (interlock.h) next to the controller
+ * core against the simulated heater, with the timing of the firmware: a
+ * reading and a control step every 250 ms, an interlock check after every
+ * reading and every 50 ms in between. A trip inhibits the simulated
+ * actuator and puts the controller in manual at 0%, as the safety task
+ * does. Each scenario injects one condition at its event time; nominal
+ * ones (setpoint steps, load change, short bus glitch, one spike) must not
+ * trip at all, fault ones must trip with the expected fault:
+ *
+ *   open_thermocouple  MAX6675 open bit set               sensor
+ *   bus_failure        SPI reads time out                 stale
+ *   sampler_hang       No new readings published          stale
+ *   probe_detached     Reads ambient, loop drives 100%    stuck
+ *   output_stuck_18v   Output stuck at 100%, 18 V supply  over_temp
+ *   supply_36v         Output stuck at 100%, 36 V supply  rise
+ *
+ * Reports one JSON line per scenario with the first trip, the time from
+ * the event to the cutoff and the peak drum temperature after the event.
+ * The stuck-output scenarios keep commanding full power after the trip, so
+ * the peak shows the cutoff does not depend on the controller.
+ *
+ * Usage: interlock_faults
+ * Exits with status 1 if any scenario trips when it must not, or does not
+ * trip with the expected fault.
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal_sim.h"
+#include "controller.h"
+#include "estimator.h"
+#include "interlock.h"
+
+#define SIM_PERIOD_MS        250     // TEMP_SAMPLER_PERIOD_MS, CONTROL_TASK_PERIOD_MS
+#define SIM_CHECK_MS         50      // SAFETY_CHECK_PERIOD_MS
+#define SIM_FOREVER_S        1e9
+
+typedef struct {
+    const char *name;
+    double warmup_s;          // At setpoint_before, checked but before the event
+    double duration_s;        // After the event
+    float setpoint_before;
+    float setpoint_after;
+    float disturbance_w_per_k;// Extra drum losses from the event
+    double bus_error_s;       // SPI timeouts for this long from the event
+    double open_s;            // Open thermocouple for this long
+    double hang_s;            // No readings published for this long
+    double detach_s;          // Probe reads ambient for this long
+    float spike_c;            // Added to the first reading after the event
+    bool output_stuck;        // Heater at 100% from the event, whatever the controller says
+    float supply_v;           // Supply from the event, 0: nominal
+    uint32_t expect;          // INTERLOCK_FAULT_* the first trip must include, 0: no trip allowed
+} fault_scenario_t;
+
+typedef struct {
+    uint32_t faults;          // First trip, 0: none
+    double trip_s;            // From the event (negative: before it)
+    double peak_c;            // Drum, from the event on
+} fault_result_t;
+
+// At 12 V the drum settles near 315°C at full power, so step_200_340 also
+// holds 100% for an hour: the stuck check must not mistake saturation for a
+// detached probe. probe_detached starts mid-window of that check.
+static const fault_scenario_t s_scenarios[] = {
+    { .name = "step_25_200", .duration_s = 1800, .setpoint_before = 25, .setpoint_after = 200 },
+    { .name = "step_200_340", .warmup_s = 1800, .duration_s = 3600, .setpoint_before = 200, .setpoint_after = 340 },
+    { .name = "step_340_150", .warmup_s = 5400, .duration_s = 1800, .setpoint_before = 340, .setpoint_after = 150 },
+    { .name = "load_disturbance", .warmup_s = 1800, .duration_s = 1200, .setpoint_before = 200,
+      .setpoint_after = 200, .disturbance_w_per_k = 0.1f },
+    { .name = "bus_glitch", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .bus_error_s = 0.5 },
+    { .name = "spike", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .spike_c = 40.0f },
+    { .name = "open_thermocouple", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .open_s = SIM_FOREVER_S, .expect = INTERLOCK_FAULT_SENSOR },
+    { .name = "bus_failure", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .bus_error_s = SIM_FOREVER_S, .expect = INTERLOCK_FAULT_STALE },
+    { .name = "sampler_hang", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .hang_s = SIM_FOREVER_S, .expect = INTERLOCK_FAULT_STALE },
+    { .name = "probe_detached", .warmup_s = 1830, .duration_s = 900, .setpoint_before = 200,
+      .setpoint_after = 200, .detach_s = SIM_FOREVER_S, .expect = INTERLOCK_FAULT_STUCK },
+    { .name = "output_stuck_18v", .warmup_s = 1800, .duration_s = 900, .setpoint_before = 200,
+      .setpoint_after = 200, .output_stuck = true, .supply_v = 18.0f, .expect = INTERLOCK_FAULT_OVER_TEMP },
+    { .name = "supply_36v", .warmup_s = 1800, .duration_s = 600, .setpoint_before = 200,
+      .setpoint_after = 200, .output_stuck = true, .supply_v = 36.0f, .expect = INTERLOCK_FAULT_RISE },
+};
+
+#define NUM_SCENARIOS  (sizeof(s_scenarios) / sizeof(s_scenarios[0]))
+
+static bool within(uint64_t now_us, uint64_t event_us, double duration_s)
+{
+    return duration_s > 0.0 && now_us >= event_us && (double)(now_us - event_us) < duration_s * 1e6;
+}
+
+static void run_scenario(const fault_scenario_t *sc, fault_result_t *result)
+{
+    plant_params_t params = PLANT_PARAMS_DEFAULT();
+    hal_sim_t sim;
+    hal_sensor_t sensor;
+    hal_actuator_t heater;
+    hal_sim_init(&sim, &params, 1);
+    hal_sim_bind(&sim, &sensor, &heater);
+
+    // As control_task_start() with the firmware defaults
+    pid_fixed_config_t pid_config = {
+        .kp = 2.0f,
+        .ki = 0.02f,
+        .kd = 5.0f,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = SIM_PERIOD_MS,
+        .full_scale = (int32_t)heater.max_duty,
+        .output_min = 0,
+        .output_max = (int32_t)heater.max_duty,
+    };
+    controller_t controller;
+    controller_init(&controller, &pid_config);
+    feedforward_t ff;
+    feedforward_init(&ff, &params, pid_config.full_scale);
+    ff.calibrate = true;
+    controller_set_feedforward(&controller, &ff);
+    controller_set_setpoint(&controller, controller_celsius_to_units(sc->setpoint_before));
+    controller_set_mode(&controller, CONTROL_MODE_AUTO);
+    estimator_t est;
+    estimator_init(&est, &params);
+
+    // The supervisor's model is the nominal one, whatever the simulated supply
+    const interlock_config_t config = INTERLOCK_CONFIG_DEFAULT();
+    interlock_t il;
+    interlock_init(&il, &config, &params, 1);
+
+    const uint64_t event_us = (uint64_t)(sc->warmup_s * 1e6);
+    const uint64_t end_us = event_us + (uint64_t)(sc->duration_s * 1e6);
+    interlock_reading_t published = { 0 };
+    bool event_done = false;
+    bool spiked = false;
+    uint32_t rng = 12345;
+
+    memset(result, 0, sizeof(*result));
+    result->peak_c = -INFINITY;
+
+    for (uint64_t step = 0; sim.plant.now_us < end_us; step++) {
+        uint64_t now_us = sim.plant.now_us;
+
+        if (!event_done && now_us >= event_us) {
+            controller_set_setpoint(&controller, controller_celsius_to_units(sc->setpoint_after));
+            sim.plant.extra_loss_w_per_k = sc->disturbance_w_per_k;
+            if (sc->supply_v > 0.0f) {
+                sim.plant.params.supply_voltage = sc->supply_v;
+            }
+            event_done = true;
+        }
+        sim.plant.open_thermocouple = within(now_us, event_us, sc->open_s);
+        sim.bus_error = within(now_us, event_us, sc->bus_error_s);
+
+        // Sampler and control task, once per period
+        if (step % (SIM_PERIOD_MS / SIM_CHECK_MS) == 0) {
+            hal_sensor_reading_t reading;
+            esp_err_t ret = hal_sensor_read(&sensor, &reading, 1);
+            if (ret == ESP_OK) {
+                ret = reading.status;
+            }
+            if (ret == ESP_OK && within(now_us, event_us, sc->detach_s)) {
+                rng = rng * 1103515245u + 12345u;
+                reading.temperature = params.ambient_c + (float)((rng >> 16) & 1) * PLANT_ADC_LSB_C;
+                reading.raw = (uint16_t)(reading.temperature / PLANT_ADC_LSB_C) << 3;
+            }
+            if (ret == ESP_OK && event_done && sc->spike_c != 0.0f && !spiked) {
+                reading.temperature += sc->spike_c;
+                reading.raw = (uint16_t)(reading.temperature / PLANT_ADC_LSB_C) << 3;
+                spiked = true;
+            }
+
+            bool hung = within(now_us, event_us, sc->hang_s);
+            if (!hung) {
+                published = (interlock_reading_t) {
+                    .temperature = reading.temperature,
+                    .timestamp_us = (int64_t)now_us,
+                    .sequence = published.sequence + 1,
+                    .valid = ret == ESP_OK,
+                    .open = reading.fault != 0,
+                };
+            }
+
+            // A stopped sampler reaches the controller as a stale sample
+            esp_err_t status = hung ? ESP_ERR_INVALID_STATE : ret;
+            int32_t measurement = reading.raw >> 3;
+            if (status == ESP_OK) {
+                estimator_update(&est, reading.temperature, (int64_t)now_us);
+                measurement = controller_celsius_to_units(estimator_predict(&est, (int64_t)now_us));
+            }
+            uint32_t duty = controller_step(&controller, status, measurement, NULL);
+            if (sc->output_stuck && event_done) {
+                duty = heater.max_duty;
+            }
+            hal_actuator_set_duty(&heater, 0, duty);
+            estimator_set_duty(&est, (float)duty / (float)heater.max_duty);
+        }
+
+        // Safety task: after every reading and every SIM_CHECK_MS
+        float duty = (float)hal_actuator_get_duty(&heater, 0) / (float)heater.max_duty;
+        uint32_t found = interlock_check(&il, &published, 1, duty, (int64_t)now_us, NULL);
+        if (found != 0 && result->faults == 0) {
+            hal_actuator_inhibit(&heater, true);
+            controller_set_manual(&controller, 0);
+            controller_set_mode(&controller, CONTROL_MODE_MANUAL);
+            result->faults = found;
+            result->trip_s = ((double)now_us - (double)event_us) / 1e6;
+        }
+
+        if (event_done && sim.plant.drum_c > result->peak_c) {
+            result->peak_c = sim.plant.drum_c;
+        }
+        hal_sim_advance(&sim, SIM_CHECK_MS * 1000ULL);
+    }
+}
+
+static void print_faults(uint32_t faults)
+{
+    if (faults == 0) {
+        printf("\"none\"");
+        return;
+    }
+
+    const char *sep = "";
+    printf("\"");
+    for (uint32_t i = 0; i < INTERLOCK_FAULT_COUNT; i++) {
+        if (faults & (1u << i)) {
+            printf("%s%s", sep, interlock_fault_name(1u << i));
+            sep = "+";
+        }
+    }
+    printf("\"");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        fprintf(stderr, "usage: %s\n", argv[0]);
+        return 2;
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < NUM_SCENARIOS; i++) {
+        const fault_scenario_t *sc = &s_scenarios[i];
+        fault_result_t result;
+        run_scenario(sc, &result);
+
+        bool pass = (sc->expect == 0) ? (result.faults == 0)
+                                      : ((result.faults & sc->expect) != 0 && result.trip_s >= 0.0);
+        failures += pass ? 0 : 1;
+
+        printf("{\"scenario\":\"%s\",\"expect\":", sc->name);
+        print_faults(sc->expect);
+        printf(",\"tripped\":");
+        print_faults(result.faults);
+        if (result.faults != 0) {
+            printf(",\"trip_s\":%.2f", result.trip_s);
+        }
+        printf(",\"peak_c\":%.2f,\"result\":\"%s\"}\n", result.peak_c, pass ? "pass" : "FAIL");
+    }
+
+    fprintf(stderr, "%s: %d of %d scenario(s) failed\n", failures ? "FAIL" : "PASS", failures, (int)NUM_SCENARIOS);
+    return failures ? 1 : 0;
+}
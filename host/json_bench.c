@@ -0,0 +1,206 @@
+/*
+ * JSON Response Benchmark (host)
+ *
+ * Cost of one /api/temperature response plus one /api/power body parse,
+ * as the REST handlers do them: json_writer/json_scan (current) against
+ * cJSON_Print/cJSON_Parse (previous, built when cJSON sources are found,
+ * see CMakeLists.txt). Reports bytes, time, cycles and heap operations
+ * per request; heap calls are counted by wrapping malloc/free at link time.
+ *
+ * Usage: json_bench [iterations]
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "json_writer.h"
+#ifdef HAVE_CJSON
+#include "cJSON.h"
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define DEFAULT_ITERATIONS  200000
+#define RESPONSE_BUFFER     512     // REST_JSON_BUFFER_SIZE
+
+static const char s_power_body[] = "{\"power\": 42.5}";
+
+typedef struct {
+    const char *name;
+    size_t bytes;
+    double ns;
+    double cycles;
+    double heap_ops;
+} bench_result_t;
+
+// ---------------------------------------------------------------------------
+// Heap call counting (-Wl,--wrap=malloc,...)
+// ---------------------------------------------------------------------------
+
+void *__real_malloc(size_t size);
+void __real_free(void *ptr);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static bool s_counting = false;
+static unsigned long s_heap_ops = 0;
+
+void *__wrap_malloc(size_t size)
+{
+    s_heap_ops += s_counting;
+    return __real_malloc(size);
+}
+
+void __wrap_free(void *ptr)
+{
+    s_heap_ops += s_counting && ptr != NULL;
+    __real_free(ptr);
+}
+
+void *__wrap_calloc(size_t n, size_t size)
+{
+    s_heap_ops += s_counting;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    s_heap_ops += s_counting;
+    return __real_realloc(ptr, size);
+}
+
+// ---------------------------------------------------------------------------
+// Request bodies, same content as temperature_handler/power_handler
+// ---------------------------------------------------------------------------
+
+static volatile double s_sink;
+
+static size_t request_writer(void)
+{
+    char buf[RESPONSE_BUFFER];
+    json_writer_t w;
+
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_obj_begin(&w);
+    json_kv_uint(&w, "sequence", 123456);
+    json_kv_int(&w, "age_ms", 87);
+    json_kv_uint(&w, "raw", 0x1900);
+    json_kv_bool(&w, "success", true);
+    json_kv_fixed(&w, "temperature", 200.25, 2);
+    json_key(&w, "channels");
+    json_arr_begin(&w);
+    json_obj_begin(&w);
+    json_kv_uint(&w, "channel", 0);
+    json_kv_fixed(&w, "temperature", 200.25, 2);
+    json_kv_int(&w, "timestamp_us", 86400123456LL);
+    json_obj_end(&w);
+    json_arr_end(&w);
+    json_obj_end(&w);
+
+    double power = 0.0;
+    json_scan_number(s_power_body, sizeof(s_power_body) - 1, "power", &power);
+    s_sink = power + buf[w.len - 1];
+    return w.len;
+}
+
+#ifdef HAVE_CJSON
+static size_t request_cjson(void)
+{
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "sequence", 123456);
+    cJSON_AddNumberToObject(json, "age_ms", 87);
+    cJSON_AddNumberToObject(json, "raw", 0x1900);
+    cJSON_AddBoolToObject(json, "success", true);
+    cJSON_AddNumberToObject(json, "temperature", 200.25);
+    cJSON *channels = cJSON_AddArrayToObject(json, "channels");
+    cJSON *channel = cJSON_CreateObject();
+    cJSON_AddNumberToObject(channel, "channel", 0);
+    cJSON_AddNumberToObject(channel, "temperature", 200.25);
+    cJSON_AddNumberToObject(channel, "timestamp_us", 86400123456.0);
+    cJSON_AddItemToArray(channels, channel);
+
+    char *out = cJSON_Print(json);
+    size_t len = strlen(out);
+    free(out);
+    cJSON_Delete(json);
+
+    cJSON *root = cJSON_Parse(s_power_body);
+    cJSON *power = cJSON_GetObjectItem(root, "power");
+    s_sink = cJSON_IsNumber(power) ? power->valuedouble : 0.0;
+    cJSON_Delete(root);
+    return len;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// Harness
+// ---------------------------------------------------------------------------
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bench_result_t run(const char *name, size_t (*request)(void), long iterations)
+{
+    bench_result_t result = { .name = name };
+
+    // Warm-up, and one counted request for the heap figure
+    for (int i = 0; i < 1000; i++) {
+        result.bytes = request();
+    }
+    s_heap_ops = 0;
+    s_counting = true;
+    request();
+    s_counting = false;
+    result.heap_ops = (double)s_heap_ops;
+
+    double start = now_ns();
+#ifdef HAVE_TSC
+    unsigned long long tsc_start = __rdtsc();
+#endif
+    for (long i = 0; i < iterations; i++) {
+        request();
+    }
+#ifdef HAVE_TSC
+    result.cycles = (double)(__rdtsc() - tsc_start) / iterations;
+#endif
+    result.ns = (now_ns() - start) / iterations;
+    return result;
+}
+
+static void print_result(const bench_result_t *r)
+{
+    printf("%-12s %8zu %10.1f %10.0f %10.0f\n", r->name, r->bytes, r->ns, r->cycles, r->heap_ops);
+}
+
+int main(int argc, char **argv)
+{
+    long iterations = (argc > 1) ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    printf("%-12s %8s %10s %10s %10s\n", "serializer", "bytes", "ns/req", "cycles/req", "heap_ops");
+
+    bench_result_t writer = run("json_writer", request_writer, iterations);
+    print_result(&writer);
+
+#ifdef HAVE_CJSON
+    bench_result_t cjson = run("cJSON", request_cjson, iterations);
+    print_result(&cjson);
+    printf("json_writer: %.1fx faster, %zu fewer bytes, %.0f fewer heap ops per request\n",
+           cjson.ns / writer.ns, cjson.bytes - writer.bytes, cjson.heap_ops - writer.heap_ops);
+#else
+    printf("cJSON not built (set IDF_PATH or -DCJSON_DIR=<dir with cJSON.c>) - no baseline row\n");
+#endif
+
+    return 0;
+}
@@ -0,0 +1,556 @@
+/*
+ * Modbus TCP Client (host)
+ *
+ * Checks the controller's Modbus TCP server (main/modbus.h) from Linux.
+ *
+ * Without --seconds it reads the whole register map once and prints it
+ * decoded. With --seconds, --connections masters poll concurrently, each
+ * reading all input and holding registers every --interval-ms as a
+ * PLC/SCADA master would, and the round-trip latency, exceptions and
+ * malformed responses are reported. --set writes registers first
+ * (mode=auto|manual, setpoint=C, power=%, kp=X, ki=X, kd=X; repeatable).
+ *
+ * Usage: modbus_client [--host H] [--port N] [--unit N] [--set NAME=VALUE]...
+ *                      [--seconds S [--connections N] [--interval-ms N]]
+ *
+ * Local test against the simulator:
+ *   plant_sim --hours 0.1 --modbus 1502 &
+ *   modbus_client --port 1502 --set setpoint=150
+ *   modbus_client --port 1502 --seconds 30 --connections 4 --interval-ms 10
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "modbus.h"
+
+#define CLIENT_MAX_CONNECTIONS  32
+#define CLIENT_MAX_WRITES       16
+#define CLIENT_MAX_SAMPLES      (1u << 20)  // Latencies kept per connection
+
+typedef struct {
+    char name[16];
+    double value;
+} client_write_t;
+
+typedef struct {
+    const char *host;
+    uint16_t port;
+    uint8_t unit;
+    double seconds;
+    uint32_t connections;
+    uint32_t interval_ms;
+    client_write_t writes[CLIENT_MAX_WRITES];
+    size_t write_count;
+} client_options_t;
+
+typedef struct {
+    const client_options_t *opt;
+    uint16_t transaction;
+    uint64_t requests;
+    uint64_t exceptions;
+    uint64_t malformed;
+    uint64_t late;                  // Polls started after their slot
+    bool failed;
+    double *latency_ms;
+    size_t samples;
+} poller_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--host H] [--port N] [--unit N] [--set NAME=VALUE]...\n"
+            "          [--seconds S [--connections N] [--interval-ms N]]\n", prog);
+}
+
+static int parse_write(const char *spec, client_options_t *opt)
+{
+    if (opt->write_count == CLIENT_MAX_WRITES) {
+        return -1;
+    }
+    client_write_t *write = &opt->writes[opt->write_count];
+    char value[32];
+    if (sscanf(spec, "%15[^=]=%31s", write->name, value) != 2) {
+        return -1;
+    }
+    if (strcmp(write->name, "mode") == 0) {
+        if (strcmp(value, "auto") != 0 && strcmp(value, "manual") != 0) {
+            return -1;
+        }
+        write->value = strcmp(value, "auto") == 0 ? 1.0 : 0.0;
+    } else if (strcmp(write->name, "setpoint") == 0 || strcmp(write->name, "power") == 0 ||
+               strcmp(write->name, "kp") == 0 || strcmp(write->name, "ki") == 0 ||
+               strcmp(write->name, "kd") == 0) {
+        write->value = atof(value);
+    } else {
+        return -1;
+    }
+    opt->write_count++;
+    return 0;
+}
+
+static int parse_options(int argc, char **argv, client_options_t *opt)
+{
+    static const struct option long_options[] = {
+        {"host", required_argument, NULL, 'h'},
+        {"port", required_argument, NULL, 'p'},
+        {"unit", required_argument, NULL, 'u'},
+        {"set", required_argument, NULL, 's'},
+        {"seconds", required_argument, NULL, 't'},
+        {"connections", required_argument, NULL, 'c'},
+        {"interval-ms", required_argument, NULL, 'i'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'h': opt->host = optarg; break;
+        case 'p': opt->port = (uint16_t)atoi(optarg); break;
+        case 'u': opt->unit = (uint8_t)atoi(optarg); break;
+        case 's':
+            if (parse_write(optarg, opt) != 0) {
+                return -1;
+            }
+            break;
+        case 't': opt->seconds = atof(optarg); break;
+        case 'c': opt->connections = (uint32_t)atoi(optarg); break;
+        case 'i': opt->interval_ms = (uint32_t)atoi(optarg); break;
+        default: return -1;
+        }
+    }
+    return (opt->port != 0 && opt->seconds >= 0.0 && opt->connections > 0 &&
+            opt->connections <= CLIENT_MAX_CONNECTIONS && opt->interval_ms > 0) ? 0 : -1;
+}
+
+static int connect_server(const client_options_t *opt)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(opt->host, NULL, &hints, &result) != 0 || result == NULL) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memcpy(&addr, result->ai_addr, sizeof(addr));
+    addr.sin_port = htons(opt->port);
+    freeaddrinfo(result);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool recv_all(int fd, uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        ssize_t n = recv(fd, buf + got, len - got, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        got += (size_t)n;
+    }
+    return true;
+}
+
+// Sends one PDU and receives the response PDU; returns its length, -1 on a
+// connection error, -2 on a response that does not match the request
+static int transact(int fd, uint8_t unit, uint16_t transaction, const uint8_t *pdu, size_t pdu_len,
+                    uint8_t *response)
+{
+    uint8_t adu[MODBUS_MAX_ADU];
+    adu[0] = (uint8_t)(transaction >> 8);
+    adu[1] = (uint8_t)transaction;
+    adu[2] = 0;
+    adu[3] = 0;
+    adu[4] = (uint8_t)((pdu_len + 1) >> 8);
+    adu[5] = (uint8_t)(pdu_len + 1);
+    adu[6] = unit;
+    memcpy(&adu[MODBUS_MBAP_SIZE], pdu, pdu_len);
+    if (send(fd, adu, MODBUS_MBAP_SIZE + pdu_len, MSG_NOSIGNAL) != (ssize_t)(MODBUS_MBAP_SIZE + pdu_len)) {
+        return -1;
+    }
+
+    uint8_t header[MODBUS_MBAP_SIZE];
+    if (!recv_all(fd, header, sizeof(header))) {
+        return -1;
+    }
+    size_t len = (size_t)((header[4] << 8) | header[5]);
+    if (len < 2 || len > MODBUS_MAX_ADU - 6 || !recv_all(fd, response, len - 1)) {
+        return -1;
+    }
+    bool match = header[0] == adu[0] && header[1] == adu[1] && header[2] == 0 && header[3] == 0 &&
+                 header[6] == unit && (response[0] & 0x7F) == pdu[0];
+    return match ? (int)(len - 1) : -2;
+}
+
+// Reads count registers into regs; returns 0, the exception code, or -1/-2 as transact()
+static int read_registers(int fd, uint8_t unit, uint16_t transaction, uint8_t function, uint16_t first,
+                          uint16_t count, uint16_t *regs)
+{
+    const uint8_t pdu[5] = {
+        function, (uint8_t)(first >> 8), (uint8_t)first, (uint8_t)(count >> 8), (uint8_t)count,
+    };
+    uint8_t response[MODBUS_MAX_ADU];
+    int len = transact(fd, unit, transaction, pdu, sizeof(pdu), response);
+    if (len < 0) {
+        return len;
+    }
+    if (response[0] & 0x80) {
+        return len == 2 ? response[1] : -2;
+    }
+    if (len != 2 + count * 2 || response[1] != count * 2) {
+        return -2;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        regs[i] = (uint16_t)((response[2 + i * 2] << 8) | response[3 + i * 2]);
+    }
+    return 0;
+}
+
+static int write_registers(int fd, uint8_t unit, uint16_t transaction, uint16_t first, uint16_t count,
+                           const uint16_t *regs)
+{
+    uint8_t pdu[6 + 2 * 4];
+    size_t pdu_len;
+    if (count == 1) {
+        pdu[0] = MODBUS_FC_WRITE_SINGLE;
+        pdu[1] = (uint8_t)(first >> 8);
+        pdu[2] = (uint8_t)first;
+        pdu[3] = (uint8_t)(regs[0] >> 8);
+        pdu[4] = (uint8_t)regs[0];
+        pdu_len = 5;
+    } else {
+        pdu[0] = MODBUS_FC_WRITE_MULTIPLE;
+        pdu[1] = (uint8_t)(first >> 8);
+        pdu[2] = (uint8_t)first;
+        pdu[3] = 0;
+        pdu[4] = (uint8_t)count;
+        pdu[5] = (uint8_t)(count * 2);
+        for (uint16_t i = 0; i < count; i++) {
+            pdu[6 + i * 2] = (uint8_t)(regs[i] >> 8);
+            pdu[7 + i * 2] = (uint8_t)regs[i];
+        }
+        pdu_len = 6 + (size_t)count * 2;
+    }
+
+    uint8_t response[MODBUS_MAX_ADU];
+    int len = transact(fd, unit, transaction, pdu, pdu_len, response);
+    if (len < 0) {
+        return len;
+    }
+    if (response[0] & 0x80) {
+        return len == 2 ? response[1] : -2;
+    }
+    return (len == 5 && memcmp(&response[1], &pdu[1], 4) == 0) ? 0 : -2;
+}
+
+static const char *exception_name(int code)
+{
+    switch (code) {
+    case -1: return "connection error";
+    case -2: return "malformed response";
+    case MODBUS_EX_ILLEGAL_FUNCTION: return "illegal function";
+    case MODBUS_EX_ILLEGAL_ADDRESS: return "illegal data address";
+    case MODBUS_EX_ILLEGAL_VALUE: return "illegal data value";
+    case MODBUS_EX_DEVICE_FAILURE: return "server device failure";
+    default: return "exception";
+    }
+}
+
+static int apply_writes(int fd, const client_options_t *opt)
+{
+    for (size_t i = 0; i < opt->write_count; i++) {
+        const client_write_t *write = &opt->writes[i];
+        uint16_t regs[2];
+        uint16_t first;
+        uint16_t count = 1;
+        if (strcmp(write->name, "mode") == 0) {
+            first = MODBUS_HR_MODE;
+            regs[0] = (uint16_t)write->value;
+        } else if (strcmp(write->name, "setpoint") == 0 || strcmp(write->name, "power") == 0) {
+            first = strcmp(write->name, "setpoint") == 0 ? MODBUS_HR_SETPOINT : MODBUS_HR_POWER;
+            regs[0] = (uint16_t)(int16_t)lround(write->value * 10.0);
+        } else {
+            first = strcmp(write->name, "kp") == 0 ? MODBUS_HR_KP
+                  : strcmp(write->name, "ki") == 0 ? MODBUS_HR_KI : MODBUS_HR_KD;
+            float value = (float)write->value;
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            regs[0] = (uint16_t)(bits >> 16);
+            regs[1] = (uint16_t)bits;
+            count = 2;
+        }
+
+        int ret = write_registers(fd, opt->unit, (uint16_t)(0x8000 + i), first, count, regs);
+        if (ret != 0) {
+            fprintf(stderr, "write %s=%g: %s\n", write->name, write->value, exception_name(ret));
+            return -1;
+        }
+        if (strcmp(write->name, "mode") == 0) {
+            printf("wrote mode=%s\n", write->value != 0.0 ? "auto" : "manual");
+        } else {
+            printf("wrote %s=%g\n", write->name, write->value);
+        }
+    }
+    return 0;
+}
+
+static double reg_scaled(uint16_t reg)
+{
+    return (double)(int16_t)reg / 10.0;
+}
+
+static void print_scaled(const char *name, uint16_t reg, const char *unit)
+{
+    if (reg == MODBUS_INVALID) {
+        printf("%-14s --\n", name);
+    } else {
+        printf("%-14s %.1f %s\n", name, reg_scaled(reg), unit);
+    }
+}
+
+static float reg_float(const uint16_t *regs)
+{
+    uint32_t bits = ((uint32_t)regs[0] << 16) | regs[1];
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static int dump(int fd, const client_options_t *opt)
+{
+    uint16_t input[MODBUS_INPUT_COUNT];
+    uint16_t holding[MODBUS_HOLDING_COUNT];
+    int ret = read_registers(fd, opt->unit, 1, MODBUS_FC_READ_INPUT, 0, MODBUS_INPUT_COUNT, input);
+    if (ret == 0) {
+        ret = read_registers(fd, opt->unit, 2, MODBUS_FC_READ_HOLDING, 0, MODBUS_HOLDING_COUNT, holding);
+    }
+    if (ret != 0) {
+        fprintf(stderr, "read: %s\n", exception_name(ret));
+        return -1;
+    }
+
+    uint16_t status = input[MODBUS_IR_STATUS];
+    printf("%-14s 0x%04x%s%s%s%s%s\n", "status", status,
+           (status & MODBUS_STATUS_RUNNING) ? " running" : "", (status & MODBUS_STATUS_SENSOR_OK) ? " sensor_ok" : "",
+           (status & MODBUS_STATUS_AUTO) ? " auto" : " manual", (status & MODBUS_STATUS_PROFILE) ? " profile" : "",
+           (status & MODBUS_STATUS_AUTOTUNE) ? " autotune" : "");
+    print_scaled("temperature", input[MODBUS_IR_TEMPERATURE], "°C");
+    print_scaled("estimate", input[MODBUS_IR_ESTIMATE], "°C");
+    print_scaled("setpoint", input[MODBUS_IR_SETPOINT], "°C");
+    print_scaled("output", input[MODBUS_IR_OUTPUT], "%");
+    print_scaled("feedforward", input[MODBUS_IR_FEEDFORWARD], "%");
+    print_scaled("rate", input[MODBUS_IR_RATE], "°C/min");
+    printf("%-14s %u\n", "spikes", input[MODBUS_IR_SPIKES]);
+    printf("%-14s %" PRIu32 "\n", "ticks", ((uint32_t)input[MODBUS_IR_TICKS] << 16) | input[MODBUS_IR_TICKS + 1]);
+    printf("%-14s %" PRIu32 "\n", "overruns",
+           ((uint32_t)input[MODBUS_IR_OVERRUNS] << 16) | input[MODBUS_IR_OVERRUNS + 1]);
+    printf("%-14s %u µs\n", "step", input[MODBUS_IR_STEP_US]);
+    for (uint16_t i = 0; i < input[MODBUS_IR_CHANNELS] && i < MODBUS_MAX_CHANNELS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "channel %u", i);
+        print_scaled(name, input[MODBUS_IR_CHANNEL_TEMP + i], "°C");
+        if (input[MODBUS_IR_CHANNEL_FAULT + i] != 0) {
+            printf("%-14s fault 0x%02x\n", "", input[MODBUS_IR_CHANNEL_FAULT + i]);
+        }
+    }
+    for (uint16_t i = 0; i < input[MODBUS_IR_ZONES] && i < MODBUS_MAX_ZONES; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "zone %u", i);
+        print_scaled(name, input[MODBUS_IR_ZONE_DUTY + i], "%");
+    }
+    printf("%-14s %s\n", "hr mode", holding[MODBUS_HR_MODE] ? "auto" : "manual");
+    print_scaled("hr setpoint", holding[MODBUS_HR_SETPOINT], "°C");
+    print_scaled("hr power", holding[MODBUS_HR_POWER], "%");
+    printf("%-14s Kp %.4f Ki %.5f Kd %.3f\n", "hr gains", reg_float(&holding[MODBUS_HR_KP]),
+           reg_float(&holding[MODBUS_HR_KI]), reg_float(&holding[MODBUS_HR_KD]));
+    return 0;
+}
+
+// One master: reads all input and holding registers every interval
+static void *poll_thread(void *arg)
+{
+    poller_t *poller = arg;
+    const client_options_t *opt = poller->opt;
+    int fd = connect_server(opt);
+    if (fd < 0) {
+        poller->failed = true;
+        return NULL;
+    }
+
+    const double interval_s = opt->interval_ms / 1000.0;
+    double start = now_s();
+    double next = start;
+    uint16_t input[MODBUS_INPUT_COUNT];
+    uint16_t holding[MODBUS_HOLDING_COUNT];
+    while (next - start < opt->seconds) {
+        for (int i = 0; i < 2; i++) {
+            bool inputs = (i == 0);
+            double t0 = now_s();
+            int ret = read_registers(fd, opt->unit, poller->transaction++,
+                                     inputs ? MODBUS_FC_READ_INPUT : MODBUS_FC_READ_HOLDING, 0,
+                                     inputs ? MODBUS_INPUT_COUNT : MODBUS_HOLDING_COUNT, inputs ? input : holding);
+            double t1 = now_s();
+            poller->requests++;
+            if (ret == -1) {
+                poller->failed = true;
+                close(fd);
+                return NULL;
+            } else if (ret == -2) {
+                poller->malformed++;
+            } else if (ret != 0) {
+                poller->exceptions++;
+            } else if (poller->samples < CLIENT_MAX_SAMPLES) {
+                poller->latency_ms[poller->samples++] = (t1 - t0) * 1000.0;
+            }
+        }
+
+        next += interval_s;
+        double wait = next - now_s();
+        if (wait > 0.0) {
+            struct timespec ts = {
+                .tv_sec = (time_t)wait,
+                .tv_nsec = (long)((wait - (double)(time_t)wait) * 1e9),
+            };
+            nanosleep(&ts, NULL);
+        } else {
+            poller->late++;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static int run_pollers(const client_options_t *opt)
+{
+    static poller_t pollers[CLIENT_MAX_CONNECTIONS];
+    pthread_t threads[CLIENT_MAX_CONNECTIONS];
+    for (uint32_t i = 0; i < opt->connections; i++) {
+        pollers[i] = (poller_t) {
+            .opt = opt,
+            .transaction = (uint16_t)(i << 12),
+            .latency_ms = malloc(CLIENT_MAX_SAMPLES * sizeof(double)),
+        };
+        if (pollers[i].latency_ms == NULL) {
+            return -1;
+        }
+    }
+    for (uint32_t i = 0; i < opt->connections; i++) {
+        pthread_create(&threads[i], NULL, poll_thread, &pollers[i]);
+    }
+
+    uint64_t requests = 0;
+    uint64_t exceptions = 0;
+    uint64_t malformed = 0;
+    uint64_t late = 0;
+    size_t total = 0;
+    uint32_t failed = 0;
+    for (uint32_t i = 0; i < opt->connections; i++) {
+        pthread_join(threads[i], NULL);
+        requests += pollers[i].requests;
+        exceptions += pollers[i].exceptions;
+        malformed += pollers[i].malformed;
+        late += pollers[i].late;
+        total += pollers[i].samples;
+        failed += pollers[i].failed ? 1 : 0;
+    }
+
+    double *all = malloc((total > 0 ? total : 1) * sizeof(double));
+    if (all == NULL) {
+        return -1;
+    }
+    size_t n = 0;
+    for (uint32_t i = 0; i < opt->connections; i++) {
+        memcpy(&all[n], pollers[i].latency_ms, pollers[i].samples * sizeof(double));
+        n += pollers[i].samples;
+        free(pollers[i].latency_ms);
+    }
+    qsort(all, n, sizeof(double), compare_double);
+
+    printf("masters:        %u x every %u ms for %.1f s (%u failed)\n", opt->connections, opt->interval_ms,
+           opt->seconds, failed);
+    printf("requests:       %" PRIu64 " (%" PRIu64 " exceptions, %" PRIu64 " malformed, %" PRIu64 " late polls)\n",
+           requests, exceptions, malformed, late);
+    if (n > 0) {
+        double sum = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            sum += all[i];
+        }
+        printf("latency:        min %.3f ms, mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               all[0], sum / (double)n, all[n / 2], all[(size_t)((double)(n - 1) * 0.99)], all[n - 1]);
+    }
+    free(all);
+    return (failed == 0 && exceptions == 0 && malformed == 0) ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    client_options_t opt = {
+        .host = "127.0.0.1",
+        .port = MODBUS_TCP_DEFAULT_PORT,
+        .unit = 1,
+        .connections = 1,
+        .interval_ms = 50,
+    };
+    if (parse_options(argc, argv, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int fd = connect_server(&opt);
+    if (fd < 0) {
+        fprintf(stderr, "cannot connect to %s:%u\n", opt.host, opt.port);
+        return 1;
+    }
+    int ret = apply_writes(fd, &opt);
+    if (ret == 0 && opt.seconds == 0.0) {
+        ret = dump(fd, &opt);
+    }
+    close(fd);
+
+    if (ret == 0 && opt.seconds > 0.0) {
+        ret = run_pollers(&opt);
+    }
+    return ret == 0 ? 0 : 1;
+}
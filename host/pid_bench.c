@@ -0,0 +1,97 @@
+/*
+ * PID Benchmark (host)
+ *
+ * Measures the cost per step of the fixed-point PID (pid_fixed) against
+ * the float reference (pid_controller) on a closed first-order plant.
+ *
+ * Usage: pid_bench [steps]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pid_fixed.h"
+#include "pid_controller.h"
+
+#define BENCH_DEFAULT_STEPS  10000000L
+#define BENCH_FULL_SCALE     4095
+#define BENCH_PERIOD_MS      250
+
+// Volatile sink so the compiler cannot drop the loops
+static volatile int32_t s_sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Cheap plant so the controller sees a realistic, varying error
+static int32_t plant_step(int32_t temp_q2, int32_t duty)
+{
+    return temp_q2 + (duty * 1300 / BENCH_FULL_SCALE - (temp_q2 - 100)) / 64;
+}
+
+static double bench_fixed(long steps)
+{
+    pid_fixed_config_t config = {
+        .kp = 2.0f, .ki = 0.02f, .kd = 5.0f,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = BENCH_PERIOD_MS,
+        .full_scale = BENCH_FULL_SCALE,
+        .output_min = 0,
+        .output_max = BENCH_FULL_SCALE,
+    };
+    pid_fixed_t pid;
+    pid_fixed_init(&pid, &config);
+    pid_fixed_set_auto(&pid);
+
+    int32_t temp = 100;
+    double start = now_ns();
+    for (long i = 0; i < steps; i++) {
+        int32_t setpoint = (i & 0x4000) ? 800 : 400;
+        int32_t duty = pid_fixed_step(&pid, setpoint, temp);
+        temp = plant_step(temp, duty);
+    }
+    double elapsed = now_ns() - start;
+    s_sink = temp;
+    return elapsed / (double)steps;
+}
+
+static double bench_float(long steps)
+{
+    pid_controller_t pid;
+    pid_controller_init(&pid, 2.0f, 0.02f, 5.0f, 0.0f, 100.0f);
+
+    int32_t temp = 100;
+    const float dt = BENCH_PERIOD_MS / 1000.0f;
+    double start = now_ns();
+    for (long i = 0; i < steps; i++) {
+        float setpoint = (i & 0x4000) ? 200.0f : 100.0f;
+        float output = pid_controller_update(&pid, setpoint, temp * 0.25f, dt);
+        int32_t duty = (int32_t)(output / 100.0f * BENCH_FULL_SCALE);
+        temp = plant_step(temp, duty);
+    }
+    double elapsed = now_ns() - start;
+    s_sink = temp;
+    return elapsed / (double)steps;
+}
+
+int main(int argc, char **argv)
+{
+    long steps = (argc > 1) ? strtol(argv[1], NULL, 10) : BENCH_DEFAULT_STEPS;
+    if (steps <= 0) {
+        fprintf(stderr, "usage: %s [steps]\n", argv[0]);
+        return 1;
+    }
+
+    double fixed_ns = bench_fixed(steps);
+    double float_ns = bench_float(steps);
+
+    printf("steps: %ld\n", steps);
+    printf("pid_fixed (Q16.16):    %.2f ns/step\n", fixed_ns);
+    printf("pid_controller (float): %.2f ns/step\n", float_ns);
+    printf("ratio float/fixed:     %.2f\n", float_ns / fixed_ns);
+    return 0;
+}
@@ -0,0 +1,550 @@
+/*
+ * Heater Plant Simulator (host)
+ *
+ * Runs the firmware controller core against the simulated nichrome heater through
+ * the same hal_sensor_t/hal_actuator_t interfaces the firmware uses,
+ * much faster than real time.
+ *
+ * With --profile, the setpoint follows a ramp/soak profile run by the
+ * firmware profile engine, given as target:rate[:hold_s[:band]] segments
+ * (°C, °C/min, s, °C) separated by commas, e.g. 150:5:600:2,250:3:900:2.
+ *
+ * With --autotune, the firmware relay autotuner runs first around the
+ * setpoint; the loop then continues in automatic mode with the tuned gains.
+ *
+ * The model feed-forward (feedforward.h) is on with calibration and the PID
+ * runs on the state estimate (estimator.h), as in the firmware;
+ * --no-feedforward and --no-estimator turn them off.
+ *
+ * With --udp, every tick also goes through the firmware telemetry ring and
+ * is sent as UDP telemetry frames (telemetry_frame.h), one batch per
+ * simulated second as the firmware publisher does, to test
+ * host/udp_receiver locally. --udp-loss drops that percentage of the
+ * datagrams instead of sending them, to exercise loss detection.
+ *
+ * With --modbus, the simulation runs in real time and serves the firmware
+ * Modbus TCP register map (modbus.h) on that port between ticks, to test
+ * host/modbus_client or a PLC/SCADA master locally. Writes change the
+ * mode, setpoint, manual power and gains of the running loop.
+ *
+ * Usage: plant_sim [--hours H] [--setpoint C] [--kp X] [--ki X] [--kd X]
+ *                  [--period-ms N] [--seed N] [--csv FILE] [--decimate N]
+ *                  [--profile SEGMENTS] [--autotune RULE] [--no-feedforward]
+ *                  [--no-estimator] [--udp HOST:PORT [--udp-loss PCT]] [--modbus PORT]
+ */
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "hal_sim.h"
+#include "telemetry.h"
+#include "telemetry_frame.h"
+#include "controller.h"
+#include "profile.h"
+#include "autotune.h"
+#include "estimator.h"
+#include "modbus.h"
+
+#define SIM_MAX_SETPOINT  350.0f   // CONTROL_MAX_SETPOINT
+#define SIM_UDP_INTERVAL_MS  1000  // UDP_TELEMETRY_INTERVAL_MS
+#define SIM_UDP_RECORDS      32    // UDP_TELEMETRY_RECORDS
+#define SIM_UDP_PACING_US    200   // Between datagrams, so a local receiver keeps up
+
+typedef struct {
+    double hours;
+    float setpoint;
+    float kp;
+    float ki;
+    float kd;
+    uint32_t period_ms;
+    uint32_t seed;
+    const char *csv_path;
+    uint32_t decimate;
+    profile_segment_t segments[PROFILE_MAX_SEGMENTS];
+    size_t segment_count;
+    bool autotune;
+    autotune_rule_t autotune_rule;
+    bool feedforward;
+    bool estimator;
+    const char *udp_target;
+    double udp_loss_pct;
+    uint16_t modbus_port;
+} sim_options_t;
+
+// What the Modbus callbacks see of the running loop
+typedef struct {
+    controller_t *controller;
+    hal_actuator_t *heater;
+    float *setpoint;
+    bool sensor_ok;
+    float temperature;
+    float estimate;
+    uint32_t ticks;
+} sim_modbus_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+            "usage: %s [--hours H] [--setpoint C] [--kp X] [--ki X] [--kd X]\n"
+            "          [--period-ms N] [--seed N] [--csv FILE] [--decimate N]\n"
+            "          [--profile target:rate[:hold_s[:band]],...] [--autotune RULE]\n"
+            "          [--no-feedforward] [--no-estimator] [--udp HOST:PORT [--udp-loss PCT]]\n"
+            "          [--modbus PORT]\n", prog);
+}
+
+static int parse_profile(const char *spec, sim_options_t *opt)
+{
+    opt->segment_count = 0;
+    while (*spec != '\0') {
+        if (opt->segment_count >= PROFILE_MAX_SEGMENTS) {
+            return -1;
+        }
+
+        profile_segment_t *seg = &opt->segments[opt->segment_count++];
+        unsigned hold_s = 0;
+        int consumed = 0;
+        *seg = (profile_segment_t) { 0 };
+        if (sscanf(spec, "%f:%f%n:%u%n:%f%n", &seg->target, &seg->ramp_rate, &consumed,
+                   &hold_s, &consumed, &seg->soak_band, &consumed) < 2) {
+            return -1;
+        }
+        seg->hold_s = hold_s;
+
+        spec += consumed;
+        if (*spec == ',') {
+            spec++;
+        } else if (*spec != '\0') {
+            return -1;
+        }
+    }
+    return profile_validate(opt->segments, opt->segment_count, SIM_MAX_SETPOINT) == ESP_OK ? 0 : -1;
+}
+
+// Numeric IPv4 HOST:PORT
+static int open_udp(const char *target, struct sockaddr_in *dest)
+{
+    char host[64];
+    unsigned port;
+    if (sscanf(target, "%63[^:]:%u", host, &port) != 2 || port == 0 || port > 65535) {
+        return -1;
+    }
+    *dest = (struct sockaddr_in) {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)port),
+    };
+    if (inet_pton(AF_INET, host, &dest->sin_addr) != 1) {
+        return -1;
+    }
+    return socket(AF_INET, SOCK_DGRAM, 0);
+}
+
+// Sends every new ring record, as the firmware publisher does once per interval
+static void publish_udp(int sock, const struct sockaddr_in *dest, telemetry_frame_stream_t *stream,
+                        float setpoint, double loss_pct, uint32_t *sent, uint32_t *dropped)
+{
+    static telemetry_frame_t frame;
+    uint16_t setpoint_q2 = (uint16_t)controller_celsius_to_units(setpoint);
+
+    size_t len;
+    while ((len = telemetry_frame_build(stream, &frame, SIM_UDP_RECORDS, setpoint_q2)) > 0) {
+        if (rand() < loss_pct / 100.0 * RAND_MAX) {
+            (*dropped)++;
+        } else if (sendto(sock, &frame, len, 0, (const struct sockaddr *)dest, sizeof(*dest)) == (ssize_t)len) {
+            (*sent)++;
+            usleep(SIM_UDP_PACING_US);
+        } else {
+            perror("sendto");
+            return;
+        }
+        telemetry_frame_commit(stream, &frame);
+    }
+}
+
+static void modbus_read_state(void *ctx, modbus_state_t *state)
+{
+    const sim_modbus_t *m = ctx;
+    const controller_t *ctl = m->controller;
+    float output = hal_actuator_duty_to_percent(m->heater, hal_actuator_get_duty(m->heater, 0));
+
+    *state = (modbus_state_t) {
+        .status = MODBUS_STATUS_RUNNING,
+        .mode = (uint16_t)ctl->mode,
+        .temperature = m->temperature,
+        .estimate = m->estimate,
+        .setpoint = *m->setpoint,
+        .output = output,
+        .feedforward = hal_actuator_duty_to_percent(m->heater, (uint32_t)ctl->ff_term),
+        .ticks = m->ticks,
+        .kp = ctl->pid_config.kp,
+        .ki = ctl->pid_config.ki,
+        .kd = ctl->pid_config.kd,
+        .channels = 1,
+        .zones = 1,
+        .channel_valid = { m->sensor_ok },
+        .channel_temp = { m->temperature },
+        .zone_duty = { output },
+    };
+    if (m->sensor_ok) {
+        state->status |= MODBUS_STATUS_SENSOR_OK;
+    }
+    if (ctl->mode == CONTROL_MODE_AUTO) {
+        state->status |= MODBUS_STATUS_AUTO;
+    }
+}
+
+// Applied in the firmware order (modbus_tcp.c): gains, setpoint, power, mode
+static esp_err_t modbus_write(void *ctx, const modbus_command_t *command)
+{
+    sim_modbus_t *m = ctx;
+    if ((command->fields & MODBUS_WRITE_SETPOINT) &&
+        (command->setpoint < 0.0f || command->setpoint > SIM_MAX_SETPOINT)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (command->fields & MODBUS_WRITE_GAINS) {
+        controller_set_gains(m->controller, command->kp, command->ki, command->kd);
+    }
+    if (command->fields & MODBUS_WRITE_SETPOINT) {
+        controller_set_setpoint(m->controller, controller_celsius_to_units(command->setpoint));
+        *m->setpoint = command->setpoint;
+    }
+    if (command->fields & MODBUS_WRITE_POWER) {
+        controller_set_manual(m->controller, hal_actuator_percent_to_duty(m->heater, command->power));
+    }
+    if (command->fields & MODBUS_WRITE_MODE) {
+        controller_set_mode(m->controller, (control_mode_t)command->mode);
+    }
+    printf("modbus write:   mode %s, setpoint %.1f°C, Kp %.3f Ki %.5f Kd %.2f\n",
+           m->controller->mode == CONTROL_MODE_AUTO ? "auto" : "manual", *m->setpoint,
+           m->controller->pid_config.kp, m->controller->pid_config.ki, m->controller->pid_config.kd);
+    return ESP_OK;
+}
+
+// Serves Modbus requests until the wall-clock deadline of the next tick
+static void serve_modbus(modbus_server_t *server, double deadline_s)
+{
+    double remaining_s;
+    while ((remaining_s = deadline_s - now_s()) > 0.0) {
+        if (modbus_server_poll(server, (uint32_t)ceil(remaining_s * 1000.0)) != ESP_OK) {
+            perror("select");
+            return;
+        }
+    }
+}
+
+static int parse_options(int argc, char **argv, sim_options_t *opt)
+{
+    static const struct option long_options[] = {
+        {"hours", required_argument, NULL, 'h'},
+        {"setpoint", required_argument, NULL, 's'},
+        {"kp", required_argument, NULL, 'p'},
+        {"ki", required_argument, NULL, 'i'},
+        {"kd", required_argument, NULL, 'd'},
+        {"period-ms", required_argument, NULL, 't'},
+        {"seed", required_argument, NULL, 'r'},
+        {"csv", required_argument, NULL, 'c'},
+        {"decimate", required_argument, NULL, 'n'},
+        {"profile", required_argument, NULL, 'f'},
+        {"autotune", required_argument, NULL, 'a'},
+        {"no-feedforward", no_argument, NULL, 'F'},
+        {"no-estimator", no_argument, NULL, 'E'},
+        {"udp", required_argument, NULL, 'u'},
+        {"udp-loss", required_argument, NULL, 'l'},
+        {"modbus", required_argument, NULL, 'm'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'h': opt->hours = atof(optarg); break;
+        case 's': opt->setpoint = (float)atof(optarg); break;
+        case 'p': opt->kp = (float)atof(optarg); break;
+        case 'i': opt->ki = (float)atof(optarg); break;
+        case 'd': opt->kd = (float)atof(optarg); break;
+        case 't': opt->period_ms = (uint32_t)atoi(optarg); break;
+        case 'r': opt->seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'c': opt->csv_path = optarg; break;
+        case 'n': opt->decimate = (uint32_t)atoi(optarg); break;
+        case 'f':
+            if (parse_profile(optarg, opt) != 0) {
+                return -1;
+            }
+            break;
+        case 'a':
+            if (autotune_rule_from_name(optarg, &opt->autotune_rule) != ESP_OK) {
+                return -1;
+            }
+            opt->autotune = true;
+            break;
+        case 'F': opt->feedforward = false; break;
+        case 'E': opt->estimator = false; break;
+        case 'u': opt->udp_target = optarg; break;
+        case 'l': opt->udp_loss_pct = atof(optarg); break;
+        case 'm': opt->modbus_port = (uint16_t)atoi(optarg); break;
+        default: return -1;
+        }
+    }
+
+    if (opt->hours <= 0.0 || opt->period_ms == 0 || opt->decimate == 0 ||
+        opt->udp_loss_pct < 0.0 || opt->udp_loss_pct > 100.0) {
+        return -1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    sim_options_t opt = {
+        .hours = 1.0,
+        .setpoint = 200.0f,
+        .kp = 2.0f,
+        .ki = 0.02f,
+        .kd = 5.0f,
+        .period_ms = 250,
+        .seed = 1,
+        .decimate = 4,
+        .feedforward = true,
+        .estimator = true,
+    };
+    if (parse_options(argc, argv, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *csv = NULL;
+    if (opt.csv_path != NULL) {
+        csv = fopen(opt.csv_path, "w");
+        if (csv == NULL) {
+            perror(opt.csv_path);
+            return 1;
+        }
+        fprintf(csv, "time_s,setpoint,measured,drum,wire,duty\n");
+    }
+
+    int udp_sock = -1;
+    struct sockaddr_in udp_dest;
+    telemetry_frame_stream_t udp_stream;
+    uint32_t udp_sent = 0;
+    uint32_t udp_dropped = 0;
+    if (opt.udp_target != NULL) {
+        udp_sock = open_udp(opt.udp_target, &udp_dest);
+        if (udp_sock < 0) {
+            fprintf(stderr, "invalid --udp target (numeric HOST:PORT)\n");
+            return 1;
+        }
+        srand(opt.seed);
+        telemetry_frame_stream_init(&udp_stream, opt.seed, (uint32_t)time(NULL));
+    }
+
+    plant_params_t params = PLANT_PARAMS_DEFAULT();
+    hal_sim_t sim;
+    hal_sensor_t sensor;
+    hal_actuator_t heater;
+    hal_sim_init(&sim, &params, opt.seed);
+    hal_sim_bind(&sim, &sensor, &heater);
+
+    pid_fixed_config_t pid_config = {
+        .kp = opt.kp,
+        .ki = opt.ki,
+        .kd = opt.kd,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = opt.period_ms,
+        .full_scale = (int32_t)heater.max_duty,
+        .output_min = 0,
+        .output_max = (int32_t)heater.max_duty,
+    };
+    controller_t controller;
+    controller_init(&controller, &pid_config);
+    feedforward_t ff;
+    if (opt.feedforward) {
+        feedforward_init(&ff, &params, pid_config.full_scale);
+        ff.calibrate = true;
+        controller_set_feedforward(&controller, &ff);
+    }
+    estimator_t est;
+    estimator_init(&est, &params);
+    controller_set_setpoint(&controller, controller_celsius_to_units(opt.setpoint));
+    controller_set_mode(&controller, CONTROL_MODE_AUTO);
+
+    profile_t profile = { 0 };
+    if (opt.segment_count > 0) {
+        profile_load(&profile, opt.segments, opt.segment_count, SIM_MAX_SETPOINT);
+        profile_start(&profile, controller_celsius_to_units(PLANT_AMBIENT_C));
+    }
+    float setpoint = opt.setpoint;
+
+    autotune_t tuner = { 0 };
+    if (opt.autotune) {
+        autotune_config_t tune_config = AUTOTUNE_CONFIG_DEFAULT();
+        tune_config.target = opt.setpoint;
+        tune_config.rule = opt.autotune_rule;
+        if (autotune_start(&tuner, &tune_config, SIM_MAX_SETPOINT) != ESP_OK) {
+            fprintf(stderr, "invalid autotune setpoint\n");
+            return 1;
+        }
+    }
+    modbus_server_t modbus;
+    sim_modbus_t modbus_view = {
+        .controller = &controller,
+        .heater = &heater,
+        .setpoint = &setpoint,
+    };
+    if (opt.modbus_port != 0) {
+        const modbus_ops_t ops = {
+            .read_state = modbus_read_state,
+            .write = modbus_write,
+            .ctx = &modbus_view,
+        };
+        if (modbus_server_open(&modbus, opt.modbus_port, &ops) != ESP_OK) {
+            perror("modbus");
+            return 1;
+        }
+        printf("modbus:         serving port %u, running in real time\n", opt.modbus_port);
+        fflush(stdout);
+    }
+
+    const uint64_t period_us = (uint64_t)opt.period_ms * 1000;
+    const uint64_t ticks = (uint64_t)(opt.hours * 3600.0 * 1000.0 / opt.period_ms);
+    const uint64_t udp_every = (opt.period_ms < SIM_UDP_INTERVAL_MS) ? SIM_UDP_INTERVAL_MS / opt.period_ms : 1;
+    const uint64_t last_hour_start = ticks > 3600000 / opt.period_ms ? ticks - 3600000 / opt.period_ms : 0;
+
+    double abs_error_sum = 0.0;
+    uint64_t abs_error_count = 0;
+    float peak_c = 0.0f;
+    uint32_t faults = 0;
+
+    double wall_start = now_s();
+    for (uint64_t tick = 0; tick < ticks; tick++) {
+        hal_sensor_reading_t reading;
+        esp_err_t ret = hal_sensor_read(&sensor, &reading, 1);
+        if (ret == ESP_OK) {
+            ret = reading.status;
+        }
+
+        int32_t profile_setpoint;
+        if (profile_step(&profile, opt.period_ms, ret, reading.raw >> 3, &profile_setpoint)) {
+            controller_set_setpoint(&controller, profile_setpoint);
+            setpoint = (float)profile_setpoint / PID_FIXED_TEMP_PER_C;
+        }
+
+        float tune_output;
+        if (autotune_step(&tuner, opt.period_ms, ret, reading.temperature, &tune_output)) {
+            controller_set_manual(&controller, (uint32_t)(tune_output * heater.max_duty / 100.0f));
+            if (tuner.state == AUTOTUNE_STATE_DONE) {
+                controller_set_gains(&controller, tuner.result.kp, tuner.result.ki, tuner.result.kd);
+                controller_set_mode(&controller, CONTROL_MODE_AUTO);
+                printf("autotuned:      %.1f s, Ku %.3f %%/°C, Tu %.1f s, a %.2f°C\n",
+                       tuner.elapsed_ms / 1000.0, tuner.result.ku, tuner.result.tu_s, tuner.result.amplitude_c);
+                printf("                %s: Kp %.3f Ki %.5f Kd %.2f\n", autotune_rule_name(tuner.config.rule),
+                       tuner.result.kp, tuner.result.ki, tuner.result.kd);
+            } else if (tuner.state != AUTOTUNE_STATE_RUNNING) {
+                printf("autotune:       %s (%s)\n", autotune_state_name(tuner.state),
+                       autotune_failure_name(tuner.failure));
+            }
+        }
+
+        int32_t measurement = reading.raw >> 3;
+        if (opt.estimator && ret == ESP_OK) {
+            estimator_update(&est, reading.temperature, reading.timestamp_us);
+            measurement = controller_celsius_to_units(estimator_predict(&est, (int64_t)sim.plant.now_us));
+        }
+        telemetry_sample_t telemetry;
+        uint32_t duty = controller_step(&controller, ret, measurement, &telemetry);
+        estimator_set_duty(&est, (float)duty / (float)heater.max_duty);
+        if (ret == ESP_OK) {
+            if (reading.temperature > peak_c) {
+                peak_c = reading.temperature;
+            }
+            if (tick >= last_hour_start) {
+                abs_error_sum += fabsf(reading.temperature - setpoint);
+                abs_error_count++;
+            }
+        } else {
+            faults++;
+        }
+        hal_actuator_set_duty(&heater, 0, duty);
+
+        if (opt.modbus_port != 0) {
+            modbus_view.sensor_ok = (ret == ESP_OK);
+            if (ret == ESP_OK) {
+                modbus_view.temperature = reading.temperature;
+            }
+            modbus_view.estimate = (float)measurement / PID_FIXED_TEMP_PER_C;
+            modbus_view.ticks = (uint32_t)(tick + 1);
+        }
+
+        if (udp_sock >= 0) {
+            telemetry.duty = (uint16_t)((uint64_t)duty * TELEMETRY_DUTY_FULL_SCALE / heater.max_duty);
+            telemetry_push(&telemetry, (int64_t)sim.plant.now_us);
+            if ((tick + 1) % udp_every == 0) {
+                publish_udp(udp_sock, &udp_dest, &udp_stream, setpoint, opt.udp_loss_pct, &udp_sent, &udp_dropped);
+            }
+        }
+
+        if (csv != NULL && tick % opt.decimate == 0) {
+            fprintf(csv, "%.3f,%.2f,%.2f,%.3f,%.3f,%u\n",
+                    (double)sim.plant.now_us / 1e6, setpoint, reading.temperature,
+                    sim.plant.drum_c, sim.plant.wire_c, duty);
+        }
+
+        hal_sim_advance(&sim, period_us);
+        if (opt.modbus_port != 0) {
+            serve_modbus(&modbus, wall_start + (double)(tick + 1) * opt.period_ms / 1000.0);
+        }
+    }
+    double wall_s = now_s() - wall_start;
+    double sim_s = (double)sim.plant.now_us / 1e6;
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    if (udp_sock >= 0) {
+        publish_udp(udp_sock, &udp_dest, &udp_stream, setpoint, opt.udp_loss_pct, &udp_sent, &udp_dropped);
+        close(udp_sock);
+    }
+
+    if (opt.modbus_port != 0) {
+        modbus_server_close(&modbus);
+    }
+
+    printf("simulated:      %.1f h (%llu ticks)\n", sim_s / 3600.0, (unsigned long long)ticks);
+    printf("wall time:      %.3f s (%.0fx real time)\n", wall_s, wall_s > 0 ? sim_s / wall_s : 0.0);
+    printf("final:          measured %.2f°C, drum %.2f°C, wire %.2f°C, duty %u\n",
+           (sim.plant.adc_register >> 3) * PLANT_ADC_LSB_C, sim.plant.drum_c, sim.plant.wire_c, sim.duty);
+    printf("peak measured:  %.2f°C (setpoint %.2f°C)\n", peak_c, setpoint);
+    printf("mean |error|:   %.3f°C over the last hour\n",
+           abs_error_count ? abs_error_sum / (double)abs_error_count : 0.0);
+    printf("energy:         %.1f Wh\n", sim.plant.energy_j / 3600.0);
+    printf("sensor faults:  %u\n", faults);
+    if (udp_sock >= 0) {
+        printf("udp telemetry:  %u datagrams sent, %u dropped on purpose\n", udp_sent, udp_dropped);
+    }
+    if (opt.modbus_port != 0) {
+        printf("modbus:         %u requests (%u exceptions, %u writes), %u connections (%u rejected, %u errors)\n",
+               modbus.stats.requests, modbus.stats.exceptions, modbus.stats.writes, modbus.stats.connections,
+               modbus.stats.rejected, modbus.stats.errors);
+    }
+    if (opt.segment_count > 0) {
+        profile_progress_t progress;
+        profile_get_progress(&profile, &progress);
+        printf("profile:        %s, segment %zu/%zu, %.1f s elapsed, %.1f s holdback\n",
+               profile_state_name(progress.state), progress.segment + 1, progress.segment_count,
+               progress.elapsed_s, progress.holdback_s);
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Flight Recorder Decoder (host)
+ *
+ * Turns a dump of the flight recorder (GET /api/recorder, or the raw
+ * "recorder" partition read with esptool.py read_flash) into CSV, one row
+ * per record, oldest first:
+ *
+ *   boot,time_ms,record,temperature,setpoint,duty,p,i,d,fault,mode,flags,event,value
+ *
+ * time_ms is the uptime of that boot. Sample rows leave event/value
+ * empty, event rows leave the sample columns empty. Sectors that are
+ * erased or not in the recorder format are skipped, so a whole partition
+ * image decodes as well as a download.
+ *
+ * Usage: recorder_decode [dump.bin] > run.csv    (stdin without an argument)
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "recorder.h"
+#include "telemetry.h"
+
+typedef struct {
+    recorder_sector_t header;
+    uint8_t data[RECORDER_SECTOR_SIZE];
+} sector_t;
+
+// Indexed by recorder_event_t
+static const char *const s_event_names[RECORDER_EVENT_COUNT] = {
+    [RECORDER_EVENT_BOOT] = "boot",
+    [RECORDER_EVENT_MODE] = "mode",
+    [RECORDER_EVENT_SETPOINT] = "setpoint",
+    [RECORDER_EVENT_POWER] = "power",
+    [RECORDER_EVENT_SENSOR] = "sensor",
+    [RECORDER_EVENT_SPIKE] = "spike",
+    [RECORDER_EVENT_PROFILE] = "profile",
+    [RECORDER_EVENT_AUTOTUNE] = "autotune",
+    [RECORDER_EVENT_INTERLOCK] = "interlock",
+};
+
+static int compare_sequence(const void *a, const void *b)
+{
+    uint32_t sa = ((const sector_t *)a)->header.sequence;
+    uint32_t sb = ((const sector_t *)b)->header.sequence;
+    return (sa > sb) - (sa < sb);
+}
+
+static void print_q2(uint32_t q2)
+{
+    printf("%" PRIu32 ".%02" PRIu32, q2 / 4, (q2 % 4) * 25);
+}
+
+// Returns the number of records decoded
+static long decode_sector(const sector_t *sector)
+{
+    const uint8_t *p = sector->data + sizeof(recorder_sector_t);
+    const uint8_t *end = sector->data + RECORDER_SECTOR_SIZE;
+    long records = 0;
+
+    while (p + sizeof(uint32_t) <= end) {
+        uint32_t header;
+        memcpy(&header, p, sizeof(header));
+        unsigned type = header & 0x0F;
+        size_t size = ((header >> 4) & 0x0F) * sizeof(uint32_t);
+        uint32_t time_ms = sector->header.base_ms + (header >> 8);
+        if (type == RECORDER_RECORD_ERASED || p + sizeof(header) + size > end) {
+            break;
+        }
+        const uint8_t *payload = p + sizeof(header);
+        p += sizeof(header) + size;
+
+        if (type == RECORDER_RECORD_SAMPLE && size >= sizeof(recorder_sample_t)) {
+            recorder_sample_t record;
+            telemetry_sample_t sample;
+            memcpy(&record, payload, sizeof(record));
+            telemetry_unpack(record.telemetry, &sample);
+
+            printf("%u,%" PRIu32 ",sample,", (unsigned)sector->header.boot, time_ms);
+            print_q2(sample.temp_q2);
+            putchar(',');
+            print_q2(record.setpoint_q2);
+            printf(",%u,%d,%d,%d,%d,%u,%u,,\n", sample.duty, sample.p_term, sample.i_term, sample.d_term,
+                   sample.fault, record.mode, record.flags);
+        } else if (type == RECORDER_RECORD_EVENT && size >= sizeof(recorder_event_record_t)) {
+            recorder_event_record_t event;
+            memcpy(&event, payload, sizeof(event));
+            const char *name = (event.event < RECORDER_EVENT_COUNT && s_event_names[event.event] != NULL)
+                             ? s_event_names[event.event] : "unknown";
+
+            printf("%u,%" PRIu32 ",event,,,,,,,,,,%s,%g\n", (unsigned)sector->header.boot, time_ms,
+                   name, event.value);
+        } else {
+            continue;  // Newer record type: skipped by its length
+        }
+        records++;
+    }
+    return records;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *in = (argc > 1) ? fopen(argv[1], "rb") : stdin;
+    if (in == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    size_t count = 0;
+    size_t capacity = 0;
+    sector_t *sectors = NULL;
+    uint8_t raw[RECORDER_SECTOR_SIZE];
+    size_t skipped = 0;
+
+    while (fread(raw, 1, sizeof(raw), in) == sizeof(raw)) {
+        recorder_sector_t header;
+        memcpy(&header, raw, sizeof(header));
+        if (header.magic != RECORDER_MAGIC || header.version != RECORDER_FORMAT_VERSION) {
+            skipped++;
+            continue;
+        }
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            sectors = realloc(sectors, capacity * sizeof(*sectors));
+            if (sectors == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                return 1;
+            }
+        }
+        sectors[count].header = header;
+        memcpy(sectors[count].data, raw, sizeof(raw));
+        count++;
+    }
+    if (in != stdin) {
+        fclose(in);
+    }
+
+    // A partition image starts anywhere in the ring
+    qsort(sectors, count, sizeof(*sectors), compare_sequence);
+
+    printf("boot,time_ms,record,temperature,setpoint,duty,p,i,d,fault,mode,flags,event,value\n");
+    long records = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (i > 0 && sectors[i].header.sequence != sectors[i - 1].header.sequence + 1) {
+            fprintf(stderr, "Gap before sector %" PRIu32 "\n", sectors[i].header.sequence);
+        }
+        records += decode_sector(&sectors[i]);
+    }
+
+    fprintf(stderr, "%zu sectors, %zu skipped, %ld records\n", count, skipped, records);
+    free(sectors);
+    return 0;
+}
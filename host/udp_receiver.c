@@ -0,0 +1,316 @@
+/*
+ * UDP Telemetry Receiver (host)
+ *
+ * Listens for telemetry frames (main/telemetry_frame.h) from any number of
+ * controllers and writes every record to CSV, one row per control tick:
+ *
+ *   device,session,seq,time_ms,temperature,duty,p,i,d,fault,setpoint
+ *
+ * and optionally every valid datagram verbatim to a raw file (frames are
+ * self-describing, so the file can be replayed). Streams are told apart by
+ * device and session (a new session is a reboot). Per stream it reports
+ * datagrams lost in the network (datagram_seq gaps), records the
+ * controller's ring overwrote before it could send them (first_seq gaps
+ * between consecutive datagrams) and duplicate or late datagrams, which
+ * are dropped.
+ *
+ * Runs until interrupted, until --datagrams frames arrived or after
+ * --idle-s seconds without one; then prints the totals.
+ *
+ * Usage: udp_receiver [--port N] [--csv FILE] [--raw FILE] [--datagrams N] [--idle-s S]
+ *
+ * Local test against the simulator:
+ *   udp_receiver --port 5005 --csv run.csv --idle-s 2 &
+ *   plant_sim --hours 1 --udp 127.0.0.1:5005 --udp-loss 1
+ */
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "telemetry.h"
+#include "telemetry_frame.h"
+
+#define RECEIVER_DEFAULT_PORT  5005
+#define RECEIVER_MAX_STREAMS   64
+#define RECEIVER_RCVBUF        (4 * 1024 * 1024)
+
+typedef struct {
+    uint32_t device_id;
+    uint32_t session;
+    uint32_t next_datagram;     // Expected datagram_seq
+    uint32_t next_record;       // Expected first_seq
+    uint64_t datagrams;
+    uint64_t records;
+    uint64_t lost_datagrams;
+    uint64_t lost_records;      // Missing sequence numbers, in lost datagrams or not
+    uint64_t overwritten;       // Missing between consecutive datagrams: dropped by the ring
+    uint64_t duplicates;        // Late or repeated datagrams, dropped
+} stream_t;
+
+typedef struct {
+    uint16_t port;
+    const char *csv_path;
+    const char *raw_path;
+    uint64_t max_datagrams;
+    double idle_s;
+} receiver_options_t;
+
+static stream_t s_streams[RECEIVER_MAX_STREAMS];
+static size_t s_stream_count;
+static volatile sig_atomic_t s_stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    s_stop = 1;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--port N] [--csv FILE] [--raw FILE] [--datagrams N] [--idle-s S]\n", prog);
+}
+
+static int parse_options(int argc, char **argv, receiver_options_t *opt)
+{
+    static const struct option long_options[] = {
+        {"port", required_argument, NULL, 'p'},
+        {"csv", required_argument, NULL, 'c'},
+        {"raw", required_argument, NULL, 'r'},
+        {"datagrams", required_argument, NULL, 'n'},
+        {"idle-s", required_argument, NULL, 'i'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int c;
+    while ((c = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (c) {
+        case 'p': opt->port = (uint16_t)atoi(optarg); break;
+        case 'c': opt->csv_path = optarg; break;
+        case 'r': opt->raw_path = optarg; break;
+        case 'n': opt->max_datagrams = strtoull(optarg, NULL, 10); break;
+        case 'i': opt->idle_s = atof(optarg); break;
+        default: return -1;
+        }
+    }
+    return (opt->port != 0 && opt->idle_s >= 0.0) ? 0 : -1;
+}
+
+static bool frame_valid(const uint8_t *data, size_t len, const telemetry_frame_header_t *header)
+{
+    return len >= sizeof(*header) && header->magic == TELEMETRY_FRAME_MAGIC &&
+           header->version == TELEMETRY_FRAME_VERSION && header->header_size >= sizeof(*header) &&
+           header->count <= TELEMETRY_FRAME_MAX_RECORDS && len == telemetry_frame_size(header);
+}
+
+static stream_t *find_stream(const telemetry_frame_header_t *header, bool *is_new)
+{
+    for (size_t i = 0; i < s_stream_count; i++) {
+        if (s_streams[i].device_id == header->device_id && s_streams[i].session == header->session) {
+            *is_new = false;
+            return &s_streams[i];
+        }
+    }
+    if (s_stream_count == RECEIVER_MAX_STREAMS) {
+        return NULL;
+    }
+
+    stream_t *stream = &s_streams[s_stream_count++];
+    *stream = (stream_t) {
+        .device_id = header->device_id,
+        .session = header->session,
+        .next_datagram = header->datagram_seq,
+        .next_record = header->first_seq,
+    };
+    *is_new = true;
+    return stream;
+}
+
+// Checks the frame against its stream; returns false for a frame to drop
+static bool track(stream_t *stream, const telemetry_frame_header_t *header)
+{
+    int32_t datagram_gap = (int32_t)(header->datagram_seq - stream->next_datagram);
+    if (datagram_gap < 0) {
+        stream->duplicates++;
+        return false;
+    }
+
+    int32_t record_gap = (int32_t)(header->first_seq - stream->next_record);
+    if (datagram_gap > 0) {
+        stream->lost_datagrams += (uint32_t)datagram_gap;
+        fprintf(stderr, "%08" PRIx32 "/%08" PRIx32 ": %" PRId32 " datagram(s) lost before #%" PRIu32 "\n",
+                stream->device_id, stream->session, datagram_gap, header->datagram_seq);
+    }
+    if (record_gap > 0) {
+        stream->lost_records += (uint32_t)record_gap;
+        if (datagram_gap == 0) {
+            stream->overwritten += (uint32_t)record_gap;
+            fprintf(stderr, "%08" PRIx32 "/%08" PRIx32 ": %" PRId32 " record(s) overwritten on the controller\n",
+                    stream->device_id, stream->session, record_gap);
+        }
+    }
+
+    stream->next_datagram = header->datagram_seq + 1;
+    stream->next_record = header->first_seq + header->count;
+    stream->datagrams++;
+    stream->records += header->count;
+    return true;
+}
+
+static void write_csv(FILE *csv, const telemetry_frame_header_t *header, const telemetry_record_t *records)
+{
+    telemetry_sample_t samples[TELEMETRY_FRAME_MAX_RECORDS];
+    for (size_t i = 0; i < header->count; i++) {
+        telemetry_unpack(records[i], &samples[i]);
+    }
+
+    // timestamp_ms is the last record's; earlier ones go back by each record's interval
+    uint32_t time_ms = header->timestamp_ms;
+    uint32_t times[TELEMETRY_FRAME_MAX_RECORDS];
+    for (size_t i = header->count; i-- > 0;) {
+        times[i] = time_ms;
+        time_ms -= samples[i].dt_ms;
+    }
+
+    for (size_t i = 0; i < header->count; i++) {
+        const telemetry_sample_t *s = &samples[i];
+        fprintf(csv, "%08" PRIx32 ",%08" PRIx32 ",%" PRIu32 ",%" PRIu32 ",%u.%02u,%u,%d,%d,%d,%d,%u.%02u\n",
+                header->device_id, header->session, header->first_seq + (uint32_t)i, times[i],
+                s->temp_q2 / 4, (s->temp_q2 % 4) * 25, s->duty, s->p_term, s->i_term, s->d_term, s->fault,
+                header->setpoint_q2 / 4, (header->setpoint_q2 % 4) * 25);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    receiver_options_t opt = {
+        .port = RECEIVER_DEFAULT_PORT,
+    };
+    if (parse_options(argc, argv, &opt) != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        perror("socket");
+        return 1;
+    }
+    int rcvbuf = RECEIVER_RCVBUF;
+    setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(opt.port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    if (opt.idle_s > 0.0) {
+        struct timeval timeout = {
+            .tv_sec = (time_t)opt.idle_s,
+            .tv_usec = (suseconds_t)((opt.idle_s - (double)(time_t)opt.idle_s) * 1e6),
+        };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    }
+
+    FILE *csv = NULL;
+    if (opt.csv_path != NULL) {
+        csv = fopen(opt.csv_path, "w");
+        if (csv == NULL) {
+            perror(opt.csv_path);
+            return 1;
+        }
+        fprintf(csv, "device,session,seq,time_ms,temperature,duty,p,i,d,fault,setpoint\n");
+    }
+    FILE *raw = NULL;
+    if (opt.raw_path != NULL) {
+        raw = fopen(opt.raw_path, "wb");
+        if (raw == NULL) {
+            perror(opt.raw_path);
+            return 1;
+        }
+    }
+
+    // No SA_RESTART: a signal ends the blocking receive
+    struct sigaction action = { .sa_handler = on_signal };
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    fprintf(stderr, "listening on UDP port %u\n", opt.port);
+
+    static telemetry_frame_t frame;
+    uint64_t total = 0;
+    uint64_t invalid = 0;
+    while (!s_stop && (opt.max_datagrams == 0 || total < opt.max_datagrams)) {
+        ssize_t len = recv(sock, &frame, sizeof(frame), 0);
+        if (len < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;  // Idle timeout
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("recv");
+            break;
+        }
+        if (!frame_valid((const uint8_t *)&frame, (size_t)len, &frame.header)) {
+            invalid++;
+            continue;
+        }
+        total++;
+
+        bool is_new;
+        stream_t *stream = find_stream(&frame.header, &is_new);
+        if (stream == NULL) {
+            invalid++;
+            continue;
+        }
+        if (is_new) {
+            fprintf(stderr, "%08" PRIx32 "/%08" PRIx32 ": new stream at record %" PRIu32 "\n",
+                    frame.header.device_id, frame.header.session, frame.header.first_seq);
+        }
+        if (!track(stream, &frame.header)) {
+            continue;
+        }
+
+        const telemetry_record_t *records = (const telemetry_record_t *)((const uint8_t *)&frame +
+                                                                         frame.header.header_size);
+        if (csv != NULL) {
+            write_csv(csv, &frame.header, records);
+        }
+        if (raw != NULL) {
+            fwrite(&frame, 1, (size_t)len, raw);
+        }
+    }
+
+    if (csv != NULL) {
+        fclose(csv);
+    }
+    if (raw != NULL) {
+        fclose(raw);
+    }
+    close(sock);
+
+    printf("device   session  datagrams lost_dgram records lost_rec overwritten duplicates\n");
+    for (size_t i = 0; i < s_stream_count; i++) {
+        const stream_t *s = &s_streams[i];
+        printf("%08" PRIx32 " %08" PRIx32 " %9" PRIu64 " %10" PRIu64 " %7" PRIu64 " %8" PRIu64 " %11" PRIu64
+               " %10" PRIu64 "\n", s->device_id, s->session, s->datagrams, s->lost_datagrams, s->records,
+               s->lost_records, s->overwritten, s->duplicates);
+    }
+    if (invalid > 0) {
+        printf("%" PRIu64 " invalid datagram(s) ignored\n", invalid);
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+/*
+ * Relay-Feedback PID Autotuner Implementation
+ */
+
+#include <math.h>
+#include <string.h>
+#include "autotune.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Kp = kp * Ku, Ti = ti * Tu, Td = td * Tu
+typedef struct {
+    const char *name;
+    float kp;
+    float ti;
+    float td;
+} autotune_rule_def_t;
+
+static const autotune_rule_def_t s_rules[AUTOTUNE_RULE_COUNT] = {
+    [AUTOTUNE_RULE_ZN_PID]         = { "zn_pid",         0.60f,  0.50f,  0.125f },
+    [AUTOTUNE_RULE_ZN_PI]          = { "zn_pi",          0.45f,  0.833f, 0.0f   },
+    [AUTOTUNE_RULE_TYREUS_LUYBEN]  = { "tyreus_luyben",  0.4545f, 2.2f,  0.1587f },
+    [AUTOTUNE_RULE_SOME_OVERSHOOT] = { "some_overshoot", 0.33f,  0.50f,  0.333f },
+    [AUTOTUNE_RULE_NO_OVERSHOOT]   = { "no_overshoot",   0.20f,  0.50f,  0.333f },
+};
+
+esp_err_t autotune_validate(const autotune_config_t *config, float max_setpoint)
+{
+    if (config == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Written as !(in range) so NaN is rejected too
+    float max_temp = (config->max_temp > 0.0f) ? config->max_temp : config->target + AUTOTUNE_DEFAULT_MARGIN;
+    if (!(config->target > 0.0f && config->target <= max_setpoint) ||
+        !(config->amplitude > 0.0f && config->bias - config->amplitude >= 0.0f &&
+          config->bias + config->amplitude <= 100.0f) ||
+        !(config->hysteresis >= 0.0f && config->hysteresis < 10.0f) ||
+        !(max_temp > config->target + config->hysteresis) ||
+        config->cycles == 0 || config->cycles > AUTOTUNE_MAX_CYCLES ||
+        config->timeout_s == 0 || config->rule >= AUTOTUNE_RULE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t autotune_start(autotune_t *tuner, const autotune_config_t *config, float max_setpoint)
+{
+    if (tuner == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = autotune_validate(config, max_setpoint);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    memset(tuner, 0, sizeof(*tuner));
+    tuner->config = *config;
+    if (tuner->config.max_temp <= 0.0f) {
+        tuner->config.max_temp = config->target + AUTOTUNE_DEFAULT_MARGIN;
+    }
+    tuner->state = AUTOTUNE_STATE_RUNNING;
+    return ESP_OK;
+}
+
+void autotune_abort(autotune_t *tuner)
+{
+    if (autotune_is_running(tuner)) {
+        tuner->state = AUTOTUNE_STATE_ABORTED;
+        tuner->output = 0.0f;
+    }
+}
+
+bool autotune_is_running(const autotune_t *tuner)
+{
+    return tuner != NULL && tuner->state == AUTOTUNE_STATE_RUNNING;
+}
+
+static void fail(autotune_t *tuner, autotune_failure_t failure)
+{
+    tuner->state = AUTOTUNE_STATE_FAILED;
+    tuner->failure = failure;
+    tuner->output = 0.0f;
+}
+
+// Called on every low -> high switch; a full cycle lies between two of them
+static void finish_cycle(autotune_t *tuner)
+{
+    tuner->rises++;
+    if (tuner->rises >= 3) {
+        // Rise 1 starts the first cycle, which still carries the approach transient
+        tuner->period_sum_s += (tuner->elapsed_ms - tuner->last_rise_ms) / 1000.0;
+        tuner->amplitude_sum_c += (tuner->cycle_max - tuner->cycle_min) / 2.0;
+        tuner->cycles++;
+    }
+    tuner->last_rise_ms = tuner->elapsed_ms;
+    tuner->cycle_max = -INFINITY;
+    tuner->cycle_min = INFINITY;
+
+    if (tuner->cycles < tuner->config.cycles) {
+        return;
+    }
+
+    const float a = (float)(tuner->amplitude_sum_c / tuner->cycles);
+    const float eps = tuner->config.hysteresis;
+    if (a <= eps) {
+        fail(tuner, AUTOTUNE_FAIL_NO_OSCILLATION);
+        return;
+    }
+
+    float ku = (float)(4.0 * tuner->config.amplitude / (M_PI * sqrtf(a * a - eps * eps)));
+    float tu_s = (float)(tuner->period_sum_s / tuner->cycles);
+    autotune_compute_gains(tuner->config.rule, ku, tu_s, &tuner->result);
+    tuner->result.amplitude_c = a;
+    tuner->state = AUTOTUNE_STATE_DONE;
+    tuner->output = 0.0f;
+}
+
+bool autotune_step(autotune_t *tuner, uint32_t dt_ms, esp_err_t sensor_status, float temperature,
+                   float *output)
+{
+    if (!autotune_is_running(tuner)) {
+        return false;
+    }
+
+    const autotune_config_t *cfg = &tuner->config;
+    tuner->elapsed_ms += dt_ms;
+
+    if (sensor_status != ESP_OK) {
+        fail(tuner, AUTOTUNE_FAIL_SENSOR);
+    } else if (temperature > cfg->max_temp) {
+        fail(tuner, AUTOTUNE_FAIL_OVER_TEMPERATURE);
+    } else if (tuner->elapsed_ms > (uint64_t)cfg->timeout_s * 1000) {
+        fail(tuner, AUTOTUNE_FAIL_TIMEOUT);
+    } else {
+        if (!tuner->primed) {
+            tuner->primed = true;
+            tuner->output_high = (temperature < cfg->target);
+            tuner->cycle_max = -INFINITY;
+            tuner->cycle_min = INFINITY;
+        }
+
+        if (temperature > tuner->cycle_max) {
+            tuner->cycle_max = temperature;
+        }
+        if (temperature < tuner->cycle_min) {
+            tuner->cycle_min = temperature;
+        }
+
+        if (tuner->output_high && temperature > cfg->target + cfg->hysteresis) {
+            tuner->output_high = false;
+        } else if (!tuner->output_high && temperature < cfg->target - cfg->hysteresis) {
+            tuner->output_high = true;
+            finish_cycle(tuner);
+        }
+
+        if (tuner->state == AUTOTUNE_STATE_RUNNING) {
+            tuner->output = tuner->output_high ? cfg->bias + cfg->amplitude : cfg->bias - cfg->amplitude;
+        }
+    }
+
+    if (output != NULL) {
+        *output = tuner->output;
+    }
+    return true;
+}
+
+void autotune_get_progress(const autotune_t *tuner, autotune_progress_t *progress)
+{
+    if (tuner == NULL || progress == NULL) {
+        return;
+    }
+
+    *progress = (autotune_progress_t) {
+        .state = tuner->state,
+        .failure = tuner->failure,
+        .rule = tuner->config.rule,
+        .target = tuner->config.target,
+        .output = tuner->output,
+        .cycles = tuner->cycles,
+        .cycles_needed = tuner->config.cycles,
+        .elapsed_s = tuner->elapsed_ms / 1000.0f,
+        .result = tuner->result,
+    };
+}
+
+// Members of the progress object shared by GET /api/autotune and the live stream
+void autotune_progress_to_json(json_writer_t *w, const autotune_progress_t *progress)
+{
+    json_kv_str(w, "state", autotune_state_name(progress->state));
+    if (progress->state == AUTOTUNE_STATE_IDLE) {
+        return;
+    }
+
+    json_kv_str(w, "rule", autotune_rule_name(progress->rule));
+    json_kv_fixed(w, "target", progress->target, 2);
+    json_kv_fixed(w, "output", progress->output, 1);
+    json_kv_uint(w, "cycles", progress->cycles);
+    json_kv_uint(w, "cycles_needed", progress->cycles_needed);
+    json_kv_fixed(w, "elapsed_s", progress->elapsed_s, 1);
+    if (progress->state == AUTOTUNE_STATE_FAILED) {
+        json_kv_str(w, "failure", autotune_failure_name(progress->failure));
+    } else if (progress->state == AUTOTUNE_STATE_DONE) {
+        json_kv_fixed(w, "ku", progress->result.ku, 4);
+        json_kv_fixed(w, "tu_s", progress->result.tu_s, 2);
+        json_kv_fixed(w, "amplitude_c", progress->result.amplitude_c, 2);
+        json_kv_fixed(w, "kp", progress->result.kp, 4);
+        json_kv_fixed(w, "ki", progress->result.ki, 5);
+        json_kv_fixed(w, "kd", progress->result.kd, 4);
+    }
+}
+
+void autotune_compute_gains(autotune_rule_t rule, float ku, float tu_s, autotune_result_t *result)
+{
+    if (result == NULL || rule >= AUTOTUNE_RULE_COUNT || tu_s <= 0.0f) {
+        return;
+    }
+
+    const autotune_rule_def_t *def = &s_rules[rule];
+    float kp = def->kp * ku;
+    float ti = def->ti * tu_s;
+    float td = def->td * tu_s;
+
+    result->ku = ku;
+    result->tu_s = tu_s;
+    result->kp = kp;
+    result->ki = kp / ti;
+    result->kd = kp * td;
+}
+
+const char *autotune_state_name(autotune_state_t state)
+{
+    switch (state) {
+    case AUTOTUNE_STATE_RUNNING: return "running";
+    case AUTOTUNE_STATE_DONE:    return "done";
+    case AUTOTUNE_STATE_FAILED:  return "failed";
+    case AUTOTUNE_STATE_ABORTED: return "aborted";
+    default:                     return "idle";
+    }
+}
+
+const char *autotune_failure_name(autotune_failure_t failure)
+{
+    switch (failure) {
+    case AUTOTUNE_FAIL_SENSOR:           return "sensor_fault";
+    case AUTOTUNE_FAIL_OVER_TEMPERATURE: return "over_temperature";
+    case AUTOTUNE_FAIL_TIMEOUT:          return "timeout";
+    case AUTOTUNE_FAIL_NO_OSCILLATION:   return "no_oscillation";
+    default:                             return "none";
+    }
+}
+
+const char *autotune_rule_name(autotune_rule_t rule)
+{
+    return (rule < AUTOTUNE_RULE_COUNT) ? s_rules[rule].name : "unknown";
+}
+
+esp_err_t autotune_rule_from_name(const char *name, autotune_rule_t *rule)
+{
+    if (name == NULL || rule == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < AUTOTUNE_RULE_COUNT; i++) {
+        if (strcmp(name, s_rules[i].name) == 0) {
+            *rule = (autotune_rule_t)i;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
@@ -0,0 +1,144 @@
+/*
+ * Relay-Feedback PID Autotuner
+ *
+ * Åström-Hägglund relay experiment: the output switches between
+ * bias + amplitude and bias - amplitude whenever the temperature crosses
+ * the target by more than the hysteresis. The loop settles into a limit
+ * cycle whose period is the ultimate period Tu and whose amplitude a gives
+ * the ultimate gain Ku = 4d / (pi * sqrt(a^2 - eps^2)). PID gains follow
+ * from Ku/Tu through the selected tuning rule.
+ *
+ * The first cycle is discarded as the approach transient; the next
+ * `cycles` are averaged. Any sensor fault, a temperature above max_temp or
+ * the timeout stops the experiment with the output at zero.
+ *
+ * Units match the controller: output in %, temperature in °C, gains in
+ * %/°C (Ki per second, Kd in seconds). No RTOS dependencies: also built
+ * on the host.
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "json_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AUTOTUNE_MAX_CYCLES          10
+#define AUTOTUNE_DEFAULT_BIAS        50.0f   // %
+#define AUTOTUNE_DEFAULT_AMPLITUDE   50.0f   // %, relay swings bias +/- amplitude
+#define AUTOTUNE_DEFAULT_HYSTERESIS  0.5f    // °C, two MAX6675 LSBs
+#define AUTOTUNE_DEFAULT_MARGIN      30.0f   // °C above target before aborting
+#define AUTOTUNE_DEFAULT_CYCLES      4
+#define AUTOTUNE_DEFAULT_TIMEOUT_S   (3 * 3600)
+
+typedef enum {
+    AUTOTUNE_RULE_ZN_PID = 0,         // Ziegler-Nichols classic, fast with overshoot
+    AUTOTUNE_RULE_ZN_PI,
+    AUTOTUNE_RULE_TYREUS_LUYBEN,      // Less aggressive, suits lagging thermal loads
+    AUTOTUNE_RULE_SOME_OVERSHOOT,
+    AUTOTUNE_RULE_NO_OVERSHOOT,
+    AUTOTUNE_RULE_COUNT,
+} autotune_rule_t;
+
+typedef enum {
+    AUTOTUNE_STATE_IDLE = 0,
+    AUTOTUNE_STATE_RUNNING,
+    AUTOTUNE_STATE_DONE,
+    AUTOTUNE_STATE_FAILED,
+    AUTOTUNE_STATE_ABORTED,
+} autotune_state_t;
+
+typedef enum {
+    AUTOTUNE_FAIL_NONE = 0,
+    AUTOTUNE_FAIL_SENSOR,             // Thermocouple fault or stale reading
+    AUTOTUNE_FAIL_OVER_TEMPERATURE,
+    AUTOTUNE_FAIL_TIMEOUT,
+    AUTOTUNE_FAIL_NO_OSCILLATION,     // Amplitude not above the hysteresis
+} autotune_failure_t;
+
+typedef struct {
+    float target;             // °C, centre of the oscillation
+    float bias;               // %
+    float amplitude;          // %
+    float hysteresis;         // °C
+    float max_temp;           // °C, 0: target + AUTOTUNE_DEFAULT_MARGIN
+    uint32_t cycles;          // Cycles averaged after the discarded first one
+    uint32_t timeout_s;
+    autotune_rule_t rule;
+} autotune_config_t;
+
+#define AUTOTUNE_CONFIG_DEFAULT() {                 \
+    .bias = AUTOTUNE_DEFAULT_BIAS,                  \
+    .amplitude = AUTOTUNE_DEFAULT_AMPLITUDE,        \
+    .hysteresis = AUTOTUNE_DEFAULT_HYSTERESIS,      \
+    .cycles = AUTOTUNE_DEFAULT_CYCLES,              \
+    .timeout_s = AUTOTUNE_DEFAULT_TIMEOUT_S,        \
+    .rule = AUTOTUNE_RULE_TYREUS_LUYBEN,            \
+}
+
+typedef struct {
+    float ku;                 // %/°C
+    float tu_s;
+    float amplitude_c;        // Mean half peak-to-peak of the measurement
+    float kp;
+    float ki;
+    float kd;
+} autotune_result_t;
+
+// Autotuner State
+typedef struct {
+    autotune_config_t config;
+    autotune_state_t state;
+    autotune_failure_t failure;
+    bool primed;              // First reading seen, relay direction chosen
+    bool output_high;
+    uint32_t rises;           // Low -> high relay switches so far
+    uint32_t cycles;          // Cycles measured (after the discarded one)
+    uint64_t elapsed_ms;
+    uint64_t last_rise_ms;
+    float cycle_max;
+    float cycle_min;
+    double period_sum_s;
+    double amplitude_sum_c;
+    float output;             // % requested this tick
+    autotune_result_t result;
+} autotune_t;
+
+typedef struct {
+    autotune_state_t state;
+    autotune_failure_t failure;
+    autotune_rule_t rule;
+    float target;             // °C
+    float output;             // % requested by the relay
+    uint32_t cycles;          // Cycles measured so far
+    uint32_t cycles_needed;
+    float elapsed_s;
+    autotune_result_t result; // Valid in AUTOTUNE_STATE_DONE
+} autotune_progress_t;
+
+// Function prototypes
+esp_err_t autotune_validate(const autotune_config_t *config, float max_setpoint);
+esp_err_t autotune_start(autotune_t *tuner, const autotune_config_t *config, float max_setpoint);
+void autotune_abort(autotune_t *tuner);
+bool autotune_is_running(const autotune_t *tuner);
+bool autotune_step(autotune_t *tuner, uint32_t dt_ms, esp_err_t sensor_status, float temperature,
+                   float *output);
+void autotune_get_progress(const autotune_t *tuner, autotune_progress_t *progress);
+void autotune_progress_to_json(json_writer_t *w, const autotune_progress_t *progress);
+void autotune_compute_gains(autotune_rule_t rule, float ku, float tu_s, autotune_result_t *result);
+const char *autotune_state_name(autotune_state_t state);
+const char *autotune_failure_name(autotune_failure_t failure);
+const char *autotune_rule_name(autotune_rule_t rule);
+esp_err_t autotune_rule_from_name(const char *name, autotune_rule_t *rule);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUTOTUNE_H
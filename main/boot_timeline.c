@@ -0,0 +1,68 @@
+/*
+ * Boot Timeline Implementation
+ */
+
+#include "boot_timeline.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static boot_timeline_t s_timeline;      // Protected by s_lock
+
+void boot_timeline_mark(boot_phase_t phase)
+{
+    if (phase >= BOOT_PHASE_COUNT) {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    if (s_timeline.phase_us[phase] == 0) {
+        s_timeline.phase_us[phase] = now_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_timeline_get(boot_timeline_t *timeline)
+{
+    if (timeline == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *timeline = s_timeline;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const char *boot_phase_name(boot_phase_t phase)
+{
+    switch (phase) {
+    case BOOT_PHASE_APP_MAIN:        return "app_main";
+    case BOOT_PHASE_HARDWARE:        return "hardware";
+    case BOOT_PHASE_SETTINGS:        return "settings";
+    case BOOT_PHASE_FIRST_SAMPLE:    return "first_sample";
+    case BOOT_PHASE_FIRST_TICK:      return "first_tick";
+    case BOOT_PHASE_WIFI_START:      return "wifi_start";
+    case BOOT_PHASE_HTTP:            return "http";
+    case BOOT_PHASE_WIFI_ASSOCIATED: return "wifi_associated";
+    case BOOT_PHASE_NETWORK:         return "network";
+    default:                         return "unknown";
+    }
+}
+
+const char *boot_reset_reason_name(esp_reset_reason_t reason)
+{
+    switch (reason) {
+    case ESP_RST_POWERON:   return "power_on";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "interrupt_watchdog";
+    case ESP_RST_TASK_WDT:  return "task_watchdog";
+    case ESP_RST_WDT:       return "watchdog";
+    case ESP_RST_DEEPSLEEP: return "deep_sleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    case ESP_RST_SDIO:      return "sdio";
+    default:                return "unknown";
+    }
+}
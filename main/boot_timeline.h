@@ -0,0 +1,48 @@
+/*
+ * Boot Timeline
+ *
+ * Time since boot at which each startup phase was first reached, so it is
+ * visible how soon sensing and control are up and how long the network
+ * took (GET /api/system). Each phase is recorded once; later marks of the
+ * same phase are ignored, so marking from a loop is cheap and harmless.
+ */
+
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_system.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    BOOT_PHASE_APP_MAIN = 0,        // app_main entered
+    BOOT_PHASE_HARDWARE,            // MAX6675 bus and heater PWM initialized
+    BOOT_PHASE_SETTINGS,            // Settings loaded from NVS
+    BOOT_PHASE_FIRST_SAMPLE,        // Sampler published its first reading
+    BOOT_PHASE_FIRST_TICK,          // Control task completed its first period
+    BOOT_PHASE_WIFI_START,          // WiFi driver started, connecting in the background
+    BOOT_PHASE_HTTP,                // REST server listening
+    BOOT_PHASE_WIFI_ASSOCIATED,     // First association with the AP
+    BOOT_PHASE_NETWORK,             // First IP address
+    BOOT_PHASE_COUNT,
+} boot_phase_t;
+
+typedef struct {
+    int64_t phase_us[BOOT_PHASE_COUNT];     // esp_timer time, 0 if not reached yet
+} boot_timeline_t;
+
+// Function prototypes
+void boot_timeline_mark(boot_phase_t phase);
+void boot_timeline_get(boot_timeline_t *timeline);
+const char *boot_phase_name(boot_phase_t phase);
+const char *boot_reset_reason_name(esp_reset_reason_t reason);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BOOT_TIMELINE_H
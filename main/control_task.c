@@ -0,0 +1,630 @@
+/*
+ * Temperature Control Task Implementation
+ */
+
+#include <inttypes.h>
+#include <math.h>
+#include "control_task.h"
+#include "temp_sampler.h"
+#include "telemetry.h"
+#include "recorder.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "boot_timeline.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "CONTROL";
+
+// Sharing a core, equal priorities would only time-slice the two tasks
+_Static_assert(TEMP_SAMPLER_PRIORITY > CONTROL_TASK_PRIORITY, "The sampler must preempt the control task");
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t s_state_lock = NULL;
+
+static const hal_actuator_t *s_heater = NULL;
+static uint32_t s_period_ms = CONTROL_TASK_PERIOD_MS;
+
+// Shared with the API, protected by s_state_lock. A mutex, not a spinlock: the
+// tick computes with interrupts enabled and can be preempted while it does
+static controller_t s_controller;
+static feedforward_t s_feedforward;
+static estimator_t s_estimator;
+static bool s_use_estimator;
+static int64_t s_estimator_sample_us;  // Reading last fed to the estimator
+static control_status_t s_status;
+static profile_t s_profile;
+static int64_t s_profile_clock_us;     // Time the profile has been advanced to
+static autotune_t s_autotune;
+static int64_t s_autotune_clock_us;
+static bool s_tuned_gains_pending;     // New gains not yet collected for storage
+
+// Copy of s_status for readers, protected by s_lock; only ever copied in or out
+static control_status_t s_published;
+
+// Takes the loop state; false before control_task_start()
+static bool lock_state(void)
+{
+    if (s_state_lock == NULL) {
+        return false;
+    }
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    return true;
+}
+
+// Publishes the status with the gains in use. Caller holds s_state_lock.
+static void publish_status(void)
+{
+    s_status.kp = s_controller.pid_config.kp;
+    s_status.ki = s_controller.pid_config.ki;
+    s_status.kd = s_controller.pid_config.kd;
+
+    portENTER_CRITICAL(&s_lock);
+    s_published = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Moves the profile on by the time actually elapsed, so overruns do not stretch it.
+// Caller holds s_state_lock; returns true when the profile changed state.
+static bool profile_tick(esp_err_t sensor_status, int32_t measurement, int64_t now_us)
+{
+    uint32_t dt_ms = (uint32_t)((now_us - s_profile_clock_us) / 1000);
+    s_profile_clock_us += (int64_t)dt_ms * 1000;
+
+    int32_t setpoint;
+    if (profile_step(&s_profile, dt_ms, sensor_status, measurement, &setpoint)) {
+        controller_set_setpoint(&s_controller, setpoint);
+        s_status.setpoint = (float)setpoint / PID_FIXED_TEMP_PER_C;
+    }
+
+    bool changed = (s_profile.state != s_status.profile);
+    s_status.profile = s_profile.state;
+    return changed;
+}
+
+// Caller holds s_state_lock; returns true if a profile was running
+static bool abort_profile_locked(void)
+{
+    if (!profile_is_active(&s_profile)) {
+        return false;
+    }
+    profile_abort(&s_profile);
+    s_status.profile = s_profile.state;
+    return true;
+}
+
+// Drives the relay experiment through manual output; on success the tuned gains take
+// over in automatic mode at the target. Caller holds s_state_lock; returns true on a state change.
+static bool autotune_tick(esp_err_t sensor_status, float temperature, int64_t now_us)
+{
+    uint32_t dt_ms = (uint32_t)((now_us - s_autotune_clock_us) / 1000);
+    s_autotune_clock_us += (int64_t)dt_ms * 1000;
+
+    float output;
+    if (!autotune_step(&s_autotune, dt_ms, sensor_status, temperature, &output)) {
+        return false;
+    }
+
+    controller_set_manual(&s_controller, hal_actuator_percent_to_duty(s_heater, output));
+    s_status.mode = CONTROL_MODE_MANUAL;
+
+    if (s_autotune.state == AUTOTUNE_STATE_DONE) {
+        const autotune_result_t *result = &s_autotune.result;
+        controller_set_gains(&s_controller, result->kp, result->ki, result->kd);
+        controller_set_setpoint(&s_controller, controller_celsius_to_units(s_autotune.config.target));
+        controller_set_mode(&s_controller, CONTROL_MODE_AUTO);
+        s_status.setpoint = s_autotune.config.target;
+        s_status.mode = CONTROL_MODE_AUTO;
+        s_tuned_gains_pending = true;
+    }
+
+    bool changed = (s_autotune.state != s_status.autotune);
+    s_status.autotune = s_autotune.state;
+    return changed;
+}
+
+// Caller holds s_state_lock; returns true if the relay experiment was running
+static bool abort_autotune_locked(void)
+{
+    if (!autotune_is_running(&s_autotune)) {
+        return false;
+    }
+    autotune_abort(&s_autotune);
+    controller_set_manual(&s_controller, 0);
+    s_status.mode = CONTROL_MODE_MANUAL;
+    s_status.autotune = s_autotune.state;
+    return true;
+}
+
+// Manual input overrides a running profile or autotune. Caller holds s_state_lock.
+static bool abort_overrides_locked(void)
+{
+    bool aborted = abort_profile_locked();
+    return abort_autotune_locked() || aborted;
+}
+
+static uint32_t control_step(telemetry_sample_t *telemetry, recorder_sample_t *record)
+{
+    temp_sample_t sample;
+    esp_err_t ret = temp_sampler_get_latest(&sample);
+    if (ret == ESP_OK) {
+        ret = sample.status;
+    }
+    const int64_t now_us = esp_timer_get_time();
+    if (ret == ESP_OK && now_us - sample.timestamp_us > CONTROL_SAMPLE_MAX_AGE_MS * 1000LL) {
+        ret = ESP_ERR_TIMEOUT;
+        metrics_count(METRICS_SENSOR_FAULT_STALE);
+    }
+
+    // Temperature in MAX6675 units (0.25°C), calibration offset included
+    int32_t measurement = controller_celsius_to_units(sample.temperature);
+
+    // Each conversion is fused once; the loop runs on the estimate for this instant
+    bool spike = false;
+    if (s_use_estimator && ret == ESP_OK) {
+        if (sample.timestamp_us != s_estimator_sample_us) {
+            s_estimator_sample_us = sample.timestamp_us;
+            spike = (estimator_update(&s_estimator, sample.temperature, sample.timestamp_us) ==
+                     ESP_ERR_INVALID_RESPONSE);
+        }
+        measurement = controller_celsius_to_units(estimator_predict(&s_estimator, now_us));
+    }
+    estimator_output_t estimate;
+    estimator_get(&s_estimator, &estimate);
+
+    xSemaphoreTake(s_state_lock, portMAX_DELAY);
+    bool profile_changed = profile_tick(ret, measurement, now_us);
+    size_t profile_segment = s_profile.segment;
+    size_t profile_count = s_profile.count;
+    bool autotune_changed = autotune_tick(ret, sample.temperature, now_us);
+    autotune_state_t tune_state = s_autotune.state;
+    autotune_failure_t tune_failure = s_autotune.failure;
+    autotune_result_t tune_result = s_autotune.result;
+    uint32_t duty = controller_step(&s_controller, ret, measurement, telemetry);
+
+    bool sensor_changed = (s_status.sensor_ok != (ret == ESP_OK));
+    s_status.sensor_ok = (ret == ESP_OK);
+    if (ret == ESP_OK) {
+        s_status.temperature = sample.temperature;
+    }
+    s_status.output = hal_actuator_duty_to_percent(s_heater, duty);
+    if (s_use_estimator && ret == ESP_OK) {
+        s_status.estimate = estimate.temperature;
+        s_status.rate = estimate.rate * 60.0f;
+    }
+    s_status.spike_count = s_estimator.spikes;
+    s_status.feedforward = hal_actuator_duty_to_percent(s_heater, (uint32_t)s_controller.ff_term);
+    profile_state_t profile_state = s_status.profile;
+    record->setpoint_q2 = (uint16_t)controller_celsius_to_units(s_status.setpoint);
+    record->mode = (uint8_t)s_status.mode;
+    record->flags = (profile_is_active(&s_profile) ? RECORDER_FLAG_PROFILE : 0) |
+                    (tune_state == AUTOTUNE_STATE_RUNNING ? RECORDER_FLAG_AUTOTUNE : 0);
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    if (s_use_estimator) {
+        estimator_set_duty(&s_estimator, (float)duty / (float)s_heater->max_duty);
+    }
+    if (sensor_changed) {
+        recorder_event(RECORDER_EVENT_SENSOR, (float)ret);
+    }
+    if (spike) {
+        recorder_event(RECORDER_EVENT_SPIKE, sample.temperature);
+        DLOGW(TAG, "Dropped temperature spike: %.2f°C, expected %.2f°C",
+              sample.temperature, estimate.temperature);
+    }
+    if (profile_changed) {
+        recorder_event(RECORDER_EVENT_PROFILE, (float)profile_state);
+        DLOGI(TAG, "Profile segment %u/%u: %s", (unsigned)profile_segment + 1,
+              (unsigned)profile_count, profile_state_name(profile_state));
+    }
+    if (autotune_changed) {
+        recorder_event(RECORDER_EVENT_AUTOTUNE, (float)tune_state);
+    }
+    if (autotune_changed && tune_state == AUTOTUNE_STATE_DONE) {
+        DLOGI(TAG, "Autotune done: Ku=%.3f Tu=%.1fs -> Kp=%.3f Ki=%.4f Kd=%.3f",
+              tune_result.ku, tune_result.tu_s, tune_result.kp, tune_result.ki, tune_result.kd);
+    } else if (autotune_changed) {
+        DLOGW(TAG, "Autotune %s: %s, output off", autotune_state_name(tune_state),
+              autotune_failure_name(tune_failure));
+    }
+
+    return duty;
+}
+
+static void control_task(void *arg)
+{
+    const TickType_t period_ticks = pdMS_TO_TICKS(s_period_ms);
+    const int64_t period_us = (int64_t)s_period_ms * 1000;
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t prev_start_us = 0;
+
+    ESP_LOGI(TAG, "Control task running on core %d, period %" PRIu32 " ms",
+             xPortGetCoreID(), s_period_ms);
+
+    while (s_running) {
+        int64_t start_us = esp_timer_get_time();
+        if (prev_start_us != 0) {
+            int64_t jitter_us = start_us - prev_start_us - period_us;
+            metrics_observe(METRICS_CONTROL_JITTER, (uint32_t)(jitter_us < 0 ? -jitter_us : jitter_us));
+        }
+        prev_start_us = start_us;
+
+        telemetry_sample_t telemetry;
+        recorder_sample_t record;
+        uint32_t duty = control_step(&telemetry, &record);
+        esp_err_t ret = hal_actuator_set_duty(s_heater, 0, duty);
+        if (ret != ESP_OK) {
+            DLOGE(TAG, "Failed to apply output: %s", esp_err_to_name(ret));
+        }
+
+        // Record what the actuator actually holds, on the telemetry scale
+        uint64_t applied = hal_actuator_get_duty(s_heater, 0);
+        telemetry.duty = (uint16_t)(applied * TELEMETRY_DUTY_FULL_SCALE / s_heater->max_duty);
+        telemetry_push(&telemetry, start_us);
+
+        // The recorder timestamps its records itself
+        telemetry.dt_ms = 0;
+        record.telemetry = telemetry_pack(&telemetry);
+        recorder_sample(&record);
+
+        uint32_t step_us = (uint32_t)(esp_timer_get_time() - start_us);
+        metrics_observe(METRICS_CONTROL_STEP, step_us);
+
+        // xTaskDelayUntil keeps the period anchored to last_wake so it does not drift
+        BaseType_t delayed = xTaskDelayUntil(&last_wake, period_ticks);
+
+        xSemaphoreTake(s_state_lock, portMAX_DELAY);
+        s_status.tick_count++;
+        s_status.last_step_us = step_us;
+        if (delayed == pdFALSE) {
+            s_status.overrun_count++;
+        }
+        bool first_tick = (s_status.tick_count == 1);
+        publish_status();
+        xSemaphoreGive(s_state_lock);
+
+        if (first_tick) {
+            boot_timeline_mark(BOOT_PHASE_FIRST_TICK);
+        }
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t control_task_start(const hal_actuator_t *heater, const control_config_t *config)
+{
+    if (heater == NULL || config == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (config->period_ms == 0) {
+        ESP_LOGE(TAG, "Control period must be greater than 0");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_task_handle != NULL) {
+        ESP_LOGW(TAG, "Control task already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (s_state_lock == NULL) {
+        s_state_lock = xSemaphoreCreateMutex();
+        if (s_state_lock == NULL) {
+            ESP_LOGE(TAG, "Failed to create state lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    s_heater = heater;
+    s_period_ms = config->period_ms;
+
+    pid_fixed_config_t pid_config = {
+        .kp = config->kp,
+        .ki = config->ki,
+        .kd = config->kd,
+        .derivative_filter_n = PID_FIXED_DEFAULT_N,
+        .period_ms = config->period_ms,
+        .full_scale = (int32_t)heater->max_duty,
+        .output_min = 0,
+        .output_max = (int32_t)heater->max_duty,
+    };
+    controller_init(&s_controller, &pid_config);
+    controller_set_setpoint(&s_controller, controller_celsius_to_units(config->setpoint));
+    // Same heater model as the host simulator; calibration and the estimator's
+    // loss state correct it for this fixture
+    const plant_params_t model = PLANT_PARAMS_DEFAULT();
+    if (config->feedforward) {
+        if (feedforward_init(&s_feedforward, &model, pid_config.full_scale) == ESP_OK) {
+            s_feedforward.calibrate = true;
+            controller_set_feedforward(&s_controller, &s_feedforward);
+        } else {
+            ESP_LOGW(TAG, "Feed-forward disabled: duty resolution too fine for the table");
+        }
+    }
+    s_use_estimator = config->estimator && estimator_init(&s_estimator, &model) == ESP_OK;
+    s_estimator_sample_us = 0;
+    s_status = (control_status_t) {
+        .mode = CONTROL_MODE_MANUAL,
+        .setpoint = config->setpoint,
+    };
+    s_profile.state = PROFILE_STATE_IDLE;
+    s_autotune.state = AUTOTUNE_STATE_IDLE;
+    publish_status();
+    s_running = true;
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? CONTROL_TASK_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(control_task, "control", CONTROL_TASK_STACK_SIZE,
+                                                 NULL, CONTROL_TASK_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create control task");
+        s_running = false;
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Control task started (Kp=%.3f Ki=%.3f Kd=%.3f, feed-forward %s, estimator %s)",
+             config->kp, config->ki, config->kd, s_controller.ff != NULL ? "on" : "off",
+             s_use_estimator ? "on" : "off");
+    return ESP_OK;
+}
+
+esp_err_t control_task_stop(void)
+{
+    if (s_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_running = false;
+    while (s_task_handle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(s_period_ms));
+    }
+
+    hal_actuator_stop(s_heater);
+    ESP_LOGI(TAG, "Control task stopped");
+    return ESP_OK;
+}
+
+esp_err_t control_task_set_mode(control_mode_t mode)
+{
+    if (mode != CONTROL_MODE_MANUAL && mode != CONTROL_MODE_AUTO) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool aborted = abort_autotune_locked();
+    aborted = ((mode == CONTROL_MODE_MANUAL) && abort_profile_locked()) || aborted;
+    controller_set_mode(&s_controller, mode);
+    s_status.mode = mode;
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    if (aborted) {
+        ESP_LOGI(TAG, "Profile/autotune aborted by mode change");
+    }
+    recorder_event(RECORDER_EVENT_MODE, (float)mode);
+    ESP_LOGI(TAG, "Mode set to %s", mode == CONTROL_MODE_AUTO ? "auto" : "manual");
+    return ESP_OK;
+}
+
+esp_err_t control_task_set_setpoint(float setpoint)
+{
+    if (setpoint < 0.0f || setpoint > CONTROL_MAX_SETPOINT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool aborted = abort_overrides_locked();
+    s_status.setpoint = setpoint;
+    controller_set_setpoint(&s_controller, controller_celsius_to_units(setpoint));
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    if (aborted) {
+        ESP_LOGI(TAG, "Profile/autotune aborted by setpoint change");
+    }
+    recorder_event(RECORDER_EVENT_SETPOINT, setpoint);
+    ESP_LOGI(TAG, "Setpoint set to %.2f°C", setpoint);
+    return ESP_OK;
+}
+
+esp_err_t control_task_set_manual_power(float power_percent)
+{
+    if (power_percent < 0.0f || power_percent > 100.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool aborted = abort_overrides_locked();
+    controller_set_manual(&s_controller, hal_actuator_percent_to_duty(s_heater, power_percent));
+    s_status.mode = CONTROL_MODE_MANUAL;
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    if (aborted) {
+        ESP_LOGI(TAG, "Profile/autotune aborted by manual power");
+    }
+    recorder_event(RECORDER_EVENT_POWER, power_percent);
+    return ESP_OK;
+}
+
+esp_err_t control_task_set_gains(float kp, float ki, float kd)
+{
+    if (!(kp >= 0.0f && ki >= 0.0f && kd >= 0.0f && isfinite(kp) && isfinite(ki) && isfinite(kd))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    controller_set_gains(&s_controller, kp, ki, kd);
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    ESP_LOGI(TAG, "Gains set to Kp=%.3f Ki=%.3f Kd=%.3f", kp, ki, kd);
+    return ESP_OK;
+}
+
+// Replaces any running profile and starts from the current temperature
+esp_err_t control_task_run_profile(const profile_segment_t *segments, size_t count)
+{
+    esp_err_t ret = profile_validate(segments, count, CONTROL_MAX_SETPOINT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    abort_autotune_locked();
+    profile_load(&s_profile, segments, count, CONTROL_MAX_SETPOINT);
+    float start = s_status.sensor_ok ? s_status.temperature : s_status.setpoint;
+    profile_start(&s_profile, controller_celsius_to_units(start));
+    s_profile_clock_us = esp_timer_get_time();
+    s_status.profile = s_profile.state;
+    controller_set_mode(&s_controller, CONTROL_MODE_AUTO);
+    s_status.mode = CONTROL_MODE_AUTO;
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    ESP_LOGI(TAG, "Profile started: %u segments from %.2f°C", (unsigned)count, start);
+    return ESP_OK;
+}
+
+esp_err_t control_task_abort_profile(void)
+{
+    esp_err_t ret = ESP_ERR_INVALID_STATE;
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (abort_profile_locked()) {
+        ret = ESP_OK;
+        publish_status();
+    }
+    xSemaphoreGive(s_state_lock);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Profile aborted");
+    }
+
+    return ret;
+}
+
+void control_task_get_profile(profile_progress_t *progress)
+{
+    if (progress == NULL) {
+        return;
+    }
+
+    if (!lock_state()) {
+        *progress = (profile_progress_t) { .state = PROFILE_STATE_IDLE };
+        return;
+    }
+    profile_get_progress(&s_profile, progress);
+    xSemaphoreGive(s_state_lock);
+}
+
+// Replaces any running profile; the heater is driven by the relay until the result is in
+esp_err_t control_task_start_autotune(const autotune_config_t *config)
+{
+    esp_err_t ret = autotune_validate(config, CONTROL_MAX_SETPOINT);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    abort_profile_locked();
+    autotune_start(&s_autotune, config, CONTROL_MAX_SETPOINT);
+    s_autotune_clock_us = esp_timer_get_time();
+    s_status.autotune = s_autotune.state;
+    float max_temp = s_autotune.config.max_temp;
+    publish_status();
+    xSemaphoreGive(s_state_lock);
+
+    ESP_LOGI(TAG, "Autotune started around %.2f°C: relay %.1f%% +/- %.1f%%, hysteresis %.2f°C, limit %.2f°C (%s)",
+             config->target, config->bias, config->amplitude, config->hysteresis,
+             max_temp, autotune_rule_name(config->rule));
+    return ESP_OK;
+}
+
+esp_err_t control_task_abort_autotune(void)
+{
+    if (!lock_state()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    bool aborted = abort_autotune_locked();
+    if (aborted) {
+        publish_status();
+    }
+    xSemaphoreGive(s_state_lock);
+
+    if (!aborted) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ESP_LOGI(TAG, "Autotune aborted, output off");
+    return ESP_OK;
+}
+
+void control_task_get_autotune(autotune_progress_t *progress)
+{
+    if (progress == NULL) {
+        return;
+    }
+
+    if (!lock_state()) {
+        *progress = (autotune_progress_t) { .state = AUTOTUNE_STATE_IDLE };
+        return;
+    }
+    autotune_get_progress(&s_autotune, progress);
+    xSemaphoreGive(s_state_lock);
+}
+
+// Hands the gains of a finished autotune to the caller once, for storage outside the loop
+bool control_task_take_tuned_gains(autotune_result_t *result)
+{
+    bool pending;
+
+    if (!lock_state()) {
+        return false;
+    }
+    pending = s_tuned_gains_pending;
+    if (pending && result != NULL) {
+        *result = s_autotune.result;
+    }
+    s_tuned_gains_pending = false;
+    xSemaphoreGive(s_state_lock);
+
+    return pending;
+}
+
+void control_task_get_status(control_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_published;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+bool control_task_is_running(void)
+{
+    return s_task_handle != NULL;
+}
@@ -0,0 +1,101 @@
+/*
+ * Temperature Control Task
+ *
+ * Runs the PID loop at a fixed period on a dedicated core, independent
+ * of the status loop in app_main and of WiFi/HTTP activity.
+ */
+
+#ifndef CONTROL_TASK_H
+#define CONTROL_TASK_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "hal_actuator.h"
+#include "controller.h"
+#include "profile.h"
+#include "autotune.h"
+#include "estimator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Task Configuration
+#define CONTROL_TASK_PERIOD_MS    250    // Matches the MAX6675 conversion time (~220 ms)
+#define CONTROL_TASK_STACK_SIZE   4096
+#define CONTROL_TASK_PRIORITY     (configMAX_PRIORITIES - 3)  // Below the sampler so it sees fresh data
+#define CONTROL_TASK_CORE         1      // WiFi and lwIP run on core 0
+#define CONTROL_SAMPLE_MAX_AGE_MS 1000   // Older samples are treated as a sensor failure
+
+// Default PID Gains (output in %, input in °C)
+#define CONTROL_DEFAULT_KP        2.0f
+#define CONTROL_DEFAULT_KI        0.02f
+#define CONTROL_DEFAULT_KD        5.0f
+#define CONTROL_DEFAULT_SETPOINT  25.0f
+#define CONTROL_MAX_SETPOINT      350.0f // Drum design temperature (CALCULOS_FIO_NICROMO.md)
+#define CONTROL_DEFAULT_FEEDFORWARD true // Model feed-forward, calibrated while settled
+#define CONTROL_DEFAULT_ESTIMATOR   true // PID runs on the state estimate, not raw readings
+
+typedef struct {
+    uint32_t period_ms;
+    float kp;
+    float ki;
+    float kd;
+    float setpoint;
+    bool feedforward;
+    bool estimator;
+} control_config_t;
+
+typedef struct {
+    control_mode_t mode;
+    float setpoint;          // °C
+    float temperature;       // Last valid measurement (°C)
+    float estimate;          // Estimated temperature now (°C), with the estimator on
+    float rate;              // Estimated rate of change (°C/min)
+    uint32_t spike_count;    // Readings dropped as spikes
+    float output;            // Applied power (%)
+    float feedforward;       // Feed-forward part of the output (%)
+    bool sensor_ok;          // False if the last read failed
+    uint32_t tick_count;     // Number of completed control periods
+    uint32_t overrun_count;  // Periods where the step took longer than the period
+    uint32_t last_step_us;   // Duration of the last control step
+    float kp;                // Gains in use, set or tuned
+    float ki;
+    float kd;
+    profile_state_t profile; // Setpoint profile, if one was started
+    autotune_state_t autotune;
+} control_status_t;
+
+#define CONTROL_CONFIG_DEFAULT() {              \
+    .period_ms = CONTROL_TASK_PERIOD_MS,        \
+    .kp = CONTROL_DEFAULT_KP,                   \
+    .ki = CONTROL_DEFAULT_KI,                   \
+    .kd = CONTROL_DEFAULT_KD,                   \
+    .setpoint = CONTROL_DEFAULT_SETPOINT,       \
+    .feedforward = CONTROL_DEFAULT_FEEDFORWARD, \
+    .estimator = CONTROL_DEFAULT_ESTIMATOR,     \
+}
+
+// Function prototypes
+esp_err_t control_task_start(const hal_actuator_t *heater, const control_config_t *config);
+esp_err_t control_task_stop(void);
+esp_err_t control_task_set_mode(control_mode_t mode);
+esp_err_t control_task_set_setpoint(float setpoint);
+esp_err_t control_task_set_manual_power(float power_percent);
+esp_err_t control_task_set_gains(float kp, float ki, float kd);
+esp_err_t control_task_run_profile(const profile_segment_t *segments, size_t count);
+esp_err_t control_task_abort_profile(void);
+void control_task_get_profile(profile_progress_t *progress);
+esp_err_t control_task_start_autotune(const autotune_config_t *config);
+esp_err_t control_task_abort_autotune(void);
+void control_task_get_autotune(autotune_progress_t *progress);
+bool control_task_take_tuned_gains(autotune_result_t *result);
+void control_task_get_status(control_status_t *status);
+bool control_task_is_running(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTROL_TASK_H
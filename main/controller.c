@@ -0,0 +1,130 @@
+/*
+ * Temperature Controller Core Implementation
+ */
+
+#include <stddef.h>
+#include "controller.h"
+
+void controller_init(controller_t *ctl, const pid_fixed_config_t *pid_config)
+{
+    ctl->pid_config = *pid_config;
+    pid_fixed_init(&ctl->pid, &ctl->pid_config);
+    ctl->mode = CONTROL_MODE_MANUAL;
+    ctl->setpoint = 0;
+    ctl->ff = NULL;
+    ctl->ff_term = 0;
+    ctl->settled_ticks = 0;
+}
+
+void controller_set_mode(controller_t *ctl, control_mode_t mode)
+{
+    if (mode == CONTROL_MODE_AUTO) {
+        // Bumpless: the PID starts from the output currently applied
+        pid_fixed_set_auto(&ctl->pid);
+    } else {
+        // Hold the last automatic output until a new manual value arrives
+        pid_fixed_set_manual(&ctl->pid, ctl->pid.output);
+    }
+    ctl->mode = mode;
+}
+
+void controller_set_setpoint(controller_t *ctl, int32_t setpoint)
+{
+    if (setpoint != ctl->setpoint) {
+        ctl->settled_ticks = 0;
+    }
+    ctl->setpoint = setpoint;
+}
+
+void controller_set_manual(controller_t *ctl, uint32_t duty)
+{
+    pid_fixed_set_manual(&ctl->pid, (int32_t)duty);
+    ctl->mode = CONTROL_MODE_MANUAL;
+}
+
+void controller_set_gains(controller_t *ctl, float kp, float ki, float kd)
+{
+    ctl->pid_config.kp = kp;
+    ctl->pid_config.ki = ki;
+    ctl->pid_config.kd = kd;
+    pid_fixed_set_gains(&ctl->pid, &ctl->pid_config);
+}
+
+void controller_set_feedforward(controller_t *ctl, feedforward_t *ff)
+{
+    ctl->ff = ff;
+    ctl->settled_ticks = 0;
+    if (ff == NULL) {
+        ctl->ff_term = 0;
+        pid_fixed_set_feedforward(&ctl->pid, 0);
+    }
+}
+
+// Calibrates the feed-forward from the steady-state output (feed-forward plus
+// integral) once the loop has held the setpoint for FEEDFORWARD_SETTLE_S
+static void calibrate_feedforward(controller_t *ctl, esp_err_t sensor_status, int32_t measurement)
+{
+    const int32_t band = (int32_t)(FEEDFORWARD_SETTLE_BAND_C * PID_FIXED_TEMP_PER_C);
+    const uint32_t settle_ticks = FEEDFORWARD_SETTLE_S * 1000 / ctl->pid_config.period_ms;
+    int32_t error = ctl->setpoint - measurement;
+
+    if (ctl->mode != CONTROL_MODE_AUTO || sensor_status != ESP_OK || error > band || error < -band) {
+        ctl->settled_ticks = 0;
+        return;
+    }
+
+    if (ctl->settled_ticks < settle_ticks) {
+        ctl->settled_ticks++;
+        return;
+    }
+
+    // Move what the integral holds into the table; the output stays where it is
+    q16_t held = (q16_t)((int64_t)ctl->pid.feedforward + ctl->pid.integral);
+    q16_t moved = feedforward_calibrate(ctl->ff, ctl->setpoint, held);
+    pid_fixed_transfer_to_feedforward(&ctl->pid, moved);
+}
+
+// Actuators may run finer than the 12-bit telemetry records
+static int16_t to_telemetry_scale(const controller_t *ctl, int32_t counts)
+{
+    int64_t scaled = (int64_t)counts * TELEMETRY_DUTY_FULL_SCALE / ctl->pid_config.full_scale;
+    if (scaled > INT16_MAX) return INT16_MAX;
+    if (scaled < INT16_MIN) return INT16_MIN;
+    return (int16_t)scaled;
+}
+
+uint32_t controller_step(controller_t *ctl, esp_err_t sensor_status, int32_t measurement,
+                         telemetry_sample_t *telemetry)
+{
+    if (ctl->ff != NULL) {
+        q16_t ff = feedforward_lookup_q16(ctl->ff, ctl->setpoint);
+        pid_fixed_set_feedforward(&ctl->pid, ff);
+        ctl->ff_term = (ff + Q16_ONE / 2) >> Q16_SHIFT;
+    }
+
+    int32_t duty;
+    if (sensor_status == ESP_OK || ctl->mode == CONTROL_MODE_MANUAL) {
+        duty = pid_fixed_step(&ctl->pid, ctl->setpoint, measurement);
+    } else {
+        // No valid measurement: do not heat blindly
+        pid_fixed_reset(&ctl->pid);
+        duty = 0;
+    }
+
+    if (ctl->ff != NULL && ctl->ff->calibrate) {
+        calibrate_feedforward(ctl, sensor_status, measurement);
+    }
+
+    if (telemetry != NULL) {
+        *telemetry = (telemetry_sample_t) {
+            .temp_q2 = (sensor_status == ESP_OK) ? (uint16_t)measurement : 0,
+            .duty = (uint16_t)to_telemetry_scale(ctl, duty),
+            .p_term = to_telemetry_scale(ctl, ctl->pid.p_term),
+            .i_term = to_telemetry_scale(ctl, ctl->pid.i_term),
+            .d_term = to_telemetry_scale(ctl, ctl->pid.d_term),
+            .fault = (sensor_status != ESP_OK),
+        };
+    }
+
+    return (uint32_t)duty;
+}
@@ -0,0 +1,56 @@
+/*
+ * Temperature Controller Core
+ *
+ * The per-tick control logic (mode handling, PID, sensor fault policy)
+ * without any RTOS or driver dependencies. control_task runs it on the
+ * device; host tools run the very same code against the plant model.
+ */
+
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "pid_fixed.h"
+#include "telemetry.h"
+#include "feedforward.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CONTROL_MODE_MANUAL = 0,  // Output set directly through the API
+    CONTROL_MODE_AUTO,        // Output computed by the PID
+} control_mode_t;
+
+typedef struct {
+    pid_fixed_t pid;
+    pid_fixed_config_t pid_config;
+    control_mode_t mode;
+    int32_t setpoint;         // MAX6675 units (0.25°C)
+    feedforward_t *ff;        // NULL: PID only
+    int32_t ff_term;          // Feed-forward of the last step (duty counts)
+    uint32_t settled_ticks;   // Consecutive automatic ticks within the settle band
+} controller_t;
+
+// Function prototypes
+void controller_init(controller_t *ctl, const pid_fixed_config_t *pid_config);
+void controller_set_mode(controller_t *ctl, control_mode_t mode);
+void controller_set_setpoint(controller_t *ctl, int32_t setpoint);
+void controller_set_manual(controller_t *ctl, uint32_t duty);
+void controller_set_gains(controller_t *ctl, float kp, float ki, float kd);
+void controller_set_feedforward(controller_t *ctl, feedforward_t *ff);
+uint32_t controller_step(controller_t *ctl, esp_err_t sensor_status, int32_t measurement,
+                         telemetry_sample_t *telemetry);
+
+static inline int32_t controller_celsius_to_units(float celsius)
+{
+    return (int32_t)(celsius * PID_FIXED_TEMP_PER_C + 0.5f);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTROLLER_H
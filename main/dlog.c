@@ -0,0 +1,252 @@
+/*
+ * Deferred Logging Implementation
+ */
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "dlog.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "DLOG";
+
+typedef struct {
+    const dlog_format_t *format;
+    const char *tag;
+    uint32_t timestamp_ms;
+    uint8_t count;
+    dlog_arg_t args[DLOG_MAX_ARGS];
+} dlog_event_t;
+
+// Bounded multi-producer ring (Vyukov). Sequence numbers count laps of the
+// ring: a slot is free for position p when seq == LAP(p) and holds the event
+// for p when seq == LAP(p) + 1, so the zeroed static ring is ready as is
+#define LAP(pos)  ((pos) & ~(unsigned)(DLOG_RING_SIZE - 1))
+
+typedef struct {
+    atomic_uint seq;
+    dlog_event_t event;
+} dlog_slot_t;
+
+typedef struct {
+    dlog_slot_t slots[DLOG_RING_SIZE];
+    atomic_uint head;          // Next position to reserve (producers)
+    unsigned tail;             // Next position to drain (drain task only)
+    atomic_uint written;
+    atomic_uint dropped;
+} dlog_ring_t;
+
+_Static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0, "DLOG_RING_SIZE must be a power of two");
+
+static dlog_ring_t s_rings[portNUM_PROCESSORS];
+static TaskHandle_t s_task_handle = NULL;
+
+// Function prototypes
+static void dlog_drain_task(void *arg);
+
+void dlog_write(const dlog_format_t *format, const char *tag, const dlog_arg_t *args, size_t count)
+{
+    dlog_ring_t *ring = &s_rings[xPortGetCoreID()];
+
+    unsigned pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    dlog_slot_t *slot;
+    for (;;) {
+        slot = &ring->slots[pos & (DLOG_RING_SIZE - 1)];
+        unsigned seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        int diff = (int)(seq - LAP(pos));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: the drain task has not reached this slot yet
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+        }
+    }
+
+    dlog_event_t *event = &slot->event;
+    event->format = format;
+    event->tag = tag;
+    event->timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    event->count = (uint8_t)(count < DLOG_MAX_ARGS ? count : DLOG_MAX_ARGS);
+    memcpy(event->args, args, event->count * sizeof(dlog_arg_t));
+
+    atomic_fetch_add_explicit(&ring->written, 1, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, LAP(pos) + 1, memory_order_release);
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    *stats = (dlog_stats_t) { 0 };
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        stats->written += atomic_load_explicit(&s_rings[core].written, memory_order_relaxed);
+        stats->dropped += atomic_load_explicit(&s_rings[core].dropped, memory_order_relaxed);
+    }
+}
+
+// Formats one conversion; spec is "%[flags][width][.precision]" plus the conversion character
+static int format_arg(char *buf, size_t size, const char *spec, size_t spec_len, char conversion,
+                      const dlog_arg_t *arg)
+{
+    // Length modifiers are dropped: every integer is stored as 64 bits
+    char fmt[24];
+    if (spec_len + 3 > sizeof(fmt)) {
+        return 0;
+    }
+    memcpy(fmt, spec, spec_len);
+    size_t n = spec_len;
+
+    switch (conversion) {
+    case 'c':
+        fmt[n++] = 'c';
+        fmt[n] = '\0';
+        return snprintf(buf, size, fmt, (int)arg->i);
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+        fmt[n++] = 'l';
+        fmt[n++] = 'l';
+        fmt[n++] = conversion;
+        fmt[n] = '\0';
+        return (arg->type == DLOG_ARG_UINT) ? snprintf(buf, size, fmt, (unsigned long long)arg->u)
+                                            : snprintf(buf, size, fmt, (long long)arg->i);
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+        fmt[n++] = conversion;
+        fmt[n] = '\0';
+        return snprintf(buf, size, fmt, arg->type == DLOG_ARG_DOUBLE ? arg->d : (double)arg->i);
+    case 's':
+        fmt[n++] = 's';
+        fmt[n] = '\0';
+        return snprintf(buf, size, fmt, (arg->type == DLOG_ARG_STR && arg->s != NULL) ? arg->s : "(?)");
+    default:
+        return 0;
+    }
+}
+
+// printf-style formatting from the recorded arguments; returns the length written
+size_t dlog_format(const char *format, const dlog_arg_t *args, size_t count, char *buf, size_t size)
+{
+    if (buf == NULL || size == 0) {
+        return 0;
+    }
+
+    size_t len = 0;
+    size_t next_arg = 0;
+    const char *p = format;
+    while (*p != '\0' && len + 1 < size) {
+        if (*p != '%') {
+            buf[len++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[len++] = '%';
+            p += 2;
+            continue;
+        }
+
+        const char *spec = p++;
+        while (*p != '\0' && strchr("-+ #0123456789.", *p) != NULL) {
+            p++;
+        }
+        size_t spec_len = (size_t)(p - spec);
+        while (*p != '\0' && strchr("hlLqjzt", *p) != NULL) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        char conversion = *p++;
+
+        if (next_arg >= count) {
+            break;
+        }
+        int written = format_arg(buf + len, size - len, spec, spec_len, conversion, &args[next_arg++]);
+        if (written > 0) {
+            len += ((size_t)written < size - len) ? (size_t)written : size - len - 1;
+        }
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+static char level_letter(uint8_t level)
+{
+    switch (level) {
+    case DLOG_LEVEL_ERROR: return 'E';
+    case DLOG_LEVEL_WARN:  return 'W';
+    case DLOG_LEVEL_INFO:  return 'I';
+    case DLOG_LEVEL_DEBUG: return 'D';
+    default:               return 'V';
+    }
+}
+
+// Prints every event of one ring that is ready, in order
+static void drain_ring(dlog_ring_t *ring, char *line)
+{
+    for (;;) {
+        dlog_slot_t *slot = &ring->slots[ring->tail & (DLOG_RING_SIZE - 1)];
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) != LAP(ring->tail) + 1) {
+            return;
+        }
+
+        // Copy out and release the slot before the slow part
+        dlog_event_t event = slot->event;
+        atomic_store_explicit(&slot->seq, LAP(ring->tail) + DLOG_RING_SIZE, memory_order_release);
+        ring->tail++;
+
+        dlog_format(event.format->format, event.args, event.count, line, DLOG_LINE_MAX);
+        esp_log_write((esp_log_level_t)event.format->level, event.tag, "%c (%" PRIu32 ") %s: %s\n",
+                      level_letter(event.format->level), event.timestamp_ms, event.tag, line);
+    }
+}
+
+static void dlog_drain_task(void *arg)
+{
+    static char line[DLOG_LINE_MAX];
+    uint32_t reported_drops = 0;
+
+    while (1) {
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            drain_ring(&s_rings[core], line);
+        }
+
+        dlog_stats_t stats;
+        dlog_get_stats(&stats);
+        if (stats.dropped != reported_drops) {
+            ESP_LOGW(TAG, "%" PRIu32 " log events dropped (%" PRIu32 " total)",
+                     stats.dropped - reported_drops, stats.dropped);
+            reported_drops = stats.dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_MS));
+    }
+}
+
+// Events recorded before this are kept and printed once the task runs
+esp_err_t dlog_start(void)
+{
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    BaseType_t created = xTaskCreate(dlog_drain_task, "dlog", DLOG_STACK_SIZE, NULL, DLOG_PRIORITY,
+                                     &s_task_handle);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create drain task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Deferred logging started (%d events per core, level %d)", DLOG_RING_SIZE, DLOG_LEVEL);
+    return ESP_OK;
+}
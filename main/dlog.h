@@ -0,0 +1,136 @@
+/*
+ * Deferred Logging
+ *
+ * DLOGE/DLOGW/DLOGI/DLOGD take the same arguments as ESP_LOGx, but only
+ * record a binary event (format descriptor, tag, timestamp and up to
+ * DLOG_MAX_ARGS arguments) in a lock-free ring of the calling core. A
+ * low-priority drain task formats the events and writes them through
+ * esp_log_write(), so a control or sampler task never waits on the UART.
+ *
+ * Recording never blocks and is safe from any task, inside critical
+ * sections and from ISRs. When a ring is full the event is dropped and
+ * counted; the drain task reports drops. Levels above DLOG_LEVEL are cut
+ * at compile time: the call compiles to nothing, arguments are still
+ * type-checked.
+ *
+ * %s arguments are stored as pointers and formatted later: only pass
+ * strings with static storage (literals, *_name() tables, esp_err_to_name()).
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Levels, numerically equal to esp_log_level_t
+#define DLOG_LEVEL_NONE     0
+#define DLOG_LEVEL_ERROR    1
+#define DLOG_LEVEL_WARN     2
+#define DLOG_LEVEL_INFO     3
+#define DLOG_LEVEL_DEBUG    4
+#define DLOG_LEVEL_VERBOSE  5
+
+// Compile-time cut, follows the ESP_LOG maximum level by default
+#ifndef DLOG_LEVEL
+#ifdef CONFIG_LOG_MAXIMUM_LEVEL
+#define DLOG_LEVEL          CONFIG_LOG_MAXIMUM_LEVEL
+#else
+#define DLOG_LEVEL          DLOG_LEVEL_INFO
+#endif
+#endif
+
+// Configuration
+#define DLOG_MAX_ARGS       6
+#define DLOG_RING_SIZE      64      // Events per core, power of two
+#define DLOG_LINE_MAX       192     // Formatted message, longer ones are truncated
+#define DLOG_DRAIN_MS       20      // Drain task polling period
+#define DLOG_STACK_SIZE     3072
+#define DLOG_PRIORITY       (tskIDLE_PRIORITY + 1)
+
+typedef enum {
+    DLOG_ARG_INT = 0,
+    DLOG_ARG_UINT,
+    DLOG_ARG_DOUBLE,
+    DLOG_ARG_STR,
+} dlog_arg_type_t;
+
+typedef struct {
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const char *s;
+    };
+    dlog_arg_type_t type;
+} dlog_arg_t;
+
+// One per call site, in flash; its address is the format id
+typedef struct {
+    uint8_t level;
+    const char *format;
+} dlog_format_t;
+
+typedef struct {
+    uint32_t written;
+    uint32_t dropped;
+} dlog_stats_t;
+
+static inline dlog_arg_t dlog_arg_int(int64_t value) { return (dlog_arg_t) { .i = value, .type = DLOG_ARG_INT }; }
+static inline dlog_arg_t dlog_arg_uint(uint64_t value) { return (dlog_arg_t) { .u = value, .type = DLOG_ARG_UINT }; }
+static inline dlog_arg_t dlog_arg_double(double value) { return (dlog_arg_t) { .d = value, .type = DLOG_ARG_DOUBLE }; }
+static inline dlog_arg_t dlog_arg_str(const char *value) { return (dlog_arg_t) { .s = value, .type = DLOG_ARG_STR }; }
+
+#define DLOG_ARG(x) _Generic((x),                                                  \
+    float: dlog_arg_double, double: dlog_arg_double,                               \
+    char *: dlog_arg_str, const char *: dlog_arg_str,                              \
+    unsigned char: dlog_arg_uint, unsigned short: dlog_arg_uint,                   \
+    unsigned int: dlog_arg_uint, unsigned long: dlog_arg_uint,                     \
+    unsigned long long: dlog_arg_uint,                                             \
+    default: dlog_arg_int)(x)
+
+#define DLOG_NARGS(...)  DLOG_NARGS_(_, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...)  n
+#define DLOG_CAT(a, b)   DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b)  a##b
+#define DLOG_ARGS(...)   DLOG_CAT(DLOG_ARGS_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define DLOG_ARGS_0()
+#define DLOG_ARGS_1(a)                 DLOG_ARG(a)
+#define DLOG_ARGS_2(a, b)              DLOG_ARG(a), DLOG_ARG(b)
+#define DLOG_ARGS_3(a, b, c)           DLOG_ARGS_2(a, b), DLOG_ARG(c)
+#define DLOG_ARGS_4(a, b, c, d)        DLOG_ARGS_3(a, b, c), DLOG_ARG(d)
+#define DLOG_ARGS_5(a, b, c, d, e)     DLOG_ARGS_4(a, b, c, d), DLOG_ARG(e)
+#define DLOG_ARGS_6(a, b, c, d, e, f)  DLOG_ARGS_5(a, b, c, d, e), DLOG_ARG(f)
+
+// The leading placeholder keeps the initializer valid without arguments
+#define DLOG_AT(level, tag, format, ...) do {                                      \
+    if ((level) <= DLOG_LEVEL) {                                                   \
+        static const dlog_format_t dlog_format_ = { (level), (format) };          \
+        const dlog_arg_t dlog_args_[] = { { .i = 0 }, DLOG_ARGS(__VA_ARGS__) };    \
+        dlog_write(&dlog_format_, (tag), dlog_args_ + 1, DLOG_NARGS(__VA_ARGS__)); \
+    }                                                                              \
+} while (0)
+
+#define DLOGE(tag, format, ...)  DLOG_AT(DLOG_LEVEL_ERROR, tag, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...)  DLOG_AT(DLOG_LEVEL_WARN, tag, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...)  DLOG_AT(DLOG_LEVEL_INFO, tag, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...)  DLOG_AT(DLOG_LEVEL_DEBUG, tag, format, ##__VA_ARGS__)
+
+// Function prototypes
+esp_err_t dlog_start(void);
+void dlog_write(const dlog_format_t *format, const char *tag, const dlog_arg_t *args, size_t count);
+void dlog_get_stats(dlog_stats_t *stats);
+size_t dlog_format(const char *format, const dlog_arg_t *args, size_t count, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DLOG_H
@@ -0,0 +1,219 @@
+/*
+ * Temperature State Estimator Implementation
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "estimator.h"
+
+#define PROBE 0
+#define DRUM  1
+#define LOSS  2
+
+// Uncertainty of a restart from a single reading
+#define RESTART_DRUM_SIGMA_C  2.0f
+#define RESTART_LOSS_SIGMA_W  2.0f
+
+static float measurement_variance(void)
+{
+    // Sensor noise plus the uniform quantization error of one LSB
+    return ESTIMATOR_MEASUREMENT_NOISE * ESTIMATOR_MEASUREMENT_NOISE +
+           PLANT_ADC_LSB_C * PLANT_ADC_LSB_C / 12.0f;
+}
+
+// Heater power at the current duty; the wire runs hotter than the drum by P / G_wire
+static float heater_power(const plant_params_t *m, float duty, float drum_c, float last_power_w)
+{
+    float wire_c = drum_c + last_power_w / m->wire_to_drum;
+    float resistance = m->resistance_20c * (1.0f + m->resistance_alpha * (wire_c - 20.0f));
+    return duty * m->supply_voltage * m->supply_voltage / resistance;
+}
+
+// One Euler step of the model, dt <= ESTIMATOR_MAX_STEP_S
+static void model_step(const plant_params_t *m, float x[ESTIMATOR_STATES], float power_w, float dt)
+{
+    float drum_rate = (power_w - m->drum_to_ambient * (x[DRUM] - m->ambient_c) + x[LOSS]) / m->drum_capacity;
+    x[PROBE] += (x[DRUM] - x[PROBE]) * dt / m->thermocouple_tau_s;
+    x[DRUM] += drum_rate * dt;
+}
+
+// P = F P F' + Q for the linearized step
+static void covariance_step(estimator_t *est, float dt)
+{
+    const plant_params_t *m = &est->model;
+    const float a = dt / m->thermocouple_tau_s;
+    const float f[ESTIMATOR_STATES][ESTIMATOR_STATES] = {
+        { 1.0f - a, a, 0.0f },
+        { 0.0f, 1.0f - dt * m->drum_to_ambient / m->drum_capacity, dt / m->drum_capacity },
+        { 0.0f, 0.0f, 1.0f },
+    };
+
+    float fp[ESTIMATOR_STATES][ESTIMATOR_STATES];
+    for (int i = 0; i < ESTIMATOR_STATES; i++) {
+        for (int j = 0; j < ESTIMATOR_STATES; j++) {
+            fp[i][j] = f[i][0] * est->p[0][j] + f[i][1] * est->p[1][j] + f[i][2] * est->p[2][j];
+        }
+    }
+    for (int i = 0; i < ESTIMATOR_STATES; i++) {
+        for (int j = 0; j < ESTIMATOR_STATES; j++) {
+            est->p[i][j] = fp[i][0] * f[j][0] + fp[i][1] * f[j][1] + fp[i][2] * f[j][2];
+        }
+    }
+
+    est->p[DRUM][DRUM] += ESTIMATOR_DRUM_NOISE * ESTIMATOR_DRUM_NOISE * dt;
+    est->p[LOSS][LOSS] += ESTIMATOR_LOSS_NOISE * ESTIMATOR_LOSS_NOISE * dt;
+}
+
+// Brings state and covariance forward to timestamp_us under the applied duty
+static void advance(estimator_t *est, int64_t timestamp_us)
+{
+    float remaining = (float)(timestamp_us - est->timestamp_us) / 1e6f;
+    while (remaining > 0.0f) {
+        float dt = remaining > ESTIMATOR_MAX_STEP_S ? ESTIMATOR_MAX_STEP_S : remaining;
+        est->power_w = heater_power(&est->model, est->duty, est->x[DRUM], est->power_w);
+        model_step(&est->model, est->x, est->power_w, dt);
+        covariance_step(est, dt);
+        remaining -= dt;
+    }
+    est->timestamp_us = timestamp_us;
+}
+
+static void restart(estimator_t *est, float measured, int64_t timestamp_us)
+{
+    est->x[PROBE] = measured;
+    est->x[DRUM] = measured;
+    est->x[LOSS] = 0.0f;
+    memset(est->p, 0, sizeof(est->p));
+    est->p[PROBE][PROBE] = measurement_variance();
+    est->p[DRUM][DRUM] = RESTART_DRUM_SIGMA_C * RESTART_DRUM_SIGMA_C;
+    est->p[LOSS][LOSS] = RESTART_LOSS_SIGMA_W * RESTART_LOSS_SIGMA_W;
+    est->timestamp_us = timestamp_us;
+    est->initialized = true;
+    est->last_rejected = false;
+    est->restarts++;
+}
+
+esp_err_t estimator_init(estimator_t *est, const plant_params_t *model)
+{
+    if (est == NULL || model == NULL || model->drum_capacity <= 0.0f ||
+        model->thermocouple_tau_s < ESTIMATOR_MAX_STEP_S || model->wire_to_drum <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(est, 0, sizeof(*est));
+    est->model = *model;
+    return ESP_OK;
+}
+
+// Forget the state; the next reading starts the filter again
+void estimator_reset(estimator_t *est)
+{
+    if (est != NULL) {
+        est->initialized = false;
+    }
+}
+
+void estimator_set_duty(estimator_t *est, float duty)
+{
+    if (est != NULL) {
+        est->duty = duty < 0.0f ? 0.0f : (duty > 1.0f ? 1.0f : duty);
+    }
+}
+
+// Returns ESP_ERR_INVALID_RESPONSE if the reading was dropped as a spike
+esp_err_t estimator_update(estimator_t *est, float temperature, int64_t timestamp_us)
+{
+    if (est == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The MAX6675 truncates: a reading stands for the middle of its LSB
+    const float measured = temperature + PLANT_ADC_LSB_C / 2.0f;
+
+    if (!est->initialized || timestamp_us < est->timestamp_us ||
+        timestamp_us - est->timestamp_us > (int64_t)(ESTIMATOR_MAX_GAP_S * 1e6f)) {
+        restart(est, measured, timestamp_us);
+        return ESP_OK;
+    }
+
+    advance(est, timestamp_us);
+
+    const float s = est->p[PROBE][PROBE] + measurement_variance();
+    const float innovation = measured - est->x[PROBE];
+    const float gate = fmaxf(ESTIMATOR_SPIKE_SIGMA * sqrtf(s), ESTIMATOR_SPIKE_MIN_C);
+    if (fabsf(innovation) > gate) {
+        if (!est->last_rejected) {
+            est->last_rejected = true;
+            est->spikes++;
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        // Two in a row: the temperature really is there
+        restart(est, measured, timestamp_us);
+        return ESP_OK;
+    }
+    est->last_rejected = false;
+
+    // Scalar measurement of the probe state: K = P[:, probe] / s
+    float k[ESTIMATOR_STATES];
+    float p_row[ESTIMATOR_STATES];
+    for (int i = 0; i < ESTIMATOR_STATES; i++) {
+        k[i] = est->p[i][PROBE] / s;
+        p_row[i] = est->p[PROBE][i];
+    }
+    for (int i = 0; i < ESTIMATOR_STATES; i++) {
+        est->x[i] += k[i] * innovation;
+        for (int j = 0; j < ESTIMATOR_STATES; j++) {
+            est->p[i][j] -= k[i] * p_row[j];
+        }
+    }
+
+    // Keep the covariance symmetric against rounding
+    for (int i = 0; i < ESTIMATOR_STATES; i++) {
+        for (int j = i + 1; j < ESTIMATOR_STATES; j++) {
+            float mean = 0.5f * (est->p[i][j] + est->p[j][i]);
+            est->p[i][j] = mean;
+            est->p[j][i] = mean;
+        }
+    }
+
+    est->updates++;
+    return ESP_OK;
+}
+
+// Probe temperature expected at timestamp_us (between or after conversions)
+float estimator_predict(const estimator_t *est, int64_t timestamp_us)
+{
+    if (est == NULL || !est->initialized) {
+        return NAN;
+    }
+
+    float x[ESTIMATOR_STATES] = { est->x[PROBE], est->x[DRUM], est->x[LOSS] };
+    float power_w = est->power_w;
+    float remaining = (float)(timestamp_us - est->timestamp_us) / 1e6f;
+    if (remaining > ESTIMATOR_MAX_GAP_S) {
+        remaining = ESTIMATOR_MAX_GAP_S;
+    }
+    while (remaining > 0.0f) {
+        float dt = remaining > ESTIMATOR_MAX_STEP_S ? ESTIMATOR_MAX_STEP_S : remaining;
+        power_w = heater_power(&est->model, est->duty, x[DRUM], power_w);
+        model_step(&est->model, x, power_w, dt);
+        remaining -= dt;
+    }
+    return x[PROBE];
+}
+
+void estimator_get(const estimator_t *est, estimator_output_t *out)
+{
+    if (est == NULL || out == NULL) {
+        return;
+    }
+
+    *out = (estimator_output_t) {
+        .temperature = est->x[PROBE],
+        .rate = (est->x[DRUM] - est->x[PROBE]) / est->model.thermocouple_tau_s,
+        .drum = est->x[DRUM],
+        .loss_w = est->x[LOSS],
+        .sigma = sqrtf(est->p[PROBE][PROBE]),
+    };
+}
@@ -0,0 +1,79 @@
+/*
+ * Temperature State Estimator
+ *
+ * Kalman filter that fuses the MAX6675 readings (0.25°C steps, one
+ * conversion every ~220 ms) with the applied duty and the heater model
+ * (plant_params_t, as in plant_model.h and feedforward.h). States:
+ *
+ *   probe  thermocouple junction, what the MAX6675 measures    °C
+ *   drum   drum temperature the probe lags by its time constant °C
+ *   loss   heat flow the model misses (load, draughts), + heats W
+ *
+ *   d(drum)/dt  = (P(duty) - G_amb * (drum - T_amb) + loss) / C_drum
+ *   d(probe)/dt = (drum - probe) / tau_probe
+ *
+ * Outputs a filtered temperature, its rate of change and a prediction
+ * for any time between conversions. A reading far outside the predicted
+ * spread is dropped once as a spike; a second one in a row is taken as a
+ * real jump and restarts the filter there.
+ *
+ * Single-precision float (the ESP32 has an FPU), no RTOS dependencies:
+ * also built on the host, see host/estimator_bench.c.
+ */
+
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "plant_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESTIMATOR_STATES            3
+#define ESTIMATOR_MEASUREMENT_NOISE 0.15f    // °C rms, thermocouple noise before quantization
+#define ESTIMATOR_DRUM_NOISE        0.02f    // °C/sqrt(s), drum process noise
+#define ESTIMATOR_LOSS_NOISE        0.2f     // W/sqrt(s), random walk of the unmodelled loss
+#define ESTIMATOR_SPIKE_SIGMA       5.0f     // Innovation gate in standard deviations ...
+#define ESTIMATOR_SPIKE_MIN_C       2.0f     // ... and never tighter than this
+#define ESTIMATOR_MAX_STEP_S        0.25f    // Model integration step
+#define ESTIMATOR_MAX_GAP_S         5.0f     // Longer without a reading: restart on the next one
+
+typedef struct {
+    plant_params_t model;
+    float x[ESTIMATOR_STATES];                    // probe °C, drum °C, loss W
+    float p[ESTIMATOR_STATES][ESTIMATOR_STATES];  // Covariance
+    float duty;                                   // Applied duty since the last update, 0..1
+    float power_w;                                // Heater power at duty, hot wire resistance
+    int64_t timestamp_us;                         // Time of the state
+    bool initialized;
+    bool last_rejected;                           // Previous reading was dropped as a spike
+    uint32_t updates;
+    uint32_t spikes;                              // Readings dropped
+    uint32_t restarts;                            // Restarts on a gap or a confirmed jump
+} estimator_t;
+
+typedef struct {
+    float temperature;       // °C, filtered probe temperature
+    float rate;              // °C/s
+    float drum;              // °C
+    float loss_w;            // Unmodelled heat flow, + heats
+    float sigma;             // °C, standard deviation of temperature
+} estimator_output_t;
+
+// Function prototypes
+esp_err_t estimator_init(estimator_t *est, const plant_params_t *model);
+void estimator_reset(estimator_t *est);
+void estimator_set_duty(estimator_t *est, float duty);
+esp_err_t estimator_update(estimator_t *est, float temperature, int64_t timestamp_us);
+float estimator_predict(const estimator_t *est, int64_t timestamp_us);
+void estimator_get(const estimator_t *est, estimator_output_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ESTIMATOR_H
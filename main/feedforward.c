@@ -0,0 +1,102 @@
+/*
+ * Steady-State Feed-Forward Implementation
+ */
+
+#include <stddef.h>
+#include "feedforward.h"
+
+#define TABLE_STEP_UNITS  (FEEDFORWARD_STEP_C * PID_FIXED_TEMP_PER_C)
+
+static int64_t clamp_i64(int64_t value, int64_t min, int64_t max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+float feedforward_model_duty(const plant_params_t *model, float temperature)
+{
+    if (temperature <= model->ambient_c) {
+        return 0.0f;
+    }
+
+    float power = model->drum_to_ambient * (temperature - model->ambient_c);
+    float wire_c = temperature + power / model->wire_to_drum;
+    float resistance = model->resistance_20c * (1.0f + model->resistance_alpha * (wire_c - 20.0f));
+    float max_power = model->supply_voltage * model->supply_voltage / resistance;
+
+    float duty = power / max_power;
+    return duty > 1.0f ? 1.0f : duty;
+}
+
+esp_err_t feedforward_init(feedforward_t *ff, const plant_params_t *model, int32_t full_scale)
+{
+    if (ff == NULL || model == NULL || full_scale <= 0 || full_scale >= 32768) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < FEEDFORWARD_POINTS; i++) {
+        float duty = feedforward_model_duty(model, (float)(i * FEEDFORWARD_STEP_C));
+        ff->duty[i] = Q16_FROM_FLOAT(duty * full_scale);
+    }
+    ff->full_scale = full_scale;
+    ff->calibrate = false;
+    return ESP_OK;
+}
+
+// Index of the segment holding setpoint and its position in it (0..TABLE_STEP_UNITS)
+static void locate(int32_t setpoint, int *index, int32_t *offset)
+{
+    if (setpoint <= 0) {
+        *index = 0;
+        *offset = 0;
+    } else if (setpoint >= (FEEDFORWARD_POINTS - 1) * TABLE_STEP_UNITS) {
+        *index = FEEDFORWARD_POINTS - 2;
+        *offset = TABLE_STEP_UNITS;
+    } else {
+        *index = setpoint / TABLE_STEP_UNITS;
+        *offset = setpoint - *index * TABLE_STEP_UNITS;
+    }
+}
+
+// Setpoint in measurement units, result in duty counts (Q16)
+q16_t feedforward_lookup_q16(const feedforward_t *ff, int32_t setpoint)
+{
+    if (ff == NULL) {
+        return 0;
+    }
+
+    int index;
+    int32_t offset;
+    locate(setpoint, &index, &offset);
+
+    int64_t lo = ff->duty[index];
+    int64_t hi = ff->duty[index + 1];
+    return (q16_t)(lo + (hi - lo) * offset / TABLE_STEP_UNITS);
+}
+
+int32_t feedforward_lookup(const feedforward_t *ff, int32_t setpoint)
+{
+    return (feedforward_lookup_q16(ff, setpoint) + Q16_ONE / 2) >> Q16_SHIFT;
+}
+
+// Moves the two points around setpoint a step towards the settled duty (Q16), each by
+// its interpolation weight. Returns how much the lookup at setpoint changed.
+q16_t feedforward_calibrate(feedforward_t *ff, int32_t setpoint, q16_t duty)
+{
+    if (ff == NULL) {
+        return 0;
+    }
+
+    int index;
+    int32_t offset;
+    locate(setpoint, &index, &offset);
+
+    const int64_t max = (int64_t)ff->full_scale << Q16_SHIFT;
+    const q16_t before = feedforward_lookup_q16(ff, setpoint);
+    int64_t error = (int64_t)duty - before;
+    int64_t lo_step = (error * (TABLE_STEP_UNITS - offset) / TABLE_STEP_UNITS) >> FEEDFORWARD_CAL_SHIFT;
+    int64_t hi_step = (error * offset / TABLE_STEP_UNITS) >> FEEDFORWARD_CAL_SHIFT;
+
+    ff->duty[index] = (q16_t)clamp_i64(ff->duty[index] + lo_step, 0, max);
+    ff->duty[index + 1] = (q16_t)clamp_i64(ff->duty[index + 1] + hi_step, 0, max);
+    return feedforward_lookup_q16(ff, setpoint) - before;
+}
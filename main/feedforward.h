@@ -0,0 +1,60 @@
+/*
+ * Steady-State Feed-Forward
+ *
+ * Maps a setpoint to the duty that holds it, so a setpoint change moves
+ * the output close to its final value at once and the integrator only
+ * has to correct the model error. The table is computed once from the
+ * heater model (CALCULOS_FIO_NICROMO.md, the same plant_params_t the
+ * simulator uses):
+ *
+ *   P(T)    = G_amb * (T - T_amb)                 power lost by the drum
+ *   T_wire  = T + P / G_wire                      wire runs hotter
+ *   P_max   = V^2 / (R20 * (1 + alpha * (T_wire - 20)))
+ *   duty(T) = P / P_max
+ *
+ * and interpolated with integer math on every tick. Calibration then
+ * pulls the points around a settled setpoint towards the duty actually
+ * needed by the installed fixture; the controller takes the same amount
+ * out of the PID integral, so the output does not move.
+ *
+ * Pure C, no ESP-IDF dependencies beyond esp_err.h: also built on the host.
+ */
+
+#ifndef FEEDFORWARD_H
+#define FEEDFORWARD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "pid_fixed.h"
+#include "plant_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FEEDFORWARD_STEP_C          25       // Table spacing
+#define FEEDFORWARD_POINTS          16       // 0..375°C
+#define FEEDFORWARD_SETTLE_BAND_C   1.0f     // |error| to count as settled
+#define FEEDFORWARD_SETTLE_S        60       // Settled this long before calibrating
+#define FEEDFORWARD_CAL_SHIFT       8        // Calibration rate 1/256 per tick
+
+// Feed-Forward Table
+typedef struct {
+    q16_t duty[FEEDFORWARD_POINTS];  // Duty counts at i * FEEDFORWARD_STEP_C, Q16
+    int32_t full_scale;              // Duty counts at 100%
+    bool calibrate;                  // Learn from settled operation
+} feedforward_t;
+
+// Function prototypes
+esp_err_t feedforward_init(feedforward_t *ff, const plant_params_t *model, int32_t full_scale);
+int32_t feedforward_lookup(const feedforward_t *ff, int32_t setpoint);
+q16_t feedforward_lookup_q16(const feedforward_t *ff, int32_t setpoint);
+q16_t feedforward_calibrate(feedforward_t *ff, int32_t setpoint, q16_t duty);
+float feedforward_model_duty(const plant_params_t *model, float temperature);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FEEDFORWARD_H
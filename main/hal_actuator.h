@@ -0,0 +1,121 @@
+/*
+ * Actuator Hardware Abstraction
+ *
+ * Thin interface between the controller/REST server and a concrete heater
+ * output backend. Duties are raw counts in 0..max_duty so backends keep
+ * their full resolution.
+ */
+
+#ifndef HAL_ACTUATOR_H
+#define HAL_ACTUATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HAL_ACTUATOR_MAX_CHANNELS  8
+
+// Backend function table
+typedef struct {
+    esp_err_t (*set_duty)(void *ctx, size_t channel, uint32_t duty);
+    // Optional: channels 0..count-1 in one update (NULL falls back to set_duty per channel)
+    esp_err_t (*set_duties)(void *ctx, const uint32_t *duties, size_t count);
+    uint32_t (*get_duty)(void *ctx, size_t channel);   // Duty applied, 0 while inhibited
+    esp_err_t (*stop)(void *ctx);   // All channels to 0
+    // Optional safety cutoff: true holds every output off without waiting on
+    // other writers, later duties only update the targets; false applies them.
+    // NULL falls back to stop, with nothing held.
+    esp_err_t (*inhibit)(void *ctx, bool inhibit);
+} hal_actuator_ops_t;
+
+// Actuator Instance
+typedef struct {
+    const hal_actuator_ops_t *ops;
+    void *ctx;
+    const char *name;
+    size_t channels;
+    uint32_t max_duty;              // Duty counts at 100%
+} hal_actuator_t;
+
+static inline esp_err_t hal_actuator_set_duty(const hal_actuator_t *actuator, size_t channel, uint32_t duty)
+{
+    if (actuator == NULL || actuator->ops == NULL || channel >= actuator->channels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return actuator->ops->set_duty(actuator->ctx, channel, duty > actuator->max_duty ? actuator->max_duty : duty);
+}
+
+static inline esp_err_t hal_actuator_set_duties(const hal_actuator_t *actuator, const uint32_t *duties, size_t count)
+{
+    if (actuator == NULL || actuator->ops == NULL || duties == NULL ||
+        count > actuator->channels || count > HAL_ACTUATOR_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t clamped[HAL_ACTUATOR_MAX_CHANNELS];
+    for (size_t i = 0; i < count; i++) {
+        clamped[i] = duties[i] > actuator->max_duty ? actuator->max_duty : duties[i];
+    }
+
+    if (actuator->ops->set_duties != NULL) {
+        return actuator->ops->set_duties(actuator->ctx, clamped, count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        esp_err_t ret = actuator->ops->set_duty(actuator->ctx, i, clamped[i]);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+static inline uint32_t hal_actuator_get_duty(const hal_actuator_t *actuator, size_t channel)
+{
+    if (actuator == NULL || actuator->ops == NULL || channel >= actuator->channels) {
+        return 0;
+    }
+    return actuator->ops->get_duty(actuator->ctx, channel);
+}
+
+static inline esp_err_t hal_actuator_stop(const hal_actuator_t *actuator)
+{
+    if (actuator == NULL || actuator->ops == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return actuator->ops->stop(actuator->ctx);
+}
+
+static inline esp_err_t hal_actuator_inhibit(const hal_actuator_t *actuator, bool inhibit)
+{
+    if (actuator == NULL || actuator->ops == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (actuator->ops->inhibit == NULL) {
+        return inhibit ? actuator->ops->stop(actuator->ctx) : ESP_OK;
+    }
+    return actuator->ops->inhibit(actuator->ctx, inhibit);
+}
+
+// Percent helpers for API/UI code; the control path works in counts
+static inline uint32_t hal_actuator_percent_to_duty(const hal_actuator_t *actuator, float percent)
+{
+    if (percent < 0.0f) percent = 0.0f;
+    if (percent > 100.0f) percent = 100.0f;
+    return (uint32_t)(percent / 100.0f * actuator->max_duty + 0.5f);
+}
+
+static inline float hal_actuator_duty_to_percent(const hal_actuator_t *actuator, uint32_t duty)
+{
+    return (float)duty * 100.0f / (float)actuator->max_duty;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_ACTUATOR_H
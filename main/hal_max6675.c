@@ -0,0 +1,92 @@
+/*
+ * MAX6675 Sensor Backend Implementation
+ */
+
+#include "hal_max6675.h"
+#include "esp_timer.h"
+
+static esp_err_t hal_max6675_read(void *ctx, hal_sensor_reading_t *readings, size_t count)
+{
+    hal_sensor_reading_t *reading = &readings[0];
+    uint16_t raw = 0;
+
+    esp_err_t ret = max6675_read_raw((max6675_handle_t *)ctx, &raw);
+    *reading = (hal_sensor_reading_t) {
+        .status = ret,
+        .raw = raw,
+        .timestamp_us = esp_timer_get_time(),
+    };
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    reading->fault = raw & MAX6675_FAULT_OPEN;
+    if (reading->fault) {
+        reading->status = ESP_ERR_INVALID_RESPONSE;
+    } else {
+        reading->temperature = max6675_raw_to_celsius(raw);
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t hal_max6675_bus_read(void *ctx, hal_sensor_reading_t *readings, size_t count)
+{
+    max6675_reading_t raw_readings[MAX6675_BUS_MAX_DEVICES];
+
+    esp_err_t ret = max6675_bus_read_all((max6675_bus_t *)ctx, raw_readings, count);
+
+    // Channels that completed are valid even if a later one failed
+    for (size_t i = 0; i < count; i++) {
+        const max6675_reading_t *raw = &raw_readings[i];
+        readings[i] = (hal_sensor_reading_t) {
+            .status = raw->status,
+            .raw = raw->raw,
+            .fault = raw->raw & MAX6675_FAULT_OPEN,
+            .timestamp_us = raw->timestamp_us,
+        };
+        if (raw->status == ESP_OK) {
+            readings[i].temperature = max6675_raw_to_celsius(raw->raw);
+        }
+    }
+
+    return ret;
+}
+
+static const hal_sensor_ops_t s_max6675_ops = {
+    .read = hal_max6675_read,
+};
+
+static const hal_sensor_ops_t s_max6675_bus_ops = {
+    .read = hal_max6675_bus_read,
+};
+
+esp_err_t hal_max6675_bind(hal_sensor_t *sensor, max6675_handle_t *handle)
+{
+    if (sensor == NULL || handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *sensor = (hal_sensor_t) {
+        .ops = &s_max6675_ops,
+        .ctx = handle,
+        .name = "max6675",
+        .channels = 1,
+    };
+    return ESP_OK;
+}
+
+esp_err_t hal_max6675_bind_bus(hal_sensor_t *sensor, max6675_bus_t *bus)
+{
+    if (sensor == NULL || bus == NULL || bus->device_count == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *sensor = (hal_sensor_t) {
+        .ops = &s_max6675_bus_ops,
+        .ctx = bus,
+        .name = "max6675_bus",
+        .channels = bus->device_count,
+    };
+    return ESP_OK;
+}
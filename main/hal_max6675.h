@@ -0,0 +1,25 @@
+/*
+ * MAX6675 Sensor Backend
+ *
+ * Exposes a single max6675_handle_t, or every channel of a max6675_bus_t,
+ * through the hal_sensor_t interface.
+ */
+
+#ifndef HAL_MAX6675_H
+#define HAL_MAX6675_H
+
+#include "hal_sensor.h"
+#include "max6675.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t hal_max6675_bind(hal_sensor_t *sensor, max6675_handle_t *handle);
+esp_err_t hal_max6675_bind_bus(hal_sensor_t *sensor, max6675_bus_t *bus);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_MAX6675_H
@@ -0,0 +1,54 @@
+/*
+ * MOSFET PWM Actuator Backend Implementation
+ */
+
+#include "hal_mosfet_pwm.h"
+
+static esp_err_t hal_mosfet_pwm_set_duty(void *ctx, size_t channel, uint32_t duty)
+{
+    return mosfet_pwm_set_zone_duty_fine((mosfet_pwm_handle_t *)ctx, channel, duty);
+}
+
+static esp_err_t hal_mosfet_pwm_set_duties(void *ctx, const uint32_t *duties, size_t count)
+{
+    return mosfet_pwm_set_zone_duties_fine((mosfet_pwm_handle_t *)ctx, duties, count);
+}
+
+static uint32_t hal_mosfet_pwm_get_duty(void *ctx, size_t channel)
+{
+    return mosfet_pwm_get_applied_fine((mosfet_pwm_handle_t *)ctx, channel);
+}
+
+static esp_err_t hal_mosfet_pwm_stop(void *ctx)
+{
+    return mosfet_pwm_stop((mosfet_pwm_handle_t *)ctx);
+}
+
+static esp_err_t hal_mosfet_pwm_inhibit(void *ctx, bool inhibit)
+{
+    return mosfet_pwm_inhibit((mosfet_pwm_handle_t *)ctx, inhibit);
+}
+
+static const hal_actuator_ops_t s_mosfet_pwm_ops = {
+    .set_duty = hal_mosfet_pwm_set_duty,
+    .set_duties = hal_mosfet_pwm_set_duties,
+    .get_duty = hal_mosfet_pwm_get_duty,
+    .stop = hal_mosfet_pwm_stop,
+    .inhibit = hal_mosfet_pwm_inhibit,
+};
+
+esp_err_t hal_mosfet_pwm_bind(hal_actuator_t *actuator, mosfet_pwm_handle_t *handle)
+{
+    if (actuator == NULL || handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *actuator = (hal_actuator_t) {
+        .ops = &s_mosfet_pwm_ops,
+        .ctx = handle,
+        .name = "mosfet_pwm",
+        .channels = handle->zone_count,
+        .max_duty = MOSFET_PWM_MAX_DUTY_FINE,  // Fine counts, dithered below one LEDC count
+    };
+    return ESP_OK;
+}
@@ -0,0 +1,25 @@
+/*
+ * MOSFET PWM Actuator Backend
+ *
+ * Exposes a mosfet_pwm_handle_t through the hal_actuator_t interface.
+ * One channel per heater zone; duties are fine counts
+ * (MOSFET_PWM_MAX_DUTY_FINE at 100%).
+ */
+
+#ifndef HAL_MOSFET_PWM_H
+#define HAL_MOSFET_PWM_H
+
+#include "hal_actuator.h"
+#include "mosfet_pwm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t hal_mosfet_pwm_bind(hal_actuator_t *actuator, mosfet_pwm_handle_t *handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_MOSFET_PWM_H
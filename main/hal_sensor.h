@@ -0,0 +1,57 @@
+/*
+ * Sensor Hardware Abstraction
+ *
+ * Thin interface between temperature consumers (sampler, control, REST)
+ * and a concrete sensor backend. A backend provides a function table and
+ * an opaque context; the MAX6675 driver is one backend, simulated, replay
+ * and multi-channel backends plug in the same way.
+ */
+
+#ifndef HAL_SENSOR_H
+#define HAL_SENSOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One channel reading
+typedef struct {
+    esp_err_t status;        // ESP_OK, ESP_ERR_INVALID_RESPONSE on sensor fault, ...
+    uint16_t raw;            // Raw word in MAX6675 format (bits 15-3 temperature, bit 2 open)
+    uint8_t fault;           // Fault bits (MAX6675_FAULT_OPEN layout)
+    float temperature;       // °C, valid only when status == ESP_OK
+    int64_t timestamp_us;    // Time the channel was read, 0 if the backend does not provide it
+} hal_sensor_reading_t;
+
+// Backend function table
+typedef struct {
+    // Read channels 0..count-1 into readings; returns the bus/transport status,
+    // per-channel faults are reported in readings[i].status
+    esp_err_t (*read)(void *ctx, hal_sensor_reading_t *readings, size_t count);
+} hal_sensor_ops_t;
+
+// Sensor Instance
+typedef struct {
+    const hal_sensor_ops_t *ops;
+    void *ctx;
+    const char *name;
+    size_t channels;
+} hal_sensor_t;
+
+static inline esp_err_t hal_sensor_read(const hal_sensor_t *sensor, hal_sensor_reading_t *readings, size_t count)
+{
+    if (sensor == NULL || sensor->ops == NULL || readings == NULL || count == 0 || count > sensor->channels) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return sensor->ops->read(sensor->ctx, readings, count);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_SENSOR_H
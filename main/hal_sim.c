@@ -0,0 +1,107 @@
+/*
+ * Simulated Sensor/Actuator Backend Implementation
+ */
+
+#include "hal_sim.h"
+
+static esp_err_t hal_sim_read(void *ctx, hal_sensor_reading_t *readings, size_t count)
+{
+    hal_sim_t *sim = (hal_sim_t *)ctx;
+    sim->read_count++;
+    if (sim->bus_error) {
+        readings[0] = (hal_sensor_reading_t) { .status = ESP_ERR_TIMEOUT };
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uint16_t raw = plant_model_read_adc(&sim->plant);
+
+    readings[0] = (hal_sensor_reading_t) {
+        .status = ESP_OK,
+        .raw = raw,
+        .fault = raw & 0x0004,
+        .timestamp_us = (int64_t)sim->plant.now_us,
+    };
+    if (readings[0].fault) {
+        readings[0].status = ESP_ERR_INVALID_RESPONSE;
+    } else {
+        readings[0].temperature = (raw >> 3) * PLANT_ADC_LSB_C;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t hal_sim_set_duty(void *ctx, size_t channel, uint32_t duty)
+{
+    hal_sim_t *sim = (hal_sim_t *)ctx;
+    sim->duty = duty;
+    plant_model_set_duty(&sim->plant, sim->inhibited ? 0.0f : (float)duty / HAL_SIM_MAX_DUTY);
+    return ESP_OK;
+}
+
+static uint32_t hal_sim_get_duty(void *ctx, size_t channel)
+{
+    hal_sim_t *sim = (hal_sim_t *)ctx;
+    return sim->inhibited ? 0 : sim->duty;
+}
+
+static esp_err_t hal_sim_stop(void *ctx)
+{
+    return hal_sim_set_duty(ctx, 0, 0);
+}
+
+static esp_err_t hal_sim_inhibit(void *ctx, bool inhibit)
+{
+    hal_sim_t *sim = (hal_sim_t *)ctx;
+    sim->inhibited = inhibit;
+    return hal_sim_set_duty(ctx, 0, sim->duty);
+}
+
+static const hal_sensor_ops_t s_sim_sensor_ops = {
+    .read = hal_sim_read,
+};
+
+static const hal_actuator_ops_t s_sim_actuator_ops = {
+    .set_duty = hal_sim_set_duty,
+    .get_duty = hal_sim_get_duty,
+    .stop = hal_sim_stop,
+    .inhibit = hal_sim_inhibit,
+};
+
+void hal_sim_init(hal_sim_t *sim, const plant_params_t *params, uint32_t seed)
+{
+    plant_model_init(&sim->plant, params, seed);
+    sim->duty = 0;
+    sim->read_count = 0;
+    sim->bus_error = false;
+    sim->inhibited = false;
+}
+
+esp_err_t hal_sim_bind(hal_sim_t *sim, hal_sensor_t *sensor, hal_actuator_t *actuator)
+{
+    if (sim == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sensor != NULL) {
+        *sensor = (hal_sensor_t) {
+            .ops = &s_sim_sensor_ops,
+            .ctx = sim,
+            .name = "sim",
+            .channels = 1,
+        };
+    }
+    if (actuator != NULL) {
+        *actuator = (hal_actuator_t) {
+            .ops = &s_sim_actuator_ops,
+            .ctx = sim,
+            .name = "sim",
+            .channels = 1,
+            .max_duty = HAL_SIM_MAX_DUTY,
+        };
+    }
+    return ESP_OK;
+}
+
+void hal_sim_advance(hal_sim_t *sim, uint64_t dt_us)
+{
+    plant_model_advance(&sim->plant, dt_us);
+}
@@ -0,0 +1,40 @@
+/*
+ * Simulated Sensor/Actuator Backend
+ *
+ * Binds a plant_model_t behind the hal_sensor_t and hal_actuator_t
+ * interfaces, so the sampler and controller can run against a simulated
+ * heater. Time is driven by the caller through hal_sim_advance(), which
+ * lets host tools run much faster than real time.
+ */
+
+#ifndef HAL_SIM_H
+#define HAL_SIM_H
+
+#include "hal_sensor.h"
+#include "hal_actuator.h"
+#include "plant_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HAL_SIM_MAX_DUTY   4095   // Same resolution as the LEDC output
+
+typedef struct {
+    plant_model_t plant;
+    uint32_t duty;
+    uint32_t read_count;
+    bool bus_error;           // Fault injection: reads fail at the transport level
+    bool inhibited;           // Safety cutoff: the plant sees 0 whatever duty is set
+} hal_sim_t;
+
+// Function prototypes
+void hal_sim_init(hal_sim_t *sim, const plant_params_t *params, uint32_t seed);
+esp_err_t hal_sim_bind(hal_sim_t *sim, hal_sensor_t *sensor, hal_actuator_t *actuator);
+void hal_sim_advance(hal_sim_t *sim, uint64_t dt_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HAL_SIM_H
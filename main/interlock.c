@@ -0,0 +1,200 @@
+/*
+ * Heater Safety Interlock Checks Implementation
+ */
+
+#include <string.h>
+#include "interlock.h"
+
+esp_err_t interlock_init(interlock_t *il, const interlock_config_t *config, const plant_params_t *model,
+                         size_t channel_count)
+{
+    if (il == NULL || config == NULL || model == NULL ||
+        channel_count == 0 || channel_count > INTERLOCK_MAX_CHANNELS ||
+        config->sample_max_age_ms == 0 || config->rise_window_ms == 0 || config->confirm_samples == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(il, 0, sizeof(*il));
+    il->config = *config;
+    il->model = *model;
+    il->channel_count = channel_count;
+    il->started_us = -1;
+    return ESP_OK;
+}
+
+// Rate against the newest reading at least rise_window_ms older than this one
+static void update_rate(interlock_t *il, interlock_channel_t *ch, float temperature, int64_t timestamp_us)
+{
+    const int64_t window_us = (int64_t)il->config.rise_window_ms * 1000;
+    bool have_rate = false;
+
+    for (size_t n = 1; n <= ch->history_count; n++) {
+        size_t i = (ch->history_head + INTERLOCK_HISTORY - n) % INTERLOCK_HISTORY;
+        int64_t dt_us = timestamp_us - ch->history_us[i];
+        if (dt_us >= window_us) {
+            ch->rate_c_per_s = (temperature - ch->history_c[i]) * 1e6f / (float)dt_us;
+            have_rate = true;
+            break;
+        }
+    }
+
+    ch->history_c[ch->history_head] = temperature;
+    ch->history_us[ch->history_head] = timestamp_us;
+    ch->history_head = (ch->history_head + 1) % INTERLOCK_HISTORY;
+    if (ch->history_count < INTERLOCK_HISTORY) {
+        ch->history_count++;
+    }
+
+    if (!have_rate) {
+        ch->rate_c_per_s = 0.0f;
+        ch->rise_count = 0;
+    } else if (ch->rate_c_per_s > il->config.max_rise_c_per_s) {
+        ch->rise_count++;
+    } else {
+        ch->rise_count = 0;
+    }
+}
+
+// Channel 0 must warm up when zone 0 is driven well past what holds it
+static bool update_stuck(interlock_t *il, const interlock_reading_t *reading, float duty)
+{
+    const interlock_config_t *cfg = &il->config;
+
+    if (cfg->stuck_window_s == 0) {
+        return false;
+    }
+    if (!il->window_active) {
+        il->window_active = true;
+        il->window_start_us = reading->timestamp_us;
+        il->window_last_us = reading->timestamp_us;
+        il->window_start_c = reading->temperature;
+        il->window_duty_us = 0.0;
+        return false;
+    }
+
+    il->window_duty_us += (double)duty * (double)(reading->timestamp_us - il->window_last_us);
+    il->window_last_us = reading->timestamp_us;
+
+    int64_t elapsed_us = reading->timestamp_us - il->window_start_us;
+    if (elapsed_us < (int64_t)cfg->stuck_window_s * 1000000) {
+        return false;
+    }
+
+    float mean_duty = (float)(il->window_duty_us / (double)elapsed_us);
+    float excess = mean_duty - plant_model_steady_state_duty(&il->model, reading->temperature);
+    bool stuck = excess >= cfg->stuck_excess_duty &&
+                 reading->temperature - il->window_start_c < cfg->stuck_min_rise_c;
+
+    il->window_start_us = reading->timestamp_us;
+    il->window_start_c = reading->temperature;
+    il->window_duty_us = 0.0;
+    return stuck;
+}
+
+uint32_t interlock_check(interlock_t *il, const interlock_reading_t *readings, size_t count, float duty,
+                         int64_t now_us, int64_t *detected_us)
+{
+    const interlock_config_t *cfg = &il->config;
+    const int64_t max_age_us = (int64_t)cfg->sample_max_age_ms * 1000;
+    int64_t detected = INT64_MAX;
+    uint32_t active = 0;
+    uint32_t events = 0;
+
+    if (il->started_us < 0) {
+        il->started_us = now_us;
+    }
+
+    for (size_t c = 0; c < il->channel_count; c++) {
+        interlock_channel_t *ch = &il->channels[c];
+        const interlock_reading_t *reading = (c < count) ? &readings[c] : NULL;
+
+        if (reading != NULL && reading->sequence != 0 && reading->sequence != ch->sequence) {
+            ch->sequence = reading->sequence;
+            ch->open_count = reading->open ? ch->open_count + 1 : 0;
+
+            // Invalid readings neither confirm nor clear the temperature checks
+            if (reading->valid) {
+                ch->last_valid_us = reading->timestamp_us;
+                ch->over_count = (reading->temperature > cfg->max_temp_c) ? ch->over_count + 1 : 0;
+                update_rate(il, ch, reading->temperature, reading->timestamp_us);
+                if (c == 0 && update_stuck(il, reading, duty)) {
+                    events |= INTERLOCK_FAULT_STUCK;
+                }
+            } else if (c == 0) {
+                il->window_active = false;
+            }
+
+            uint32_t confirmed = 0;
+            if (ch->open_count == cfg->confirm_samples) {
+                confirmed |= INTERLOCK_FAULT_SENSOR;
+            }
+            if (ch->over_count == cfg->confirm_samples) {
+                confirmed |= INTERLOCK_FAULT_OVER_TEMP;
+            }
+            if (ch->rise_count == cfg->confirm_samples) {
+                confirmed |= INTERLOCK_FAULT_RISE;
+            }
+            if (((confirmed | events) & ~il->latched) && reading->timestamp_us < detected) {
+                detected = reading->timestamp_us;
+            }
+        }
+
+        if (ch->open_count >= cfg->confirm_samples) {
+            active |= INTERLOCK_FAULT_SENSOR;
+        }
+        if (ch->over_count >= cfg->confirm_samples) {
+            active |= INTERLOCK_FAULT_OVER_TEMP;
+        }
+        if (ch->rise_count >= cfg->confirm_samples) {
+            active |= INTERLOCK_FAULT_RISE;
+        }
+
+        int64_t since_us = (ch->history_count > 0) ? ch->last_valid_us : il->started_us;
+        int64_t stale_at_us = since_us + max_age_us;
+        if (now_us > stale_at_us) {
+            active |= INTERLOCK_FAULT_STALE;
+            if (!(il->latched & INTERLOCK_FAULT_STALE) && stale_at_us < detected) {
+                detected = stale_at_us;
+            }
+        }
+    }
+
+    il->active = active;
+    uint32_t found = (active | events) & ~il->latched;
+    il->latched |= found;
+    if (detected_us != NULL) {
+        *detected_us = (found != 0 && detected != INT64_MAX) ? detected : now_us;
+    }
+    return found;
+}
+
+uint32_t interlock_trip(interlock_t *il, uint32_t faults)
+{
+    uint32_t found = faults & ~il->latched;
+    il->latched |= found;
+    return found;
+}
+
+esp_err_t interlock_acknowledge(interlock_t *il)
+{
+    if (il->active != 0) {
+        return ESP_ERR_INVALID_STATE;  // The cause is still there
+    }
+
+    il->latched = 0;
+    il->window_active = false;
+    return ESP_OK;
+}
+
+const char *interlock_fault_name(uint32_t fault)
+{
+    switch (fault) {
+    case INTERLOCK_FAULT_STALE:     return "stale";
+    case INTERLOCK_FAULT_SENSOR:    return "sensor";
+    case INTERLOCK_FAULT_OVER_TEMP: return "over_temp";
+    case INTERLOCK_FAULT_RISE:      return "rise";
+    case INTERLOCK_FAULT_STUCK:     return "stuck";
+    case INTERLOCK_FAULT_TEST:      return "test";
+    default:                        return "unknown";
+    }
+}
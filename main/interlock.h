@@ -0,0 +1,138 @@
+/*
+ * Heater Safety Interlock Checks
+ *
+ * The conditions that must cut the heater off regardless of what the
+ * control loop, a profile, autotune or an API client asks for:
+ *
+ *   stale      No valid reading from a channel for sample_max_age_ms
+ *              (bus failure, sampler stopped)
+ *   sensor     Thermocouple open on confirm_samples consecutive reads
+ *   over_temp  A channel above max_temp_c on confirm_samples consecutive reads
+ *   rise       A channel rising faster than max_rise_c_per_s over
+ *              rise_window_ms, on confirm_samples consecutive reads
+ *   stuck      Channel 0 not following the heater: over stuck_window_s the
+ *              mean duty of zone 0 was stuck_excess_duty above the plant
+ *              model's steady-state duty at the measured temperature, yet
+ *              the reading rose by less than stuck_min_rise_c (probe
+ *              detached from the drum, reading frozen)
+ *
+ * Faults latch until interlock_acknowledge(), which is refused while any
+ * condition is still present. Every fault carries the time it became
+ * observable (the reading that confirmed it, or the moment a channel went
+ * stale), so the caller can measure detection-to-cutoff latency.
+ *
+ * No RTOS dependencies: the safety task runs it on the device, host tools
+ * run it against the plant model.
+ */
+
+#ifndef INTERLOCK_H
+#define INTERLOCK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "plant_model.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTERLOCK_MAX_CHANNELS        8
+#define INTERLOCK_HISTORY             16      // Readings kept per channel for the rise check
+
+// Defaults
+#define INTERLOCK_MAX_TEMP_C          375.0f  // 25°C above CONTROL_MAX_SETPOINT
+#define INTERLOCK_SAMPLE_MAX_AGE_MS   1000    // As CONTROL_SAMPLE_MAX_AGE_MS
+#define INTERLOCK_MAX_RISE_C_PER_S    5.0f    // Full power moves the drum < 2°C/s
+#define INTERLOCK_RISE_WINDOW_MS      2000
+#define INTERLOCK_CONFIRM_SAMPLES     2       // A single spike never trips
+#define INTERLOCK_STUCK_WINDOW_S      60
+#define INTERLOCK_STUCK_EXCESS_DUTY   0.35f   // Full scale, above the model's steady state
+#define INTERLOCK_STUCK_MIN_RISE_C    2.0f
+
+// Fault bits
+#define INTERLOCK_FAULT_STALE         (1u << 0)
+#define INTERLOCK_FAULT_SENSOR        (1u << 1)
+#define INTERLOCK_FAULT_OVER_TEMP     (1u << 2)
+#define INTERLOCK_FAULT_RISE          (1u << 3)
+#define INTERLOCK_FAULT_STUCK         (1u << 4)
+#define INTERLOCK_FAULT_TEST          (1u << 5)   // Requested trip, proves the cutoff path
+#define INTERLOCK_FAULT_COUNT         6
+
+typedef struct {
+    float max_temp_c;
+    uint32_t sample_max_age_ms;
+    float max_rise_c_per_s;
+    uint32_t rise_window_ms;
+    uint32_t confirm_samples;
+    uint32_t stuck_window_s;      // 0: stuck check off
+    float stuck_excess_duty;      // 0..1
+    float stuck_min_rise_c;
+} interlock_config_t;
+
+#define INTERLOCK_CONFIG_DEFAULT() {                    \
+    .max_temp_c = INTERLOCK_MAX_TEMP_C,                 \
+    .sample_max_age_ms = INTERLOCK_SAMPLE_MAX_AGE_MS,   \
+    .max_rise_c_per_s = INTERLOCK_MAX_RISE_C_PER_S,     \
+    .rise_window_ms = INTERLOCK_RISE_WINDOW_MS,         \
+    .confirm_samples = INTERLOCK_CONFIRM_SAMPLES,       \
+    .stuck_window_s = INTERLOCK_STUCK_WINDOW_S,         \
+    .stuck_excess_duty = INTERLOCK_STUCK_EXCESS_DUTY,   \
+    .stuck_min_rise_c = INTERLOCK_STUCK_MIN_RISE_C,     \
+}
+
+// One channel's latest published reading
+typedef struct {
+    float temperature;            // °C, meaningful only when valid
+    int64_t timestamp_us;         // Time of the read
+    uint32_t sequence;            // Changes with every new reading, 0: none yet
+    bool valid;                   // Read succeeded
+    bool open;                    // Thermocouple open
+} interlock_reading_t;
+
+typedef struct {
+    uint32_t sequence;            // Last reading seen
+    int64_t last_valid_us;        // Time of the last valid reading
+    uint32_t open_count;          // Consecutive open reads
+    uint32_t over_count;          // Consecutive readings above max_temp_c
+    uint32_t rise_count;          // Consecutive readings rising too fast
+    float history_c[INTERLOCK_HISTORY];
+    int64_t history_us[INTERLOCK_HISTORY];
+    size_t history_head;          // Next slot
+    size_t history_count;
+    float rate_c_per_s;           // Over rise_window_ms, last computed
+} interlock_channel_t;
+
+typedef struct {
+    interlock_config_t config;
+    plant_params_t model;
+    size_t channel_count;
+    interlock_channel_t channels[INTERLOCK_MAX_CHANNELS];
+
+    // Stuck check on channel 0 against zone 0
+    bool window_active;
+    int64_t window_start_us;
+    int64_t window_last_us;
+    float window_start_c;
+    double window_duty_us;        // Integral of the duty over the window
+
+    uint32_t active;              // Conditions present at the last check
+    uint32_t latched;             // Faults since the last acknowledge
+    int64_t started_us;           // First check; channels count as stale from here
+} interlock_t;
+
+// Function prototypes
+esp_err_t interlock_init(interlock_t *il, const interlock_config_t *config, const plant_params_t *model,
+                         size_t channel_count);
+uint32_t interlock_check(interlock_t *il, const interlock_reading_t *readings, size_t count, float duty,
+                         int64_t now_us, int64_t *detected_us);
+uint32_t interlock_trip(interlock_t *il, uint32_t faults);
+esp_err_t interlock_acknowledge(interlock_t *il);
+const char *interlock_fault_name(uint32_t fault);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // INTERLOCK_H
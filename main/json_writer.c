@@ -0,0 +1,578 @@
+/*
+ * Zero-Allocation JSON Writer and Scanner Implementation
+ */
+
+#include <math.h>
+#include <string.h>
+#include "json_writer.h"
+
+static const uint64_t s_pow10[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+};
+
+#define JSON_MAX_DECIMALS  (sizeof(s_pow10) / sizeof(s_pow10[0]) - 1)
+
+// ---------------------------------------------------------------------------
+// Writer
+// ---------------------------------------------------------------------------
+
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_flush_fn_t flush, void *flush_ctx)
+{
+    *w = (json_writer_t) {
+        .buf = buf,
+        .size = size,
+        .flush = flush,
+        .flush_ctx = flush_ctx,
+        .status = ESP_OK,
+    };
+}
+
+esp_err_t json_writer_flush(json_writer_t *w)
+{
+    if (w->status != ESP_OK) {
+        return w->status;
+    }
+
+    if (w->len > 0 && w->flush != NULL) {
+        w->status = w->flush(w->flush_ctx, w->buf, w->len);
+        w->len = 0;
+    }
+    return w->status;
+}
+
+static void put(json_writer_t *w, const char *data, size_t len)
+{
+    while (len > 0 && w->status == ESP_OK) {
+        if (w->len == w->size) {
+            if (w->flush == NULL) {
+                w->status = ESP_ERR_NO_MEM;
+                return;
+            }
+            json_writer_flush(w);
+            continue;
+        }
+
+        size_t n = w->size - w->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        w->total += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static inline void put_char(json_writer_t *w, char c)
+{
+    put(w, &c, 1);
+}
+
+// Comma before every member but the first of its container
+static void separator(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+
+    uint32_t bit = 1u << w->depth;
+    if (w->has_items & bit) {
+        put_char(w, ',');
+    }
+    w->has_items |= bit;
+}
+
+static void open_container(json_writer_t *w, char c)
+{
+    separator(w);
+    put_char(w, c);
+
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->status = ESP_ERR_INVALID_STATE;
+        return;
+    }
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+}
+
+static void close_container(json_writer_t *w, char c)
+{
+    put_char(w, c);
+    if (w->depth > 0) {
+        w->depth--;
+    }
+}
+
+void json_obj_begin(json_writer_t *w)
+{
+    open_container(w, '{');
+}
+
+void json_obj_end(json_writer_t *w)
+{
+    close_container(w, '}');
+}
+
+void json_arr_begin(json_writer_t *w)
+{
+    open_container(w, '[');
+}
+
+void json_arr_end(json_writer_t *w)
+{
+    close_container(w, ']');
+}
+
+static void put_string(json_writer_t *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put_char(w, '"');
+    const char *run = s;
+    for (; *s != '\0'; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        // Copy the clean run, then the escape
+        put(w, run, s - run);
+        run = s + 1;
+        switch (c) {
+        case '"':  put(w, "\\\"", 2); break;
+        case '\\': put(w, "\\\\", 2); break;
+        case '\n': put(w, "\\n", 2); break;
+        case '\r': put(w, "\\r", 2); break;
+        case '\t': put(w, "\\t", 2); break;
+        default: {
+            char esc[6] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+            put(w, esc, sizeof(esc));
+            break;
+        }
+        }
+    }
+    put(w, run, s - run);
+    put_char(w, '"');
+}
+
+void json_key(json_writer_t *w, const char *key)
+{
+    separator(w);
+    put_string(w, key);
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_str(json_writer_t *w, const char *value)
+{
+    if (value == NULL) {
+        json_null(w);
+        return;
+    }
+    separator(w);
+    put_string(w, value);
+}
+
+static void put_u64(json_writer_t *w, uint64_t value, unsigned min_digits)
+{
+    char digits[20];
+    size_t n = 0;
+
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0 || n < min_digits);
+
+    put(w, digits + sizeof(digits) - n, n);
+}
+
+void json_uint(json_writer_t *w, uint64_t value)
+{
+    separator(w);
+    put_u64(w, value, 1);
+}
+
+void json_int(json_writer_t *w, int64_t value)
+{
+    separator(w);
+    if (value < 0) {
+        put_char(w, '-');
+        put_u64(w, (uint64_t)0 - (uint64_t)value, 1);
+    } else {
+        put_u64(w, (uint64_t)value, 1);
+    }
+}
+
+void json_fixed(json_writer_t *w, double value, unsigned decimals)
+{
+    if (isnan(value) || isinf(value) || fabs(value) >= 1e15) {
+        json_null(w);  // Not representable in JSON / beyond the fixed-point range
+        return;
+    }
+
+    if (decimals > JSON_MAX_DECIMALS) {
+        decimals = JSON_MAX_DECIMALS;
+    }
+
+    uint64_t scale = s_pow10[decimals];
+    uint64_t scaled = (uint64_t)(fabs(value) * (double)scale + 0.5);
+
+    separator(w);
+    if (value < 0 && scaled != 0) {
+        put_char(w, '-');
+    }
+    put_u64(w, scaled / scale, 1);
+    if (decimals > 0) {
+        put_char(w, '.');
+        put_u64(w, scaled % scale, decimals);
+    }
+}
+
+void json_bool(json_writer_t *w, bool value)
+{
+    separator(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_null(json_writer_t *w)
+{
+    separator(w);
+    put(w, "null", 4);
+}
+
+void json_raw(json_writer_t *w, const char *data, size_t len)
+{
+    separator(w);
+    put(w, data, len);
+}
+
+// ---------------------------------------------------------------------------
+// Scanner
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    const char *p;
+    const char *end;
+} json_scan_t;
+
+static void skip_ws(json_scan_t *s)
+{
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+// At the opening quote; leaves p after the closing quote
+static bool skip_string(json_scan_t *s)
+{
+    s->p++;
+    while (s->p < s->end) {
+        char c = *s->p++;
+        if (c == '\\') {
+            s->p++;
+        } else if (c == '"') {
+            return s->p <= s->end;
+        }
+    }
+    return false;
+}
+
+static bool skip_value(json_scan_t *s)
+{
+    if (s->p >= s->end) {
+        return false;
+    }
+
+    if (*s->p == '"') {
+        return skip_string(s);
+    }
+
+    if (*s->p == '{' || *s->p == '[') {
+        int depth = 0;
+        while (s->p < s->end) {
+            char c = *s->p;
+            if (c == '"') {
+                if (!skip_string(s)) {
+                    return false;
+                }
+                continue;
+            }
+            s->p++;
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if ((c == '}' || c == ']') && --depth == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Number or literal
+    const char *start = s->p;
+    while (s->p < s->end && *s->p != ',' && *s->p != '}' && *s->p != ']' &&
+           *s->p != ' ' && *s->p != '\t' && *s->p != '\n' && *s->p != '\r') {
+        s->p++;
+    }
+    return s->p > start;
+}
+
+// Positions s at the value of a top-level member
+static esp_err_t find_value(const char *json, size_t len, const char *key, json_scan_t *s)
+{
+    if (json == NULL || key == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const size_t key_len = strlen(key);
+    *s = (json_scan_t) { .p = json, .end = json + len };
+
+    skip_ws(s);
+    if (s->p >= s->end || *s->p != '{') {
+        return ESP_FAIL;
+    }
+    s->p++;
+
+    for (;;) {
+        skip_ws(s);
+        if (s->p < s->end && *s->p == '}') {
+            return ESP_ERR_NOT_FOUND;
+        }
+        if (s->p >= s->end || *s->p != '"') {
+            return ESP_FAIL;
+        }
+
+        // Keys are compared raw; escaped keys never match plain ASCII names
+        const char *name = s->p + 1;
+        if (!skip_string(s)) {
+            return ESP_FAIL;
+        }
+        bool match = (size_t)(s->p - 1 - name) == key_len && memcmp(name, key, key_len) == 0;
+
+        skip_ws(s);
+        if (s->p >= s->end || *s->p != ':') {
+            return ESP_FAIL;
+        }
+        s->p++;
+        skip_ws(s);
+
+        if (match) {
+            return ESP_OK;
+        }
+        if (!skip_value(s)) {
+            return ESP_FAIL;
+        }
+
+        skip_ws(s);
+        if (s->p < s->end && *s->p == ',') {
+            s->p++;
+        } else if (s->p < s->end && *s->p == '}') {
+            return ESP_ERR_NOT_FOUND;
+        } else {
+            return ESP_FAIL;
+        }
+    }
+}
+
+// Plain decimal parser; strtod may allocate for long inputs. The number
+// must end the value: only whitespace, ',', '}' or ']' may follow it.
+static esp_err_t parse_number(json_scan_t *s, double *value)
+{
+    bool negative = false;
+    if (s->p < s->end && (*s->p == '-' || *s->p == '+')) {
+        negative = (*s->p == '-');
+        s->p++;
+    }
+
+    double result = 0.0;
+    int digits = 0;
+    while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+        result = result * 10.0 + (*s->p++ - '0');
+        digits++;
+    }
+
+    if (s->p < s->end && *s->p == '.') {
+        s->p++;
+        double place = 0.1;
+        while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+            result += (*s->p++ - '0') * place;
+            place *= 0.1;
+            digits++;
+        }
+    }
+
+    if (digits == 0) {
+        return ESP_ERR_INVALID_ARG;  // Not a number (string, bool, ...)
+    }
+
+    if (s->p < s->end && (*s->p == 'e' || *s->p == 'E')) {
+        s->p++;
+        bool exp_negative = false;
+        if (s->p < s->end && (*s->p == '-' || *s->p == '+')) {
+            exp_negative = (*s->p == '-');
+            s->p++;
+        }
+        int exponent = 0;
+        int exp_digits = 0;
+        while (s->p < s->end && *s->p >= '0' && *s->p <= '9') {
+            if (exponent < 400) {
+                exponent = exponent * 10 + (*s->p - '0');
+            }
+            s->p++;
+            exp_digits++;
+        }
+        if (exp_digits == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        while (exponent-- > 0) {
+            result = exp_negative ? result / 10.0 : result * 10.0;
+        }
+    }
+
+    skip_ws(s);
+    if (s->p < s->end && *s->p != ',' && *s->p != '}' && *s->p != ']') {
+        return ESP_ERR_INVALID_ARG;  // Trailing garbage
+    }
+    if (!isfinite(result)) {
+        return ESP_ERR_INVALID_ARG;  // Overflowed
+    }
+
+    *value = negative ? -result : result;
+    return ESP_OK;
+}
+
+esp_err_t json_scan_number(const char *json, size_t len, const char *key, double *value)
+{
+    json_scan_t s;
+    esp_err_t ret = find_value(json, len, key, &s);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return parse_number(&s, value);
+}
+
+// A bare number, such as an element from json_scan_array_next()
+esp_err_t json_parse_number(const char *text, size_t len, double *value)
+{
+    if (text == NULL || value == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    json_scan_t s = { .p = text, .end = text + len };
+    skip_ws(&s);
+    return parse_number(&s, value);
+}
+
+esp_err_t json_scan_bool(const char *json, size_t len, const char *key, bool *value)
+{
+    json_scan_t s;
+    esp_err_t ret = find_value(json, len, key, &s);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t left = s.end - s.p;
+    if (left >= 4 && memcmp(s.p, "true", 4) == 0) {
+        *value = true;
+    } else if (left >= 5 && memcmp(s.p, "false", 5) == 0) {
+        *value = false;
+    } else {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+esp_err_t json_scan_string(const char *json, size_t len, const char *key, char *value, size_t size)
+{
+    json_scan_t s;
+    esp_err_t ret = find_value(json, len, key, &s);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    if (s.p >= s.end || *s.p != '"' || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s.p++;
+
+    size_t n = 0;
+    while (s.p < s.end && *s.p != '"') {
+        char c = *s.p++;
+        if (c == '\\' && s.p < s.end) {
+            c = *s.p++;
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'u':
+                c = '?';  // Only ASCII payloads are expected
+                s.p += (s.end - s.p >= 4) ? 4 : (s.end - s.p);
+                break;
+            default: break;  // \" \\ \/
+            }
+        }
+        if (n + 1 >= size) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        value[n++] = c;
+    }
+
+    if (s.p >= s.end) {
+        return ESP_FAIL;  // Unterminated
+    }
+    value[n] = '\0';
+    return ESP_OK;
+}
+
+// Walks the elements of an array member. Start with *cursor = NULL; each call
+// returns the next element's text and ESP_ERR_NOT_FOUND after the last one.
+esp_err_t json_scan_array_next(const char *json, size_t len, const char *key, const char **cursor,
+                               const char **element, size_t *element_len)
+{
+    if (cursor == NULL || element == NULL || element_len == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    json_scan_t s;
+    if (*cursor == NULL) {
+        esp_err_t ret = find_value(json, len, key, &s);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        if (s.p >= s.end || *s.p != '[') {
+            return ESP_ERR_INVALID_ARG;
+        }
+        s.p++;
+    } else {
+        s = (json_scan_t) { .p = *cursor, .end = json + len };
+    }
+
+    skip_ws(&s);
+    if (s.p < s.end && *s.p == ']') {
+        *cursor = s.p;
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    const char *start = s.p;
+    if (!skip_value(&s)) {
+        return ESP_FAIL;
+    }
+    *element = start;
+    *element_len = s.p - start;
+
+    skip_ws(&s);
+    if (s.p < s.end && *s.p == ',') {
+        s.p++;
+    } else if (s.p >= s.end || *s.p != ']') {
+        return ESP_FAIL;
+    }
+    *cursor = s.p;
+    return ESP_OK;
+}
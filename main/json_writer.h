@@ -0,0 +1,113 @@
+/*
+ * Zero-Allocation JSON Writer and Scanner
+ *
+ * The writer emits compact JSON into a caller-provided buffer. When a
+ * flush callback is given, full buffers are handed to it (e.g. as HTTP
+ * chunks), so responses of any size need only the fixed buffer. Numbers
+ * are formatted without printf, so nothing in here touches the heap.
+ *
+ * The scanner reads single values out of a flat JSON object (a POST body)
+ * in place, without building a tree. Arrays are walked one element at a
+ * time; an element that is an object is scanned the same way.
+ *
+ * Pure C, no ESP-IDF dependencies beyond esp_err.h: also built on the host.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JSON_WRITER_MAX_DEPTH   16
+
+// Receives each full buffer; returning an error stops the writer
+typedef esp_err_t (*json_flush_fn_t)(void *ctx, const char *data, size_t len);
+
+// Writer State
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;                // Bytes pending in buf
+    size_t total;              // Bytes emitted, flushed or pending
+    json_flush_fn_t flush;     // NULL: everything must fit in buf
+    void *flush_ctx;
+    uint32_t has_items;        // Bit n: container at depth n already has a member
+    uint8_t depth;
+    bool after_key;
+    esp_err_t status;          // First error (ESP_ERR_NO_MEM on overflow)
+} json_writer_t;
+
+// Function prototypes
+void json_writer_init(json_writer_t *w, char *buf, size_t size, json_flush_fn_t flush, void *flush_ctx);
+esp_err_t json_writer_flush(json_writer_t *w);
+
+void json_obj_begin(json_writer_t *w);
+void json_obj_end(json_writer_t *w);
+void json_arr_begin(json_writer_t *w);
+void json_arr_end(json_writer_t *w);
+void json_key(json_writer_t *w, const char *key);
+
+void json_str(json_writer_t *w, const char *value);
+void json_int(json_writer_t *w, int64_t value);
+void json_uint(json_writer_t *w, uint64_t value);
+void json_fixed(json_writer_t *w, double value, unsigned decimals);
+void json_bool(json_writer_t *w, bool value);
+void json_null(json_writer_t *w);
+void json_raw(json_writer_t *w, const char *data, size_t len);
+
+esp_err_t json_scan_number(const char *json, size_t len, const char *key, double *value);
+esp_err_t json_parse_number(const char *text, size_t len, double *value);
+esp_err_t json_scan_bool(const char *json, size_t len, const char *key, bool *value);
+esp_err_t json_scan_string(const char *json, size_t len, const char *key, char *value, size_t size);
+esp_err_t json_scan_array_next(const char *json, size_t len, const char *key, const char **cursor,
+                               const char **element, size_t *element_len);
+
+// Key/value shorthands
+static inline void json_kv_str(json_writer_t *w, const char *key, const char *value)
+{
+    json_key(w, key);
+    json_str(w, value);
+}
+
+static inline void json_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_key(w, key);
+    json_int(w, value);
+}
+
+static inline void json_kv_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    json_key(w, key);
+    json_uint(w, value);
+}
+
+static inline void json_kv_fixed(json_writer_t *w, const char *key, double value, unsigned decimals)
+{
+    json_key(w, key);
+    json_fixed(w, value, decimals);
+}
+
+static inline void json_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_key(w, key);
+    json_bool(w, value);
+}
+
+static inline void json_kv_null(json_writer_t *w, const char *key)
+{
+    json_key(w, key);
+    json_null(w);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // JSON_WRITER_H
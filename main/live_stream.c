@@ -0,0 +1,316 @@
+/*
+ * Live Stream (Server-Sent Events) Implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "live_stream.h"
+#include "control_task.h"
+#include "telemetry.h"
+#include "json_writer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "LIVE_STREAM";
+
+typedef struct {
+    httpd_req_t *req;           // Async copy, owned until httpd_req_async_handler_complete()
+    uint32_t decimation;
+    uint32_t countdown;         // Ticks until the next event
+    TickType_t last_send;
+} live_stream_client_t;
+
+typedef enum {
+    SEND_SAMPLE,       // Decimated per client
+    SEND_ALL,          // Every client, now
+    SEND_HEARTBEAT,    // Only to clients idle for LIVE_STREAM_HEARTBEAT_MS
+} send_kind_t;
+
+// Owned by the stream task, which does every send with no lock held; a slow
+// client can only delay the stream, never the httpd task
+static live_stream_client_t s_clients[LIVE_STREAM_MAX_CLIENTS];
+static size_t s_client_count = 0;               // Written under s_lock
+
+// New subscribers handed over by the httpd task, protected by s_lock
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static live_stream_client_t s_pending[LIVE_STREAM_MAX_CLIENTS];
+static size_t s_pending_count = 0;
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+
+// Moves the new subscribers into s_clients; stream task only
+static void adopt_pending(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    for (size_t i = 0; i < s_pending_count && s_client_count < LIVE_STREAM_MAX_CLIENTS; i++) {
+        s_clients[s_client_count++] = s_pending[i];
+    }
+    s_pending_count = 0;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Stream task only
+static void remove_client(size_t index)
+{
+    httpd_req_async_handler_complete(s_clients[index].req);
+
+    portENTER_CRITICAL(&s_lock);
+    s_clients[index] = s_clients[--s_client_count];
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Serializes one record as an SSE event; the same bytes go to every client
+static int format_event(char *buf, size_t size, uint32_t seq, const telemetry_sample_t *sample,
+                        const control_status_t *status)
+{
+    int prefix = snprintf(buf, size, "id: %" PRIu32 "\ndata: ", seq);
+
+    json_writer_t w;
+    json_writer_init(&w, buf + prefix, size - prefix - 2, NULL, NULL);
+    json_obj_begin(&w);
+    json_kv_uint(&w, "seq", seq);
+    json_kv_fixed(&w, "temperature", sample->temp_q2 * 0.25, 2);
+    json_kv_bool(&w, "sensor_ok", !sample->fault);
+    json_kv_fixed(&w, "output", sample->duty * 100.0 / TELEMETRY_DUTY_FULL_SCALE, 2);
+    json_kv_fixed(&w, "setpoint", status->setpoint, 2);
+    json_kv_str(&w, "mode", status->mode == CONTROL_MODE_AUTO ? "auto" : "manual");
+    json_kv_int(&w, "p", sample->p_term);
+    json_kv_int(&w, "i", sample->i_term);
+    json_kv_int(&w, "d", sample->d_term);
+    json_obj_end(&w);
+    if (w.status != ESP_OK) {
+        return -1;
+    }
+
+    // Blank line terminates the event (room reserved above)
+    int len = prefix + (int)w.len;
+    buf[len++] = '\n';
+    buf[len++] = '\n';
+    return len;
+}
+
+// Named event with the autotune progress object
+static int format_autotune_event(char *buf, size_t size, const autotune_progress_t *progress)
+{
+    static const char prefix[] = "event: autotune\ndata: ";
+    const int prefix_len = sizeof(prefix) - 1;
+    memcpy(buf, prefix, prefix_len);
+
+    json_writer_t w;
+    json_writer_init(&w, buf + prefix_len, size - prefix_len - 2, NULL, NULL);
+    json_obj_begin(&w);
+    autotune_progress_to_json(&w, progress);
+    json_obj_end(&w);
+    if (w.status != ESP_OK) {
+        return -1;
+    }
+
+    int len = prefix_len + (int)w.len;
+    buf[len++] = '\n';
+    buf[len++] = '\n';
+    return len;
+}
+
+static void send_to_clients(const char *event, int len, send_kind_t kind)
+{
+    static const char heartbeat[] = ": ping\n\n";
+    const TickType_t now = xTaskGetTickCount();
+
+    for (size_t i = 0; i < s_client_count; ) {
+        live_stream_client_t *client = &s_clients[i];
+        esp_err_t ret = ESP_OK;
+
+        if (kind == SEND_ALL || (kind == SEND_SAMPLE && --client->countdown == 0)) {
+            if (kind == SEND_SAMPLE) {
+                client->countdown = client->decimation;
+            }
+            ret = httpd_resp_send_chunk(client->req, event, len);
+            client->last_send = now;
+        } else if (now - client->last_send >= pdMS_TO_TICKS(LIVE_STREAM_HEARTBEAT_MS)) {
+            ret = httpd_resp_send_chunk(client->req, heartbeat, sizeof(heartbeat) - 1);
+            client->last_send = now;
+        }
+
+        if (ret != ESP_OK) {
+            ESP_LOGI(TAG, "Client disconnected (%u left)", (unsigned)(s_client_count - 1));
+            remove_client(i);
+            continue;  // Slot i now holds the former last client
+        }
+        i++;
+    }
+}
+
+static void live_stream_task(void *arg)
+{
+    uint32_t next_seq = telemetry_head();
+    char event[384];
+    autotune_state_t last_autotune = AUTOTUNE_STATE_IDLE;
+    TickType_t last_autotune_send = 0;
+
+    while (s_running) {
+        vTaskDelay(pdMS_TO_TICKS(LIVE_STREAM_POLL_MS));
+        adopt_pending();
+
+        autotune_progress_t tune;
+        control_task_get_autotune(&tune);
+        TickType_t now = xTaskGetTickCount();
+        if (s_client_count > 0 && (tune.state != last_autotune ||
+            (tune.state == AUTOTUNE_STATE_RUNNING &&
+             now - last_autotune_send >= pdMS_TO_TICKS(LIVE_STREAM_AUTOTUNE_MS)))) {
+            int len = format_autotune_event(event, sizeof(event), &tune);
+            if (len > 0) {
+                send_to_clients(event, len, SEND_ALL);
+            }
+            last_autotune_send = now;
+        }
+        last_autotune = tune.state;
+
+        uint32_t head = telemetry_head();
+        if (s_client_count == 0 || head == next_seq) {
+            next_seq = head;
+            send_to_clients(NULL, 0, SEND_HEARTBEAT);
+            continue;
+        }
+
+        // Fell behind by more than the ring: resume from the oldest record still there
+        uint32_t oldest = telemetry_oldest();
+        if ((int32_t)(next_seq - oldest) < 0) {
+            next_seq = oldest;
+        }
+
+        control_status_t status;
+        control_task_get_status(&status);
+
+        for (; next_seq != head; next_seq++) {
+            telemetry_sample_t sample;
+            if (!telemetry_read(next_seq, &sample)) {
+                continue;
+            }
+
+            int len = format_event(event, sizeof(event), next_seq, &sample, &status);
+            if (len > 0) {
+                send_to_clients(event, len, SEND_SAMPLE);
+            }
+        }
+    }
+
+    adopt_pending();
+    while (s_client_count > 0) {
+        remove_client(s_client_count - 1);
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t live_stream_start(void)
+{
+    if (s_task_handle != NULL) {
+        ESP_LOGW(TAG, "Live stream already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_running = true;
+    BaseType_t created = xTaskCreate(live_stream_task, "live_stream", LIVE_STREAM_STACK_SIZE, NULL,
+                                     LIVE_STREAM_PRIORITY, &s_task_handle);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create live stream task");
+        s_running = false;
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Live stream started, up to %d clients", LIVE_STREAM_MAX_CLIENTS);
+    return ESP_OK;
+}
+
+esp_err_t live_stream_stop(void)
+{
+    if (s_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_running = false;
+    while (s_task_handle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(LIVE_STREAM_POLL_MS));
+    }
+
+    ESP_LOGI(TAG, "Live stream stopped");
+    return ESP_OK;
+}
+
+// GET /api/stream?decimation=<n>
+esp_err_t live_stream_handler(httpd_req_t *req)
+{
+    if (s_task_handle == NULL) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Live stream not running", HTTPD_RESP_USE_STRLEN);
+    }
+
+    char query[32];
+    char value[8];
+    uint32_t decimation = LIVE_STREAM_DEFAULT_DECIMATION;
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "decimation", value, sizeof(value)) == ESP_OK) {
+        decimation = strtoul(value, NULL, 10);
+    }
+    if (decimation < 1) {
+        decimation = 1;
+    } else if (decimation > LIVE_STREAM_MAX_DECIMATION) {
+        decimation = LIVE_STREAM_MAX_DECIMATION;
+    }
+
+    if (s_client_count + s_pending_count >= LIVE_STREAM_MAX_CLIENTS) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        return httpd_resp_send(req, "Too many stream clients", HTTPD_RESP_USE_STRLEN);
+    }
+
+    // Headers and the retry hint go out now; events follow from the stream task
+    char preamble[32];
+    int len = snprintf(preamble, sizeof(preamble), "retry: %d\n\n", LIVE_STREAM_RETRY_MS);
+    httpd_resp_set_type(req, "text/event-stream");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+    if (httpd_resp_send_chunk(req, preamble, len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+
+    httpd_req_t *async_req = NULL;
+    esp_err_t ret = httpd_req_async_handler_begin(req, &async_req);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to detach request: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Only handed over here; the stream task adopts it on its next poll
+    const live_stream_client_t client = {
+        .req = async_req,
+        .decimation = decimation,
+        .countdown = 1,  // First event on the next tick
+        .last_send = xTaskGetTickCount(),
+    };
+    portENTER_CRITICAL(&s_lock);
+    size_t count = s_client_count + s_pending_count;
+    bool accepted = (count < LIVE_STREAM_MAX_CLIENTS);
+    if (accepted) {
+        s_pending[s_pending_count++] = client;
+        count++;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!accepted) {
+        httpd_req_async_handler_complete(async_req);
+        return ESP_OK;  // Lost the race for the last slot; the browser retries
+    }
+
+    ESP_LOGI(TAG, "Client subscribed, decimation %" PRIu32 " (%u clients)", decimation, (unsigned)count);
+    return ESP_OK;
+}
+
+size_t live_stream_client_count(void)
+{
+    return s_client_count;
+}
@@ -0,0 +1,48 @@
+/*
+ * Live Stream (Server-Sent Events)
+ *
+ * GET /api/stream?decimation=<n> keeps the connection open and pushes one
+ * "data:" event every <n> control ticks. A single task serializes each
+ * new telemetry record once and fans the same bytes out to every
+ * subscriber, so the cost per screen is one socket write instead of one
+ * HTTP request, JSON tree and print per poll.
+ *
+ * While an autotune runs, its progress goes to every subscriber as
+ * "event: autotune" (once per LIVE_STREAM_AUTOTUNE_MS and on each state
+ * change), independent of the decimation.
+ */
+
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_http_server.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Stream Configuration
+#define LIVE_STREAM_MAX_CLIENTS       10
+#define LIVE_STREAM_MAX_DECIMATION    240     // One event per minute at 4 Hz
+#define LIVE_STREAM_DEFAULT_DECIMATION 4      // 1 Hz
+#define LIVE_STREAM_POLL_MS           50      // Telemetry head polling
+#define LIVE_STREAM_HEARTBEAT_MS      15000   // Comment line to detect dead clients
+#define LIVE_STREAM_RETRY_MS          2000    // Browser reconnect delay
+#define LIVE_STREAM_AUTOTUNE_MS       1000    // Autotune progress events
+#define LIVE_STREAM_STACK_SIZE        4096
+#define LIVE_STREAM_PRIORITY          (tskIDLE_PRIORITY + 2)  // Below control and sampler
+
+// Function prototypes
+esp_err_t live_stream_start(void);
+esp_err_t live_stream_stop(void);
+esp_err_t live_stream_handler(httpd_req_t *req);
+size_t live_stream_client_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIVE_STREAM_H
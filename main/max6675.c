@@ -2,13 +2,27 @@
  * MAX6675 Thermocouple-to-Digital Converter Driver Implementation
  */
 
+#include <string.h>
 #include "max6675.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "MAX6675";
 
+static const spi_bus_config_t s_bus_cfg = {
+    .miso_io_num = MAX6675_MISO_PIN,
+    .mosi_io_num = MAX6675_MOSI_PIN,
+    .sclk_io_num = MAX6675_CLK_PIN,
+    .quadwp_io_num = -1,
+    .quadhd_io_num = -1,
+    .max_transfer_sz = 32,
+};
+
 esp_err_t max6675_init(max6675_handle_t *handle)
 {
     if (handle == NULL) {
@@ -16,18 +30,8 @@ esp_err_t max6675_init(max6675_handle_t *handle)
         return ESP_ERR_INVALID_ARG;
     }
 
-    // Initialize SPI bus configuration
-    spi_bus_config_t bus_cfg = {
-        .miso_io_num = MAX6675_MISO_PIN,
-        .mosi_io_num = MAX6675_MOSI_PIN,
-        .sclk_io_num = MAX6675_CLK_PIN,
-        .quadwp_io_num = -1,
-        .quadhd_io_num = -1,
-        .max_transfer_sz = 32,
-    };
-
     // Initialize SPI bus
-    esp_err_t ret = spi_bus_initialize(MAX6675_SPI_HOST, &bus_cfg, SPI_DMA_DISABLED);
+    esp_err_t ret = spi_bus_initialize(MAX6675_SPI_HOST, &s_bus_cfg, SPI_DMA_DISABLED);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
         return ret;
@@ -60,9 +64,9 @@ esp_err_t max6675_init(max6675_handle_t *handle)
     return ESP_OK;
 }
 
-esp_err_t max6675_read_temperature(max6675_handle_t *handle, float *temperature)
+esp_err_t max6675_read_raw(max6675_handle_t *handle, uint16_t *raw_data)
 {
-    if (handle == NULL || temperature == NULL) {
+    if (handle == NULL || raw_data == NULL) {
         ESP_LOGE(TAG, "Invalid parameters");
         return ESP_ERR_INVALID_ARG;
     }
@@ -82,29 +86,52 @@ esp_err_t max6675_read_temperature(max6675_handle_t *handle, float *temperature)
         .rx_buffer = rx_data,
     };
 
+    int64_t start_us = esp_timer_get_time();
     esp_err_t ret = spi_device_transmit(handle->spi_device, &trans);
+    metrics_observe(METRICS_SPI_READ, (uint32_t)(esp_timer_get_time() - start_us));
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "SPI transaction failed: %s", esp_err_to_name(ret));
+        DLOGE(TAG, "SPI transaction failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
     // Combine the two bytes (MSB first)
-    uint16_t raw_data = (rx_data[0] << 8) | rx_data[1];
+    *raw_data = (rx_data[0] << 8) | rx_data[1];
 
-    // Check for thermocouple connection (bit 2)
-    if (raw_data & 0x04) {
-        ESP_LOGW(TAG, "Thermocouple not connected");
-        return ESP_ERR_INVALID_RESPONSE;
-    }
+    return ESP_OK;
+}
 
+float max6675_raw_to_celsius(uint16_t raw_data)
+{
     // Extract temperature data (bits 15-3)
     // Temperature is in 0.25°C increments
     int16_t temp_raw = (raw_data >> 3) & 0x0FFF;
-    
+
+    return temp_raw * MAX6675_TEMP_LSB_C;
+}
+
+esp_err_t max6675_read_temperature(max6675_handle_t *handle, float *temperature)
+{
+    if (handle == NULL || temperature == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint16_t raw_data = 0;
+    esp_err_t ret = max6675_read_raw(handle, &raw_data);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    // Check for thermocouple connection (bit 2)
+    if (raw_data & MAX6675_FAULT_OPEN) {
+        DLOGW(TAG, "Thermocouple not connected");
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
     // Convert to Celsius
-    *temperature = temp_raw * 0.25f;
+    *temperature = max6675_raw_to_celsius(raw_data);
 
-    ESP_LOGD(TAG, "Raw data: 0x%04X, Temperature: %.2f°C", raw_data, *temperature);
+    DLOGD(TAG, "Raw data: 0x%04X, Temperature: %.2f°C", raw_data, *temperature);
 
     return ESP_OK;
 }
@@ -138,3 +165,197 @@ esp_err_t max6675_deinit(max6675_handle_t *handle)
 
     return ESP_OK;
 }
+
+// Runs in the SPI ISR when a device's transfer completes
+static void IRAM_ATTR max6675_post_cb(spi_transaction_t *trans)
+{
+    *(volatile int64_t *)trans->user = esp_timer_get_time();
+}
+
+esp_err_t max6675_bus_init(max6675_bus_t *bus, spi_host_device_t host)
+{
+    if (bus == NULL) {
+        ESP_LOGE(TAG, "Bus is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(bus, 0, sizeof(*bus));
+    bus->host = host;
+
+    // One bus for all devices; each device only adds its CS line
+    esp_err_t ret = spi_bus_initialize(host, &s_bus_cfg, SPI_DMA_DISABLED);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to initialize SPI bus: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    bus->initialized = true;
+    ESP_LOGI(TAG, "MAX6675 bus initialized on SPI host %d", host);
+    return ESP_OK;
+}
+
+esp_err_t max6675_bus_add_device(max6675_bus_t *bus, gpio_num_t cs_pin, size_t *channel)
+{
+    if (bus == NULL) {
+        ESP_LOGE(TAG, "Bus is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bus->initialized) {
+        ESP_LOGE(TAG, "MAX6675 bus not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (bus->device_count >= MAX6675_BUS_MAX_DEVICES) {
+        ESP_LOGE(TAG, "Bus full (%d devices)", MAX6675_BUS_MAX_DEVICES);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t index = bus->device_count;
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = MAX6675_CLOCK_SPEED,
+        .mode = 0,  // SPI mode 0 (CPOL=0, CPHA=0)
+        .spics_io_num = cs_pin,
+        .queue_size = 1,  // One read per device per pass
+        .flags = SPI_DEVICE_NO_DUMMY,
+        .post_cb = max6675_post_cb,
+    };
+
+    esp_err_t ret = spi_bus_add_device(bus->host, &dev_cfg, &bus->devices[index]);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add SPI device on CS %d: %s", cs_pin, esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Transactions are reused every pass; only the RX data changes
+    bus->trans[index] = (spi_transaction_t) {
+        .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA,
+        .length = 16,
+        .user = (void *)&bus->done_us[index],
+    };
+    bus->cs_pins[index] = cs_pin;
+    bus->device_count++;
+
+    if (channel != NULL) {
+        *channel = index;
+    }
+
+    ESP_LOGI(TAG, "MAX6675 channel %u on CS pin %d", (unsigned)index, cs_pin);
+    return ESP_OK;
+}
+
+esp_err_t max6675_bus_read_all(max6675_bus_t *bus, max6675_reading_t *readings, size_t count)
+{
+    if (bus == NULL || readings == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Every channel reads as failed unless its transfer completes below,
+    // including when the pass is cut short
+    for (size_t i = 0; i < count; i++) {
+        readings[i] = (max6675_reading_t) { .status = ESP_ERR_TIMEOUT };
+    }
+
+    if (!bus->initialized || count > bus->device_count) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const TickType_t timeout = pdMS_TO_TICKS(MAX6675_BUS_TIMEOUT_MS);
+    const int64_t start_us = esp_timer_get_time();
+    esp_err_t bus_status = ESP_OK;
+    bool queued[MAX6675_BUS_MAX_DEVICES] = { false };
+
+    // Queue every channel first so the transfers run back-to-back from the ISR
+    for (size_t i = 0; i < count; i++) {
+        // A transfer that timed out may still be in flight and the driver
+        // owns its descriptor until the result is collected: drain it, or
+        // leave the channel faulted for this pass
+        if (bus->pending[i]) {
+            spi_transaction_t *stale = NULL;
+            if (spi_device_get_trans_result(bus->devices[i], &stale, 0) != ESP_OK) {
+                DLOGW(TAG, "Channel %u still busy with a timed-out transfer", (unsigned)i);
+                bus_status = ESP_ERR_TIMEOUT;
+                continue;
+            }
+            bus->pending[i] = false;
+        }
+
+        bus->done_us[i] = 0;
+        esp_err_t ret = spi_device_queue_trans(bus->devices[i], &bus->trans[i], timeout);
+        if (ret != ESP_OK) {
+            DLOGE(TAG, "Failed to queue channel %u: %s", (unsigned)i, esp_err_to_name(ret));
+            readings[i].status = ret;
+            bus_status = ret;
+            break;
+        }
+        bus->pending[i] = true;
+        queued[i] = true;
+    }
+
+    // Collect in order; a device's result only depends on its own queue
+    for (size_t i = 0; i < count; i++) {
+        if (!queued[i]) {
+            continue;
+        }
+
+        spi_transaction_t *done = NULL;
+        esp_err_t ret = spi_device_get_trans_result(bus->devices[i], &done, timeout);
+        if (ret != ESP_OK) {
+            DLOGE(TAG, "Channel %u transfer failed: %s", (unsigned)i, esp_err_to_name(ret));
+            readings[i].status = ret;
+            bus_status = ret;
+            continue;  // Still pending, drained on a later pass
+        }
+        bus->pending[i] = false;
+
+        uint16_t raw = (done->rx_data[0] << 8) | done->rx_data[1];
+        readings[i].raw = raw;
+        readings[i].timestamp_us = bus->done_us[i];
+        readings[i].status = (raw & MAX6675_FAULT_OPEN) ? ESP_ERR_INVALID_RESPONSE : ESP_OK;
+    }
+
+    metrics_observe(METRICS_SPI_BUS_READ, (uint32_t)(esp_timer_get_time() - start_us));
+    return bus_status;
+}
+
+esp_err_t max6675_bus_deinit(max6675_bus_t *bus)
+{
+    if (bus == NULL) {
+        ESP_LOGE(TAG, "Bus is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!bus->initialized) {
+        ESP_LOGW(TAG, "MAX6675 bus not initialized");
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < bus->device_count; i++) {
+        // A device with a transfer still queued cannot be removed
+        if (bus->pending[i]) {
+            spi_transaction_t *stale = NULL;
+            if (spi_device_get_trans_result(bus->devices[i], &stale, pdMS_TO_TICKS(MAX6675_BUS_TIMEOUT_MS)) == ESP_OK) {
+                bus->pending[i] = false;
+            }
+        }
+
+        esp_err_t ret = spi_bus_remove_device(bus->devices[i]);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to remove SPI device: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    bus->device_count = 0;
+
+    esp_err_t ret = spi_bus_free(bus->host);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to free SPI bus: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    bus->initialized = false;
+    ESP_LOGI(TAG, "MAX6675 bus deinitialized");
+
+    return ESP_OK;
+}
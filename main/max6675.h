@@ -8,6 +8,7 @@
 #ifndef MAX6675_H
 #define MAX6675_H
 
+#include <stddef.h>
 #include "esp_err.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
@@ -24,7 +25,12 @@ extern "C" {
 #define MAX6675_MISO_PIN    GPIO_NUM_19  // Master In, Slave Out
 #define MAX6675_MOSI_PIN    GPIO_NUM_23  // Master Out, Slave In  
 #define MAX6675_CLK_PIN     GPIO_NUM_18  // Clock
-#define MAX6675_CS_PIN      GPIO_NUM_5   // Chip Select
+#define MAX6675_CS_PIN      GPIO_NUM_5   // Chip Select (single device / bus channel 0)
+
+// MAX6675 Data Word
+#define MAX6675_CONVERSION_TIME_MS 220     // Maximum conversion time
+#define MAX6675_FAULT_OPEN         0x0004  // Bit 2: thermocouple input open
+#define MAX6675_TEMP_LSB_C         0.25f   // Bits 15-3: temperature in 0.25°C steps
 
 // MAX6675 Data Structure
 typedef struct {
@@ -33,11 +39,41 @@ typedef struct {
     bool initialized;
 } max6675_handle_t;
 
+// Multi-device bus: several MAX6675 sharing MISO/CLK with distinct CS lines
+#define MAX6675_BUS_MAX_DEVICES    8
+#define MAX6675_BUS_TIMEOUT_MS     20      // Per pass; 8 x 16 bits at 1 MHz is ~150 us
+
+// One channel of a bus read
+typedef struct {
+    uint16_t raw;            // Raw 16-bit word
+    esp_err_t status;        // ESP_OK, ESP_ERR_INVALID_RESPONSE if open, or the SPI error
+    int64_t timestamp_us;    // esp_timer time at the end of this device's transfer
+} max6675_reading_t;
+
+// Bus Owner
+typedef struct {
+    spi_host_device_t host;
+    spi_device_handle_t devices[MAX6675_BUS_MAX_DEVICES];
+    gpio_num_t cs_pins[MAX6675_BUS_MAX_DEVICES];
+    spi_transaction_t trans[MAX6675_BUS_MAX_DEVICES];
+    volatile int64_t done_us[MAX6675_BUS_MAX_DEVICES];  // Written by the SPI post-transfer callback
+    bool pending[MAX6675_BUS_MAX_DEVICES];  // Queued, result not collected yet (owned by the driver)
+    size_t device_count;
+    bool initialized;
+} max6675_bus_t;
+
 // Function prototypes
 esp_err_t max6675_init(max6675_handle_t *handle);
 esp_err_t max6675_read_temperature(max6675_handle_t *handle, float *temperature);
+esp_err_t max6675_read_raw(max6675_handle_t *handle, uint16_t *raw_data);
+float max6675_raw_to_celsius(uint16_t raw_data);
 esp_err_t max6675_deinit(max6675_handle_t *handle);
 
+esp_err_t max6675_bus_init(max6675_bus_t *bus, spi_host_device_t host);
+esp_err_t max6675_bus_add_device(max6675_bus_t *bus, gpio_num_t cs_pin, size_t *channel);
+esp_err_t max6675_bus_read_all(max6675_bus_t *bus, max6675_reading_t *readings, size_t count);
+esp_err_t max6675_bus_deinit(max6675_bus_t *bus);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,349 @@
+/*
+ * Runtime Metrics Implementation
+ */
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "metrics.h"
+#include "dlog.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "freertos/task.h"
+
+static const char *TAG = "METRICS";
+
+typedef struct {
+    const char *name;
+    const char *labels;
+    const char *help;
+} counter_info_t;
+
+// Consecutive entries with the same name are one family
+static const counter_info_t s_counter_info[METRICS_COUNTER_COUNT] = {
+    [METRICS_SENSOR_FAULT_OPEN]  = { "sensor_faults_total", "kind=\"open\"",  "Failed thermocouple reads" },
+    [METRICS_SENSOR_FAULT_BUS]   = { "sensor_faults_total", "kind=\"bus\"",   "Failed thermocouple reads" },
+    [METRICS_SENSOR_FAULT_STALE] = { "sensor_faults_total", "kind=\"stale\"", "Failed thermocouple reads" },
+    [METRICS_WIFI_DISCONNECTS]   = { "wifi_events_total",   "event=\"disconnect\"", "WiFi station events" },
+    [METRICS_WIFI_RETRIES]       = { "wifi_events_total",   "event=\"retry\"",      "WiFi station events" },
+    [METRICS_WIFI_CONNECTS]      = { "wifi_events_total",   "event=\"connect\"",    "WiFi station events" },
+    [METRICS_SAFETY_STALE]       = { "safety_trips_total",  "fault=\"stale\"",      "Safety interlock trips" },
+    [METRICS_SAFETY_SENSOR]      = { "safety_trips_total",  "fault=\"sensor\"",     "Safety interlock trips" },
+    [METRICS_SAFETY_OVER_TEMP]   = { "safety_trips_total",  "fault=\"over_temp\"",  "Safety interlock trips" },
+    [METRICS_SAFETY_RISE]        = { "safety_trips_total",  "fault=\"rise\"",       "Safety interlock trips" },
+    [METRICS_SAFETY_STUCK]       = { "safety_trips_total",  "fault=\"stuck\"",      "Safety interlock trips" },
+    [METRICS_SAFETY_TEST]        = { "safety_trips_total",  "fault=\"test\"",       "Safety interlock trips" },
+};
+
+static atomic_uint s_counters[portNUM_PROCESSORS][METRICS_COUNTER_COUNT];
+
+static const uint32_t s_jitter_bounds[] = { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 };
+static const uint32_t s_step_bounds[]   = { 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000 };
+static const uint32_t s_spi_bounds[]    = { 20, 30, 50, 75, 100, 200, 500, 1000, 5000, 20000 };
+static const uint32_t s_bus_bounds[]    = { 20, 50, 100, 200, 500, 1000, 2000, 5000, 20000, 100000 };
+static const uint32_t s_ledc_bounds[]   = { 2, 5, 10, 20, 50, 100, 200, 500, 1000 };
+static const uint32_t s_cutoff_bounds[] = { 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000, 100000 };
+
+#define BOUNDS(b)  (b), (sizeof(b) / sizeof((b)[0]))
+
+static metrics_histogram_t s_builtin[METRICS_HISTOGRAM_COUNT] = {
+    [METRICS_CONTROL_JITTER] = { "control_jitter_seconds", "Control loop start deviation from its period",
+                                 NULL, BOUNDS(s_jitter_bounds) },
+    [METRICS_CONTROL_STEP]   = { "control_step_seconds", "Control step duration, sample to applied output",
+                                 NULL, BOUNDS(s_step_bounds) },
+    [METRICS_SPI_READ]       = { "spi_read_seconds", "MAX6675 transaction", "op=\"single\"",
+                                 BOUNDS(s_spi_bounds) },
+    [METRICS_SPI_BUS_READ]   = { "spi_read_seconds", "MAX6675 transaction", "op=\"bus\"",
+                                 BOUNDS(s_bus_bounds) },
+    [METRICS_LEDC_UPDATE]    = { "ledc_update_seconds", "Heater zone duty update", NULL, BOUNDS(s_ledc_bounds) },
+    [METRICS_SAFETY_CUTOFF]  = { "safety_cutoff_seconds", "Safety interlock, condition observable to heater off",
+                                 NULL, BOUNDS(s_cutoff_bounds) },
+};
+
+static metrics_histogram_t *s_registered[METRICS_MAX_HISTOGRAMS - METRICS_HISTOGRAM_COUNT];
+static size_t s_registered_count = 0;
+static portMUX_TYPE s_register_lock = portMUX_INITIALIZER_UNLOCKED;
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static TaskStatus_t s_tasks[METRICS_MAX_TASKS];     // The HTTP server renders one scrape at a time
+#endif
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static uint32_t s_prev_idle[portNUM_PROCESSORS];
+static uint32_t s_prev_total;
+#endif
+
+// ---------------------------------------------------------------------------
+// Recording
+// ---------------------------------------------------------------------------
+
+void metrics_count(metrics_counter_t counter)
+{
+    if (counter >= METRICS_COUNTER_COUNT) {
+        return;
+    }
+    atomic_fetch_add_explicit(&s_counters[xPortGetCoreID()][counter], 1, memory_order_relaxed);
+}
+
+void metrics_histogram_observe(metrics_histogram_t *hist, uint32_t value_us)
+{
+    size_t bucket = 0;
+    while (bucket < hist->bound_count && value_us > hist->bounds_us[bucket]) {
+        bucket++;
+    }
+
+    metrics_shard_t *shard = &hist->shards[xPortGetCoreID()];
+    atomic_fetch_add_explicit(&shard->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&shard->sum_us, value_us, memory_order_relaxed);
+}
+
+void metrics_observe(metrics_histogram_id_t id, uint32_t value_us)
+{
+    if (id >= METRICS_HISTOGRAM_COUNT) {
+        return;
+    }
+    metrics_histogram_observe(&s_builtin[id], value_us);
+}
+
+esp_err_t metrics_register_histogram(metrics_histogram_t *hist)
+{
+    if (hist == NULL || hist->name == NULL || hist->bound_count > METRICS_MAX_BUCKETS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ESP_OK;
+    portENTER_CRITICAL(&s_register_lock);
+    if (s_registered_count < sizeof(s_registered) / sizeof(s_registered[0])) {
+        s_registered[s_registered_count++] = hist;
+    } else {
+        ret = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&s_register_lock);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No room for histogram %s", hist->name);
+    }
+    return ret;
+}
+
+// ---------------------------------------------------------------------------
+// Text exposition
+// ---------------------------------------------------------------------------
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t size, metrics_flush_fn_t flush, void *flush_ctx)
+{
+    *w = (metrics_writer_t) {
+        .buf = buf,
+        .size = size,
+        .flush = flush,
+        .flush_ctx = flush_ctx,
+        .status = ESP_OK,
+    };
+}
+
+esp_err_t metrics_writer_flush(metrics_writer_t *w)
+{
+    if (w->status == ESP_OK && w->len > 0 && w->flush != NULL) {
+        w->status = w->flush(w->flush_ctx, w->buf, w->len);
+        w->len = 0;
+    }
+    return w->status;
+}
+
+static void put(metrics_writer_t *w, const char *data, size_t len)
+{
+    while (len > 0 && w->status == ESP_OK) {
+        if (w->len == w->size) {
+            if (w->flush == NULL) {
+                w->status = ESP_ERR_NO_MEM;
+                return;
+            }
+            metrics_writer_flush(w);
+            continue;
+        }
+
+        size_t n = w->size - w->len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void put_line(metrics_writer_t *w, const char *format, ...)
+{
+    char line[METRICS_LINE_MAX];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+
+    if (len < 0 || (size_t)len >= sizeof(line)) {
+        w->status = (w->status == ESP_OK) ? ESP_ERR_INVALID_SIZE : w->status;
+        return;
+    }
+    put(w, line, len);
+}
+
+void metrics_write_family(metrics_writer_t *w, const char *name, const char *type, const char *help)
+{
+    put_line(w, "# HELP " METRICS_PREFIX "%s %s\n# TYPE " METRICS_PREFIX "%s %s\n", name, help, name, type);
+}
+
+void metrics_write_sample(metrics_writer_t *w, const char *name, const char *labels, double value)
+{
+    if (labels != NULL && labels[0] != '\0') {
+        put_line(w, METRICS_PREFIX "%s{%s} %.10g\n", name, labels, value);
+    } else {
+        put_line(w, METRICS_PREFIX "%s %.10g\n", name, value);
+    }
+}
+
+static void write_histogram(metrics_writer_t *w, const metrics_histogram_t *hist, const char **family)
+{
+    if (*family == NULL || strcmp(*family, hist->name) != 0) {
+        metrics_write_family(w, hist->name, "histogram", hist->help);
+        *family = hist->name;
+    }
+
+    // Shards are read one bucket at a time; a scrape racing a record may be off by one
+    uint32_t buckets[METRICS_MAX_BUCKETS + 1] = { 0 };
+    uint64_t sum_us = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const metrics_shard_t *shard = &hist->shards[core];
+        for (size_t i = 0; i <= hist->bound_count; i++) {
+            buckets[i] += atomic_load_explicit(&shard->buckets[i], memory_order_relaxed);
+        }
+        sum_us += atomic_load_explicit(&shard->sum_us, memory_order_relaxed);
+    }
+
+    const char *labels = hist->labels != NULL ? hist->labels : "";
+    const char *sep = labels[0] != '\0' ? "," : "";
+    uint32_t cumulative = 0;
+    for (size_t i = 0; i <= hist->bound_count; i++) {
+        cumulative += buckets[i];
+        if (i < hist->bound_count) {
+            put_line(w, METRICS_PREFIX "%s_bucket{%s%sle=\"%g\"} %" PRIu32 "\n",
+                     hist->name, labels, sep, hist->bounds_us[i] / 1e6, cumulative);
+        } else {
+            put_line(w, METRICS_PREFIX "%s_bucket{%s%sle=\"+Inf\"} %" PRIu32 "\n",
+                     hist->name, labels, sep, cumulative);
+        }
+    }
+    const char *open = labels[0] != '\0' ? "{" : "";
+    const char *close = labels[0] != '\0' ? "}" : "";
+    put_line(w, METRICS_PREFIX "%s_sum%s%s%s %.6f\n", hist->name, open, labels, close, sum_us / 1e6);
+    put_line(w, METRICS_PREFIX "%s_count%s%s%s %" PRIu32 "\n", hist->name, open, labels, close, cumulative);
+}
+
+static void write_counters(metrics_writer_t *w)
+{
+    const char *family = NULL;
+    for (size_t i = 0; i < METRICS_COUNTER_COUNT; i++) {
+        const counter_info_t *info = &s_counter_info[i];
+        if (family == NULL || strcmp(family, info->name) != 0) {
+            metrics_write_family(w, info->name, "counter", info->help);
+            family = info->name;
+        }
+
+        uint32_t total = 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            total += atomic_load_explicit(&s_counters[core][i], memory_order_relaxed);
+        }
+        metrics_write_sample(w, info->name, info->labels, total);
+    }
+
+    dlog_stats_t log_stats;
+    dlog_get_stats(&log_stats);
+    metrics_write_family(w, "log_events_total", "counter", "Deferred log events by outcome");
+    metrics_write_sample(w, "log_events_total", "outcome=\"written\"", log_stats.written);
+    metrics_write_sample(w, "log_events_total", "outcome=\"dropped\"", log_stats.dropped);
+}
+
+static void write_heap(metrics_writer_t *w)
+{
+    metrics_write_family(w, "uptime_seconds", "gauge", "Time since boot");
+    metrics_write_sample(w, "uptime_seconds", NULL, esp_timer_get_time() / 1e6);
+
+    metrics_write_family(w, "heap_free_bytes", "gauge", "Free 8-bit capable heap");
+    metrics_write_sample(w, "heap_free_bytes", NULL, heap_caps_get_free_size(MALLOC_CAP_8BIT));
+    metrics_write_family(w, "heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+    metrics_write_sample(w, "heap_min_free_bytes", NULL, heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    metrics_write_family(w, "heap_largest_free_block_bytes", "gauge", "Largest single allocation possible");
+    metrics_write_sample(w, "heap_largest_free_block_bytes", NULL, heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+static void write_tasks(metrics_writer_t *w)
+{
+    uint32_t total_time = 0;
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    if (count > METRICS_MAX_TASKS) {
+        ESP_LOGW(TAG, "%u tasks, reporting none (METRICS_MAX_TASKS %d)", (unsigned)count, METRICS_MAX_TASKS);
+        return;
+    }
+    count = uxTaskGetSystemState(s_tasks, METRICS_MAX_TASKS, &total_time);
+
+    char labels[48];
+    metrics_write_family(w, "task_stack_free_min_bytes", "gauge", "Stack high-water mark: least free stack seen");
+    for (UBaseType_t i = 0; i < count; i++) {
+        snprintf(labels, sizeof(labels), "task=\"%s\"", s_tasks[i].pcTaskName);
+        metrics_write_sample(w, "task_stack_free_min_bytes", labels, s_tasks[i].usStackHighWaterMark);
+    }
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    // Load since the previous scrape; unsigned differences survive the counter wrapping
+    uint32_t elapsed = total_time - s_prev_total;
+    bool have_baseline = (s_prev_total != 0 && elapsed > 0);
+    if (have_baseline) {
+        metrics_write_family(w, "cpu_load_ratio", "gauge", "Share of time not idle since the previous scrape");
+    }
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        TaskHandle_t idle = xTaskGetIdleTaskHandleForCore(core);
+        for (UBaseType_t i = 0; i < count; i++) {
+            if (s_tasks[i].xHandle != idle) {
+                continue;
+            }
+            uint32_t idle_time = s_tasks[i].ulRunTimeCounter - s_prev_idle[core];
+            s_prev_idle[core] = s_tasks[i].ulRunTimeCounter;
+            if (have_baseline) {
+                double load = 1.0 - (double)idle_time / elapsed;
+                snprintf(labels, sizeof(labels), "core=\"%d\"", core);
+                metrics_write_sample(w, "cpu_load_ratio", labels, load < 0.0 ? 0.0 : load);
+            }
+        }
+    }
+    s_prev_total = total_time;
+#endif
+}
+#endif
+
+// Everything this module owns: counters, histograms, heap, tasks, CPU
+void metrics_write(metrics_writer_t *w)
+{
+    write_counters(w);
+
+    const char *family = NULL;
+    for (size_t i = 0; i < METRICS_HISTOGRAM_COUNT; i++) {
+        write_histogram(w, &s_builtin[i], &family);
+    }
+
+    portENTER_CRITICAL(&s_register_lock);
+    size_t registered = s_registered_count;
+    portEXIT_CRITICAL(&s_register_lock);
+    for (size_t i = 0; i < registered; i++) {
+        write_histogram(w, s_registered[i], &family);
+    }
+
+    write_heap(w);
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    write_tasks(w);
+#endif
+}
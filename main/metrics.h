@@ -0,0 +1,106 @@
+/*
+ * Runtime Metrics
+ *
+ * Counters and fixed-bucket latency histograms, rendered in Prometheus
+ * text format for GET /api/metrics. Every counter and histogram has one
+ * shard per core: recording is a relaxed atomic add on the caller's
+ * shard, with no lock and no cross-core cache line; the shards are only
+ * summed when a scrape renders them.
+ *
+ * The scrape also reports heap (free, minimum, largest block), the stack
+ * high-water mark of every task and the CPU load of each core since the
+ * previous scrape (both need CONFIG_FREERTOS_USE_TRACE_FACILITY, the
+ * load also CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS, see
+ * sdkconfig.defaults).
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_PREFIX          "tpc_"
+#define METRICS_MAX_BUCKETS     12      // Finite upper bounds per histogram, +Inf is implicit
+#define METRICS_MAX_HISTOGRAMS  32      // Built-in ones plus those registered (HTTP routes)
+#define METRICS_MAX_TASKS       32      // More tasks than this: no stack/CPU figures
+#define METRICS_LINE_MAX        160
+
+typedef enum {
+    METRICS_SENSOR_FAULT_OPEN = 0,      // Thermocouple open
+    METRICS_SENSOR_FAULT_BUS,           // SPI transfer failed or timed out
+    METRICS_SENSOR_FAULT_STALE,         // Control step found no fresh sample
+    METRICS_WIFI_DISCONNECTS,
+    METRICS_WIFI_RETRIES,
+    METRICS_WIFI_CONNECTS,
+    METRICS_SAFETY_STALE,               // Interlock trips, one per fault (INTERLOCK_FAULT_* order)
+    METRICS_SAFETY_SENSOR,
+    METRICS_SAFETY_OVER_TEMP,
+    METRICS_SAFETY_RISE,
+    METRICS_SAFETY_STUCK,
+    METRICS_SAFETY_TEST,
+    METRICS_COUNTER_COUNT,
+} metrics_counter_t;
+
+typedef enum {
+    METRICS_CONTROL_JITTER = 0,         // |start-to-start interval - period| of the control loop
+    METRICS_CONTROL_STEP,               // Control step, sample to applied output
+    METRICS_SPI_READ,                   // One MAX6675 transaction
+    METRICS_SPI_BUS_READ,               // Every channel of the bus, queue to last result
+    METRICS_LEDC_UPDATE,                // Staging and latching the zone duties
+    METRICS_SAFETY_CUTOFF,              // Interlock condition observable to heater off
+    METRICS_HISTOGRAM_COUNT,
+} metrics_histogram_id_t;
+
+typedef struct {
+    atomic_uint buckets[METRICS_MAX_BUCKETS + 1];   // Not cumulative, last is +Inf
+    _Atomic uint64_t sum_us;
+} metrics_shard_t;
+
+// Statically allocated by its owner; name and labels must outlive the registration
+typedef struct {
+    const char *name;           // Family name after METRICS_PREFIX, e.g. "http_request_duration_seconds"
+    const char *help;
+    const char *labels;         // Extra labels, e.g. "uri=\"/api/control\"", or NULL
+    const uint32_t *bounds_us;  // Ascending upper bounds
+    size_t bound_count;
+    metrics_shard_t shards[portNUM_PROCESSORS];
+} metrics_histogram_t;
+
+// Receives each full buffer (e.g. as an HTTP chunk); returning an error stops the writer
+typedef esp_err_t (*metrics_flush_fn_t)(void *ctx, const char *data, size_t len);
+
+// Text exposition into a caller-provided buffer
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    metrics_flush_fn_t flush;
+    void *flush_ctx;
+    esp_err_t status;           // First error
+} metrics_writer_t;
+
+// Function prototypes
+void metrics_count(metrics_counter_t counter);
+void metrics_observe(metrics_histogram_id_t id, uint32_t value_us);
+void metrics_histogram_observe(metrics_histogram_t *hist, uint32_t value_us);
+esp_err_t metrics_register_histogram(metrics_histogram_t *hist);
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t size, metrics_flush_fn_t flush, void *flush_ctx);
+esp_err_t metrics_writer_flush(metrics_writer_t *w);
+void metrics_write_family(metrics_writer_t *w, const char *name, const char *type, const char *help);
+void metrics_write_sample(metrics_writer_t *w, const char *name, const char *labels, double value);
+void metrics_write(metrics_writer_t *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // METRICS_H
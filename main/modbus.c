@@ -0,0 +1,457 @@
+/*
+ * Modbus TCP Slave Implementation
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include "modbus.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void put_u16(uint8_t *p, uint16_t value)
+{
+    p[0] = (uint8_t)(value >> 8);
+    p[1] = (uint8_t)value;
+}
+
+// Value x10 as a signed register, rounded and clamped
+static uint16_t scaled(float value)
+{
+    if (isnan(value)) {
+        return MODBUS_INVALID;
+    }
+    float x = roundf(value * 10.0f);
+    x = fminf(fmaxf(x, -32767.0f), 32767.0f);
+    return (uint16_t)(int16_t)x;
+}
+
+static uint16_t saturated(uint32_t value)
+{
+    return value > UINT16_MAX ? UINT16_MAX : (uint16_t)value;
+}
+
+static void put_u32(uint16_t *regs, uint32_t value)
+{
+    regs[0] = (uint16_t)(value >> 16);
+    regs[1] = (uint16_t)value;
+}
+
+static void put_float(uint16_t *regs, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u32(regs, bits);
+}
+
+static float get_float(const uint16_t *regs)
+{
+    uint32_t bits = ((uint32_t)regs[0] << 16) | regs[1];
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void modbus_encode_inputs(const modbus_state_t *state, uint16_t *regs)
+{
+    memset(regs, 0, MODBUS_INPUT_COUNT * sizeof(uint16_t));
+
+    regs[MODBUS_IR_STATUS] = state->status;
+    regs[MODBUS_IR_TEMPERATURE] = (state->status & MODBUS_STATUS_SENSOR_OK) ? scaled(state->temperature)
+                                                                            : MODBUS_INVALID;
+    regs[MODBUS_IR_ESTIMATE] = scaled(state->estimate);
+    regs[MODBUS_IR_SETPOINT] = scaled(state->setpoint);
+    regs[MODBUS_IR_OUTPUT] = scaled(state->output);
+    regs[MODBUS_IR_FEEDFORWARD] = scaled(state->feedforward);
+    regs[MODBUS_IR_RATE] = scaled(state->rate);
+    regs[MODBUS_IR_SPIKES] = saturated(state->spikes);
+    put_u32(&regs[MODBUS_IR_TICKS], state->ticks);
+    put_u32(&regs[MODBUS_IR_OVERRUNS], state->overruns);
+    regs[MODBUS_IR_STEP_US] = saturated(state->step_us);
+
+    size_t channels = state->channels < MODBUS_MAX_CHANNELS ? state->channels : MODBUS_MAX_CHANNELS;
+    size_t zones = state->zones < MODBUS_MAX_ZONES ? state->zones : MODBUS_MAX_ZONES;
+    regs[MODBUS_IR_CHANNELS] = (uint16_t)channels;
+    regs[MODBUS_IR_ZONES] = (uint16_t)zones;
+    for (size_t i = 0; i < MODBUS_MAX_CHANNELS; i++) {
+        bool valid = i < channels && state->channel_valid[i];
+        regs[MODBUS_IR_CHANNEL_TEMP + i] = valid ? scaled(state->channel_temp[i]) : MODBUS_INVALID;
+        regs[MODBUS_IR_CHANNEL_FAULT + i] = i < channels ? state->channel_fault[i] : 0;
+    }
+    for (size_t i = 0; i < zones; i++) {
+        regs[MODBUS_IR_ZONE_DUTY + i] = scaled(state->zone_duty[i]);
+    }
+}
+
+void modbus_encode_holding(const modbus_state_t *state, uint16_t *regs)
+{
+    regs[MODBUS_HR_MODE] = state->mode;
+    regs[MODBUS_HR_SETPOINT] = scaled(state->setpoint);
+    regs[MODBUS_HR_POWER] = scaled(state->output);
+    put_float(&regs[MODBUS_HR_KP], state->kp);
+    put_float(&regs[MODBUS_HR_KI], state->ki);
+    put_float(&regs[MODBUS_HR_KD], state->kd);
+}
+
+static bool covers(uint16_t first, uint16_t count, uint16_t reg)
+{
+    return reg >= first && reg < first + count;
+}
+
+// True if [first, first + count) holds only one half of the float at reg
+static bool splits(uint16_t first, uint16_t count, uint16_t reg)
+{
+    return covers(first, count, reg) != covers(first, count, reg + 1);
+}
+
+// regs is the whole holding image with the written registers merged in;
+// returns 0 or the exception code to answer
+uint8_t modbus_decode_holding(const uint16_t *regs, uint16_t first, uint16_t count, modbus_command_t *command)
+{
+    if (splits(first, count, MODBUS_HR_KP) || splits(first, count, MODBUS_HR_KI) ||
+        splits(first, count, MODBUS_HR_KD)) {
+        return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+
+    *command = (modbus_command_t) { 0 };
+    if (covers(first, count, MODBUS_HR_MODE)) {
+        if (regs[MODBUS_HR_MODE] > 1) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        command->mode = regs[MODBUS_HR_MODE];
+        command->fields |= MODBUS_WRITE_MODE;
+    }
+    if (covers(first, count, MODBUS_HR_SETPOINT)) {
+        command->setpoint = (float)(int16_t)regs[MODBUS_HR_SETPOINT] / 10.0f;
+        command->fields |= MODBUS_WRITE_SETPOINT;
+    }
+    if (covers(first, count, MODBUS_HR_POWER)) {
+        if (regs[MODBUS_HR_POWER] > 1000) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        command->power = (float)regs[MODBUS_HR_POWER] / 10.0f;
+        command->fields |= MODBUS_WRITE_POWER;
+    }
+    if (covers(first, count, MODBUS_HR_KP) || covers(first, count, MODBUS_HR_KI) ||
+        covers(first, count, MODBUS_HR_KD)) {
+        command->kp = get_float(&regs[MODBUS_HR_KP]);
+        command->ki = get_float(&regs[MODBUS_HR_KI]);
+        command->kd = get_float(&regs[MODBUS_HR_KD]);
+        if (!isfinite(command->kp) || !isfinite(command->ki) || !isfinite(command->kd) ||
+            command->kp < 0.0f || command->ki < 0.0f || command->kd < 0.0f) {
+            return MODBUS_EX_ILLEGAL_VALUE;
+        }
+        command->fields |= MODBUS_WRITE_GAINS;
+    }
+    return 0;
+}
+
+// Response PDU for registers [first, first + count) of the image
+static size_t read_response(uint8_t *pdu, const uint16_t *regs, uint16_t first, uint16_t count)
+{
+    pdu[1] = (uint8_t)(count * 2);
+    for (uint16_t i = 0; i < count; i++) {
+        put_u16(&pdu[2 + i * 2], regs[first + i]);
+    }
+    return 2 + (size_t)count * 2;
+}
+
+// Handles the PDU after the unit id; returns the response PDU length, or
+// 0 with *exception set
+static size_t process_pdu(const modbus_ops_t *ops, const uint8_t *pdu, size_t len, uint8_t *out,
+                          uint8_t *exception)
+{
+    uint8_t function = pdu[0];
+    out[0] = function;
+
+    if (function != MODBUS_FC_READ_HOLDING && function != MODBUS_FC_READ_INPUT &&
+        function != MODBUS_FC_WRITE_SINGLE && function != MODBUS_FC_WRITE_MULTIPLE) {
+        *exception = MODBUS_EX_ILLEGAL_FUNCTION;
+        return 0;
+    }
+    if (len < 5) {
+        *exception = MODBUS_EX_ILLEGAL_VALUE;
+        return 0;
+    }
+
+    uint16_t first = get_u16(&pdu[1]);
+    uint16_t count = get_u16(&pdu[3]);
+    modbus_state_t state;
+    uint16_t regs[MODBUS_INPUT_COUNT > MODBUS_HOLDING_COUNT ? MODBUS_INPUT_COUNT : MODBUS_HOLDING_COUNT];
+
+    if (function == MODBUS_FC_READ_HOLDING || function == MODBUS_FC_READ_INPUT) {
+        if (count == 0 || count > MODBUS_MAX_READ) {
+            *exception = MODBUS_EX_ILLEGAL_VALUE;
+            return 0;
+        }
+        size_t size = (function == MODBUS_FC_READ_INPUT) ? MODBUS_INPUT_COUNT : MODBUS_HOLDING_COUNT;
+        if ((size_t)first + count > size) {
+            *exception = MODBUS_EX_ILLEGAL_ADDRESS;
+            return 0;
+        }
+        ops->read_state(ops->ctx, &state);
+        if (function == MODBUS_FC_READ_INPUT) {
+            modbus_encode_inputs(&state, regs);
+        } else {
+            modbus_encode_holding(&state, regs);
+        }
+        return read_response(out, regs, first, count);
+    }
+
+    // Writes: merge into the current image, so a partial write keeps the rest
+    const uint8_t *values;
+    if (function == MODBUS_FC_WRITE_SINGLE) {
+        values = &pdu[3];
+        count = 1;
+    } else {
+        if (len < 6 || count == 0 || count > MODBUS_MAX_WRITE || pdu[5] != count * 2 ||
+            len < 6 + (size_t)count * 2) {
+            *exception = MODBUS_EX_ILLEGAL_VALUE;
+            return 0;
+        }
+        values = &pdu[6];
+    }
+    if ((size_t)first + count > MODBUS_HOLDING_COUNT) {
+        *exception = MODBUS_EX_ILLEGAL_ADDRESS;
+        return 0;
+    }
+
+    ops->read_state(ops->ctx, &state);
+    modbus_encode_holding(&state, regs);
+    for (uint16_t i = 0; i < count; i++) {
+        regs[first + i] = get_u16(&values[i * 2]);
+    }
+
+    modbus_command_t command;
+    *exception = modbus_decode_holding(regs, first, count, &command);
+    if (*exception != 0) {
+        return 0;
+    }
+    esp_err_t ret = ops->write(ops->ctx, &command);
+    if (ret != ESP_OK) {
+        *exception = (ret == ESP_ERR_INVALID_ARG) ? MODBUS_EX_ILLEGAL_VALUE : MODBUS_EX_DEVICE_FAILURE;
+        return 0;
+    }
+
+    // Both write responses echo the address and the value or quantity
+    memcpy(&out[1], &pdu[1], 4);
+    return 5;
+}
+
+// One complete ADU in, its response out (at most MODBUS_MAX_ADU bytes);
+// returns the response length, 0 if the request is not Modbus and gets none
+size_t modbus_process(const modbus_ops_t *ops, const uint8_t *request, size_t len, uint8_t *response)
+{
+    if (len < MODBUS_MBAP_SIZE + 1 || get_u16(&request[2]) != 0 || get_u16(&request[4]) != len - 6) {
+        return 0;
+    }
+
+    uint8_t exception = 0;
+    size_t pdu_len = process_pdu(ops, &request[MODBUS_MBAP_SIZE], len - MODBUS_MBAP_SIZE,
+                                 &response[MODBUS_MBAP_SIZE], &exception);
+    if (exception != 0) {
+        response[MODBUS_MBAP_SIZE] = request[MODBUS_MBAP_SIZE] | 0x80;
+        response[MODBUS_MBAP_SIZE + 1] = exception;
+        pdu_len = 2;
+    }
+
+    memcpy(response, request, 4);   // Transaction and protocol id
+    put_u16(&response[4], (uint16_t)(pdu_len + 1));
+    response[6] = request[6];       // Unit id
+    return MODBUS_MBAP_SIZE + pdu_len;
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void close_client(modbus_server_t *server, modbus_client_t *client)
+{
+    close(client->fd);
+    client->fd = -1;
+    client->len = 0;
+    server->stats.clients--;
+}
+
+static void accept_client(modbus_server_t *server, int64_t now)
+{
+    int fd = accept(server->listen_fd, NULL, NULL);
+    if (fd < 0) {
+        return;
+    }
+
+    modbus_client_t *client = NULL;
+    for (size_t i = 0; i < MODBUS_MAX_CLIENTS && client == NULL; i++) {
+        if (server->clients[i].fd < 0) {
+            client = &server->clients[i];
+        }
+    }
+    if (client == NULL) {
+        close(fd);
+        server->stats.rejected++;
+        return;
+    }
+
+    // Non-blocking: a master that stops reading is dropped, not waited for
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    client->fd = fd;
+    client->len = 0;
+    client->last_ms = now;
+    server->stats.connections++;
+    server->stats.clients++;
+}
+
+// Answers every complete request buffered for the client; false to drop it
+static bool serve_client(modbus_server_t *server, modbus_client_t *client, int64_t now)
+{
+    ssize_t received = recv(client->fd, &client->rx[client->len], sizeof(client->rx) - client->len, 0);
+    if (received == 0) {
+        return false;
+    }
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    client->len += (size_t)received;
+    client->last_ms = now;
+
+    // Masters may pipeline requests or split them across segments
+    while (client->len >= MODBUS_MBAP_SIZE) {
+        size_t frame_len = 6 + (size_t)get_u16(&client->rx[4]);
+        if (frame_len < MODBUS_MBAP_SIZE + 1 || frame_len > MODBUS_MAX_ADU) {
+            server->stats.errors++;
+            return false;
+        }
+        if (client->len < frame_len) {
+            break;
+        }
+
+        uint8_t response[MODBUS_MAX_ADU];
+        size_t response_len = modbus_process(&server->ops, client->rx, frame_len, response);
+        if (response_len > 0) {
+            server->stats.requests++;
+            uint8_t function = response[MODBUS_MBAP_SIZE];
+            if (function & 0x80) {
+                server->stats.exceptions++;
+            } else if (function == MODBUS_FC_WRITE_SINGLE || function == MODBUS_FC_WRITE_MULTIPLE) {
+                server->stats.writes++;
+            }
+            if (send(client->fd, response, response_len, MSG_NOSIGNAL) != (ssize_t)response_len) {
+                server->stats.errors++;
+                return false;
+            }
+        }
+
+        client->len -= frame_len;
+        memmove(client->rx, &client->rx[frame_len], client->len);
+    }
+    return true;
+}
+
+esp_err_t modbus_server_open(modbus_server_t *server, uint16_t port, const modbus_ops_t *ops)
+{
+    if (server == NULL || ops == NULL || ops->read_state == NULL || ops->write == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    *server = (modbus_server_t) {
+        .ops = *ops,
+        .listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP),
+    };
+    for (size_t i = 0; i < MODBUS_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+    if (server->listen_fd < 0) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int one = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_port = htons(port),
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+    };
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(server->listen_fd, MODBUS_MAX_CLIENTS) != 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+// Waits up to timeout_ms for requests or connections and serves them
+esp_err_t modbus_server_poll(modbus_server_t *server, uint32_t timeout_ms)
+{
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(server->listen_fd, &readable);
+    int max_fd = server->listen_fd;
+    for (size_t i = 0; i < MODBUS_MAX_CLIENTS; i++) {
+        int fd = server->clients[i].fd;
+        if (fd >= 0) {
+            FD_SET(fd, &readable);
+            max_fd = fd > max_fd ? fd : max_fd;
+        }
+    }
+
+    struct timeval timeout = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_usec = (timeout_ms % 1000) * 1000,
+    };
+    int ready = select(max_fd + 1, &readable, NULL, NULL, &timeout);
+    if (ready < 0) {
+        return (errno == EINTR) ? ESP_OK : ESP_FAIL;
+    }
+
+    int64_t now = now_ms();
+    for (size_t i = 0; i < MODBUS_MAX_CLIENTS; i++) {
+        modbus_client_t *client = &server->clients[i];
+        if (client->fd < 0) {
+            continue;
+        }
+        bool keep = FD_ISSET(client->fd, &readable) ? serve_client(server, client, now)
+                                                    : (now - client->last_ms < MODBUS_IDLE_TIMEOUT_MS);
+        if (!keep) {
+            close_client(server, client);
+        }
+    }
+    // After serving, so a slot freed by a disconnect is available
+    if (FD_ISSET(server->listen_fd, &readable)) {
+        accept_client(server, now);
+    }
+    return ESP_OK;
+}
+
+void modbus_server_close(modbus_server_t *server)
+{
+    for (size_t i = 0; i < MODBUS_MAX_CLIENTS; i++) {
+        if (server->clients[i].fd >= 0) {
+            close_client(server, &server->clients[i]);
+        }
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+    }
+}
@@ -0,0 +1,208 @@
+/*
+ * Modbus TCP Slave
+ *
+ * Register map and protocol for PLC/SCADA masters, plus a small
+ * select()-based server for several concurrent connections. Portable:
+ * BSD sockets only, so the same code runs in the firmware
+ * (modbus_tcp.h) and on Linux (host/plant_sim --modbus), where
+ * host/modbus_client polls it.
+ *
+ * The server never reads hardware. Each request takes one modbus_state_t
+ * snapshot through ops.read_state and answers from it, so a read of
+ * several registers is consistent. Writes are decoded into one
+ * modbus_command_t and applied through ops.write.
+ *
+ * Supported functions: 03 read holding registers, 04 read input
+ * registers, 06 write single register, 16 write multiple registers. Any
+ * unit id is answered. Values are scaled integers (x10, signed) or
+ * IEEE 754 floats in two registers, high word first.
+ *
+ * Input registers (FC 04)
+ *   0       status bits (MODBUS_STATUS_*)
+ *   1       temperature, loop channel (0.1 °C)
+ *   2       estimated temperature (0.1 °C)
+ *   3       setpoint (0.1 °C)
+ *   4       output (0.1 %)
+ *   5       feed-forward part of the output (0.1 %)
+ *   6       rate of change (0.1 °C/min)
+ *   7       spikes dropped (saturates at 65535)
+ *   8-9     control ticks (32 bit, high word first)
+ *   10-11   control overruns (32 bit, high word first)
+ *   12      last control step (µs, saturates)
+ *   13      thermocouple channels
+ *   14      heater zones
+ *   16-23   channel temperature (0.1 °C, MODBUS_INVALID when not valid)
+ *   24-31   channel MAX6675 fault bits
+ *   32-35   zone duty (0.1 %)
+ *
+ * Holding registers (FC 03, 06, 16)
+ *   0       mode: 0 manual, 1 auto
+ *   1       setpoint (0.1 °C)
+ *   2       manual power (0.1 %); reads the applied output, writing it
+ *           switches to manual as POST /api/power does
+ *   3-4     Kp (float)
+ *   5-6     Ki (float)
+ *   7-8     Kd (float)
+ *
+ * A write covering both halves of a float is required; one that splits a
+ * pair is refused with ILLEGAL DATA ADDRESS.
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MODBUS_TCP_DEFAULT_PORT     502
+#define MODBUS_MAX_CLIENTS          4       // Concurrent masters; another connection is closed at once
+#define MODBUS_IDLE_TIMEOUT_MS      60000   // Silent connections are closed (half-open after a master reboot)
+#define MODBUS_MBAP_SIZE            7       // Transaction, protocol, length, unit
+#define MODBUS_MAX_ADU              260
+#define MODBUS_MAX_READ             125     // Registers per read request
+#define MODBUS_MAX_WRITE            123     // Registers per write request
+
+// Function codes
+#define MODBUS_FC_READ_HOLDING      0x03
+#define MODBUS_FC_READ_INPUT        0x04
+#define MODBUS_FC_WRITE_SINGLE      0x06
+#define MODBUS_FC_WRITE_MULTIPLE    0x10
+
+// Exception codes
+#define MODBUS_EX_ILLEGAL_FUNCTION  0x01
+#define MODBUS_EX_ILLEGAL_ADDRESS   0x02
+#define MODBUS_EX_ILLEGAL_VALUE     0x03
+#define MODBUS_EX_DEVICE_FAILURE    0x04
+
+// Input registers
+#define MODBUS_IR_STATUS            0
+#define MODBUS_IR_TEMPERATURE       1
+#define MODBUS_IR_ESTIMATE          2
+#define MODBUS_IR_SETPOINT          3
+#define MODBUS_IR_OUTPUT            4
+#define MODBUS_IR_FEEDFORWARD       5
+#define MODBUS_IR_RATE              6
+#define MODBUS_IR_SPIKES            7
+#define MODBUS_IR_TICKS             8
+#define MODBUS_IR_OVERRUNS          10
+#define MODBUS_IR_STEP_US           12
+#define MODBUS_IR_CHANNELS          13
+#define MODBUS_IR_ZONES             14
+#define MODBUS_IR_CHANNEL_TEMP      16
+#define MODBUS_IR_CHANNEL_FAULT     24
+#define MODBUS_IR_ZONE_DUTY         32
+#define MODBUS_INPUT_COUNT          36
+
+// Holding registers
+#define MODBUS_HR_MODE              0
+#define MODBUS_HR_SETPOINT          1
+#define MODBUS_HR_POWER             2
+#define MODBUS_HR_KP                3
+#define MODBUS_HR_KI                5
+#define MODBUS_HR_KD                7
+#define MODBUS_HOLDING_COUNT        9
+
+// Status bits (input register 0)
+#define MODBUS_STATUS_RUNNING       (1u << 0)   // Control task running
+#define MODBUS_STATUS_SENSOR_OK     (1u << 1)   // Last loop reading valid
+#define MODBUS_STATUS_AUTO          (1u << 2)   // PID in control
+#define MODBUS_STATUS_PROFILE       (1u << 3)   // Profile running
+#define MODBUS_STATUS_AUTOTUNE      (1u << 4)   // Autotune running
+#define MODBUS_STATUS_INTERLOCK     (1u << 5)   // Safety interlock tripped, heater held off
+
+#define MODBUS_INVALID              0x8000      // Scaled value not available
+#define MODBUS_MAX_CHANNELS         8
+#define MODBUS_MAX_ZONES            4
+
+// Fields a write set (modbus_command_t.fields)
+#define MODBUS_WRITE_MODE           (1u << 0)
+#define MODBUS_WRITE_SETPOINT       (1u << 1)
+#define MODBUS_WRITE_POWER          (1u << 2)
+#define MODBUS_WRITE_GAINS          (1u << 3)
+
+typedef struct {
+    uint16_t status;                // MODBUS_STATUS_*
+    uint16_t mode;                  // control_mode_t
+    float temperature;              // °C
+    float estimate;                 // °C
+    float setpoint;                 // °C
+    float output;                   // %
+    float feedforward;              // %
+    float rate;                     // °C/min
+    uint32_t spikes;
+    uint32_t ticks;
+    uint32_t overruns;
+    uint32_t step_us;
+    float kp;
+    float ki;
+    float kd;
+    uint8_t channels;
+    uint8_t zones;
+    bool channel_valid[MODBUS_MAX_CHANNELS];
+    float channel_temp[MODBUS_MAX_CHANNELS];   // °C
+    uint8_t channel_fault[MODBUS_MAX_CHANNELS];
+    float zone_duty[MODBUS_MAX_ZONES];         // %
+} modbus_state_t;
+
+typedef struct {
+    uint32_t fields;                // MODBUS_WRITE_*
+    uint16_t mode;
+    float setpoint;                 // °C
+    float power;                    // %
+    float kp;                       // All three set with MODBUS_WRITE_GAINS
+    float ki;
+    float kd;
+} modbus_command_t;
+
+typedef struct {
+    // Fills a snapshot of the live state; must not block
+    void (*read_state)(void *ctx, modbus_state_t *state);
+    // ESP_ERR_INVALID_ARG answers ILLEGAL DATA VALUE, other errors DEVICE FAILURE
+    esp_err_t (*write)(void *ctx, const modbus_command_t *command);
+    void *ctx;
+} modbus_ops_t;
+
+typedef struct {
+    uint32_t connections;           // Accepted
+    uint32_t rejected;              // Closed at once: all MODBUS_MAX_CLIENTS slots busy
+    uint32_t requests;
+    uint32_t exceptions;            // Requests answered with an exception
+    uint32_t writes;                // Commands applied
+    uint32_t errors;                // Connections dropped on a framing or send error
+    uint8_t clients;                // Open now
+} modbus_stats_t;
+
+typedef struct {
+    int fd;                         // -1: free slot
+    size_t len;                     // Bytes buffered in rx
+    int64_t last_ms;                // Last request, for the idle timeout
+    uint8_t rx[MODBUS_MAX_ADU];
+} modbus_client_t;
+
+typedef struct {
+    modbus_ops_t ops;
+    int listen_fd;
+    modbus_client_t clients[MODBUS_MAX_CLIENTS];
+    modbus_stats_t stats;
+} modbus_server_t;
+
+// Function prototypes
+void modbus_encode_inputs(const modbus_state_t *state, uint16_t *regs);
+void modbus_encode_holding(const modbus_state_t *state, uint16_t *regs);
+uint8_t modbus_decode_holding(const uint16_t *regs, uint16_t first, uint16_t count, modbus_command_t *command);
+size_t modbus_process(const modbus_ops_t *ops, const uint8_t *request, size_t len, uint8_t *response);
+esp_err_t modbus_server_open(modbus_server_t *server, uint16_t port, const modbus_ops_t *ops);
+esp_err_t modbus_server_poll(modbus_server_t *server, uint32_t timeout_ms);
+void modbus_server_close(modbus_server_t *server);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_H
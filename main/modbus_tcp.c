@@ -0,0 +1,195 @@
+/*
+ * Modbus TCP Server Task Implementation
+ */
+
+#include "modbus_tcp.h"
+#include "control_task.h"
+#include "temp_sampler.h"
+#include "settings.h"
+#include "safety.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "dlog.h"
+#include "freertos/task.h"
+
+static const char *TAG = "MODBUS_TCP";
+
+static TaskHandle_t s_task_handle = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static modbus_tcp_status_t s_status;        // Protected by s_lock
+
+// Server task only
+static const hal_actuator_t *s_heater = NULL;
+static uint16_t s_port;
+static modbus_server_t s_server;
+
+// Function prototypes
+static void modbus_tcp_task(void *arg);
+
+static void read_state(void *ctx, modbus_state_t *state)
+{
+    control_status_t control;
+    control_task_get_status(&control);
+
+    *state = (modbus_state_t) {
+        .mode = (uint16_t)control.mode,
+        .temperature = control.temperature,
+        .estimate = control.estimate,
+        .setpoint = control.setpoint,
+        .output = control.output,
+        .feedforward = control.feedforward,
+        .rate = control.rate,
+        .spikes = control.spike_count,
+        .ticks = control.tick_count,
+        .overruns = control.overrun_count,
+        .step_us = control.last_step_us,
+        .kp = control.kp,
+        .ki = control.ki,
+        .kd = control.kd,
+    };
+    if (control_task_is_running()) {
+        state->status |= MODBUS_STATUS_RUNNING;
+    }
+    if (control.sensor_ok) {
+        state->status |= MODBUS_STATUS_SENSOR_OK;
+    }
+    if (control.mode == CONTROL_MODE_AUTO) {
+        state->status |= MODBUS_STATUS_AUTO;
+    }
+    if (control.profile == PROFILE_STATE_RAMP || control.profile == PROFILE_STATE_HOLD) {
+        state->status |= MODBUS_STATUS_PROFILE;
+    }
+    if (control.autotune == AUTOTUNE_STATE_RUNNING) {
+        state->status |= MODBUS_STATUS_AUTOTUNE;
+    }
+    if (safety_is_tripped()) {
+        state->status |= MODBUS_STATUS_INTERLOCK;
+    }
+
+    // The sampler's last published readings; a stale one is reported invalid
+    temp_sample_t samples[MODBUS_MAX_CHANNELS];
+    size_t count = 0;
+    temp_sampler_get_all(samples, MODBUS_MAX_CHANNELS, &count);
+    int64_t now_us = esp_timer_get_time();
+    state->channels = (uint8_t)count;
+    for (size_t i = 0; i < count; i++) {
+        bool fresh = (now_us - samples[i].timestamp_us) <= (int64_t)CONTROL_SAMPLE_MAX_AGE_MS * 1000;
+        state->channel_valid[i] = samples[i].status == ESP_OK && fresh;
+        state->channel_temp[i] = samples[i].temperature;
+        state->channel_fault[i] = samples[i].fault;
+    }
+
+    size_t zones = s_heater->channels < MODBUS_MAX_ZONES ? s_heater->channels : MODBUS_MAX_ZONES;
+    state->zones = (uint8_t)zones;
+    for (size_t i = 0; i < zones; i++) {
+        state->zone_duty[i] = hal_actuator_duty_to_percent(s_heater, hal_actuator_get_duty(s_heater, i));
+    }
+}
+
+// Same effect and persistence as the REST endpoints; the mode goes last so
+// it wins over the manual switch a power write implies. Refused (device
+// failure) while the safety interlock holds the heater off.
+static esp_err_t write_command(void *ctx, const modbus_command_t *command)
+{
+    if (!control_task_is_running() || safety_is_tripped()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (command->fields & MODBUS_WRITE_GAINS) {
+        ret = control_task_set_gains(command->kp, command->ki, command->kd);
+        if (ret == ESP_OK) {
+            settings_set_gains(command->kp, command->ki, command->kd);
+        }
+    }
+    if (ret == ESP_OK && (command->fields & MODBUS_WRITE_SETPOINT)) {
+        ret = control_task_set_setpoint(command->setpoint);
+        if (ret == ESP_OK) {
+            settings_set_setpoint(command->setpoint);
+        }
+    }
+    if (ret == ESP_OK && (command->fields & MODBUS_WRITE_POWER)) {
+        ret = control_task_set_manual_power(command->power);
+        if (ret == ESP_OK) {
+            settings_set_manual_power(command->power);
+        }
+    }
+    if (ret == ESP_OK && (command->fields & MODBUS_WRITE_MODE)) {
+        ret = control_task_set_mode((control_mode_t)command->mode);
+        if (ret == ESP_OK) {
+            // The store keeps the mode with the setpoint or manual power that goes with it
+            control_status_t control;
+            control_task_get_status(&control);
+            if (command->mode == CONTROL_MODE_AUTO) {
+                settings_set_setpoint(control.setpoint);
+            } else {
+                settings_set_manual_power(control.output);
+            }
+        }
+    }
+    return ret;
+}
+
+static void modbus_tcp_task(void *arg)
+{
+    const modbus_ops_t ops = {
+        .read_state = read_state,
+        .write = write_command,
+    };
+
+    while (modbus_server_open(&s_server, s_port, &ops) != ESP_OK) {
+        DLOGW(TAG, "Cannot listen on the Modbus port, retrying");
+        vTaskDelay(pdMS_TO_TICKS(MODBUS_TCP_POLL_MS));
+    }
+
+    while (1) {
+        if (modbus_server_poll(&s_server, MODBUS_TCP_POLL_MS) != ESP_OK) {
+            DLOGW(TAG, "select() failed");
+            vTaskDelay(pdMS_TO_TICKS(MODBUS_TCP_POLL_MS));
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_status.stats = s_server.stats;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t modbus_tcp_start(const hal_actuator_t *heater, uint16_t port)
+{
+    if (heater == NULL || port == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_heater = heater;
+    s_port = port;
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? MODBUS_TCP_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(modbus_tcp_task, "modbus_tcp", MODBUS_TCP_STACK_SIZE,
+                                                 NULL, MODBUS_TCP_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create server task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_status.running = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Modbus TCP server on port %u (%d masters)", port, MODBUS_MAX_CLIENTS);
+    return ESP_OK;
+}
+
+void modbus_tcp_get_status(modbus_tcp_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,47 @@
+/*
+ * Modbus TCP Server Task
+ *
+ * Serves the register map in modbus.h to PLC/SCADA masters. Reads are
+ * answered from the control task status, the sampler's published samples
+ * and the actuator's duty targets, never from the sensors, so a master
+ * polling every 10 ms costs a few microseconds per request and cannot
+ * delay the control loop. Writes go through the same control task setters
+ * and settings store as the REST API. One task on core 0 serves up to
+ * MODBUS_MAX_CLIENTS connections with select().
+ */
+
+#ifndef MODBUS_TCP_H
+#define MODBUS_TCP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "hal_actuator.h"
+#include "modbus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MODBUS_TCP_ENABLED          true
+#define MODBUS_TCP_PORT             MODBUS_TCP_DEFAULT_PORT
+#define MODBUS_TCP_POLL_MS          1000    // select() timeout, bounds the idle-connection check
+#define MODBUS_TCP_STACK_SIZE       4096
+#define MODBUS_TCP_PRIORITY         (tskIDLE_PRIORITY + 4)  // Above telemetry, below the HTTP server
+#define MODBUS_TCP_CORE             0       // Away from the control task
+
+typedef struct {
+    bool running;
+    modbus_stats_t stats;
+} modbus_tcp_status_t;
+
+// Function prototypes
+esp_err_t modbus_tcp_start(const hal_actuator_t *heater, uint16_t port);
+void modbus_tcp_get_status(modbus_tcp_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MODBUS_TCP_H
@@ -4,19 +4,35 @@
 
 #include "mosfet_pwm.h"
 #include "esp_log.h"
+#include "dlog.h"
+#include "metrics.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "MOSFET_PWM";
 
+static void mosfet_pwm_dither_cb(void *arg);
+
 esp_err_t mosfet_pwm_init(mosfet_pwm_handle_t *handle)
 {
-    if (handle == NULL) {
+    const gpio_num_t pin = MOSFET_PWM_PIN;
+    return mosfet_pwm_init_zones(handle, &pin, 1);
+}
+
+esp_err_t mosfet_pwm_init_zones(mosfet_pwm_handle_t *handle, const gpio_num_t *pins, size_t count)
+{
+    if (handle == NULL || pins == NULL) {
         ESP_LOGE(TAG, "Handle is NULL");
         return ESP_ERR_INVALID_ARG;
     }
 
-    // Configure LEDC timer
+    if (count == 0 || count > MOSFET_PWM_MAX_ZONES) {
+        ESP_LOGE(TAG, "Invalid zone count %u (max %d)", (unsigned)count, MOSFET_PWM_MAX_ZONES);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Configure LEDC timer, shared by all zones so their periods stay aligned
     ledc_timer_config_t timer_config = {
         .speed_mode = MOSFET_PWM_MODE,
         .timer_num = MOSFET_PWM_TIMER,
@@ -31,36 +47,292 @@ esp_err_t mosfet_pwm_init(mosfet_pwm_handle_t *handle)
         return ret;
     }
 
-    // Configure LEDC channel
-    ledc_channel_config_t channel_config = {
-        .speed_mode = MOSFET_PWM_MODE,
-        .channel = MOSFET_PWM_CHANNEL,
-        .timer_sel = MOSFET_PWM_TIMER,
-        .intr_type = LEDC_INTR_DISABLE,
-        .gpio_num = MOSFET_PWM_PIN,
-        .duty = 0,  // Start with 0% duty cycle
-        .hpoint = 0
-    };
+    // Configure one LEDC channel per zone
+    for (size_t i = 0; i < count; i++) {
+        ledc_channel_config_t channel_config = {
+            .speed_mode = MOSFET_PWM_MODE,
+            .channel = (ledc_channel_t)(MOSFET_PWM_CHANNEL + i),
+            .timer_sel = MOSFET_PWM_TIMER,
+            .intr_type = LEDC_INTR_DISABLE,
+            .gpio_num = pins[i],
+            .duty = 0,  // Start with 0% duty cycle
+            .hpoint = 0
+        };
+
+        ret = ledc_channel_config(&channel_config);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to configure LEDC channel: %s", esp_err_to_name(ret));
+            return ret;
+        }
+
+        if (i == 0) {
+            handle->channel_config = channel_config;
+        }
+        handle->zones[i] = (mosfet_pwm_zone_t) {
+            .gpio = pins[i],
+            .channel = channel_config.channel,
+        };
+        ESP_LOGI(TAG, "Zone %u: GPIO%d, LEDC channel %d", (unsigned)i, pins[i], channel_config.channel);
+    }
 
-    ret = ledc_channel_config(&channel_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to configure LEDC channel: %s", esp_err_to_name(ret));
-        return ret;
+    handle->zone_count = count;
+    handle->overlap = (mosfet_pwm_overlap_t) {0};
+    handle->dithering = false;
+    handle->skipped_writes = 0;
+    atomic_init(&handle->inhibited, false);
+
+    if (handle->lock == NULL) {
+        handle->lock = xSemaphoreCreateMutex();
+        if (handle->lock == NULL) {
+            ESP_LOGE(TAG, "Failed to create lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (handle->dither_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = mosfet_pwm_dither_cb,
+            .arg = handle,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "pwm_dither",
+            .skip_unhandled_events = true,
+        };
+        ret = esp_timer_create(&timer_args, &handle->dither_timer);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to create dither timer: %s", esp_err_to_name(ret));
+            return ret;
+        }
     }
 
-    handle->channel_config = channel_config;
     handle->initialized = true;
     handle->current_duty = 0;
 
     ESP_LOGI(TAG, "MOSFET PWM initialized successfully");
     ESP_LOGI(TAG, "PWM Pin: GPIO%d, Frequency: %d Hz, Resolution: %d bits", 
-             MOSFET_PWM_PIN, MOSFET_PWM_FREQUENCY, MOSFET_PWM_RESOLUTION);
+             pins[0], MOSFET_PWM_FREQUENCY, MOSFET_PWM_RESOLUTION);
     ESP_LOGI(TAG, "Max duty cycle: %d (100%%)", MOSFET_PWM_MAX_DUTY);
 
     return ESP_OK;
 }
 
-esp_err_t mosfet_pwm_set_duty(mosfet_pwm_handle_t *handle, uint32_t duty_percent)
+void mosfet_pwm_plan_hpoints(const uint32_t *duties, uint32_t *hpoints, size_t count)
+{
+    // Wrap-around packing: each pulse starts where the previous one ends,
+    // so every point of the period is covered floor or ceil(total / period) times
+    uint32_t start = 0;
+    for (size_t i = 0; i < count; i++) {
+        hpoints[i] = start;
+        start = (start + duties[i]) % MOSFET_PWM_PERIOD_COUNTS;
+    }
+}
+
+void mosfet_pwm_compute_overlap(const uint32_t *duties, const uint32_t *hpoints, size_t count,
+                                mosfet_pwm_overlap_t *overlap)
+{
+    // Every rising and falling edge splits the period into constant-coverage segments
+    uint32_t edges[2 * MOSFET_PWM_MAX_ZONES + 1];
+    size_t edge_count = 0;
+
+    *overlap = (mosfet_pwm_overlap_t) {0};
+    edges[edge_count++] = 0;
+    for (size_t i = 0; i < count; i++) {
+        overlap->total_duty += duties[i];
+        if (duties[i] > 0) {
+            edges[edge_count++] = hpoints[i] % MOSFET_PWM_PERIOD_COUNTS;
+            edges[edge_count++] = (hpoints[i] + duties[i]) % MOSFET_PWM_PERIOD_COUNTS;
+        }
+    }
+
+    // Insertion sort, at most 2 * MOSFET_PWM_MAX_ZONES + 1 entries
+    for (size_t i = 1; i < edge_count; i++) {
+        uint32_t edge = edges[i];
+        size_t j = i;
+        while (j > 0 && edges[j - 1] > edge) {
+            edges[j] = edges[j - 1];
+            j--;
+        }
+        edges[j] = edge;
+    }
+
+    for (size_t e = 0; e < edge_count; e++) {
+        uint32_t begin = edges[e];
+        uint32_t end = (e + 1 < edge_count) ? edges[e + 1] : MOSFET_PWM_PERIOD_COUNTS;
+        if (end == begin) {
+            continue;
+        }
+
+        uint32_t zones_on = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t offset = (begin + MOSFET_PWM_PERIOD_COUNTS - hpoints[i]) % MOSFET_PWM_PERIOD_COUNTS;
+            if (offset < duties[i]) {
+                zones_on++;
+            }
+        }
+
+        if (zones_on > overlap->max_zones_on) {
+            overlap->max_zones_on = zones_on;
+            overlap->max_on_counts = end - begin;
+        } else if (zones_on == overlap->max_zones_on) {
+            overlap->max_on_counts += end - begin;
+        }
+    }
+}
+
+// Writes counts to every zone; caller holds handle->lock
+static esp_err_t apply_zone_duties(mosfet_pwm_handle_t *handle, const uint32_t *duties)
+{
+    uint32_t hpoints[MOSFET_PWM_MAX_ZONES];
+    bool changed[MOSFET_PWM_MAX_ZONES];
+    bool any_changed = false;
+
+    mosfet_pwm_plan_hpoints(duties, hpoints, handle->zone_count);
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        changed[i] = duties[i] != handle->zones[i].duty || hpoints[i] != handle->zones[i].hpoint;
+        any_changed |= changed[i];
+    }
+
+    if (!any_changed) {
+        handle->skipped_writes++;
+        return ESP_OK;
+    }
+
+    // Under the safety cutoff only the targets move; releasing it applies them
+    if (atomic_load(&handle->inhibited)) {
+        return ESP_OK;
+    }
+
+    // Stage every changed zone, then latch them; all take effect on the same timer period
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        if (!changed[i]) {
+            continue;
+        }
+        esp_err_t ret = ledc_set_duty_with_hpoint(MOSFET_PWM_MODE, handle->zones[i].channel, duties[i], hpoints[i]);
+        if (ret != ESP_OK) {
+            DLOGE(TAG, "Failed to set duty cycle: %s", esp_err_to_name(ret));
+            return ret;
+        }
+    }
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        if (!changed[i]) {
+            continue;
+        }
+        esp_err_t ret = ledc_update_duty(MOSFET_PWM_MODE, handle->zones[i].channel);
+        if (ret != ESP_OK) {
+            DLOGE(TAG, "Failed to update duty cycle: %s", esp_err_to_name(ret));
+            return ret;
+        }
+        handle->zones[i].duty = duties[i];
+        handle->zones[i].hpoint = hpoints[i];
+    }
+
+    // ledc_update_duty() re-enables the output, so a cutoff that landed
+    // after the check above is repeated here (it sets the flag first)
+    if (atomic_load(&handle->inhibited)) {
+        for (size_t i = 0; i < handle->zone_count; i++) {
+            ledc_stop(MOSFET_PWM_MODE, handle->zones[i].channel, 0);
+        }
+    }
+    metrics_observe(METRICS_LEDC_UPDATE, (uint32_t)(esp_timer_get_time() - start_us));
+
+    mosfet_pwm_compute_overlap(duties, hpoints, handle->zone_count, &handle->overlap);
+    handle->current_duty = duties[0];
+
+    return ESP_OK;
+}
+
+// Target of every zone rounded to LEDC counts; caller holds handle->lock
+static void rounded_targets(const mosfet_pwm_handle_t *handle, uint32_t *duties)
+{
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        uint32_t fine = handle->zones[i].target_fine + (1u << (MOSFET_PWM_DITHER_BITS - 1));
+        duties[i] = fine >> MOSFET_PWM_DITHER_BITS;
+        if (duties[i] > MOSFET_PWM_MAX_DUTY) {
+            duties[i] = MOSFET_PWM_MAX_DUTY;
+        }
+    }
+}
+
+// Applies the rounded targets now (a stop must not wait for the timer);
+// with dithering on, the timer then modulates the extra bits. Caller holds
+// handle->lock
+static esp_err_t apply_targets(mosfet_pwm_handle_t *handle)
+{
+    uint32_t duties[MOSFET_PWM_MAX_ZONES];
+    rounded_targets(handle, duties);
+    esp_err_t ret = apply_zone_duties(handle, duties);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        mosfet_pwm_zone_t *zone = &handle->zones[i];
+        zone->applied_fine = handle->dithering ? zone->target_fine : duties[i] << MOSFET_PWM_DITHER_BITS;
+    }
+    return ESP_OK;
+}
+
+// First-order sigma-delta: the carried error adds one count on the periods where it overflows
+static void mosfet_pwm_dither_cb(void *arg)
+{
+    mosfet_pwm_handle_t *handle = (mosfet_pwm_handle_t *)arg;
+    const uint32_t one = 1u << MOSFET_PWM_DITHER_BITS;
+
+    // Never block the timer task; a busy lock means a fresh write is in progress
+    if (xSemaphoreTake(handle->lock, 0) != pdTRUE) {
+        return;
+    }
+
+    uint32_t duties[MOSFET_PWM_MAX_ZONES];
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        mosfet_pwm_zone_t *zone = &handle->zones[i];
+        duties[i] = zone->target_fine >> MOSFET_PWM_DITHER_BITS;
+        zone->dither_accum += zone->target_fine & (one - 1);
+        if (zone->dither_accum >= one) {
+            zone->dither_accum -= one;
+            duties[i]++;
+        }
+    }
+
+    apply_zone_duties(handle, duties);
+    xSemaphoreGive(handle->lock);
+}
+
+esp_err_t mosfet_pwm_set_zone_duties_fine(mosfet_pwm_handle_t *handle, const uint32_t *fine_duties, size_t count)
+{
+    if (handle == NULL || fine_duties == NULL) {
+        ESP_LOGE(TAG, "Handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!handle->initialized) {
+        ESP_LOGE(TAG, "MOSFET PWM not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (count > handle->zone_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+
+    // Zones past count keep their duty but are re-staggered with the rest
+    for (size_t i = 0; i < count; i++) {
+        uint32_t fine = fine_duties[i];
+        handle->zones[i].target_fine = fine > MOSFET_PWM_MAX_DUTY_FINE ? MOSFET_PWM_MAX_DUTY_FINE : fine;
+    }
+
+    esp_err_t ret = apply_targets(handle);
+
+    xSemaphoreGive(handle->lock);
+
+    ESP_LOGD(TAG, "Zone duties set, peak %d zones on for %d counts",
+             handle->overlap.max_zones_on, handle->overlap.max_on_counts);
+
+    return ret;
+}
+
+esp_err_t mosfet_pwm_set_zone_duty_fine(mosfet_pwm_handle_t *handle, size_t zone, uint32_t fine_duty)
 {
     if (handle == NULL) {
         ESP_LOGE(TAG, "Handle is NULL");
@@ -72,32 +344,141 @@ esp_err_t mosfet_pwm_set_duty(mosfet_pwm_handle_t *handle, uint32_t duty_percent
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (duty_percent > 100) {
-        ESP_LOGW(TAG, "Duty cycle clamped to 100%% (was %d%%)", duty_percent);
-        duty_percent = 100;
+    if (zone >= handle->zone_count) {
+        return ESP_ERR_INVALID_ARG;
     }
 
-    uint32_t duty_value = mosfet_pwm_percent_to_duty(duty_percent);
-    
-    esp_err_t ret = ledc_set_duty(MOSFET_PWM_MODE, MOSFET_PWM_CHANNEL, duty_value);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set duty cycle: %s", esp_err_to_name(ret));
-        return ret;
+    // The other zones' targets are read under the lock with this one
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    handle->zones[zone].target_fine = fine_duty > MOSFET_PWM_MAX_DUTY_FINE ? MOSFET_PWM_MAX_DUTY_FINE : fine_duty;
+    esp_err_t ret = apply_targets(handle);
+    xSemaphoreGive(handle->lock);
+
+    return ret;
+}
+
+// Lock-free: read by the control and safety tasks every tick
+uint32_t mosfet_pwm_get_applied_fine(const mosfet_pwm_handle_t *handle, size_t zone)
+{
+    if (handle == NULL || !handle->initialized || zone >= handle->zone_count) {
+        return 0;
     }
 
-    ret = ledc_update_duty(MOSFET_PWM_MODE, MOSFET_PWM_CHANNEL);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to update duty cycle: %s", esp_err_to_name(ret));
-        return ret;
+    if (atomic_load(&handle->inhibited)) {
+        return 0;
     }
+    return handle->zones[zone].applied_fine;
+}
 
-    handle->current_duty = duty_value;
-    
-    ESP_LOGI(TAG, "PWM duty cycle set to %d%% (duty value: %d)", duty_percent, duty_value);
+esp_err_t mosfet_pwm_set_zone_duties(mosfet_pwm_handle_t *handle, const uint32_t *duties, size_t count)
+{
+    if (handle == NULL || duties == NULL || count > MOSFET_PWM_MAX_ZONES) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uint32_t fine_duties[MOSFET_PWM_MAX_ZONES];
+    for (size_t i = 0; i < count; i++) {
+        uint32_t duty = duties[i] > MOSFET_PWM_MAX_DUTY ? MOSFET_PWM_MAX_DUTY : duties[i];
+        fine_duties[i] = duty << MOSFET_PWM_DITHER_BITS;
+    }
+
+    return mosfet_pwm_set_zone_duties_fine(handle, fine_duties, count);
+}
+
+esp_err_t mosfet_pwm_set_fraction(mosfet_pwm_handle_t *handle, uint32_t fraction_q16)
+{
+    if (fraction_q16 > MOSFET_PWM_FRACTION_ONE) {
+        fraction_q16 = MOSFET_PWM_FRACTION_ONE;
+    }
+
+    // Zone 0 only; the other zones keep their duty
+    uint32_t fine = (uint32_t)(((uint64_t)fraction_q16 * MOSFET_PWM_MAX_DUTY_FINE + MOSFET_PWM_FRACTION_ONE / 2)
+                               / MOSFET_PWM_FRACTION_ONE);
+    return mosfet_pwm_set_zone_duties_fine(handle, &fine, 1);
+}
+
+esp_err_t mosfet_pwm_set_dither(mosfet_pwm_handle_t *handle, bool enable)
+{
+    if (handle == NULL) {
+        ESP_LOGE(TAG, "Handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!handle->initialized) {
+        ESP_LOGE(TAG, "MOSFET PWM not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (enable == handle->dithering) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret;
+    if (enable) {
+        handle->dithering = true;
+        ret = esp_timer_start_periodic(handle->dither_timer, MOSFET_PWM_DITHER_PERIOD_US);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start dither timer: %s", esp_err_to_name(ret));
+            handle->dithering = false;
+            return ret;
+        }
+
+        // From here the outputs average the fine targets
+        xSemaphoreTake(handle->lock, portMAX_DELAY);
+        for (size_t i = 0; i < handle->zone_count; i++) {
+            handle->zones[i].applied_fine = handle->zones[i].target_fine;
+        }
+        xSemaphoreGive(handle->lock);
+    } else {
+        esp_timer_stop(handle->dither_timer);
+        handle->dithering = false;
+
+        // Settle on the rounded targets
+        const uint32_t unchanged[MOSFET_PWM_MAX_ZONES] = {0};
+        ret = mosfet_pwm_set_zone_duties_fine(handle, unchanged, 0);
+    }
+
+    ESP_LOGI(TAG, "Sigma-delta dithering %s (%d extra bits)", enable ? "enabled" : "disabled",
+             MOSFET_PWM_DITHER_BITS);
+    return ret;
+}
+
+esp_err_t mosfet_pwm_get_overlap(const mosfet_pwm_handle_t *handle, mosfet_pwm_overlap_t *overlap)
+{
+    if (handle == NULL || overlap == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
+    if (!handle->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *overlap = handle->overlap;
     return ESP_OK;
 }
 
+esp_err_t mosfet_pwm_set_duty(mosfet_pwm_handle_t *handle, uint32_t duty_percent)
+{
+    if (duty_percent > 100) {
+        DLOGW(TAG, "Duty cycle clamped to 100%% (was %d%%)", duty_percent);
+        duty_percent = 100;
+    }
+
+    return mosfet_pwm_set_duty_raw(handle, mosfet_pwm_percent_to_duty(duty_percent));
+}
+
+esp_err_t mosfet_pwm_set_duty_raw(mosfet_pwm_handle_t *handle, uint32_t duty_value)
+{
+    if (handle == NULL) {
+        ESP_LOGE(TAG, "Handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Zone 0 only; the other zones keep their duty
+    return mosfet_pwm_set_zone_duties(handle, &duty_value, 1);
+}
+
 esp_err_t mosfet_pwm_set_power(mosfet_pwm_handle_t *handle, float power_percent)
 {
     if (handle == NULL) {
@@ -106,15 +487,16 @@ esp_err_t mosfet_pwm_set_power(mosfet_pwm_handle_t *handle, float power_percent)
     }
 
     if (power_percent < 0.0f) {
-        ESP_LOGW(TAG, "Power percentage clamped to 0%% (was %.2f%%)", power_percent);
+        DLOGW(TAG, "Power percentage clamped to 0%% (was %.2f%%)", power_percent);
         power_percent = 0.0f;
     } else if (power_percent > 100.0f) {
-        ESP_LOGW(TAG, "Power percentage clamped to 100%% (was %.2f%%)", power_percent);
+        DLOGW(TAG, "Power percentage clamped to 100%% (was %.2f%%)", power_percent);
         power_percent = 100.0f;
     }
 
-    uint32_t duty_percent = (uint32_t)power_percent;
-    return mosfet_pwm_set_duty(handle, duty_percent);
+    // Full resolution; the old path truncated to whole percent (101 levels)
+    uint32_t fraction = (uint32_t)(power_percent / 100.0f * MOSFET_PWM_FRACTION_ONE + 0.5f);
+    return mosfet_pwm_set_fraction(handle, fraction);
 }
 
 esp_err_t mosfet_pwm_stop(mosfet_pwm_handle_t *handle)
@@ -129,7 +511,8 @@ esp_err_t mosfet_pwm_stop(mosfet_pwm_handle_t *handle)
         return ESP_OK;
     }
 
-    esp_err_t ret = mosfet_pwm_set_duty(handle, 0);
+    const uint32_t off[MOSFET_PWM_MAX_ZONES] = {0};
+    esp_err_t ret = mosfet_pwm_set_zone_duties_fine(handle, off, handle->zone_count);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "MOSFET PWM stopped (0%% duty cycle)");
     }
@@ -137,6 +520,42 @@ esp_err_t mosfet_pwm_stop(mosfet_pwm_handle_t *handle)
     return ret;
 }
 
+esp_err_t mosfet_pwm_inhibit(mosfet_pwm_handle_t *handle, bool inhibit)
+{
+    if (handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (!handle->initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (inhibit) {
+        // Flag first: a write already past its check stops the output again after latching
+        atomic_store(&handle->inhibited, true);
+        esp_err_t ret = ESP_OK;
+        for (size_t i = 0; i < handle->zone_count; i++) {
+            esp_err_t err = ledc_stop(MOSFET_PWM_MODE, handle->zones[i].channel, 0);
+            if (err != ESP_OK) {
+                ret = err;
+            }
+        }
+        return ret;
+    }
+
+    xSemaphoreTake(handle->lock, portMAX_DELAY);
+    atomic_store(&handle->inhibited, false);
+
+    // The outputs were stopped behind the bookkeeping, so every zone is rewritten
+    for (size_t i = 0; i < handle->zone_count; i++) {
+        handle->zones[i].duty = UINT32_MAX;
+    }
+    esp_err_t ret = apply_targets(handle);
+    xSemaphoreGive(handle->lock);
+
+    return ret;
+}
+
 esp_err_t mosfet_pwm_start(mosfet_pwm_handle_t *handle)
 {
     if (handle == NULL) {
@@ -168,6 +587,7 @@ esp_err_t mosfet_pwm_deinit(mosfet_pwm_handle_t *handle)
     }
 
     // Stop PWM first
+    mosfet_pwm_set_dither(handle, false);
     mosfet_pwm_stop(handle);
 
     // Note: LEDC doesn't have explicit deinit function
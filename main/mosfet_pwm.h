@@ -3,14 +3,37 @@
  * 
  * This driver provides PWM control for MOSFET IRF3205 to control
  * nichrome wire heating element.
+ *
+ * Several heater zones can share the LEDC timer, one channel each. Zone
+ * pulses are packed end to end around the PWM period (each zone's hpoint
+ * starts where the previous zone's pulse ends), so the number of zones
+ * conducting at once never exceeds ceil(sum of duties / period).
+ *
+ * Duties can be given as raw LEDC counts, as "fine" counts with
+ * MOSFET_PWM_DITHER_BITS extra bits, or as Q16 fractions. With dithering
+ * enabled, a sigma-delta modulator spreads the extra bits over successive
+ * PWM periods (15-bit effective resolution, 8 ms cycle against a ~200 ms
+ * wire time constant). Writes that do not change a zone's duty or hpoint
+ * never reach the LEDC peripheral.
+ *
+ * mosfet_pwm_inhibit() is the safety cutoff: it stops every channel low
+ * straight through the LEDC driver without taking handle->lock, so it never
+ * waits for the control task or the dither timer. While inhibited, duty
+ * writes only update the targets; releasing the cutoff applies them.
+ * mosfet_pwm_get_applied_fine() reports what the outputs apply, so 0 while
+ * inhibited, not the requested target.
  */
 
 #ifndef MOSFET_PWM_H
 #define MOSFET_PWM_H
 
+#include <stdatomic.h>
 #include "esp_err.h"
+#include "esp_timer.h"
 #include "driver/ledc.h"
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,28 +46,75 @@ extern "C" {
 #define MOSFET_PWM_FREQUENCY      1000    // 1 kHz PWM frequency
 #define MOSFET_PWM_RESOLUTION      LEDC_TIMER_12_BIT  // 0-4095 duty cycle
 #define MOSFET_PWM_MAX_DUTY       4095    // Maximum duty cycle (100%)
+#define MOSFET_PWM_PERIOD_COUNTS  4096    // Timer counts per PWM period
+#define MOSFET_PWM_MAX_ZONES      4       // LEDC_CHANNEL_0..3 on MOSFET_PWM_TIMER
+
+// Fine Duty / Dithering
+#define MOSFET_PWM_DITHER_BITS       3       // Fine counts stay below 32768 for the Q16.16 PID
+#define MOSFET_PWM_MAX_DUTY_FINE     (MOSFET_PWM_MAX_DUTY << MOSFET_PWM_DITHER_BITS)
+#define MOSFET_PWM_DITHER_PERIOD_US  (1000000 / MOSFET_PWM_FREQUENCY)  // One step per PWM period
+#define MOSFET_PWM_FRACTION_ONE      65536   // Q16 fraction at 100%
 
 // GPIO Pin Configuration
 #define MOSFET_PWM_PIN            GPIO_NUM_4   // PWM output pin (GPIO2 used for onboard LED on DevKitC)
 
+// Heater Zone
+typedef struct {
+    gpio_num_t gpio;
+    ledc_channel_t channel;
+    uint32_t duty;              // Counts currently in the LEDC channel
+    uint32_t hpoint;
+    uint32_t target_fine;       // Requested duty, fine counts
+    uint32_t applied_fine;      // Duty the LEDC applies on average, fine counts
+    uint32_t dither_accum;      // Sigma-delta error, < 1 << MOSFET_PWM_DITHER_BITS
+} mosfet_pwm_zone_t;
+
+// Worst-case overlap of the zone pulses within one period
+typedef struct {
+    uint32_t max_zones_on;      // Peak number of zones conducting together
+    uint32_t max_on_counts;     // Counts per period spent at that peak
+    uint32_t total_duty;        // Sum of zone duties (counts)
+} mosfet_pwm_overlap_t;
+
 // Power Control Functions
 typedef struct {
-    ledc_channel_config_t channel_config;
+    ledc_channel_config_t channel_config;   // Zone 0
     bool initialized;
-    uint32_t current_duty;
+    uint32_t current_duty;                  // Zone 0
+    mosfet_pwm_zone_t zones[MOSFET_PWM_MAX_ZONES];
+    size_t zone_count;
+    mosfet_pwm_overlap_t overlap;           // For the duties currently applied
+    SemaphoreHandle_t lock;                 // Serializes LEDC writes with the dither timer
+    esp_timer_handle_t dither_timer;
+    bool dithering;
+    uint32_t skipped_writes;                // Updates that changed nothing
+    atomic_bool inhibited;                  // Safety cutoff engaged, outputs held low
 } mosfet_pwm_handle_t;
 
 // Function prototypes
 esp_err_t mosfet_pwm_init(mosfet_pwm_handle_t *handle);
+esp_err_t mosfet_pwm_init_zones(mosfet_pwm_handle_t *handle, const gpio_num_t *pins, size_t count);
+esp_err_t mosfet_pwm_set_zone_duties(mosfet_pwm_handle_t *handle, const uint32_t *duties, size_t count);
+esp_err_t mosfet_pwm_set_zone_duties_fine(mosfet_pwm_handle_t *handle, const uint32_t *fine_duties, size_t count);
+esp_err_t mosfet_pwm_set_zone_duty_fine(mosfet_pwm_handle_t *handle, size_t zone, uint32_t fine_duty);
+uint32_t mosfet_pwm_get_applied_fine(const mosfet_pwm_handle_t *handle, size_t zone);
+esp_err_t mosfet_pwm_set_fraction(mosfet_pwm_handle_t *handle, uint32_t fraction_q16);
+esp_err_t mosfet_pwm_set_dither(mosfet_pwm_handle_t *handle, bool enable);
+esp_err_t mosfet_pwm_get_overlap(const mosfet_pwm_handle_t *handle, mosfet_pwm_overlap_t *overlap);
 esp_err_t mosfet_pwm_set_duty(mosfet_pwm_handle_t *handle, uint32_t duty_percent);
+esp_err_t mosfet_pwm_set_duty_raw(mosfet_pwm_handle_t *handle, uint32_t duty_value);
 esp_err_t mosfet_pwm_set_power(mosfet_pwm_handle_t *handle, float power_percent);
 esp_err_t mosfet_pwm_stop(mosfet_pwm_handle_t *handle);
+esp_err_t mosfet_pwm_inhibit(mosfet_pwm_handle_t *handle, bool inhibit);
 esp_err_t mosfet_pwm_start(mosfet_pwm_handle_t *handle);
 esp_err_t mosfet_pwm_deinit(mosfet_pwm_handle_t *handle);
 
 // Utility functions
 uint32_t mosfet_pwm_percent_to_duty(float percent);
 float mosfet_pwm_duty_to_percent(uint32_t duty);
+void mosfet_pwm_plan_hpoints(const uint32_t *duties, uint32_t *hpoints, size_t count);
+void mosfet_pwm_compute_overlap(const uint32_t *duties, const uint32_t *hpoints, size_t count,
+                                mosfet_pwm_overlap_t *overlap);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,68 @@
+/*
+ * PID Controller Implementation
+ */
+
+#include "pid_controller.h"
+
+static float clampf(float value, float min, float max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+void pid_controller_init(pid_controller_t *pid, float kp, float ki, float kd,
+                         float output_min, float output_max)
+{
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+    pid->output_min = output_min;
+    pid->output_max = output_max;
+    pid_controller_reset(pid);
+}
+
+void pid_controller_set_gains(pid_controller_t *pid, float kp, float ki, float kd)
+{
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+}
+
+void pid_controller_reset(pid_controller_t *pid)
+{
+    pid->integral = 0.0f;
+    pid->prev_measurement = 0.0f;
+    pid->p_term = 0.0f;
+    pid->d_term = 0.0f;
+    pid->initialized = false;
+}
+
+float pid_controller_update(pid_controller_t *pid, float setpoint, float measurement, float dt)
+{
+    if (dt <= 0.0f) {
+        dt = 1e-3f;
+    }
+
+    // First sample after a reset: no history for the derivative term
+    if (!pid->initialized) {
+        pid->prev_measurement = measurement;
+        pid->initialized = true;
+    }
+
+    float error = setpoint - measurement;
+    float p_term = pid->kp * error;
+
+    // Derivative on measurement avoids a kick on setpoint changes
+    float d_term = -pid->kd * (measurement - pid->prev_measurement) / dt;
+    pid->prev_measurement = measurement;
+
+    // Integrate and clamp so the integral alone can never exceed the output range
+    pid->integral += pid->ki * error * dt;
+    pid->integral = clampf(pid->integral, pid->output_min, pid->output_max);
+
+    pid->p_term = p_term;
+    pid->d_term = d_term;
+
+    return clampf(p_term + pid->integral + d_term, pid->output_min, pid->output_max);
+}
@@ -0,0 +1,42 @@
+/*
+ * PID Controller
+ *
+ * Floating point PID with derivative on measurement and integral
+ * clamping. Output is expressed in power percent (0-100%).
+ */
+
+#ifndef PID_CONTROLLER_H
+#define PID_CONTROLLER_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PID Data Structure
+typedef struct {
+    float kp;               // Proportional gain (%/°C)
+    float ki;               // Integral gain (%/(°C*s))
+    float kd;               // Derivative gain (%*s/°C)
+    float output_min;       // Lower output limit (%)
+    float output_max;       // Upper output limit (%)
+    float integral;         // Integral term accumulator (%)
+    float prev_measurement; // Last measurement, used for the derivative term
+    float p_term;           // Terms of the last update, for telemetry (%)
+    float d_term;
+    bool initialized;       // False until the first update after a reset
+} pid_controller_t;
+
+// Function prototypes
+void pid_controller_init(pid_controller_t *pid, float kp, float ki, float kd,
+                         float output_min, float output_max);
+void pid_controller_set_gains(pid_controller_t *pid, float kp, float ki, float kd);
+void pid_controller_reset(pid_controller_t *pid);
+float pid_controller_update(pid_controller_t *pid, float setpoint, float measurement, float dt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PID_CONTROLLER_H
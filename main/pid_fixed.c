@@ -0,0 +1,140 @@
+/*
+ * Fixed-Point PID Controller Implementation
+ */
+
+#include "pid_fixed.h"
+
+static int64_t clamp_i64(int64_t value, int64_t min, int64_t max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+static q16_t float_to_q16_sat(float value)
+{
+    float scaled = value * (float)Q16_ONE;
+    if (scaled > (float)INT32_MAX) return INT32_MAX;
+    if (scaled < (float)INT32_MIN) return INT32_MIN;
+    return (q16_t)(scaled + (scaled >= 0 ? 0.5f : -0.5f));
+}
+
+void pid_fixed_set_gains(pid_fixed_t *pid, const pid_fixed_config_t *config)
+{
+    float dt = (float)config->period_ms / 1000.0f;
+
+    // %/°C -> duty counts per measurement unit
+    float scale = (float)config->full_scale / 100.0f / (float)PID_FIXED_TEMP_PER_C;
+
+    pid->kp = float_to_q16_sat(config->kp * scale);
+    pid->ki = float_to_q16_sat(config->ki * scale * dt);
+    pid->kd = float_to_q16_sat(config->kd * scale / dt);
+
+    // First-order derivative filter: alpha = dt / (Tf + dt), Tf = Td / N
+    float tf = 0.0f;
+    if (config->derivative_filter_n > 0.0f && config->kp > 0.0f) {
+        tf = (config->kd / config->kp) / config->derivative_filter_n;
+    }
+    pid->d_alpha = float_to_q16_sat(dt / (tf + dt));
+
+    pid->output_min = config->output_min;
+    pid->output_max = config->output_max;
+}
+
+void pid_fixed_init(pid_fixed_t *pid, const pid_fixed_config_t *config)
+{
+    pid_fixed_set_gains(pid, config);
+    pid->automatic = false;
+    pid->feedforward = 0;
+    pid_fixed_reset(pid);
+}
+
+void pid_fixed_reset(pid_fixed_t *pid)
+{
+    pid->integral = 0;
+    pid->d_filtered = 0;
+    pid->prev_measurement = 0;
+    pid->output = pid->output_min > 0 ? pid->output_min : 0;
+    pid->p_term = 0;
+    pid->i_term = 0;
+    pid->d_term = 0;
+    pid->initialized = false;
+}
+
+void pid_fixed_set_manual(pid_fixed_t *pid, int32_t output)
+{
+    pid->automatic = false;
+    pid->output = (int32_t)clamp_i64(output, pid->output_min, pid->output_max);
+}
+
+void pid_fixed_set_auto(pid_fixed_t *pid)
+{
+    if (!pid->automatic) {
+        pid->automatic = true;
+        // The first automatic step re-seeds the integrator from the current output
+        pid->initialized = false;
+    }
+}
+
+// The integral only carries what the feed-forward misses; its limits move with it
+void pid_fixed_set_feedforward(pid_fixed_t *pid, q16_t feedforward)
+{
+    pid->feedforward = (q16_t)clamp_i64(feedforward, (int64_t)pid->output_min << Q16_SHIFT,
+                                        (int64_t)pid->output_max << Q16_SHIFT);
+}
+
+// Moves delta from the integral into the feed-forward, leaving the output unchanged
+void pid_fixed_transfer_to_feedforward(pid_fixed_t *pid, q16_t delta)
+{
+    pid->integral -= delta;
+    pid->feedforward += delta;
+}
+
+int32_t pid_fixed_step(pid_fixed_t *pid, int32_t setpoint, int32_t measurement)
+{
+    if (!pid->automatic) {
+        // Track the measurement so the derivative is ready when switching to auto
+        pid->prev_measurement = measurement;
+        pid->p_term = pid->i_term = pid->d_term = 0;
+        return pid->output;
+    }
+
+    const int64_t out_min = (int64_t)pid->output_min << Q16_SHIFT;
+    const int64_t out_max = (int64_t)pid->output_max << Q16_SHIFT;
+    const int64_t ff = pid->feedforward;
+    int32_t error = setpoint - measurement;
+
+    int64_t p = clamp_i64((int64_t)pid->kp * error, INT32_MIN, INT32_MAX);
+
+    if (!pid->initialized) {
+        // Bumpless transfer: choose the integral so the output does not jump
+        pid->prev_measurement = measurement;
+        pid->d_filtered = 0;
+        // Far below the setpoint the output has to rise anyway: start from the feed-forward
+        // rather than an integral that cancels it
+        int64_t seed = ((int64_t)pid->output << Q16_SHIFT) - p - ff;
+        pid->integral = (q16_t)clamp_i64(seed < out_min - ff ? 0 : seed, out_min - ff, out_max - ff);
+        pid->initialized = true;
+    }
+
+    // Derivative on measurement, low-pass filtered
+    int64_t d_raw = -(int64_t)pid->kd * (measurement - pid->prev_measurement);
+    d_raw = clamp_i64(d_raw, INT32_MIN, INT32_MAX);
+    pid->d_filtered += (q16_t)(((d_raw - pid->d_filtered) * pid->d_alpha) >> Q16_SHIFT);
+    pid->prev_measurement = measurement;
+
+    // Conditional integration: skip the update if it pushes further into saturation
+    int64_t di = (int64_t)pid->ki * error;
+    int64_t u = p + pid->integral + pid->d_filtered + ff + di;
+    if (!((u > out_max && di > 0) || (u < out_min && di < 0))) {
+        pid->integral = (q16_t)clamp_i64(pid->integral + di, out_min - ff, out_max - ff);
+    }
+
+    u = clamp_i64(p + pid->integral + pid->d_filtered + ff, out_min, out_max);
+
+    pid->output = (int32_t)((u + (Q16_ONE / 2)) >> Q16_SHIFT);
+    pid->p_term = (int32_t)(p >> Q16_SHIFT);
+    pid->i_term = pid->integral >> Q16_SHIFT;
+    pid->d_term = pid->d_filtered >> Q16_SHIFT;
+    return pid->output;
+}
@@ -0,0 +1,86 @@
+/*
+ * Fixed-Point PID Controller
+ *
+ * Integer-only PID engine in Q16.16 for a fixed sample period. Input is
+ * temperature in MAX6675 units (0.25°C), output is LEDC duty counts, so
+ * the hot path needs neither floats nor percent conversions.
+ *
+ * Features:
+ * - Conditional integration anti-windup (integrator frozen while the
+ *   output is saturated in the direction of the error)
+ * - Derivative on measurement with a first-order low-pass filter
+ * - Output clamping to [output_min, output_max]
+ * - Bumpless transfer from manual to automatic mode
+ *
+ * Builds for both ESP32 and a Linux host (no ESP-IDF dependencies).
+ */
+
+#ifndef PID_FIXED_H
+#define PID_FIXED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Q16.16 Fixed-Point Format
+typedef int32_t q16_t;
+#define Q16_SHIFT              16
+#define Q16_ONE                ((q16_t)1 << Q16_SHIFT)
+#define Q16_FROM_FLOAT(x)      ((q16_t)((x) * 65536.0f + ((x) >= 0 ? 0.5f : -0.5f)))
+#define Q16_TO_FLOAT(x)        ((float)(x) / 65536.0f)
+
+#define PID_FIXED_TEMP_PER_C   4      // Measurement units per °C (MAX6675 0.25°C LSB)
+#define PID_FIXED_DEFAULT_N    10     // Derivative filter: Tf = Td / N
+
+// Configuration (floats are only used here, never in the hot path)
+typedef struct {
+    float kp;                 // Proportional gain (%/°C)
+    float ki;                 // Integral gain (%/(°C*s))
+    float kd;                 // Derivative gain (%*s/°C)
+    float derivative_filter_n; // Filter time constant is kd/kp/N; 0 disables the filter
+    uint32_t period_ms;       // Fixed sample period
+    int32_t full_scale;       // Duty counts at 100%, below 32768 (Q16.16 integral)
+    int32_t output_min;       // Output limits in duty counts
+    int32_t output_max;
+} pid_fixed_config_t;
+
+// PID State
+typedef struct {
+    // Gains scaled to duty counts per measurement unit and per sample
+    q16_t kp;
+    q16_t ki;
+    q16_t kd;
+    q16_t d_alpha;            // Derivative filter coefficient, Q16 in (0, 1]
+    int32_t output_min;
+    int32_t output_max;
+
+    q16_t integral;           // Integral term (duty counts, Q16)
+    q16_t d_filtered;         // Filtered derivative term (duty counts, Q16)
+    int32_t prev_measurement;
+    q16_t feedforward;        // Added to the PID terms (duty counts, Q16), see pid_fixed_set_feedforward()
+    int32_t output;           // Last output (duty counts)
+    int32_t p_term;           // Terms of the last step, for telemetry (duty counts)
+    int32_t i_term;
+    int32_t d_term;
+    bool automatic;           // False while in manual mode
+    bool initialized;         // False until the first step after a reset/transfer
+} pid_fixed_t;
+
+// Function prototypes
+void pid_fixed_init(pid_fixed_t *pid, const pid_fixed_config_t *config);
+void pid_fixed_set_gains(pid_fixed_t *pid, const pid_fixed_config_t *config);
+void pid_fixed_reset(pid_fixed_t *pid);
+void pid_fixed_set_manual(pid_fixed_t *pid, int32_t output);
+void pid_fixed_set_auto(pid_fixed_t *pid);
+void pid_fixed_set_feedforward(pid_fixed_t *pid, q16_t feedforward);
+void pid_fixed_transfer_to_feedforward(pid_fixed_t *pid, q16_t delta);
+int32_t pid_fixed_step(pid_fixed_t *pid, int32_t setpoint, int32_t measurement);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PID_FIXED_H
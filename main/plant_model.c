@@ -0,0 +1,121 @@
+/*
+ * Heater Plant Model Implementation
+ */
+
+#include "plant_model.h"
+
+#define MAX6675_FAULT_OPEN_BIT  0x0004
+
+static float clampf(float value, float min, float max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+// xorshift32, deterministic per seed so simulations are reproducible
+static float noise_sample(plant_model_t *plant)
+{
+    uint32_t x = plant->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    plant->rng = x;
+
+    // Triangular distribution in [-1, 1]
+    float a = (float)(x & 0xFFFF) / 65535.0f;
+    float b = (float)(x >> 16) / 65535.0f;
+    return a - b;
+}
+
+static float wire_resistance(const plant_params_t *params, float wire_c)
+{
+    return params->resistance_20c * (1.0f + params->resistance_alpha * (wire_c - 20.0f));
+}
+
+static void complete_conversion(plant_model_t *plant)
+{
+    float measured = plant->probe_c + plant->params.noise_c * noise_sample(plant);
+    measured = clampf(measured, 0.0f, PLANT_ADC_MAX_C);
+
+    // The MAX6675 truncates to its 0.25°C LSB
+    uint16_t counts = (uint16_t)(measured / PLANT_ADC_LSB_C);
+    plant->adc_register = (uint16_t)(counts << 3);
+    if (plant->open_thermocouple) {
+        plant->adc_register |= MAX6675_FAULT_OPEN_BIT;
+    }
+}
+
+void plant_model_init(plant_model_t *plant, const plant_params_t *params, uint32_t seed)
+{
+    *plant = (plant_model_t) {
+        .params = *params,
+        .wire_c = params->ambient_c,
+        .drum_c = params->ambient_c,
+        .probe_c = params->ambient_c,
+        .rng = seed ? seed : 0x12345678u,
+    };
+    complete_conversion(plant);
+}
+
+void plant_model_set_duty(plant_model_t *plant, float duty)
+{
+    plant->duty = clampf(duty, 0.0f, 1.0f);
+}
+
+float plant_model_heater_power(const plant_model_t *plant)
+{
+    const plant_params_t *p = &plant->params;
+    float resistance = wire_resistance(p, plant->wire_c);
+    return plant->duty * p->supply_voltage * p->supply_voltage / resistance;
+}
+
+void plant_model_advance(plant_model_t *plant, uint64_t dt_us)
+{
+    const plant_params_t *p = &plant->params;
+
+    while (dt_us > 0) {
+        uint64_t step_us = dt_us > PLANT_MAX_STEP_US ? PLANT_MAX_STEP_US : dt_us;
+        float dt = (float)step_us / 1e6f;
+
+        float power = plant_model_heater_power(plant);
+        float wire_to_drum = p->wire_to_drum * (plant->wire_c - plant->drum_c);
+        float drum_loss = (p->drum_to_ambient + plant->extra_loss_w_per_k) * (plant->drum_c - p->ambient_c);
+
+        plant->wire_c += dt * (power - wire_to_drum) / p->wire_capacity;
+        plant->drum_c += dt * (wire_to_drum - drum_loss) / p->drum_capacity;
+        plant->probe_c += dt * (plant->drum_c - plant->probe_c) / p->thermocouple_tau_s;
+        plant->energy_j += (double)power * dt;
+
+        plant->now_us += step_us;
+        dt_us -= step_us;
+
+        // Free-running conversions while CS is high
+        while (plant->now_us - plant->conversion_start_us >= PLANT_ADC_CONVERSION_US) {
+            plant->conversion_start_us += PLANT_ADC_CONVERSION_US;
+            complete_conversion(plant);
+        }
+    }
+}
+
+uint16_t plant_model_read_adc(plant_model_t *plant)
+{
+    uint16_t word = plant->adc_register;
+
+    // Pulling CS low aborts the conversion in progress; a new one starts on release
+    plant->conversion_start_us = plant->now_us;
+    return word;
+}
+
+float plant_model_steady_state_duty(const plant_params_t *params, float drum_c)
+{
+    float power = params->drum_to_ambient * (drum_c - params->ambient_c);
+    if (power <= 0.0f) {
+        return 0.0f;
+    }
+
+    // Wire runs hotter than the drum, which raises its resistance
+    float wire_c = drum_c + power / params->wire_to_drum;
+    float max_power = params->supply_voltage * params->supply_voltage / wire_resistance(params, wire_c);
+    return clampf(power / max_power, 0.0f, 1.0f);
+}
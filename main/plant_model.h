@@ -0,0 +1,103 @@
+/*
+ * Heater Plant Model
+ *
+ * Lumped thermal model of the 0.3 mm nichrome heater on the drum, with
+ * thermocouple lag and a MAX6675 model (0.25°C quantization, 220 ms
+ * conversion restarted by every read). Default parameters come from
+ * CALCULOS_FIO_NICROMO.md and FIO_0.3MM_ESPECIFICACOES.md.
+ *
+ * Pure C, no ESP-IDF dependencies: used by the simulated HAL backend
+ * on the host and on the device.
+ */
+
+#ifndef PLANT_MODEL_H
+#define PLANT_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Electrical (12V supply, 1.5 m of 0.3 mm nichrome)
+#define PLANT_SUPPLY_VOLTAGE      12.0f    // V
+#define PLANT_RESISTANCE_20C      1.65f    // Ω at 20°C
+#define PLANT_RESISTANCE_ALPHA    2.75e-4f // 1/K, 1.65Ω -> ~1.8Ω at 350°C
+
+// Thermal
+#define PLANT_WIRE_CAPACITY       0.4f     // J/K, ~0.9 g of nichrome
+#define PLANT_WIRE_TO_DRUM        2.0f     // W/K, wire cemented to the drum
+#define PLANT_DRUM_CAPACITY       50.0f    // J/K, drum + refractory lining
+#define PLANT_DRUM_TO_AMBIENT     0.277f   // W/K, 90 W holds the drum at 350°C
+#define PLANT_AMBIENT_C           25.0f
+#define PLANT_THERMOCOUPLE_TAU_S  2.0f     // Probe response time
+
+// MAX6675
+#define PLANT_ADC_CONVERSION_US   220000
+#define PLANT_ADC_LSB_C           0.25f
+#define PLANT_ADC_MAX_C           1023.75f
+
+#define PLANT_MAX_STEP_US         10000    // Integration step limit (wire τ is ~0.2 s)
+
+typedef struct {
+    float supply_voltage;
+    float resistance_20c;
+    float resistance_alpha;
+    float wire_capacity;
+    float wire_to_drum;
+    float drum_capacity;
+    float drum_to_ambient;
+    float ambient_c;
+    float thermocouple_tau_s;
+    float noise_c;             // Thermocouple noise amplitude before quantization
+} plant_params_t;
+
+typedef struct {
+    plant_params_t params;
+
+    // Thermal state
+    float wire_c;
+    float drum_c;
+    float probe_c;             // Thermocouple junction temperature
+
+    // Inputs
+    float duty;                // Heater duty, 0..1 (PWM is much faster than the plant)
+    float extra_loss_w_per_k;  // Load disturbance: additional drum losses
+
+    // MAX6675 state
+    uint64_t now_us;
+    uint64_t conversion_start_us;
+    uint16_t adc_register;     // Last completed conversion, MAX6675 word
+    bool open_thermocouple;    // Fault injection
+
+    uint32_t rng;
+    double energy_j;           // Electrical energy delivered
+} plant_model_t;
+
+#define PLANT_PARAMS_DEFAULT() {                       \
+    .supply_voltage = PLANT_SUPPLY_VOLTAGE,            \
+    .resistance_20c = PLANT_RESISTANCE_20C,            \
+    .resistance_alpha = PLANT_RESISTANCE_ALPHA,        \
+    .wire_capacity = PLANT_WIRE_CAPACITY,              \
+    .wire_to_drum = PLANT_WIRE_TO_DRUM,                \
+    .drum_capacity = PLANT_DRUM_CAPACITY,              \
+    .drum_to_ambient = PLANT_DRUM_TO_AMBIENT,          \
+    .ambient_c = PLANT_AMBIENT_C,                      \
+    .thermocouple_tau_s = PLANT_THERMOCOUPLE_TAU_S,    \
+    .noise_c = 0.1f,                                   \
+}
+
+// Function prototypes
+void plant_model_init(plant_model_t *plant, const plant_params_t *params, uint32_t seed);
+void plant_model_set_duty(plant_model_t *plant, float duty);
+void plant_model_advance(plant_model_t *plant, uint64_t dt_us);
+uint16_t plant_model_read_adc(plant_model_t *plant);
+float plant_model_heater_power(const plant_model_t *plant);
+float plant_model_steady_state_duty(const plant_params_t *params, float drum_c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PLANT_MODEL_H
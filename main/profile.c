@@ -0,0 +1,183 @@
+/*
+ * Setpoint Profile Engine Implementation
+ */
+
+#include <stdlib.h>
+#include "profile.h"
+#include "pid_fixed.h"
+
+static int32_t to_units(float celsius)
+{
+    return (int32_t)(celsius * PID_FIXED_TEMP_PER_C + 0.5f);
+}
+
+esp_err_t profile_validate(const profile_segment_t *segments, size_t count, float max_setpoint)
+{
+    if (segments == NULL || count == 0 || count > PROFILE_MAX_SEGMENTS) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Written as !(in range) so NaN is rejected too
+    for (size_t i = 0; i < count; i++) {
+        const profile_segment_t *seg = &segments[i];
+        if (!(seg->target >= 0.0f && seg->target <= max_setpoint) ||
+            !(seg->ramp_rate >= 0.0f && seg->ramp_rate <= PROFILE_MAX_RAMP_RATE) ||
+            !(seg->soak_band >= 0.0f && seg->soak_band <= PROFILE_MAX_SOAK_BAND) ||
+            seg->hold_s > PROFILE_MAX_HOLD_S) {
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t profile_load(profile_t *profile, const profile_segment_t *segments, size_t count,
+                       float max_setpoint)
+{
+    if (profile == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = profile_validate(segments, count, max_setpoint);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        profile->steps[i] = (profile_step_t) {
+            .target = to_units(segments[i].target),
+            .rate_q16 = (int32_t)(segments[i].ramp_rate * PID_FIXED_TEMP_PER_C * Q16_ONE + 0.5f),
+            .hold_ms = segments[i].hold_s * 1000,
+            .band = to_units(segments[i].soak_band),
+        };
+    }
+    profile->count = count;
+    profile->state = PROFILE_STATE_IDLE;
+    profile->segment = 0;
+    return ESP_OK;
+}
+
+static void begin_segment(profile_t *profile, size_t segment)
+{
+    profile->segment = segment;
+    profile->start = profile->setpoint;
+    profile->ramp_ms = 0;
+    profile->hold_ms = 0;
+    profile->state = PROFILE_STATE_RAMP;
+}
+
+void profile_start(profile_t *profile, int32_t setpoint)
+{
+    if (profile == NULL || profile->count == 0) {
+        return;
+    }
+
+    profile->setpoint = setpoint;
+    profile->holdback_ms = 0;
+    profile->elapsed_ms = 0;
+    begin_segment(profile, 0);
+}
+
+void profile_abort(profile_t *profile)
+{
+    if (profile_is_active(profile)) {
+        profile->state = PROFILE_STATE_ABORTED;
+    }
+}
+
+bool profile_is_active(const profile_t *profile)
+{
+    return profile != NULL &&
+           (profile->state == PROFILE_STATE_RAMP || profile->state == PROFILE_STATE_HOLD);
+}
+
+// Setpoint from the ramp start and time ramped, so rounding never accumulates
+static int32_t ramp_setpoint(const profile_t *profile, const profile_step_t *step)
+{
+    if (step->rate_q16 == 0) {
+        return step->target;
+    }
+
+    int64_t span = (int64_t)step->target - profile->start;
+    int64_t delta = ((int64_t)step->rate_q16 * (int64_t)profile->ramp_ms / 60000) >> Q16_SHIFT;
+    if (delta >= llabs(span)) {
+        return step->target;
+    }
+    return profile->start + (int32_t)(span > 0 ? delta : -delta);
+}
+
+bool profile_step(profile_t *profile, uint32_t dt_ms, esp_err_t sensor_status, int32_t measurement,
+                  int32_t *setpoint)
+{
+    if (!profile_is_active(profile)) {
+        return false;
+    }
+
+    const profile_step_t *step = &profile->steps[profile->segment];
+    const bool in_band = (step->band == 0) ||
+                         (sensor_status == ESP_OK && abs(measurement - profile->setpoint) <= step->band);
+
+    profile->elapsed_ms += dt_ms;
+    if (!in_band) {
+        profile->holdback_ms += dt_ms;
+    }
+
+    if (profile->state == PROFILE_STATE_RAMP) {
+        if (in_band) {
+            profile->ramp_ms += dt_ms;
+        }
+        profile->setpoint = ramp_setpoint(profile, step);
+        if (profile->setpoint == step->target) {
+            profile->state = PROFILE_STATE_HOLD;
+        }
+    } else if (in_band) {
+        profile->hold_ms += dt_ms;
+    }
+
+    if (profile->state == PROFILE_STATE_HOLD && profile->hold_ms >= step->hold_ms) {
+        if (profile->segment + 1 < profile->count) {
+            begin_segment(profile, profile->segment + 1);
+        } else {
+            profile->state = PROFILE_STATE_DONE;
+        }
+    }
+
+    if (setpoint != NULL) {
+        *setpoint = profile->setpoint;
+    }
+    return true;
+}
+
+void profile_get_progress(const profile_t *profile, profile_progress_t *progress)
+{
+    if (profile == NULL || progress == NULL) {
+        return;
+    }
+
+    uint32_t hold_remaining_ms = 0;
+    if (profile_is_active(profile)) {
+        const profile_step_t *step = &profile->steps[profile->segment];
+        hold_remaining_ms = step->hold_ms - (profile->hold_ms < step->hold_ms ? profile->hold_ms : step->hold_ms);
+    }
+
+    *progress = (profile_progress_t) {
+        .state = profile->state,
+        .segment = profile->segment,
+        .segment_count = profile->count,
+        .setpoint = (float)profile->setpoint / PID_FIXED_TEMP_PER_C,
+        .hold_remaining_s = hold_remaining_ms / 1000.0f,
+        .holdback_s = profile->holdback_ms / 1000.0f,
+        .elapsed_s = profile->elapsed_ms / 1000.0f,
+    };
+}
+
+const char *profile_state_name(profile_state_t state)
+{
+    switch (state) {
+    case PROFILE_STATE_RAMP:    return "ramp";
+    case PROFILE_STATE_HOLD:    return "hold";
+    case PROFILE_STATE_DONE:    return "done";
+    case PROFILE_STATE_ABORTED: return "aborted";
+    default:                    return "idle";
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Setpoint Profile Engine (ramp/soak)
+ *
+ * Executes a multi-segment temperature profile inside the control loop:
+ * each segment ramps the setpoint to a target at a fixed rate, then holds
+ * it for a given time. With a soak band, the ramp pauses while the
+ * measurement lags the setpoint by more than the band ("holdback"), and
+ * the hold timer only runs while the measurement is within the band, so
+ * the soak time is guaranteed at temperature.
+ *
+ * The whole profile is validated once when loaded and interpolated on
+ * every control tick from the elapsed time, so it does not depend on the
+ * network or accumulate rounding error. No RTOS dependencies: also built
+ * on the host.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PROFILE_MAX_SEGMENTS      16
+#define PROFILE_MAX_RAMP_RATE     600.0f      // °C/min
+#define PROFILE_MAX_HOLD_S        (7 * 24 * 3600)
+#define PROFILE_MAX_SOAK_BAND     50.0f       // °C
+
+// One segment as uploaded (°C, °C/min, s)
+typedef struct {
+    float target;             // Setpoint at the end of the ramp
+    float ramp_rate;          // 0: step straight to the target
+    uint32_t hold_s;          // Time at target before the next segment
+    float soak_band;          // 0: no holdback, hold timer always runs
+} profile_segment_t;
+
+typedef enum {
+    PROFILE_STATE_IDLE = 0,   // Nothing loaded or started
+    PROFILE_STATE_RAMP,
+    PROFILE_STATE_HOLD,
+    PROFILE_STATE_DONE,       // Last hold finished, setpoint stays at the last target
+    PROFILE_STATE_ABORTED,
+} profile_state_t;
+
+// Segment in controller units (MAX6675 units, 0.25°C)
+typedef struct {
+    int32_t target;
+    int32_t rate_q16;         // Units per minute, Q16.16; 0 = step
+    uint32_t hold_ms;
+    int32_t band;             // 0 = unguarded
+} profile_step_t;
+
+// Profile State
+typedef struct {
+    profile_step_t steps[PROFILE_MAX_SEGMENTS];
+    size_t count;
+    profile_state_t state;
+    size_t segment;           // Current segment index
+    int32_t start;            // Setpoint when the current ramp began
+    int32_t setpoint;         // Current interpolated setpoint
+    uint64_t ramp_ms;         // Time spent ramping in this segment (excludes holdback)
+    uint32_t hold_ms;         // Time counted towards the hold (inside the band)
+    uint64_t holdback_ms;     // Total time the profile waited on the band
+    uint64_t elapsed_ms;      // Wall time since profile_start()
+} profile_t;
+
+typedef struct {
+    profile_state_t state;
+    size_t segment;
+    size_t segment_count;
+    float setpoint;           // °C
+    float hold_remaining_s;
+    float holdback_s;
+    float elapsed_s;
+} profile_progress_t;
+
+// Function prototypes
+esp_err_t profile_validate(const profile_segment_t *segments, size_t count, float max_setpoint);
+esp_err_t profile_load(profile_t *profile, const profile_segment_t *segments, size_t count,
+                       float max_setpoint);
+void profile_start(profile_t *profile, int32_t setpoint);
+void profile_abort(profile_t *profile);
+bool profile_is_active(const profile_t *profile);
+bool profile_step(profile_t *profile, uint32_t dt_ms, esp_err_t sensor_status, int32_t measurement,
+                  int32_t *setpoint);
+void profile_get_progress(const profile_t *profile, profile_progress_t *progress);
+const char *profile_state_name(profile_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,346 @@
+/*
+ * Flight Recorder Implementation
+ */
+
+#include <inttypes.h>
+#include <string.h>
+#include "recorder.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "RECORDER";
+
+#define RECORD_WORDS_SHIFT  4
+#define RECORD_OFFSET_SHIFT 8
+
+typedef struct {
+    uint8_t data[RECORDER_SECTOR_SIZE];     // Erased (0xFF) beyond fill
+    uint32_t sequence;
+    uint32_t base_ms;
+    size_t fill;                // Appenders, under s_lock
+    size_t flushed;             // Writer task only: bytes already programmed
+    bool erased;                // Writer task only: flash sector erased
+} recorder_buffer_t;
+
+_Static_assert(sizeof(recorder_sector_t) == 16, "recorder_sector_t is part of the flash format");
+_Static_assert(sizeof(recorder_sample_t) % 4 == 0, "payloads are whole words");
+_Static_assert(sizeof(recorder_event_record_t) % 4 == 0, "payloads are whole words");
+_Static_assert(RECORDER_MMAP_SIZE % RECORDER_SECTOR_SIZE == 0, "windows hold whole sectors");
+
+static const esp_partition_t *s_partition = NULL;
+static uint32_t s_sector_count;
+static TaskHandle_t s_task_handle = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static recorder_buffer_t s_buffers[2];
+
+// Protected by s_lock
+static int s_active = -1;               // Buffer being appended to, -1 until init
+static int s_pending = -1;              // Full buffer waiting for the writer
+static uint32_t s_next_sequence;
+static uint16_t s_boot;
+static uint32_t s_records;
+static uint32_t s_dropped;
+static uint32_t s_flash_errors;
+
+// Function prototypes
+static void recorder_task(void *arg);
+
+// Caller holds s_lock; the buffer's data is already erased
+static void begin_buffer_locked(recorder_buffer_t *buf, uint32_t now_ms)
+{
+    recorder_sector_t header = {
+        .magic = RECORDER_MAGIC,
+        .sequence = s_next_sequence++,
+        .boot = s_boot,
+        .version = RECORDER_FORMAT_VERSION,
+        .reserved = 0xFF,
+        .base_ms = now_ms,
+    };
+    memcpy(buf->data, &header, sizeof(header));
+    buf->sequence = header.sequence;
+    buf->base_ms = now_ms;
+    buf->fill = sizeof(header);
+    buf->flushed = 0;
+    buf->erased = false;
+}
+
+static void append(recorder_record_type_t type, const void *payload, size_t size)
+{
+    const size_t length = sizeof(uint32_t) + size;
+    bool handoff = false;
+
+    portENTER_CRITICAL(&s_lock);
+    if (s_active < 0) {
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    recorder_buffer_t *buf = &s_buffers[s_active];
+    if (buf->fill + length > RECORDER_SECTOR_SIZE || now_ms - buf->base_ms > RECORDER_OFFSET_MAX_MS) {
+        if (s_pending >= 0) {
+            // The writer still holds the other buffer
+            s_dropped++;
+            portEXIT_CRITICAL(&s_lock);
+            return;
+        }
+        s_pending = s_active;
+        s_active ^= 1;
+        buf = &s_buffers[s_active];
+        begin_buffer_locked(buf, now_ms);
+        handoff = true;
+    }
+
+    uint32_t header = (uint32_t)type | ((uint32_t)(size / sizeof(uint32_t)) << RECORD_WORDS_SHIFT) |
+                      ((now_ms - buf->base_ms) << RECORD_OFFSET_SHIFT);
+    memcpy(buf->data + buf->fill, &header, sizeof(header));
+    memcpy(buf->data + buf->fill + sizeof(header), payload, size);
+    buf->fill += length;
+    s_records++;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (handoff && s_task_handle != NULL) {
+        xTaskNotifyGive(s_task_handle);
+    }
+}
+
+void recorder_sample(const recorder_sample_t *sample)
+{
+    append(RECORDER_RECORD_SAMPLE, sample, sizeof(*sample));
+}
+
+void recorder_event(recorder_event_t event, float value)
+{
+    recorder_event_record_t record = {
+        .event = (uint16_t)event,
+        .reserved = 0xFFFF,
+        .value = value,
+    };
+    append(RECORDER_RECORD_EVENT, &record, sizeof(record));
+}
+
+// Continues after the newest sector in the partition, as a new boot
+esp_err_t recorder_init(void)
+{
+    if (s_partition != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                                RECORDER_PARTITION_SUBTYPE,
+                                                                RECORDER_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGW(TAG, "No \"%s\" partition, recording disabled", RECORDER_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+    uint32_t sector_count = partition->size / RECORDER_SECTOR_SIZE;
+    if (sector_count < 3) {
+        ESP_LOGE(TAG, "Partition too small (%" PRIu32 " bytes)", partition->size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Sector headers only: one small read per sector
+    bool found = false;
+    recorder_sector_t newest = { 0 };
+    for (uint32_t i = 0; i < sector_count; i++) {
+        recorder_sector_t header;
+        esp_err_t ret = esp_partition_read(partition, (size_t)i * RECORDER_SECTOR_SIZE, &header, sizeof(header));
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to read sector %" PRIu32 ": %s", i, esp_err_to_name(ret));
+            return ret;
+        }
+        if (header.magic == RECORDER_MAGIC && header.version == RECORDER_FORMAT_VERSION &&
+            (!found || header.sequence > newest.sequence)) {
+            newest = header;
+            found = true;
+        }
+    }
+
+    memset(s_buffers, 0xFF, sizeof(s_buffers));
+
+    portENTER_CRITICAL(&s_lock);
+    s_partition = partition;
+    s_sector_count = sector_count;
+    s_next_sequence = found ? newest.sequence + 1 : 0;
+    s_boot = found ? newest.boot + 1 : 0;
+    s_active = 0;
+    begin_buffer_locked(&s_buffers[0], (uint32_t)(esp_timer_get_time() / 1000));
+    portEXIT_CRITICAL(&s_lock);
+
+    recorder_event(RECORDER_EVENT_BOOT, (float)esp_reset_reason());
+
+    ESP_LOGI(TAG, "Recording to \"%s\": %" PRIu32 " KB, boot %u, sector %" PRIu32,
+             partition->label, partition->size / 1024, (unsigned)s_boot, s_buffers[0].sequence);
+    return ESP_OK;
+}
+
+esp_err_t recorder_start(void)
+{
+    if (s_partition == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? RECORDER_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(recorder_task, "recorder", RECORDER_STACK_SIZE, NULL,
+                                                 RECORDER_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// Writer task only: erases the buffer's sector the first time, then programs what is new
+static void program(recorder_buffer_t *buf, size_t fill)
+{
+    size_t offset = (size_t)(buf->sequence % s_sector_count) * RECORDER_SECTOR_SIZE;
+    esp_err_t ret = ESP_OK;
+
+    if (!buf->erased) {
+        ret = esp_partition_erase_range(s_partition, offset, RECORDER_SECTOR_SIZE);
+        buf->erased = (ret == ESP_OK);
+    }
+    if (ret == ESP_OK && fill > buf->flushed) {
+        ret = esp_partition_write(s_partition, offset + buf->flushed, buf->data + buf->flushed,
+                                  fill - buf->flushed);
+        if (ret == ESP_OK) {
+            buf->flushed = fill;
+        }
+    }
+
+    if (ret != ESP_OK) {
+        portENTER_CRITICAL(&s_lock);
+        s_flash_errors++;
+        portEXIT_CRITICAL(&s_lock);
+        DLOGE(TAG, "Flash write failed: %s", esp_err_to_name(ret));
+    }
+}
+
+// Writes out the full buffer, if any, then what is new in the current one
+static void write_out(void)
+{
+    // Appenders only write beyond fill, so both buffers can be read without the lock
+    portENTER_CRITICAL(&s_lock);
+    int pending = s_pending;
+    recorder_buffer_t *active = &s_buffers[s_active];
+    size_t active_fill = active->fill;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (pending >= 0) {
+        recorder_buffer_t *full = &s_buffers[pending];
+        program(full, full->fill);
+
+        // A sector that failed is given up, the log moves on
+        memset(full->data, 0xFF, sizeof(full->data));
+        portENTER_CRITICAL(&s_lock);
+        s_pending = -1;
+        portEXIT_CRITICAL(&s_lock);
+    }
+
+    program(active, active_fill);
+}
+
+static void recorder_task(void *arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(RECORDER_FLUSH_MS));
+        write_out();
+    }
+}
+
+// Sector `sequence` is still on flash and stays there for at least one more
+// full sector of appends: the writer only erases it once the buffer
+// `sequence + s_sector_count` is current
+static bool sector_stable(uint32_t sequence)
+{
+    portENTER_CRITICAL(&s_lock);
+    uint32_t current = s_buffers[s_active].sequence;
+    portEXIT_CRITICAL(&s_lock);
+    return (uint32_t)(current - sequence) < s_sector_count - 1;
+}
+
+// Closed sectors only, oldest first, as they were when the download began.
+// The sector being filled and a full one still waiting for the writer are
+// left out: they are programmed while the log streams. Each sector is
+// checked again right before it goes out and skipped once the writer is
+// about to reuse it.
+esp_err_t recorder_read(recorder_sink_fn_t sink, void *ctx)
+{
+    if (s_partition == NULL || sink == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    uint32_t current = s_buffers[s_active].sequence;
+    uint32_t last = (s_pending >= 0) ? current - 2 : current - 1;
+    portEXIT_CRITICAL(&s_lock);
+
+    const size_t log_size = (size_t)s_sector_count * RECORDER_SECTOR_SIZE;
+    esp_partition_mmap_handle_t handle = 0;
+    const uint8_t *window = NULL;
+    size_t window_offset = 0;
+    esp_err_t ret = ESP_OK;
+
+    // Starts above the oldest sector of the ring, the next to be erased
+    for (uint32_t i = s_sector_count - 2; i-- > 0 && ret == ESP_OK;) {
+        uint32_t sequence = last - i;
+        size_t offset = (size_t)(sequence % s_sector_count) * RECORDER_SECTOR_SIZE;
+        size_t wanted = offset - offset % RECORDER_MMAP_SIZE;
+        if (window == NULL || wanted != window_offset) {
+            if (window != NULL) {
+                esp_partition_munmap(handle);
+                window = NULL;
+            }
+            size_t size = (log_size - wanted < RECORDER_MMAP_SIZE) ? log_size - wanted : RECORDER_MMAP_SIZE;
+            const void *ptr;
+            ret = esp_partition_mmap(s_partition, wanted, size, ESP_PARTITION_MMAP_DATA, &ptr, &handle);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to map the log: %s", esp_err_to_name(ret));
+                break;
+            }
+            window = ptr;
+            window_offset = wanted;
+        }
+
+        const uint8_t *sector = window + (offset - window_offset);
+        const recorder_sector_t *header = (const recorder_sector_t *)sector;
+        if (header->magic != RECORDER_MAGIC || header->version != RECORDER_FORMAT_VERSION ||
+            header->sequence != sequence || !sector_stable(sequence)) {
+            continue;
+        }
+        ret = sink(ctx, sector, RECORDER_SECTOR_SIZE);
+    }
+
+    if (window != NULL) {
+        esp_partition_munmap(handle);
+    }
+    return ret;
+}
+
+void recorder_get_status(recorder_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = (recorder_status_t) {
+        .active = (s_partition != NULL && s_task_handle != NULL),
+        .sectors = s_sector_count,
+        .sequence = (s_active >= 0) ? s_buffers[s_active].sequence : 0,
+        .boot = s_boot,
+        .records = s_records,
+        .dropped = s_dropped,
+        .flash_errors = s_flash_errors,
+    };
+    portEXIT_CRITICAL(&s_lock);
+}
@@ -0,0 +1,127 @@
+/*
+ * Flight Recorder
+ *
+ * Append-only circular log of control samples and events in the
+ * "recorder" data partition (partitions.csv), kept across resets so a run
+ * that failed unattended can be read back afterwards.
+ *
+ * Appending only copies a few bytes into a sector-sized RAM buffer under a
+ * spinlock; the control loop never touches flash. When a buffer is full
+ * the next one takes over and a low-priority writer task erases the
+ * sector it goes to and programs it. The writer also programs the filled
+ * part of the current buffer every RECORDER_FLUSH_MS, so a reset loses at
+ * most that much. The oldest sector is overwritten when the log wraps.
+ *
+ * Readout maps the partition with esp_partition_mmap() a window at a time
+ * and hands out pointers into the mapped flash, oldest sector first. Only
+ * closed sectors are read; the one being filled is not.
+ *
+ * On flash every sector starts with a recorder_sector_t header, followed
+ * by records: a 32-bit header word, then the payload words it announces.
+ * Erased flash (0xFFFFFFFF) ends the records of a sector.
+ *   header [3:0]   record type (recorder_record_type_t)
+ *   header [7:4]   payload length in 32-bit words
+ *   header [31:8]  milliseconds since the sector's base_ms
+ * host/recorder_decode.c turns a dump into CSV.
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Partition (see partitions.csv)
+#define RECORDER_PARTITION_LABEL    "recorder"
+#define RECORDER_PARTITION_SUBTYPE  0x40        // First custom data subtype
+
+// Configuration
+#define RECORDER_SECTOR_SIZE        4096        // Flash erase unit, one RAM buffer
+#define RECORDER_MMAP_SIZE          0x10000     // Readout window, one MMU page
+#define RECORDER_FLUSH_MS           10000       // Program the partial sector this often
+#define RECORDER_STACK_SIZE         3072
+#define RECORDER_PRIORITY           (tskIDLE_PRIORITY + 1)
+#define RECORDER_CORE               0           // Away from the control task
+
+// On-flash format
+#define RECORDER_MAGIC              0x52465054  // "TPFR"
+#define RECORDER_FORMAT_VERSION     1
+#define RECORDER_OFFSET_MAX_MS      0x00FFFFFF  // Past this a new sector is started
+
+typedef struct {
+    uint32_t magic;
+    uint32_t sequence;          // Sectors written since the partition was blank
+    uint16_t boot;              // Boots since the partition was blank
+    uint8_t version;
+    uint8_t reserved;
+    uint32_t base_ms;           // Uptime the record offsets count from
+} recorder_sector_t;
+
+typedef enum {
+    RECORDER_RECORD_SAMPLE = 1, // recorder_sample_t, one per control tick
+    RECORDER_RECORD_EVENT = 2,  // recorder_event_record_t
+    RECORDER_RECORD_ERASED = 0xF,
+} recorder_record_type_t;
+
+typedef struct {
+    telemetry_record_t telemetry;   // Temperature, duty, PID terms, fault flag
+    uint16_t setpoint_q2;           // Setpoint in 0.25°C units
+    uint8_t mode;                   // control_mode_t
+    uint8_t flags;                  // RECORDER_FLAG_*
+} recorder_sample_t;
+
+#define RECORDER_FLAG_PROFILE       0x01        // A profile was driving the setpoint
+#define RECORDER_FLAG_AUTOTUNE      0x02        // Autotune was driving the output
+
+typedef enum {
+    RECORDER_EVENT_BOOT = 1,        // value: esp_reset_reason_t of this boot
+    RECORDER_EVENT_MODE,            // value: control_mode_t
+    RECORDER_EVENT_SETPOINT,        // value: °C
+    RECORDER_EVENT_POWER,           // value: manual power, %
+    RECORDER_EVENT_SENSOR,          // value: sensor status (esp_err_t), 0 when it recovered
+    RECORDER_EVENT_SPIKE,           // value: reading dropped by the estimator, °C
+    RECORDER_EVENT_PROFILE,         // value: profile_state_t
+    RECORDER_EVENT_AUTOTUNE,        // value: autotune_state_t
+    RECORDER_EVENT_INTERLOCK,       // value: latched INTERLOCK_FAULT_* bits, 0 when acknowledged
+    RECORDER_EVENT_COUNT,
+} recorder_event_t;
+
+typedef struct {
+    uint16_t event;                 // recorder_event_t
+    uint16_t reserved;
+    float value;
+} recorder_event_record_t;
+
+typedef struct {
+    bool active;                    // Partition found and writer running
+    uint32_t sectors;               // Sectors in the partition
+    uint32_t sequence;              // Sector being filled
+    uint16_t boot;
+    uint32_t records;               // Appended since boot
+    uint32_t dropped;               // Lost because the writer fell behind
+    uint32_t flash_errors;
+} recorder_status_t;
+
+// Receives one sector of the log, pointing into mapped flash
+typedef esp_err_t (*recorder_sink_fn_t)(void *ctx, const uint8_t *data, size_t len);
+
+// Function prototypes
+esp_err_t recorder_init(void);
+esp_err_t recorder_start(void);
+void recorder_sample(const recorder_sample_t *sample);
+void recorder_event(recorder_event_t event, float value);
+esp_err_t recorder_read(recorder_sink_fn_t sink, void *ctx);
+void recorder_get_status(recorder_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RECORDER_H
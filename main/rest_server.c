@@ -2,249 +2,1079 @@
  * REST Server Implementation
  */
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
 #include "rest_server.h"
+#include "control_task.h"
+#include "temp_sampler.h"
+#include "telemetry.h"
+#include "live_stream.h"
+#include "esp_timer.h"
 #include "esp_log.h"
-#include "cJSON.h"
+#include "dlog.h"
+#include "json_writer.h"
+#include "metrics.h"
+#include "recorder.h"
+#include "udp_telemetry.h"
+#include "modbus_tcp.h"
+#include "settings.h"
+#include "wifi_manager.h"
+#include "boot_timeline.h"
+#include "safety.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
 static const char *TAG = "REST_SERVER";
 
 static httpd_handle_t server = NULL;
-static max6675_handle_t *temp_sensor = NULL;
-static mosfet_pwm_handle_t *pwm_controller = NULL;
-
-// HTML page for the interface
-static const char* html_page = 
-"<!DOCTYPE html>"
-"<html>"
-"<head>"
-"    <title>Temperature PID Controller</title>"
-"    <meta charset='UTF-8'>"
-"    <meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-"    <style>"
-"        body { font-family: Arial, sans-serif; margin: 20px; background-color: #f0f0f0; }"
-"        .container { max-width: 600px; margin: 0 auto; background: white; padding: 20px; border-radius: 10px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }"
-"        h1 { color: #333; text-align: center; }"
-"        .status { background: #e8f5e8; padding: 15px; border-radius: 5px; margin: 10px 0; }"
-"        .control { background: #f8f8f8; padding: 15px; border-radius: 5px; margin: 10px 0; }"
-"        .slider { width: 100%; margin: 10px 0; }"
-"        .value { font-size: 18px; font-weight: bold; color: #007bff; }"
-"        button { background: #007bff; color: white; border: none; padding: 10px 20px; border-radius: 5px; cursor: pointer; margin: 5px; }"
-"        button:hover { background: #0056b3; }"
-"        .error { color: red; }"
-"        .success { color: green; }"
-"    </style>"
-"</head>"
-"<body>"
-"    <div class='container'>"
-"        <h1>🔥 Temperature PID Controller</h1>"
-"        <div class='status'>"
-"            <h3>📊 Status</h3>"
-"            <p>Temperature: <span id='temperature' class='value'>--°C</span></p>"
-"            <p>Power: <span id='power' class='value'>--%</span></p>"
-"            <p>Status: <span id='status' class='value'>--</span></p>"
-"        </div>"
-"        <div class='control'>"
-"            <h3>🎛️ Power Control</h3>"
-"            <input type='range' id='powerSlider' class='slider' min='0' max='100' value='0'>"
-"            <p>Power: <span id='powerValue'>0%</span></p>"
-"            <button onclick='setPower()'>Set Power</button>"
-"            <button onclick='stopPower()'>Stop</button>"
-"        </div>"
-"        <div class='control'>"
-"            <h3>🔄 Manual Control</h3>"
-"            <button onclick='getTemperature()'>Read Temperature</button>"
-"            <button onclick='startAutoUpdate()'>Start Auto Update</button>"
-"            <button onclick='stopAutoUpdate()'>Stop Auto Update</button>"
-"        </div>"
-"    </div>"
-"    <script>"
-"        let autoUpdateInterval;"
-"        const powerSlider = document.getElementById('powerSlider');"
-"        const powerValue = document.getElementById('powerValue');"
-"        const temperature = document.getElementById('temperature');"
-"        const power = document.getElementById('power');"
-"        const status = document.getElementById('status');"
-"        "
-"        powerSlider.oninput = function() {"
-"            powerValue.textContent = this.value + '%';"
-"        };"
-"        "
-"        function setPower() {"
-"            const powerLevel = powerSlider.value;"
-"            fetch('/api/power', {"
-"                method: 'POST',"
-"                headers: { 'Content-Type': 'application/json' },"
-"                body: JSON.stringify({power: parseInt(powerLevel)})"
-"            })"
-"            .then(response => response.json())"
-"            .then(data => {"
-"                if (data.success) {"
-"                    power.textContent = powerLevel + '%';"
-"                    status.textContent = 'Power set successfully';"
-"                    status.className = 'value success';"
-"                } else {"
-"                    status.textContent = 'Error: ' + data.error;"
-"                    status.className = 'value error';"
-"                }"
-"            })"
-"            .catch(error => {"
-"                status.textContent = 'Error: ' + error;"
-"                status.className = 'value error';"
-"            });"
-"        }"
-"        "
-"        function stopPower() {"
-"            powerSlider.value = 0;"
-"            powerValue.textContent = '0%';"
-"            setPower();"
-"        }"
-"        "
-"        function getTemperature() {"
-"            fetch('/api/temperature')"
-"            .then(response => response.json())"
-"            .then(data => {"
-"                if (data.success) {"
-"                    temperature.textContent = data.temperature.toFixed(2) + '°C';"
-"                    status.textContent = 'Temperature updated';"
-"                    status.className = 'value success';"
-"                } else {"
-"                    status.textContent = 'Error: ' + data.error;"
-"                    status.className = 'value error';"
-"                }"
-"            })"
-"            .catch(error => {"
-"                status.textContent = 'Error: ' + error;"
-"                status.className = 'value error';"
-"            });"
-"        }"
-"        "
-"        function startAutoUpdate() {"
-"            if (autoUpdateInterval) clearInterval(autoUpdateInterval);"
-"            autoUpdateInterval = setInterval(getTemperature, 2000);"
-"            status.textContent = 'Auto update started';"
-"            status.className = 'value success';"
-"        }"
-"        "
-"        function stopAutoUpdate() {"
-"            if (autoUpdateInterval) clearInterval(autoUpdateInterval);"
-"            status.textContent = 'Auto update stopped';"
-"            status.className = 'value success';"
-"        }"
-"        "
-"        // Start auto update on page load"
-"        window.onload = function() {"
-"            getTemperature();"
-"            startAutoUpdate();"
-"        };"
-"    </script>"
-"</body>"
-"</html>";
-
-// Handler for root page
-static esp_err_t root_handler(httpd_req_t *req)
-{
-    httpd_resp_set_type(req, "text/html");
-    return httpd_resp_send(req, html_page, HTTPD_RESP_USE_STRLEN);
-}
-
-// Handler for temperature API
+static const hal_actuator_t *heater = NULL;
+
+// Output changes are refused while the heater is held off by the interlock
+static const char *const s_tripped_error = "Safety interlock tripped, acknowledge it first";
+
+// Web UI assets, gzipped and embedded at build time (see CMakeLists.txt)
+extern const uint8_t index_html_gz_start[] asm("_binary_index_html_gz_start");
+extern const uint8_t index_html_gz_end[]   asm("_binary_index_html_gz_end");
+extern const uint8_t app_css_gz_start[]    asm("_binary_app_css_gz_start");
+extern const uint8_t app_css_gz_end[]      asm("_binary_app_css_gz_end");
+extern const uint8_t app_js_gz_start[]     asm("_binary_app_js_gz_start");
+extern const uint8_t app_js_gz_end[]       asm("_binary_app_js_gz_end");
+
+typedef struct {
+    const char *type;
+    const uint8_t *start;
+    const uint8_t *end;
+    const char *etag;               // Quoted strong ETag
+    const char *cache_control;
+} static_asset_t;
+
+// index.html always revalidates; app.css/app.js are requested as ?v=<etag>, so any
+// cached copy is still correct
+static const static_asset_t asset_index_html = {
+    "text/html", index_html_gz_start, index_html_gz_end, "\"" WWW_INDEX_HTML_ETAG "\"", "no-cache"
+};
+static const static_asset_t asset_app_css = {
+    "text/css", app_css_gz_start, app_css_gz_end, "\"" WWW_APP_CSS_ETAG "\"", "public, max-age=31536000, immutable"
+};
+static const static_asset_t asset_app_js = {
+    "application/javascript", app_js_gz_start, app_js_gz_end, "\"" WWW_APP_JS_ETAG "\"",
+    "public, max-age=31536000, immutable"
+};
+
+// Handler for the web UI: 304 when the browser already has this version
+static esp_err_t static_asset_handler(httpd_req_t *req)
+{
+    const static_asset_t *asset = (const static_asset_t *)req->user_ctx;
+    char if_none_match[64];
+
+    httpd_resp_set_hdr(req, "ETag", asset->etag);
+    httpd_resp_set_hdr(req, "Cache-Control", asset->cache_control);
+
+    if (httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK &&
+        (strstr(if_none_match, asset->etag) != NULL || strcmp(if_none_match, "*") == 0)) {
+        httpd_resp_set_status(req, "304 Not Modified");
+        return httpd_resp_send(req, NULL, 0);
+    }
+
+    // Every client the UI targets accepts gzip, so there is no identity fallback
+    httpd_resp_set_type(req, asset->type);
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+    return httpd_resp_send(req, (const char *)asset->start, asset->end - asset->start);
+}
+
+// Compact JSON straight from a per-request stack buffer, chunked only if it overflows
+static esp_err_t json_chunk_flush(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len);
+}
+
+static void json_begin(httpd_req_t *req, json_writer_t *w, char *buf, size_t size)
+{
+    httpd_resp_set_type(req, "application/json");
+    json_writer_init(w, buf, size, json_chunk_flush, req);
+    json_obj_begin(w);
+}
+
+static esp_err_t json_send(httpd_req_t *req, json_writer_t *w)
+{
+    json_obj_end(w);
+
+    if (w->status != ESP_OK) {
+        ESP_LOGE(TAG, "JSON response failed: %s", esp_err_to_name(w->status));
+        return ESP_FAIL;
+    }
+
+    // Fit in the buffer: one response with Content-Length
+    if (w->total == w->len) {
+        return httpd_resp_send(req, w->buf, w->len);
+    }
+
+    if (json_writer_flush(w) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static void json_error(json_writer_t *w, const char *message)
+{
+    json_kv_bool(w, "success", false);
+    json_kv_str(w, "error", message);
+}
+
+// Reads the whole POST body into buf as a NUL-terminated string; returns its length or <= 0
+static int recv_body(httpd_req_t *req, char *buf, size_t size)
+{
+    if (req->content_len >= size) {
+        return -1;  // Would be truncated
+    }
+
+    size_t received = 0;
+    while (received < req->content_len) {
+        int len = httpd_req_recv(req, buf + received, req->content_len - received);
+        if (len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (len <= 0) {
+            return len;
+        }
+        received += len;
+    }
+    buf[received] = '\0';
+    return (int)received;
+}
+
+// Handler for temperature API, answers from the sampler snapshot without touching SPI
 static esp_err_t temperature_handler(httpd_req_t *req)
 {
-    cJSON *json = cJSON_CreateObject();
-    float temperature = 0.0f;
-    
-    if (temp_sensor != NULL) {
-        esp_err_t ret = max6675_read_temperature(temp_sensor, &temperature);
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    temp_sample_t sample;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    esp_err_t ret = temp_sampler_get_latest(&sample);
+    if (ret == ESP_OK) {
+        ret = sample.status;
+        json_kv_uint(&w, "sequence", sample.sequence);
+        json_kv_int(&w, "age_ms", (esp_timer_get_time() - sample.timestamp_us) / 1000);
+        json_kv_uint(&w, "raw", sample.raw);
+    }
+
+    if (ret == ESP_OK) {
+        json_kv_bool(&w, "success", true);
+        json_kv_fixed(&w, "temperature", sample.temperature, 2);
+    } else if (ret == ESP_ERR_INVALID_RESPONSE) {
+        json_error(&w, "Thermocouple not connected");
+    } else if (ret == ESP_ERR_INVALID_STATE) {
+        json_error(&w, "Temperature sensor not initialized");
+    } else {
+        json_error(&w, "Failed to read temperature");
+    }
+
+    // Every thermocouple on the bus, channel 0 is the one reported above
+    temp_sample_t samples[TEMP_SAMPLER_MAX_CHANNELS];
+    size_t count = 0;
+    if (temp_sampler_get_all(samples, TEMP_SAMPLER_MAX_CHANNELS, &count) == ESP_OK) {
+        json_key(&w, "channels");
+        json_arr_begin(&w);
+        for (size_t i = 0; i < count; i++) {
+            json_obj_begin(&w);
+            json_kv_uint(&w, "channel", i);
+            if (samples[i].status == ESP_OK) {
+                json_kv_fixed(&w, "temperature", samples[i].temperature, 2);
+            } else {
+                json_kv_null(&w, "temperature");
+                json_kv_str(&w, "error", samples[i].fault ? "open" : esp_err_to_name(samples[i].status));
+            }
+            json_kv_int(&w, "timestamp_us", samples[i].timestamp_us);
+            json_obj_end(&w);
+        }
+        json_arr_end(&w);
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for power control API
+static esp_err_t power_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    char body[100];
+    json_writer_t w;
+    double power_level = 0.0;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    int len = recv_body(req, body, sizeof(body));
+    esp_err_t ret = (len > 0) ? json_scan_number(body, len, "power", &power_level) : ESP_ERR_INVALID_SIZE;
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if (ret == ESP_FAIL) {
+        json_error(&w, "Invalid JSON");
+    } else if (ret != ESP_OK) {
+        json_error(&w, "Invalid power value");
+    } else if (power_level < 0.0 || power_level > 100.0) {
+        json_error(&w, "Power level must be between 0 and 100");
+    } else if (safety_is_tripped()) {
+        json_error(&w, s_tripped_error);
+    } else if (heater == NULL) {
+        json_error(&w, "PWM controller not initialized");
+    } else {
+        // The control task owns the output while it runs
+        ret = control_task_is_running()
+            ? control_task_set_manual_power((float)power_level)
+            : hal_actuator_set_duty(heater, 0, hal_actuator_percent_to_duty(heater, (float)power_level));
         if (ret == ESP_OK) {
-            cJSON_AddBoolToObject(json, "success", true);
-            cJSON_AddNumberToObject(json, "temperature", temperature);
-            ESP_LOGI(TAG, "Temperature: %.2f°C", temperature);
-        } else if (ret == ESP_ERR_INVALID_RESPONSE) {
-            cJSON_AddBoolToObject(json, "success", false);
-            cJSON_AddStringToObject(json, "error", "Thermocouple not connected");
+            settings_set_manual_power((float)power_level);
+            json_kv_bool(&w, "success", true);
+            json_kv_fixed(&w, "power", power_level, 2);
+            DLOGI(TAG, "Power set to %.2f%%", power_level);
         } else {
-            cJSON_AddBoolToObject(json, "success", false);
-            cJSON_AddStringToObject(json, "error", "Failed to read temperature");
+            json_error(&w, "Failed to set power");
         }
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for setpoint API, switches the controller to automatic mode
+static esp_err_t setpoint_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    char body[100];
+    json_writer_t w;
+    double setpoint = 0.0;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    int len = recv_body(req, body, sizeof(body));
+    esp_err_t ret = (len > 0) ? json_scan_number(body, len, "setpoint", &setpoint) : ESP_ERR_INVALID_SIZE;
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if (ret == ESP_FAIL) {
+        json_error(&w, "Invalid JSON");
+    } else if (ret != ESP_OK) {
+        json_error(&w, "Invalid setpoint value");
+    } else if (!control_task_is_running()) {
+        json_error(&w, "Control task not running");
+    } else if (safety_is_tripped()) {
+        json_error(&w, s_tripped_error);
+    } else if (control_task_set_setpoint((float)setpoint) != ESP_OK) {
+        json_error(&w, "Setpoint out of range");
     } else {
-        cJSON_AddBoolToObject(json, "success", false);
-        cJSON_AddStringToObject(json, "error", "Temperature sensor not initialized");
+        control_task_set_mode(CONTROL_MODE_AUTO);
+        settings_set_setpoint((float)setpoint);
+        json_kv_bool(&w, "success", true);
+        json_kv_fixed(&w, "setpoint", setpoint, 2);
     }
-    
-    char *json_string = cJSON_Print(json);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    return ESP_OK;
+
+    return json_send(req, &w);
 }
 
-// Handler for power control API
-static esp_err_t power_handler(httpd_req_t *req)
+// Reads {"segments":[{"target":C,"ramp_rate":C/min,"hold_s":s,"soak_band":C}, ...]};
+// only target is required
+static esp_err_t parse_profile(const char *body, size_t len, profile_segment_t *segments, size_t *count)
 {
-    cJSON *json = cJSON_CreateObject();
-    char buf[100];
-    int ret = httpd_req_recv(req, buf, sizeof(buf));
-    
-    if (ret <= 0) {
-        cJSON_AddBoolToObject(json, "success", false);
-        cJSON_AddStringToObject(json, "error", "Failed to receive data");
+    const char *cursor = NULL;
+    const char *element;
+    size_t element_len;
+    esp_err_t ret;
+
+    *count = 0;
+    while ((ret = json_scan_array_next(body, len, "segments", &cursor, &element, &element_len)) == ESP_OK) {
+        if (*count >= PROFILE_MAX_SEGMENTS) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        double target, ramp_rate = 0.0, hold_s = 0.0, soak_band = 0.0;
+        if (json_scan_number(element, element_len, "target", &target) != ESP_OK) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        ret = json_scan_number(element, element_len, "ramp_rate", &ramp_rate);
+        if (ret == ESP_OK || ret == ESP_ERR_NOT_FOUND) {
+            ret = json_scan_number(element, element_len, "hold_s", &hold_s);
+        }
+        if (ret == ESP_OK || ret == ESP_ERR_NOT_FOUND) {
+            ret = json_scan_number(element, element_len, "soak_band", &soak_band);
+        }
+        if ((ret != ESP_OK && ret != ESP_ERR_NOT_FOUND) || !(hold_s >= 0.0 && hold_s <= PROFILE_MAX_HOLD_S)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        segments[(*count)++] = (profile_segment_t) {
+            .target = (float)target,
+            .ramp_rate = (float)ramp_rate,
+            .hold_s = (uint32_t)hold_s,
+            .soak_band = (float)soak_band,
+        };
+    }
+
+    return (ret == ESP_ERR_NOT_FOUND && cursor != NULL) ? ESP_OK : ret;
+}
+
+// Handler for profile upload: validated as a whole, then run by the control task and
+// stored; {"stored":true} runs the stored one again
+static esp_err_t profile_post_handler(httpd_req_t *req)
+{
+    static char body[REST_PROFILE_BODY_SIZE];  // The server runs one handler at a time
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    profile_segment_t segments[PROFILE_MAX_SEGMENTS];
+    size_t count = 0;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    int len = recv_body(req, body, sizeof(body));
+    bool stored = false;
+    esp_err_t ret = ESP_ERR_INVALID_SIZE;
+    if (len > 0 && json_scan_bool(body, len, "stored", &stored) == ESP_OK && stored) {
+        static settings_t settings;  // The server runs one handler at a time
+        settings_get(&settings);
+        count = settings.profile.count;
+        memcpy(segments, settings.profile.segments, count * sizeof(segments[0]));
+        ret = (count > 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    } else if (len > 0) {
+        ret = parse_profile(body, len, segments, &count);
+    }
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if (ret == ESP_ERR_NOT_FOUND && stored) {
+        json_error(&w, "No stored profile");
+    } else if (ret == ESP_FAIL) {
+        json_error(&w, "Invalid JSON");
+    } else if (ret == ESP_ERR_INVALID_SIZE) {
+        json_error(&w, "Too many segments");
+    } else if (ret != ESP_OK) {
+        json_error(&w, "Invalid profile segment");
+    } else if (!control_task_is_running()) {
+        json_error(&w, "Control task not running");
+    } else if (safety_is_tripped()) {
+        json_error(&w, s_tripped_error);
+    } else if (control_task_run_profile(segments, count) != ESP_OK) {
+        json_error(&w, "Profile out of range");
     } else {
-        buf[ret] = '\0';
-        cJSON *root = cJSON_Parse(buf);
-        
-        if (root != NULL) {
-            cJSON *power_item = cJSON_GetObjectItem(root, "power");
-            if (cJSON_IsNumber(power_item)) {
-                int power_level = power_item->valueint;
-                
-                if (power_level >= 0 && power_level <= 100) {
-                    if (pwm_controller != NULL) {
-                        esp_err_t ret = mosfet_pwm_set_duty(pwm_controller, power_level);
-                        if (ret == ESP_OK) {
-                            cJSON_AddBoolToObject(json, "success", true);
-                            cJSON_AddNumberToObject(json, "power", power_level);
-                            ESP_LOGI(TAG, "Power set to %d%%", power_level);
-                        } else {
-                            cJSON_AddBoolToObject(json, "success", false);
-                            cJSON_AddStringToObject(json, "error", "Failed to set power");
-                        }
-                    } else {
-                        cJSON_AddBoolToObject(json, "success", false);
-                        cJSON_AddStringToObject(json, "error", "PWM controller not initialized");
-                    }
-                } else {
-                    cJSON_AddBoolToObject(json, "success", false);
-                    cJSON_AddStringToObject(json, "error", "Power level must be between 0 and 100");
-                }
-            } else {
-                cJSON_AddBoolToObject(json, "success", false);
-                cJSON_AddStringToObject(json, "error", "Invalid power value");
+        if (!stored) {
+            settings_set_profile(segments, count);
+        }
+        json_kv_bool(&w, "success", true);
+        json_kv_uint(&w, "segments", count);
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for profile progress
+static esp_err_t profile_get_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    profile_progress_t progress;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    control_task_get_profile(&progress);
+    json_kv_bool(&w, "success", true);
+    json_kv_str(&w, "state", profile_state_name(progress.state));
+    json_kv_uint(&w, "segment", progress.segment);
+    json_kv_uint(&w, "segments", progress.segment_count);
+    json_kv_fixed(&w, "setpoint", progress.setpoint, 2);
+    json_kv_fixed(&w, "hold_remaining_s", progress.hold_remaining_s, 1);
+    json_kv_fixed(&w, "holdback_s", progress.holdback_s, 1);
+    json_kv_fixed(&w, "elapsed_s", progress.elapsed_s, 1);
+
+    return json_send(req, &w);
+}
+
+// Handler for profile abort; the setpoint stays where the profile left it
+static esp_err_t profile_delete_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    if (control_task_abort_profile() == ESP_OK) {
+        json_kv_bool(&w, "success", true);
+    } else {
+        json_error(&w, "No profile running");
+    }
+
+    return json_send(req, &w);
+}
+
+// Optional number member: keeps the default when absent, false if malformed
+// or out of float range
+static bool scan_optional(const char *body, size_t len, const char *key, float *value)
+{
+    double number;
+    esp_err_t ret = json_scan_number(body, len, key, &number);
+    if (ret == ESP_OK) {
+        if (!isfinite((float)number)) {
+            return false;
+        }
+        *value = (float)number;
+    }
+    return ret == ESP_OK || ret == ESP_ERR_NOT_FOUND;
+}
+
+// Handler for autotune start:
+// {"target":C[,"bias":%,"amplitude":%,"hysteresis":C,"max_temp":C,"cycles":n,"timeout_s":s,"rule":name]}
+static esp_err_t autotune_post_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    char body[256];
+    char rule[24];
+    json_writer_t w;
+    autotune_config_t config = AUTOTUNE_CONFIG_DEFAULT();
+    float cycles = (float)config.cycles;
+    float timeout_s = (float)config.timeout_s;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    int len = recv_body(req, body, sizeof(body));
+    esp_err_t ret = (len > 0) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    if (ret == ESP_OK) {
+        double target;
+        ret = json_scan_number(body, len, "target", &target);
+        config.target = (float)target;
+    }
+    if (ret == ESP_OK) {
+        esp_err_t rule_ret = json_scan_string(body, len, "rule", rule, sizeof(rule));
+        if (rule_ret == ESP_OK) {
+            rule_ret = autotune_rule_from_name(rule, &config.rule);
+        }
+        bool ok = scan_optional(body, len, "bias", &config.bias) &&
+                  scan_optional(body, len, "amplitude", &config.amplitude) &&
+                  scan_optional(body, len, "hysteresis", &config.hysteresis) &&
+                  scan_optional(body, len, "max_temp", &config.max_temp) &&
+                  scan_optional(body, len, "cycles", &cycles) &&
+                  scan_optional(body, len, "timeout_s", &timeout_s) &&
+                  (rule_ret == ESP_OK || rule_ret == ESP_ERR_NOT_FOUND) &&
+                  cycles >= 1.0f && cycles <= AUTOTUNE_MAX_CYCLES && timeout_s >= 1.0f && timeout_s <= 86400.0f;
+        ret = ok ? ESP_OK : ESP_ERR_INVALID_ARG;
+        config.cycles = (uint32_t)cycles;
+        config.timeout_s = (uint32_t)timeout_s;
+    }
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if (ret == ESP_FAIL) {
+        json_error(&w, "Invalid JSON");
+    } else if (ret != ESP_OK) {
+        json_error(&w, "Invalid autotune parameters");
+    } else if (!control_task_is_running()) {
+        json_error(&w, "Control task not running");
+    } else if (safety_is_tripped()) {
+        json_error(&w, s_tripped_error);
+    } else if (control_task_start_autotune(&config) != ESP_OK) {
+        json_error(&w, "Autotune parameters out of range");
+    } else {
+        json_kv_bool(&w, "success", true);
+        json_kv_str(&w, "rule", autotune_rule_name(config.rule));
+        json_kv_str(&w, "progress", "/api/stream");
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for autotune progress and result
+static esp_err_t autotune_get_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    autotune_progress_t progress;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    control_task_get_autotune(&progress);
+    json_kv_bool(&w, "success", true);
+    autotune_progress_to_json(&w, &progress);
+
+    return json_send(req, &w);
+}
+
+// Handler for autotune abort; the heater is switched off
+static esp_err_t autotune_delete_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    if (control_task_abort_autotune() == ESP_OK) {
+        json_kv_bool(&w, "success", true);
+    } else {
+        json_error(&w, "No autotune running");
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for control loop status API
+static esp_err_t control_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    if (control_task_is_running()) {
+        control_status_t status;
+        control_task_get_status(&status);
+        json_kv_bool(&w, "success", true);
+        json_kv_str(&w, "mode", status.mode == CONTROL_MODE_AUTO ? "auto" : "manual");
+        json_kv_fixed(&w, "setpoint", status.setpoint, 2);
+        json_kv_fixed(&w, "temperature", status.temperature, 2);
+        json_kv_fixed(&w, "estimate", status.estimate, 2);
+        json_kv_fixed(&w, "rate", status.rate, 2);
+        json_kv_uint(&w, "spikes", status.spike_count);
+        json_kv_fixed(&w, "output", status.output, 2);
+        json_kv_fixed(&w, "feedforward", status.feedforward, 2);
+        json_kv_bool(&w, "sensor_ok", status.sensor_ok);
+        json_kv_uint(&w, "ticks", status.tick_count);
+        json_kv_uint(&w, "overruns", status.overrun_count);
+        json_kv_uint(&w, "step_us", status.last_step_us);
+        json_kv_str(&w, "profile", profile_state_name(status.profile));
+        json_kv_str(&w, "autotune", autotune_state_name(status.autotune));
+    } else {
+        json_error(&w, "Control task not running");
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for telemetry history API
+// GET /api/history?since=<seq>[&format=bin]
+// Streams the records from <seq> up to the current head, as chunked CSV by default or
+// as raw packed telemetry_record_t words. X-Telemetry-Next is the <seq> for the next poll.
+static esp_err_t history_handler(httpd_req_t *req)
+{
+    char query[64];
+    char value[16];
+    uint32_t since = 0;
+    bool binary = false;
+
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        if (httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+            since = strtoul(value, NULL, 10);
+        }
+        if (httpd_query_key_value(query, "format", value, sizeof(value)) == ESP_OK) {
+            binary = (strcmp(value, "bin") == 0);
+        }
+    }
+
+    uint32_t next = telemetry_head();
+    uint32_t first = telemetry_oldest();
+    if (since > first) {
+        first = (since < next) ? since : next;
+    }
+
+    char first_str[12];
+    char next_str[12];
+    char time_str[12];
+    snprintf(first_str, sizeof(first_str), "%" PRIu32, first);
+    snprintf(next_str, sizeof(next_str), "%" PRIu32, next);
+    snprintf(time_str, sizeof(time_str), "%" PRIu32, telemetry_last_timestamp_ms());
+    httpd_resp_set_hdr(req, "X-Telemetry-First", first_str);
+    httpd_resp_set_hdr(req, "X-Telemetry-Next", next_str);
+    httpd_resp_set_hdr(req, "X-Telemetry-Time-Ms", time_str);
+    httpd_resp_set_type(req, binary ? "application/octet-stream" : "text/csv");
+
+    char chunk[512];
+    size_t len = 0;
+
+    if (!binary) {
+        len = snprintf(chunk, sizeof(chunk), "seq,dt_ms,temperature,duty,p,i,d,fault\n");
+    }
+
+    for (uint32_t seq = first; seq < next; seq++) {
+        if (binary) {
+            telemetry_record_t record;
+            if (!telemetry_read_record(seq, &record)) {
+                continue;  // Overwritten while streaming
             }
-            cJSON_Delete(root);
+            memcpy(chunk + len, &record, sizeof(record));
+            len += sizeof(record);
         } else {
-            cJSON_AddBoolToObject(json, "success", false);
-            cJSON_AddStringToObject(json, "error", "Invalid JSON");
+            telemetry_sample_t sample;
+            if (!telemetry_read(seq, &sample)) {
+                continue;
+            }
+            len += snprintf(chunk + len, sizeof(chunk) - len, "%" PRIu32 ",%u,%u.%02u,%u,%d,%d,%d,%d\n",
+                            seq, sample.dt_ms, sample.temp_q2 / 4, (sample.temp_q2 % 4) * 25,
+                            sample.duty, sample.p_term, sample.i_term, sample.d_term, sample.fault);
+        }
+
+        // Flush before the next line could overflow the buffer
+        if (len > sizeof(chunk) - 64) {
+            if (httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+                return ESP_FAIL;
+            }
+            len = 0;
         }
     }
-    
-    char *json_string = cJSON_Print(json);
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json_string, HTTPD_RESP_USE_STRLEN);
-    
-    free(json_string);
-    cJSON_Delete(json);
-    return ESP_OK;
+
+    if (len > 0 && httpd_resp_send_chunk(req, chunk, len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
-esp_err_t rest_server_init(max6675_handle_t *temp_sensor_handle, mosfet_pwm_handle_t *pwm_controller_handle)
+// Handler for stored settings; the WiFi password is never returned
+static esp_err_t config_get_handler(httpd_req_t *req)
 {
-    temp_sensor = temp_sensor_handle;
-    pwm_controller = pwm_controller_handle;
-    
+    static settings_t settings;  // The server runs one handler at a time
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    settings_status_t status;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    settings_get(&settings);
+    settings_get_status(&status);
+    json_kv_bool(&w, "success", true);
+    json_kv_fixed(&w, "kp", settings.gains.kp, 3);
+    json_kv_fixed(&w, "ki", settings.gains.ki, 4);
+    json_kv_fixed(&w, "kd", settings.gains.kd, 3);
+    json_kv_str(&w, "mode", settings.control.mode == CONTROL_MODE_AUTO ? "auto" : "manual");
+    json_kv_fixed(&w, "setpoint", settings.control.setpoint, 2);
+    json_kv_fixed(&w, "power", settings.control.power, 2);
+    json_key(&w, "offsets");
+    json_arr_begin(&w);
+    for (size_t i = 0; i < TEMP_SAMPLER_MAX_CHANNELS; i++) {
+        json_fixed(&w, settings.calibration.offset[i], 2);
+    }
+    json_arr_end(&w);
+    json_kv_str(&w, "ssid", settings.network.ssid[0] != '\0' ? settings.network.ssid : WIFI_SSID);
+    json_kv_bool(&w, "password_set", settings.network.password[0] != '\0');
+    json_kv_uint(&w, "profile_segments", settings.profile.count);
+    json_kv_bool(&w, "loaded", status.loaded);
+    json_kv_bool(&w, "pending", status.pending);
+    json_kv_uint(&w, "commits", status.commits);
+    json_kv_uint(&w, "skipped", status.skipped);
+    if (status.last_error != ESP_OK) {
+        json_kv_str(&w, "last_error", esp_err_to_name(status.last_error));
+    }
+
+    return json_send(req, &w);
+}
+
+// Reads {"offsets":[C, ...]}, at most one per sampler channel
+static esp_err_t parse_offsets(const char *body, size_t len, float *offsets, size_t *count)
+{
+    const char *cursor = NULL;
+    const char *element;
+    size_t element_len;
+    esp_err_t ret;
+
+    *count = 0;
+    while ((ret = json_scan_array_next(body, len, "offsets", &cursor, &element, &element_len)) == ESP_OK) {
+        double offset;
+        if (*count >= TEMP_SAMPLER_MAX_CHANNELS || json_parse_number(element, element_len, &offset) != ESP_OK ||
+            !(offset >= -SETTINGS_MAX_OFFSET_C && offset <= SETTINGS_MAX_OFFSET_C)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        offsets[(*count)++] = (float)offset;
+    }
+
+    return (ret == ESP_ERR_NOT_FOUND && cursor != NULL) ? ESP_OK : ret;
+}
+
+// Handler for settings changes; any subset of
+// {"kp":n,"ki":n,"kd":n,"offsets":[C, ...],"ssid":s,"password":s}. Gains and offsets apply
+// at once, WiFi credentials on the next boot. Saved to flash in the background.
+static esp_err_t config_post_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    char body[384];
+    char ssid[SETTINGS_SSID_MAX + 1];
+    char password[SETTINGS_PASSWORD_MAX + 1];
+    float offsets[TEMP_SAMPLER_MAX_CHANNELS];
+    size_t offset_count = 0;
+    json_writer_t w;
+    static settings_t current;  // The server runs one handler at a time
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    settings_get(&current);
+    float kp = current.gains.kp;
+    float ki = current.gains.ki;
+    float kd = current.gains.kd;
+
+    int len = recv_body(req, body, sizeof(body));
+    esp_err_t ret = (len > 0) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+    bool ok = (ret == ESP_OK) &&
+              scan_optional(body, len, "kp", &kp) && scan_optional(body, len, "ki", &ki) &&
+              scan_optional(body, len, "kd", &kd) && kp >= 0.0f && ki >= 0.0f && kd >= 0.0f &&
+              isfinite(kp) && isfinite(ki) && isfinite(kd);
+    esp_err_t offsets_ret = ok ? parse_offsets(body, len, offsets, &offset_count) : ESP_ERR_INVALID_ARG;
+    esp_err_t ssid_ret = ok ? json_scan_string(body, len, "ssid", ssid, sizeof(ssid)) : ESP_ERR_INVALID_ARG;
+    esp_err_t password_ret = ok ? json_scan_string(body, len, "password", password, sizeof(password))
+                                : ESP_ERR_INVALID_ARG;
+    ok = ok && (offsets_ret == ESP_OK || offsets_ret == ESP_ERR_NOT_FOUND) &&
+         (ssid_ret == ESP_OK || ssid_ret == ESP_ERR_NOT_FOUND) &&
+         (password_ret == ESP_OK || password_ret == ESP_ERR_NOT_FOUND) &&
+         !(ssid_ret == ESP_OK && ssid[0] == '\0');
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if (!ok) {
+        json_error(&w, "Invalid settings");
+    } else {
+        if (kp != current.gains.kp || ki != current.gains.ki || kd != current.gains.kd) {
+            if (control_task_is_running()) {
+                control_task_set_gains(kp, ki, kd);
+            }
+            settings_set_gains(kp, ki, kd);
+        }
+        if (offsets_ret == ESP_OK) {
+            temp_sampler_set_offsets(offsets, offset_count);
+            settings_set_offsets(offsets, offset_count);
+        }
+        // A password alone goes with the SSID in use
+        bool network = (ssid_ret == ESP_OK || password_ret == ESP_OK);
+        if (network) {
+            const char *current_ssid = current.network.ssid[0] != '\0' ? current.network.ssid : WIFI_SSID;
+            settings_set_network(ssid_ret == ESP_OK ? ssid : current_ssid,
+                                 password_ret == ESP_OK ? password : current.network.password);
+        }
+        json_kv_bool(&w, "success", true);
+        json_kv_bool(&w, "restart_required", network);
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for boot and network state: when each startup phase was reached
+// (ms since boot, null until it is), why the chip last reset, and where the
+// WiFi reconnect state machine stands
+static esp_err_t system_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    boot_timeline_t timeline;
+    wifi_status_t wifi;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    boot_timeline_get(&timeline);
+    wifi_get_status(&wifi);
+    int64_t now_us = esp_timer_get_time();
+
+    json_kv_bool(&w, "success", true);
+    json_kv_uint(&w, "uptime_ms", (uint64_t)(now_us / 1000));
+    json_kv_str(&w, "reset_reason", boot_reset_reason_name(esp_reset_reason()));
+    json_key(&w, "boot_ms");
+    json_obj_begin(&w);
+    for (int i = 0; i < BOOT_PHASE_COUNT; i++) {
+        if (timeline.phase_us[i] != 0) {
+            json_kv_fixed(&w, boot_phase_name((boot_phase_t)i), timeline.phase_us[i] / 1000.0, 1);
+        } else {
+            json_kv_null(&w, boot_phase_name((boot_phase_t)i));
+        }
+    }
+    json_obj_end(&w);
+
+    json_key(&w, "wifi");
+    json_obj_begin(&w);
+    json_kv_str(&w, "state", wifi_state_name(wifi.state));
+    json_kv_uint(&w, "attempt", wifi.attempt);
+    if (wifi.state == WIFI_STATE_BACKOFF) {
+        int64_t retry_in_us = wifi.retry_at_us - now_us;
+        json_kv_uint(&w, "retry_in_ms", retry_in_us > 0 ? (uint64_t)(retry_in_us / 1000) : 0);
+    }
+    json_kv_uint(&w, "connects", wifi.connects);
+    json_kv_uint(&w, "disconnects", wifi.disconnects);
+    json_kv_uint(&w, "last_reason", wifi.last_reason);
+    if (wifi.state == WIFI_STATE_CONNECTED) {
+        char ip[16];
+        snprintf(ip, sizeof(ip), IPSTR, IP2STR(&wifi.ip));
+        json_kv_str(&w, "ip", ip);
+        json_kv_uint(&w, "connected_s", (uint64_t)((now_us - wifi.connected_us) / 1000000));
+    }
+    json_obj_end(&w);
+
+    return json_send(req, &w);
+}
+
+static void write_fault_names(json_writer_t *w, const char *key, uint32_t faults)
+{
+    json_key(w, key);
+    json_arr_begin(w);
+    for (uint32_t i = 0; i < INTERLOCK_FAULT_COUNT; i++) {
+        if (faults & (1u << i)) {
+            json_str(w, interlock_fault_name(1u << i));
+        }
+    }
+    json_arr_end(w);
+}
+
+// Handler for the safety interlock: latched faults, conditions still
+// present and detection-to-cutoff latency
+static esp_err_t safety_get_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    json_writer_t w;
+    safety_status_t status;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    safety_get_status(&status);
+    json_kv_bool(&w, "success", true);
+    json_kv_bool(&w, "running", status.running);
+    json_kv_bool(&w, "tripped", status.tripped);
+    write_fault_names(&w, "faults", status.faults);
+    write_fault_names(&w, "active", status.active);
+    json_kv_uint(&w, "trips", status.trips);
+    if (status.trips > 0) {
+        write_fault_names(&w, "last_trip", status.last_trip_faults);
+        json_kv_fixed(&w, "last_trip_s", (esp_timer_get_time() - status.tripped_us) / 1e6, 1);
+        json_kv_uint(&w, "last_latency_us", status.last_latency_us);
+        json_kv_uint(&w, "worst_latency_us", status.worst_latency_us);
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for {"acknowledge":true} (release a latched cutoff once its cause
+// is gone; the loop stays in manual at 0%) or {"test":true} (trip now)
+static esp_err_t safety_post_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    char body[64];
+    json_writer_t w;
+    bool acknowledge = false;
+    bool test = false;
+
+    json_begin(req, &w, buf, sizeof(buf));
+
+    int len = recv_body(req, body, sizeof(body));
+    esp_err_t ack_ret = (len > 0) ? json_scan_bool(body, len, "acknowledge", &acknowledge) : ESP_ERR_INVALID_SIZE;
+    esp_err_t test_ret = (len > 0) ? json_scan_bool(body, len, "test", &test) : ESP_ERR_INVALID_SIZE;
+
+    if (len <= 0) {
+        json_error(&w, "Failed to receive data");
+    } else if ((ack_ret != ESP_OK && ack_ret != ESP_ERR_NOT_FOUND) ||
+               (test_ret != ESP_OK && test_ret != ESP_ERR_NOT_FOUND) || acknowledge == test) {
+        json_error(&w, "Expected {\"acknowledge\":true} or {\"test\":true}");
+    } else if (acknowledge) {
+        if (safety_acknowledge() == ESP_OK) {
+            json_kv_bool(&w, "success", true);
+        } else {
+            json_error(&w, safety_is_tripped() ? "Fault condition still present" : "Interlock not tripped");
+        }
+    } else if (safety_test() == ESP_OK) {
+        json_kv_bool(&w, "success", true);
+        json_kv_str(&w, "status", "/api/safety");
+    } else {
+        json_error(&w, "Interlock already tripped");
+    }
+
+    return json_send(req, &w);
+}
+
+// Handler for runtime metrics, Prometheus text format
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    char buf[REST_JSON_BUFFER_SIZE];
+    metrics_writer_t w;
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    metrics_writer_init(&w, buf, sizeof(buf), json_chunk_flush, req);
+    metrics_write(&w);
+
+    if (control_task_is_running()) {
+        control_status_t status;
+        control_task_get_status(&status);
+        metrics_write_family(&w, "temperature_celsius", "gauge", "Last valid thermocouple reading");
+        metrics_write_sample(&w, "temperature_celsius", NULL, status.temperature);
+        metrics_write_family(&w, "setpoint_celsius", "gauge", "Control setpoint");
+        metrics_write_sample(&w, "setpoint_celsius", NULL, status.setpoint);
+        metrics_write_family(&w, "output_percent", "gauge", "Applied heater power");
+        metrics_write_sample(&w, "output_percent", NULL, status.output);
+        metrics_write_family(&w, "sensor_ok", "gauge", "1 while the last control step had a valid reading");
+        metrics_write_sample(&w, "sensor_ok", NULL, status.sensor_ok ? 1 : 0);
+        metrics_write_family(&w, "control_ticks_total", "counter", "Completed control periods");
+        metrics_write_sample(&w, "control_ticks_total", NULL, status.tick_count);
+        metrics_write_family(&w, "control_overruns_total", "counter", "Control periods that overran");
+        metrics_write_sample(&w, "control_overruns_total", NULL, status.overrun_count);
+        metrics_write_family(&w, "estimator_spikes_total", "counter", "Readings dropped as spikes");
+        metrics_write_sample(&w, "estimator_spikes_total", NULL, status.spike_count);
+    }
+
+    safety_status_t safety;
+    safety_get_status(&safety);
+    if (safety.running) {
+        metrics_write_family(&w, "safety_tripped", "gauge", "1 while the interlock holds the heater off");
+        metrics_write_sample(&w, "safety_tripped", NULL, safety.tripped ? 1 : 0);
+        metrics_write_family(&w, "safety_cutoff_worst_seconds", "gauge",
+                             "Worst safety interlock latency since boot, condition observable to heater off");
+        metrics_write_sample(&w, "safety_cutoff_worst_seconds", NULL, safety.worst_latency_us / 1e6);
+    }
+
+    wifi_status_t wifi;
+    wifi_get_status(&wifi);
+    metrics_write_family(&w, "wifi_connected", "gauge", "1 while WiFi has an IP");
+    metrics_write_sample(&w, "wifi_connected", NULL, wifi.state == WIFI_STATE_CONNECTED ? 1 : 0);
+
+    recorder_status_t recorder;
+    recorder_get_status(&recorder);
+    if (recorder.active) {
+        metrics_write_family(&w, "recorder_records_total", "counter", "Flight recorder records appended");
+        metrics_write_sample(&w, "recorder_records_total", NULL, recorder.records);
+        metrics_write_family(&w, "recorder_dropped_total", "counter", "Flight recorder records lost to a slow writer");
+        metrics_write_sample(&w, "recorder_dropped_total", NULL, recorder.dropped);
+        metrics_write_family(&w, "recorder_flash_errors_total", "counter", "Flight recorder erase/write failures");
+        metrics_write_sample(&w, "recorder_flash_errors_total", NULL, recorder.flash_errors);
+    }
+
+    udp_telemetry_status_t udp;
+    udp_telemetry_get_status(&udp);
+    if (udp.running) {
+        metrics_write_family(&w, "udp_telemetry_datagrams_total", "counter", "Telemetry datagrams sent");
+        metrics_write_sample(&w, "udp_telemetry_datagrams_total", NULL, udp.datagrams);
+        metrics_write_family(&w, "udp_telemetry_send_errors_total", "counter", "Telemetry sends that failed");
+        metrics_write_sample(&w, "udp_telemetry_send_errors_total", NULL, udp.send_errors);
+        metrics_write_family(&w, "udp_telemetry_overwritten_total", "counter", "Records lost before they could be sent");
+        metrics_write_sample(&w, "udp_telemetry_overwritten_total", NULL, udp.overwritten);
+    }
+
+    modbus_tcp_status_t modbus;
+    modbus_tcp_get_status(&modbus);
+    if (modbus.running) {
+        metrics_write_family(&w, "modbus_requests_total", "counter", "Modbus requests answered");
+        metrics_write_sample(&w, "modbus_requests_total", NULL, modbus.stats.requests);
+        metrics_write_family(&w, "modbus_exceptions_total", "counter", "Modbus requests answered with an exception");
+        metrics_write_sample(&w, "modbus_exceptions_total", NULL, modbus.stats.exceptions);
+        metrics_write_family(&w, "modbus_writes_total", "counter", "Modbus writes applied");
+        metrics_write_sample(&w, "modbus_writes_total", NULL, modbus.stats.writes);
+        metrics_write_family(&w, "modbus_connections_total", "counter", "Modbus connections accepted");
+        metrics_write_sample(&w, "modbus_connections_total", NULL, modbus.stats.connections);
+        metrics_write_family(&w, "modbus_rejected_total", "counter", "Modbus connections refused, all slots busy");
+        metrics_write_sample(&w, "modbus_rejected_total", NULL, modbus.stats.rejected);
+        metrics_write_family(&w, "modbus_clients", "gauge", "Modbus masters connected");
+        metrics_write_sample(&w, "modbus_clients", NULL, modbus.stats.clients);
+    }
+
+    if (metrics_writer_flush(&w) != ESP_OK) {
+        ESP_LOGE(TAG, "Metrics response failed: %s", esp_err_to_name(w.status));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+static esp_err_t recorder_chunk(void *ctx, const uint8_t *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+// Handler for the flight recorder dump: raw sectors, oldest first, sent from mapped flash
+static esp_err_t recorder_handler(httpd_req_t *req)
+{
+    recorder_status_t status;
+    recorder_get_status(&status);
+    if (!status.active) {
+        char buf[REST_JSON_BUFFER_SIZE];
+        json_writer_t w;
+        json_begin(req, &w, buf, sizeof(buf));
+        json_error(&w, "Flight recorder not available");
+        return json_send(req, &w);
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"recorder.bin\"");
+    esp_err_t ret = recorder_read(recorder_chunk, req);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Recorder download failed: %s", esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;
+    const char *labels;             // Latency histogram labels
+} rest_route_t;
+
+#define REST_ROUTE(path, verb, fn, ctx) \
+    { path, HTTP_##verb, fn, (void *)(ctx), "uri=\"" path "\",method=\"" #verb "\"" }
+
+static const rest_route_t s_routes[] = {
+    REST_ROUTE("/",                GET,    static_asset_handler,   &asset_index_html),
+    REST_ROUTE("/app.css",         GET,    static_asset_handler,   &asset_app_css),
+    REST_ROUTE("/app.js",          GET,    static_asset_handler,   &asset_app_js),
+    REST_ROUTE("/api/temperature", GET,    temperature_handler,    NULL),
+    REST_ROUTE("/api/power",       POST,   power_handler,          NULL),
+    REST_ROUTE("/api/setpoint",    POST,   setpoint_handler,       NULL),
+    REST_ROUTE("/api/profile",     POST,   profile_post_handler,   NULL),
+    REST_ROUTE("/api/profile",     GET,    profile_get_handler,    NULL),
+    REST_ROUTE("/api/profile",     DELETE, profile_delete_handler, NULL),
+    REST_ROUTE("/api/autotune",    POST,   autotune_post_handler,  NULL),
+    REST_ROUTE("/api/autotune",    GET,    autotune_get_handler,   NULL),
+    REST_ROUTE("/api/autotune",    DELETE, autotune_delete_handler, NULL),
+    REST_ROUTE("/api/control",     GET,    control_handler,        NULL),
+    REST_ROUTE("/api/history",     GET,    history_handler,        NULL),
+    REST_ROUTE("/api/stream",      GET,    live_stream_handler,    NULL),
+    REST_ROUTE("/api/config",      GET,    config_get_handler,     NULL),
+    REST_ROUTE("/api/config",      POST,   config_post_handler,    NULL),
+    REST_ROUTE("/api/metrics",     GET,    metrics_handler,        NULL),
+    REST_ROUTE("/api/recorder",    GET,    recorder_handler,       NULL),
+    REST_ROUTE("/api/system",      GET,    system_handler,         NULL),
+    REST_ROUTE("/api/safety",      GET,    safety_get_handler,     NULL),
+    REST_ROUTE("/api/safety",      POST,   safety_post_handler,    NULL),
+};
+
+#define REST_ROUTE_COUNT  (sizeof(s_routes) / sizeof(s_routes[0]))
+
+_Static_assert(REST_ROUTE_COUNT <= REST_SERVER_MAX_URI_HANDLERS, "Raise REST_SERVER_MAX_URI_HANDLERS");
+
+static const uint32_t s_http_bounds_us[] = { 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000 };
+static metrics_histogram_t s_route_latency[REST_ROUTE_COUNT];
+
+// Every route goes through here: times the handler into its latency histogram
+static esp_err_t timed_handler(httpd_req_t *req)
+{
+    size_t index = (size_t)req->user_ctx;
+    const rest_route_t *route = &s_routes[index];
+
+    int64_t start_us = esp_timer_get_time();
+    req->user_ctx = route->user_ctx;
+    esp_err_t ret = route->handler(req);
+    metrics_histogram_observe(&s_route_latency[index], (uint32_t)(esp_timer_get_time() - start_us));
+
+    return ret;
+}
+
+esp_err_t rest_server_init(const hal_actuator_t *heater_handle)
+{
+    static bool latency_registered = false;
+
+    heater = heater_handle;
+
+    if (!latency_registered) {
+        for (size_t i = 0; i < REST_ROUTE_COUNT; i++) {
+            s_route_latency[i] = (metrics_histogram_t) {
+                .name = "http_request_duration_seconds",
+                .help = "HTTP handler time per route",
+                .labels = s_routes[i].labels,
+                .bounds_us = s_http_bounds_us,
+                .bound_count = sizeof(s_http_bounds_us) / sizeof(s_http_bounds_us[0]),
+            };
+            metrics_register_histogram(&s_route_latency[i]);
+        }
+        latency_registered = true;
+    }
+
     ESP_LOGI(TAG, "REST server initialized");
     return ESP_OK;
 }
@@ -254,33 +1084,25 @@ esp_err_t rest_server_start(void)
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = REST_SERVER_PORT;
     config.max_uri_handlers = REST_SERVER_MAX_URI_HANDLERS;
+    config.max_open_sockets = REST_SERVER_MAX_OPEN_SOCKETS;
+    config.send_wait_timeout = REST_SERVER_SEND_TIMEOUT_S;  // Bounds how long one slow stream client stalls the rest
     
     // Start the HTTP server
     if (httpd_start(&server, &config) == ESP_OK) {
-        // Register URI handlers
-        httpd_uri_t root_uri = {
-            .uri = "/",
-            .method = HTTP_GET,
-            .handler = root_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &root_uri);
-        
-        httpd_uri_t temperature_uri = {
-            .uri = "/api/temperature",
-            .method = HTTP_GET,
-            .handler = temperature_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &temperature_uri);
-        
-        httpd_uri_t power_uri = {
-            .uri = "/api/power",
-            .method = HTTP_POST,
-            .handler = power_handler,
-            .user_ctx = NULL
-        };
-        httpd_register_uri_handler(server, &power_uri);
+        // Register URI handlers; user_ctx is the route index for timed_handler
+        for (size_t i = 0; i < REST_ROUTE_COUNT; i++) {
+            httpd_uri_t uri = {
+                .uri = s_routes[i].uri,
+                .method = s_routes[i].method,
+                .handler = timed_handler,
+                .user_ctx = (void *)i
+            };
+            httpd_register_uri_handler(server, &uri);
+        }
+
+        if (live_stream_start() != ESP_OK) {
+            ESP_LOGW(TAG, "Live stream unavailable, clients can still poll");
+        }
         
         ESP_LOGI(TAG, "REST server started on port %d", REST_SERVER_PORT);
         return ESP_OK;
@@ -293,6 +1115,7 @@ esp_err_t rest_server_start(void)
 esp_err_t rest_server_stop(void)
 {
     if (server != NULL) {
+        live_stream_stop();
         httpd_stop(server);
         server = NULL;
         ESP_LOGI(TAG, "REST server stopped");
@@ -304,7 +1127,6 @@ esp_err_t rest_server_stop(void)
 void rest_server_deinit(void)
 {
     rest_server_stop();
-    temp_sensor = NULL;
-    pwm_controller = NULL;
+    heater = NULL;
     ESP_LOGI(TAG, "REST server deinitialized");
 }
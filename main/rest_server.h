@@ -8,8 +8,7 @@
 
 #include "esp_err.h"
 #include "esp_http_server.h"
-#include "max6675.h"
-#include "mosfet_pwm.h"
+#include "hal_actuator.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,10 +16,14 @@ extern "C" {
 
 // Server configuration
 #define REST_SERVER_PORT 80
-#define REST_SERVER_MAX_URI_HANDLERS 8
+#define REST_SERVER_MAX_URI_HANDLERS 24
+#define REST_SERVER_MAX_OPEN_SOCKETS 12   // LIVE_STREAM_MAX_CLIENTS + 2; needs CONFIG_LWIP_MAX_SOCKETS >= 15
+#define REST_SERVER_SEND_TIMEOUT_S   2
+#define REST_JSON_BUFFER_SIZE        512  // Per-request stack buffer, larger responses go out chunked
+#define REST_PROFILE_BODY_SIZE       1536 // PROFILE_MAX_SEGMENTS segments with some whitespace
 
 // Function prototypes
-esp_err_t rest_server_init(max6675_handle_t *temp_sensor, mosfet_pwm_handle_t *pwm_controller);
+esp_err_t rest_server_init(const hal_actuator_t *heater);
 esp_err_t rest_server_start(void);
 esp_err_t rest_server_stop(void);
 void rest_server_deinit(void);
@@ -0,0 +1,255 @@
+/*
+ * Heater Safety Supervisor Implementation
+ */
+
+#include <inttypes.h>
+#include "safety.h"
+#include "temp_sampler.h"
+#include "control_task.h"
+#include "recorder.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SAFETY";
+
+static TaskHandle_t s_task_handle = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Protected by s_lock
+static safety_status_t s_status;
+static bool s_ack_requested;
+static int64_t s_test_requested_us;     // 0: none
+
+// Supervisor task only
+static const hal_actuator_t *s_heater = NULL;
+static interlock_t s_interlock;
+
+// Function prototypes
+static void safety_task(void *arg);
+
+static void read_inputs(interlock_reading_t *readings, size_t *count)
+{
+    temp_sample_t samples[INTERLOCK_MAX_CHANNELS];
+
+    // Never the spinning read: this task preempts the sampler on its core, so
+    // a publish in progress counts as no new reading until the next wake
+    temp_sampler_try_get_all(samples, INTERLOCK_MAX_CHANNELS, count);
+    for (size_t i = 0; i < *count; i++) {
+        readings[i] = (interlock_reading_t) {
+            .temperature = samples[i].temperature,
+            .timestamp_us = samples[i].timestamp_us,
+            .sequence = samples[i].sequence,
+            .valid = samples[i].status == ESP_OK,
+            .open = samples[i].fault != 0,
+        };
+    }
+}
+
+// Everything after the cutoff: the heater is already off when this runs
+static void report_trip(uint32_t found, uint32_t latched, bool cut, uint32_t latency_us)
+{
+    for (uint32_t i = 0; i < INTERLOCK_FAULT_COUNT; i++) {
+        if (found & (1u << i)) {
+            metrics_count((metrics_counter_t)(METRICS_SAFETY_STALE + i));
+            DLOGE(TAG, "Interlock tripped: %s", interlock_fault_name(1u << i));
+        }
+    }
+    recorder_event(RECORDER_EVENT_INTERLOCK, (float)latched);
+
+    if (cut) {
+        metrics_observe(METRICS_SAFETY_CUTOFF, latency_us);
+        DLOGE(TAG, "Heater cut off %" PRIu32 " us after detection, acknowledge to resume", latency_us);
+
+        // Nothing resumes heating on its own after the acknowledge
+        if (control_task_is_running()) {
+            control_task_set_manual_power(0.0f);
+        }
+    }
+}
+
+static void acknowledge(void)
+{
+    if (interlock_acknowledge(&s_interlock) != ESP_OK) {
+        DLOGW(TAG, "Acknowledge refused, fault condition present again");
+        return;
+    }
+
+    if (control_task_is_running()) {
+        control_task_set_manual_power(0.0f);
+    }
+    esp_err_t ret = hal_actuator_inhibit(s_heater, false);
+    if (ret != ESP_OK) {
+        DLOGE(TAG, "Failed to release the cutoff: %s", esp_err_to_name(ret));
+    }
+    recorder_event(RECORDER_EVENT_INTERLOCK, 0.0f);
+    DLOGI(TAG, "Interlock acknowledged, heater enabled in manual at 0%%");
+}
+
+static void safety_task(void *arg)
+{
+    const TickType_t period_ticks = pdMS_TO_TICKS(SAFETY_CHECK_PERIOD_MS);
+    interlock_reading_t readings[INTERLOCK_MAX_CHANNELS];
+
+    while (1) {
+        // Woken by every published reading, or by the period when there is none
+        ulTaskNotifyTake(pdTRUE, period_ticks);
+
+        size_t count = 0;
+        read_inputs(readings, &count);
+        float duty = (float)hal_actuator_get_duty(s_heater, 0) / (float)s_heater->max_duty;
+        int64_t now_us = esp_timer_get_time();
+
+        portENTER_CRITICAL(&s_lock);
+        int64_t test_us = s_test_requested_us;
+        bool ack = s_ack_requested;
+        s_test_requested_us = 0;
+        s_ack_requested = false;
+        portEXIT_CRITICAL(&s_lock);
+
+        bool was_tripped = (s_interlock.latched != 0);
+        int64_t detected_us;
+        uint32_t found = interlock_check(&s_interlock, readings, count, duty, now_us, &detected_us);
+        if (test_us != 0 && interlock_trip(&s_interlock, INTERLOCK_FAULT_TEST)) {
+            detected_us = (found != 0 && detected_us < test_us) ? detected_us : test_us;
+            found |= INTERLOCK_FAULT_TEST;
+        }
+
+        // The cutoff comes first; bookkeeping and logging only after the heater is off
+        bool cut = (found != 0 && !was_tripped);
+        int64_t off_us = 0;
+        esp_err_t ret = ESP_OK;
+        if (cut) {
+            ret = hal_actuator_inhibit(s_heater, true);
+            off_us = esp_timer_get_time();
+        }
+        uint32_t latency_us = (off_us > detected_us) ? (uint32_t)(off_us - detected_us) : 0;
+
+        if (found != 0) {
+            report_trip(found, s_interlock.latched, cut, latency_us);
+            if (ret != ESP_OK) {
+                DLOGE(TAG, "Cutoff reported %s", esp_err_to_name(ret));
+            }
+        } else if (ack) {
+            acknowledge();
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_status.tripped = (s_interlock.latched != 0);
+        s_status.faults = s_interlock.latched;
+        s_status.active = s_interlock.active;
+        s_status.checks++;
+        if (cut) {
+            s_status.trips++;
+            s_status.last_trip_faults = found;
+            s_status.tripped_us = off_us;
+            s_status.last_latency_us = latency_us;
+            if (latency_us > s_status.worst_latency_us) {
+                s_status.worst_latency_us = latency_us;
+            }
+        }
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t safety_start(const hal_actuator_t *heater, size_t channels)
+{
+    if (heater == NULL || channels == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const interlock_config_t config = INTERLOCK_CONFIG_DEFAULT();
+    const plant_params_t model = PLANT_PARAMS_DEFAULT();
+    size_t checked = channels < INTERLOCK_MAX_CHANNELS ? channels : INTERLOCK_MAX_CHANNELS;
+    esp_err_t ret = interlock_init(&s_interlock, &config, &model, checked);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_heater = heater;
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? SAFETY_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(safety_task, "safety", SAFETY_STACK_SIZE,
+                                                 NULL, SAFETY_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create supervisor task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    temp_sampler_set_listener(s_task_handle);
+
+    portENTER_CRITICAL(&s_lock);
+    s_status.running = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Supervising %u channel(s): cutoff above %.0f°C, above %.1f°C/s, "
+             "no reading for %d ms or no response to heating",
+             (unsigned)checked, config.max_temp_c, config.max_rise_c_per_s, (int)config.sample_max_age_ms);
+    return ESP_OK;
+}
+
+// Accepted only once every condition has cleared; the supervisor task
+// then releases the cutoff, so a trip racing the request still wins
+esp_err_t safety_acknowledge(void)
+{
+    if (s_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    bool allowed = s_status.tripped && s_status.active == 0;
+    if (allowed) {
+        s_ack_requested = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!allowed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(s_task_handle);
+    return ESP_OK;
+}
+
+esp_err_t safety_test(void)
+{
+    if (s_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+    portENTER_CRITICAL(&s_lock);
+    bool allowed = !s_status.tripped;
+    if (allowed) {
+        s_test_requested_us = now_us;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!allowed) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotifyGive(s_task_handle);
+    return ESP_OK;
+}
+
+bool safety_is_tripped(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    bool tripped = s_status.tripped;
+    portEXIT_CRITICAL(&s_lock);
+    return tripped;
+}
+
+void safety_get_status(safety_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
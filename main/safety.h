@@ -0,0 +1,65 @@
+/*
+ * Heater Safety Supervisor
+ *
+ * Runs the interlock checks (interlock.h) in the highest-priority task,
+ * woken by the sampler on every published reading and at least every
+ * SAFETY_CHECK_PERIOD_MS otherwise, so a stopped sampler is caught too.
+ * A trip cuts the heater off through hal_actuator_inhibit(), which on the
+ * MOSFET driver stops the LEDC channels directly: it does not go through
+ * the control task, the HTTP server or the driver's write lock. The
+ * control loop is then put in manual at 0% so nothing resumes heating on
+ * its own.
+ *
+ * The cutoff stays latched until acknowledged (POST /api/safety), which is
+ * refused while a condition is still present; the loop stays in manual at
+ * 0% after that. The time from a condition becoming observable to the
+ * heater being off is recorded per trip (safety_cutoff_seconds in
+ * /api/metrics, worst case in the status). safety_test() trips on purpose
+ * to prove the path.
+ */
+
+#ifndef SAFETY_H
+#define SAFETY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "hal_actuator.h"
+#include "interlock.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Task Configuration
+#define SAFETY_CHECK_PERIOD_MS    50      // Longest wait between checks without a new reading
+#define SAFETY_STACK_SIZE         3072
+#define SAFETY_PRIORITY           (configMAX_PRIORITIES - 1)  // Above the sampler and the control task
+#define SAFETY_CORE               1       // With the sampler, which wakes it
+
+typedef struct {
+    bool running;
+    bool tripped;                   // Heater held off until acknowledged
+    uint32_t faults;                // Latched INTERLOCK_FAULT_* bits
+    uint32_t active;                // Conditions still present
+    uint32_t trips;                 // Since boot
+    uint32_t last_trip_faults;      // Faults of the latest trip
+    int64_t tripped_us;             // esp_timer time of the latest cutoff
+    uint32_t last_latency_us;       // Condition observable to heater off, latest trip
+    uint32_t worst_latency_us;      // Same, worst since boot
+    uint32_t checks;                // Since boot
+} safety_status_t;
+
+// Function prototypes
+esp_err_t safety_start(const hal_actuator_t *heater, size_t channels);
+esp_err_t safety_acknowledge(void);
+esp_err_t safety_test(void);
+bool safety_is_tripped(void);
+void safety_get_status(safety_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SAFETY_H
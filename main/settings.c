@@ -0,0 +1,411 @@
+/*
+ * Settings Store Implementation
+ */
+
+#include <math.h>
+#include <string.h>
+#include "settings.h"
+#include "control_task.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+static const char *TAG = "SETTINGS";
+
+// Stored by the gain-only store this replaced; imported once if nothing newer exists
+#define LEGACY_GAINS_NAMESPACE  "pid"
+#define LEGACY_GAINS_KEY        "gains"
+#define LEGACY_GAINS_VERSION    1
+
+typedef struct {
+    uint16_t version;
+    uint16_t size;              // Bytes of settings that follow
+} settings_header_t;
+
+typedef struct {
+    settings_header_t header;
+    settings_t settings;
+} settings_blob_t;
+
+_Static_assert(sizeof(settings_t) <= UINT16_MAX, "settings_t too large for the header");
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t s_task_handle = NULL;
+
+// Protected by s_lock
+static settings_t s_settings;
+static int64_t s_first_change_us;       // 0: nothing pending
+static int64_t s_last_change_us;
+static settings_status_t s_status;
+
+// init, then the writer task only
+static settings_t s_committed;          // What NVS holds
+static settings_blob_t s_blob;
+
+// Function prototypes
+static void settings_task(void *arg);
+
+static void settings_defaults(settings_t *settings)
+{
+    *settings = (settings_t) {
+        .gains = { CONTROL_DEFAULT_KP, CONTROL_DEFAULT_KI, CONTROL_DEFAULT_KD },
+        .control = { CONTROL_MODE_MANUAL, CONTROL_DEFAULT_SETPOINT, 0.0f },
+    };
+}
+
+// Falls back to the defaults section by section, so one bad field does not lose the rest
+static void settings_sanitize(settings_t *settings)
+{
+    settings_t defaults;
+    settings_defaults(&defaults);
+
+    const settings_gains_t *g = &settings->gains;
+    if (!(g->kp >= 0.0f && g->ki >= 0.0f && g->kd >= 0.0f && isfinite(g->kp) && isfinite(g->ki) && isfinite(g->kd))) {
+        settings->gains = defaults.gains;
+    }
+
+    const settings_control_t *c = &settings->control;
+    if ((c->mode != CONTROL_MODE_MANUAL && c->mode != CONTROL_MODE_AUTO) ||
+        !(c->setpoint >= 0.0f && c->setpoint <= CONTROL_MAX_SETPOINT) || !(c->power >= 0.0f && c->power <= 100.0f)) {
+        settings->control = defaults.control;
+    }
+
+    for (size_t i = 0; i < TEMP_SAMPLER_MAX_CHANNELS; i++) {
+        if (!(fabsf(settings->calibration.offset[i]) <= SETTINGS_MAX_OFFSET_C)) {
+            settings->calibration = defaults.calibration;
+            break;
+        }
+    }
+
+    settings->network.ssid[SETTINGS_SSID_MAX] = '\0';
+    settings->network.password[SETTINGS_PASSWORD_MAX] = '\0';
+
+    if (settings->profile.count > PROFILE_MAX_SEGMENTS) {
+        settings->profile = defaults.profile;
+    }
+}
+
+// Gains saved before the settings store existed
+static bool load_legacy_gains(settings_gains_t *gains)
+{
+    struct {
+        uint32_t version;
+        float kp;
+        float ki;
+        float kd;
+    } legacy;
+    size_t size = sizeof(legacy);
+    nvs_handle_t handle;
+
+    if (nvs_open(LEGACY_GAINS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t ret = nvs_get_blob(handle, LEGACY_GAINS_KEY, &legacy, &size);
+    nvs_close(handle);
+
+    if (ret != ESP_OK || size != sizeof(legacy) || legacy.version != LEGACY_GAINS_VERSION) {
+        return false;
+    }
+    *gains = (settings_gains_t) { legacy.kp, legacy.ki, legacy.kd };
+    return true;
+}
+
+// One read of the whole blob
+static esp_err_t settings_load(settings_t *settings)
+{
+    nvs_handle_t handle;
+    size_t size = sizeof(s_blob);
+    esp_err_t ret = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &handle);
+    if (ret == ESP_OK) {
+        ret = nvs_get_blob(handle, SETTINGS_KEY, &s_blob, &size);
+        nvs_close(handle);
+    }
+    if (ret == ESP_ERR_NVS_NOT_FOUND) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    const settings_header_t *header = &s_blob.header;
+    if (size < sizeof(*header) || header->version != SETTINGS_VERSION ||
+        header->size != size - sizeof(*header) || header->size > sizeof(settings_t)) {
+        ESP_LOGW(TAG, "Ignoring stored settings (version %u, %u bytes)", header->version, (unsigned)size);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    // An older, shorter layout leaves the newer fields at their defaults
+    memcpy(settings, &s_blob.settings, header->size);
+    return ESP_OK;
+}
+
+static esp_err_t settings_save(const settings_t *settings)
+{
+    nvs_handle_t handle;
+    esp_err_t ret = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_blob.header = (settings_header_t) { SETTINGS_VERSION, sizeof(settings_t) };
+    s_blob.settings = *settings;
+    ret = nvs_set_blob(handle, SETTINGS_KEY, &s_blob, sizeof(s_blob));
+    if (ret == ESP_OK) {
+        ret = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return ret;
+}
+
+// Marks the settings dirty from now; caller holds s_lock
+static void mark_pending_locked(int64_t now_us)
+{
+    if (s_first_change_us == 0) {
+        s_first_change_us = now_us;
+    }
+    s_last_change_us = now_us;
+    s_status.pending = true;
+}
+
+esp_err_t settings_init(void)
+{
+    // Same recovery as wifi_init(); whichever runs first initializes NVS
+    esp_err_t ret = nvs_flash_init();
+    if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition reset");
+        ret = nvs_flash_erase();
+        if (ret == ESP_OK) {
+            ret = nvs_flash_init();
+        }
+    }
+
+    settings_t settings;
+    settings_defaults(&settings);
+    esp_err_t load_ret = (ret == ESP_OK) ? settings_load(&settings) : ret;
+    settings_sanitize(&settings);
+    s_committed = settings;
+
+    bool import = (load_ret == ESP_ERR_NOT_FOUND && load_legacy_gains(&settings.gains));
+    if (import) {
+        settings_sanitize(&settings);
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_settings = settings;
+    s_status = (settings_status_t) {
+        .loaded = (load_ret == ESP_OK),
+        .last_error = (load_ret == ESP_ERR_NOT_FOUND) ? ESP_OK : load_ret,
+    };
+    if (import) {
+        mark_pending_locked(esp_timer_get_time());
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (load_ret == ESP_OK) {
+        ESP_LOGI(TAG, "Settings loaded");
+    } else if (import) {
+        ESP_LOGI(TAG, "Imported PID gains from the previous store");
+    } else if (load_ret == ESP_ERR_NOT_FOUND) {
+        ESP_LOGI(TAG, "No stored settings, using defaults");
+    } else {
+        ESP_LOGW(TAG, "Stored settings unavailable (%s), using defaults", esp_err_to_name(load_ret));
+    }
+    return ret;
+}
+
+esp_err_t settings_start(void)
+{
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? SETTINGS_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(settings_task, "settings", SETTINGS_STACK_SIZE, NULL,
+                                                 SETTINGS_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Changes made before the task existed (the legacy import) still get their commit
+    xTaskNotifyGive(s_task_handle);
+    return ESP_OK;
+}
+
+void settings_get(settings_t *settings)
+{
+    if (settings == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *settings = s_settings;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void settings_get_status(settings_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+// Copies value over field (a member of s_settings) and schedules a commit if it differs
+static void update(void *field, const void *value, size_t size)
+{
+    const int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    bool changed = (memcmp(field, value, size) != 0);
+    if (changed) {
+        memcpy(field, value, size);
+        mark_pending_locked(now_us);
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (changed && s_task_handle != NULL) {
+        xTaskNotifyGive(s_task_handle);
+    }
+}
+
+void settings_set_gains(float kp, float ki, float kd)
+{
+    settings_gains_t gains = { kp, ki, kd };
+    update(&s_settings.gains, &gains, sizeof(gains));
+}
+
+static settings_control_t get_control(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    settings_control_t control = s_settings.control;
+    portEXIT_CRITICAL(&s_lock);
+    return control;
+}
+
+// Automatic mode at setpoint; the manual power is kept for a later switch back
+void settings_set_setpoint(float setpoint)
+{
+    settings_control_t control = get_control();
+    control.mode = CONTROL_MODE_AUTO;
+    control.setpoint = setpoint;
+    update(&s_settings.control, &control, sizeof(control));
+}
+
+void settings_set_manual_power(float power)
+{
+    settings_control_t control = get_control();
+    control.mode = CONTROL_MODE_MANUAL;
+    control.power = power;
+    update(&s_settings.control, &control, sizeof(control));
+}
+
+void settings_set_offsets(const float *offsets, size_t count)
+{
+    settings_calibration_t calibration = { 0 };
+    if (offsets != NULL) {
+        for (size_t i = 0; i < count && i < TEMP_SAMPLER_MAX_CHANNELS; i++) {
+            calibration.offset[i] = offsets[i];
+        }
+    }
+    update(&s_settings.calibration, &calibration, sizeof(calibration));
+}
+
+void settings_set_network(const char *ssid, const char *password)
+{
+    settings_network_t network = { 0 };
+    if (ssid != NULL) {
+        strncpy(network.ssid, ssid, SETTINGS_SSID_MAX);
+    }
+    if (password != NULL) {
+        strncpy(network.password, password, SETTINGS_PASSWORD_MAX);
+    }
+    update(&s_settings.network, &network, sizeof(network));
+}
+
+void settings_set_profile(const profile_segment_t *segments, size_t count)
+{
+    settings_profile_t profile = { 0 };
+    if (segments != NULL && count <= PROFILE_MAX_SEGMENTS) {
+        profile.count = (uint32_t)count;
+        memcpy(profile.segments, segments, count * sizeof(segments[0]));
+    }
+    update(&s_settings.profile, &profile, sizeof(profile));
+}
+
+// Writes the current settings unless NVS already holds them
+static void settings_commit(void)
+{
+    settings_t snapshot;
+
+    portENTER_CRITICAL(&s_lock);
+    snapshot = s_settings;
+    s_first_change_us = 0;
+    s_status.pending = false;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (memcmp(&snapshot, &s_committed, sizeof(snapshot)) == 0) {
+        portENTER_CRITICAL(&s_lock);
+        s_status.skipped++;
+        portEXIT_CRITICAL(&s_lock);
+        return;
+    }
+
+    esp_err_t ret = settings_save(&snapshot);
+
+    portENTER_CRITICAL(&s_lock);
+    s_status.last_error = ret;
+    if (ret == ESP_OK) {
+        s_status.commits++;
+    } else {
+        mark_pending_locked(esp_timer_get_time());  // Retried after the debounce time
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (ret == ESP_OK) {
+        s_committed = snapshot;
+        DLOGI(TAG, "Settings saved");
+    } else {
+        DLOGE(TAG, "Failed to save settings: %s", esp_err_to_name(ret));
+    }
+}
+
+static void settings_task(void *arg)
+{
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        portENTER_CRITICAL(&s_lock);
+        int64_t first_us = s_first_change_us;
+        int64_t last_us = s_last_change_us;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (first_us == 0) {
+            wait = portMAX_DELAY;
+            continue;
+        }
+
+        // Due when quiet for the debounce time, or when the oldest change has waited long enough
+        int64_t due_us = last_us + SETTINGS_DEBOUNCE_MS * 1000LL;
+        if (due_us > first_us + SETTINGS_MAX_DELAY_MS * 1000LL) {
+            due_us = first_us + SETTINGS_MAX_DELAY_MS * 1000LL;
+        }
+        int64_t now_us = esp_timer_get_time();
+        if (now_us < due_us) {
+            wait = pdMS_TO_TICKS((due_us - now_us) / 1000) + 1;
+            continue;
+        }
+
+        settings_commit();
+        wait = 0;  // Look again: a change may have come in during the write
+    }
+}
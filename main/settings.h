@@ -0,0 +1,109 @@
+/*
+ * Settings Store
+ *
+ * Everything that survives a reboot: PID gains, the last setpoint and
+ * manual power, the last uploaded profile, thermocouple calibration
+ * offsets and the WiFi credentials. The settings live in RAM; setters
+ * only update that copy (under a spinlock, no flash access) and wake a
+ * low-priority writer task. The writer waits until the settings have been
+ * quiet for SETTINGS_DEBOUNCE_MS, or at most SETTINGS_MAX_DELAY_MS after
+ * the first unsaved change, and commits them as one NVS blob, skipping
+ * the write if nothing differs from what is already stored. A slider
+ * dragged for a minute costs one flash write instead of hundreds, and no
+ * NVS erase/write ever runs in the control or HTTP server tasks.
+ *
+ * The blob starts with a version and its size. Fields are only ever
+ * appended: a shorter blob of the same version is loaded and the new
+ * fields keep their defaults; a different version is ignored. Boot reads
+ * the whole blob in one nvs_get_blob().
+ */
+
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "controller.h"
+#include "profile.h"
+#include "temp_sampler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SETTINGS_NAMESPACE        "settings"
+#define SETTINGS_KEY              "v"
+#define SETTINGS_VERSION          1
+#define SETTINGS_DEBOUNCE_MS      5000    // Quiet time after the last change
+#define SETTINGS_MAX_DELAY_MS     60000   // Longest an unsaved change waits
+#define SETTINGS_STACK_SIZE       3072
+#define SETTINGS_PRIORITY         (tskIDLE_PRIORITY + 1)
+#define SETTINGS_CORE             0       // Away from the control task
+#define SETTINGS_RESUME_OUTPUT    false   // Boot into the saved mode/power instead of heater off
+
+#define SETTINGS_MAX_OFFSET_C     20.0f   // Largest calibration offset accepted
+#define SETTINGS_SSID_MAX         32
+#define SETTINGS_PASSWORD_MAX     64
+
+typedef struct {
+    float kp;
+    float ki;
+    float kd;
+} settings_gains_t;
+
+typedef struct {
+    uint32_t mode;                      // control_mode_t
+    float setpoint;                     // °C
+    float power;                        // Manual power (%)
+} settings_control_t;
+
+typedef struct {
+    float offset[TEMP_SAMPLER_MAX_CHANNELS];    // °C added to each channel's reading
+} settings_calibration_t;
+
+typedef struct {
+    char ssid[SETTINGS_SSID_MAX + 1];           // Empty: compiled-in WIFI_SSID
+    char password[SETTINGS_PASSWORD_MAX + 1];
+} settings_network_t;
+
+typedef struct {
+    uint32_t count;                     // 0: none stored
+    profile_segment_t segments[PROFILE_MAX_SEGMENTS];
+} settings_profile_t;
+
+// Append new fields at the end only (see above)
+typedef struct {
+    settings_gains_t gains;
+    settings_control_t control;
+    settings_calibration_t calibration;
+    settings_network_t network;
+    settings_profile_t profile;
+} settings_t;
+
+typedef struct {
+    bool loaded;                        // Settings came from NVS, not the defaults
+    bool pending;                       // Changes not yet committed
+    uint32_t commits;                   // Blobs written since boot
+    uint32_t skipped;                   // Commits avoided because nothing differed
+    esp_err_t last_error;
+} settings_status_t;
+
+// Function prototypes
+esp_err_t settings_init(void);
+esp_err_t settings_start(void);
+void settings_get(settings_t *settings);
+void settings_get_status(settings_status_t *status);
+void settings_set_gains(float kp, float ki, float kd);
+void settings_set_setpoint(float setpoint);
+void settings_set_manual_power(float power);
+void settings_set_offsets(const float *offsets, size_t count);
+void settings_set_network(const char *ssid, const char *password);
+void settings_set_profile(const profile_segment_t *segments, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SETTINGS_H
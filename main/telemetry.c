@@ -0,0 +1,120 @@
+/*
+ * Telemetry Ring Buffer Implementation
+ */
+
+#include <stdatomic.h>
+#include "telemetry.h"
+
+// Written only by the producer; s_head publishes each record with release ordering
+static telemetry_record_t s_ring[TELEMETRY_CAPACITY];
+static atomic_uint s_head = 0;
+static atomic_uint s_last_timestamp_ms = 0;
+static int64_t s_prev_timestamp_us = -1;
+
+static int32_t clamp_i32(int32_t value, int32_t min, int32_t max)
+{
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+static int32_t sign_extend(uint32_t value, unsigned bits)
+{
+    uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+static uint32_t pack_term(int16_t term, unsigned bits)
+{
+    int32_t limit = (1 << (bits - 1)) - 1;
+    int32_t scaled = clamp_i32(term / TELEMETRY_TERM_LSB, -limit - 1, limit);
+    return (uint32_t)scaled & ((1u << bits) - 1);
+}
+
+telemetry_record_t telemetry_pack(const telemetry_sample_t *sample)
+{
+    uint32_t dt = (sample->dt_ms + TELEMETRY_DT_LSB_MS / 2) / TELEMETRY_DT_LSB_MS;
+    if (dt > 127) dt = 127;
+
+    telemetry_record_t record;
+    record.w0 = (sample->fault ? 1u : 0u)
+              | (dt << 1)
+              | ((uint32_t)(sample->temp_q2 & 0x0FFF) << 8)
+              | ((uint32_t)(sample->duty & 0x0FFF) << 20);
+    record.w1 = pack_term(sample->p_term, 11)
+              | (pack_term(sample->i_term, 11) << 11)
+              | (pack_term(sample->d_term, 10) << 22);
+    return record;
+}
+
+void telemetry_unpack(telemetry_record_t record, telemetry_sample_t *sample)
+{
+    sample->fault = record.w0 & 1u;
+    sample->dt_ms = ((record.w0 >> 1) & 0x7F) * TELEMETRY_DT_LSB_MS;
+    sample->temp_q2 = (record.w0 >> 8) & 0x0FFF;
+    sample->duty = (record.w0 >> 20) & 0x0FFF;
+    sample->p_term = sign_extend(record.w1 & 0x7FF, 11) * TELEMETRY_TERM_LSB;
+    sample->i_term = sign_extend((record.w1 >> 11) & 0x7FF, 11) * TELEMETRY_TERM_LSB;
+    sample->d_term = sign_extend((record.w1 >> 22) & 0x3FF, 10) * TELEMETRY_TERM_LSB;
+}
+
+void telemetry_push(const telemetry_sample_t *sample, int64_t timestamp_us)
+{
+    telemetry_sample_t stamped = *sample;
+    if (s_prev_timestamp_us < 0) {
+        stamped.dt_ms = 0;
+    } else {
+        int64_t dt_ms = (timestamp_us - s_prev_timestamp_us) / 1000;
+        stamped.dt_ms = (dt_ms > TELEMETRY_DT_MAX_MS) ? TELEMETRY_DT_MAX_MS : (uint16_t)dt_ms;
+    }
+    s_prev_timestamp_us = timestamp_us;
+
+    unsigned head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    s_ring[head % TELEMETRY_CAPACITY] = telemetry_pack(&stamped);
+
+    atomic_store_explicit(&s_last_timestamp_ms, (unsigned)(timestamp_us / 1000), memory_order_relaxed);
+    atomic_store_explicit(&s_head, head + 1, memory_order_release);
+}
+
+uint32_t telemetry_head(void)
+{
+    return atomic_load_explicit(&s_head, memory_order_acquire);
+}
+
+uint32_t telemetry_oldest(void)
+{
+    uint32_t head = telemetry_head();
+    // The slot of head - TELEMETRY_CAPACITY is the one the producer writes next
+    return (head >= TELEMETRY_CAPACITY) ? head - TELEMETRY_CAPACITY + 1 : 0;
+}
+
+uint32_t telemetry_last_timestamp_ms(void)
+{
+    return atomic_load_explicit(&s_last_timestamp_ms, memory_order_relaxed);
+}
+
+bool telemetry_read_record(uint32_t sequence, telemetry_record_t *record)
+{
+    uint32_t head = telemetry_head();
+    if (sequence >= head || head - sequence >= TELEMETRY_CAPACITY) {
+        return false;
+    }
+
+    *record = s_ring[sequence % TELEMETRY_CAPACITY];
+
+    // The producer overwrites this slot while publishing sequence + TELEMETRY_CAPACITY
+    atomic_thread_fence(memory_order_acquire);
+    head = atomic_load_explicit(&s_head, memory_order_relaxed);
+    return head - sequence < TELEMETRY_CAPACITY;
+}
+
+bool telemetry_read(uint32_t sequence, telemetry_sample_t *sample)
+{
+    telemetry_record_t record;
+    if (!telemetry_read_record(sequence, &record)) {
+        return false;
+    }
+
+    telemetry_unpack(record, sample);
+    return true;
+}
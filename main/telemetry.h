@@ -0,0 +1,65 @@
+/*
+ * Telemetry Ring Buffer
+ *
+ * Single-producer/multi-consumer history of the control loop. The control
+ * task pushes one packed 8-byte record per tick into a static ring in
+ * internal RAM; any number of readers fetch records by sequence number
+ * without locks. The producer never allocates or blocks.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ring Configuration
+#define TELEMETRY_CAPACITY        3840   // 30 KB of records, 16 min at 4 Hz
+#define TELEMETRY_DT_LSB_MS       8      // Timestamp delta resolution
+#define TELEMETRY_DT_MAX_MS       (127 * TELEMETRY_DT_LSB_MS)
+#define TELEMETRY_TERM_LSB        4      // PID term resolution in duty counts
+#define TELEMETRY_DUTY_FULL_SCALE 4095   // Duty and terms are recorded on a 12-bit scale
+
+// Packed record: two 32-bit words
+//   w0 [0]      sensor fault flag
+//   w0 [7:1]    time since previous record, TELEMETRY_DT_LSB_MS units (saturating)
+//   w0 [19:8]   temperature, 0.25°C units (MAX6675 resolution)
+//   w0 [31:20]  duty (12 bit, TELEMETRY_DUTY_FULL_SCALE)
+//   w1 [10:0]   P term, signed, TELEMETRY_TERM_LSB units
+//   w1 [21:11]  I term, signed, TELEMETRY_TERM_LSB units
+//   w1 [31:22]  D term, signed, TELEMETRY_TERM_LSB units
+typedef struct {
+    uint32_t w0;
+    uint32_t w1;
+} telemetry_record_t;
+
+// Unpacked sample
+typedef struct {
+    uint16_t dt_ms;          // Time since the previous record
+    uint16_t temp_q2;        // Temperature in 0.25°C units
+    uint16_t duty;           // Duty, TELEMETRY_DUTY_FULL_SCALE at 100%
+    int16_t p_term;          // PID terms on the same scale
+    int16_t i_term;
+    int16_t d_term;
+    bool fault;              // Sensor reading invalid for this tick
+} telemetry_sample_t;
+
+// Function prototypes
+void telemetry_push(const telemetry_sample_t *sample, int64_t timestamp_us);
+uint32_t telemetry_head(void);
+uint32_t telemetry_oldest(void);
+uint32_t telemetry_last_timestamp_ms(void);
+bool telemetry_read(uint32_t sequence, telemetry_sample_t *sample);
+bool telemetry_read_record(uint32_t sequence, telemetry_record_t *record);
+telemetry_record_t telemetry_pack(const telemetry_sample_t *sample);
+void telemetry_unpack(telemetry_record_t record, telemetry_sample_t *sample);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_H
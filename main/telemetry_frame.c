@@ -0,0 +1,105 @@
+/*
+ * Telemetry Datagrams Implementation
+ */
+
+#include <string.h>
+#include "telemetry_frame.h"
+
+_Static_assert(sizeof(telemetry_frame_header_t) == 32, "telemetry_frame_header_t is part of the wire format");
+_Static_assert(sizeof(telemetry_record_t) == 8, "telemetry_record_t is part of the wire format");
+
+// Starts at the newest record: history from before the stream is not sent
+void telemetry_frame_stream_init(telemetry_frame_stream_t *stream, uint32_t device_id, uint32_t session)
+{
+    *stream = (telemetry_frame_stream_t) {
+        .device_id = device_id,
+        .session = session,
+        .next = telemetry_head(),
+    };
+}
+
+// Head and the timestamp of the record before it, read as a pair
+static uint32_t snapshot(uint32_t *timestamp_ms)
+{
+    uint32_t head;
+    do {
+        head = telemetry_head();
+        *timestamp_ms = telemetry_last_timestamp_ms();
+    } while (telemetry_head() != head);
+    return head;
+}
+
+static uint32_t record_dt_ms(telemetry_record_t record)
+{
+    telemetry_sample_t sample;
+    telemetry_unpack(record, &sample);
+    return sample.dt_ms;
+}
+
+// Fills the frame with up to max_records unsent records; returns its size in bytes, 0 if nothing is new
+size_t telemetry_frame_build(telemetry_frame_stream_t *stream, telemetry_frame_t *frame, size_t max_records,
+                             uint16_t setpoint_q2)
+{
+    if (max_records > TELEMETRY_FRAME_MAX_RECORDS) {
+        max_records = TELEMETRY_FRAME_MAX_RECORDS;
+    }
+
+    for (;;) {
+        uint32_t timestamp_ms;
+        uint32_t head = snapshot(&timestamp_ms);
+        uint32_t oldest = telemetry_oldest();
+        if (stream->next < oldest) {
+            stream->overwritten += oldest - stream->next;
+            stream->next = oldest;
+        }
+        if (stream->next >= head || max_records == 0) {
+            return 0;
+        }
+
+        uint32_t count = head - stream->next;
+        if (count > max_records) {
+            count = (uint32_t)max_records;
+        }
+
+        bool complete = true;
+        for (uint32_t i = 0; i < count && complete; i++) {
+            complete = telemetry_read_record(stream->next + i, &frame->records[i]);
+        }
+
+        // The last record's time is the head timestamp less the intervals of the records after it
+        uint32_t after_ms = 0;
+        for (uint32_t seq = stream->next + count; seq < head && complete; seq++) {
+            telemetry_record_t record;
+            complete = telemetry_read_record(seq, &record);
+            after_ms += record_dt_ms(record);
+        }
+        if (!complete) {
+            continue;  // Overwritten while reading: start again from the oldest
+        }
+
+        frame->header = (telemetry_frame_header_t) {
+            .magic = TELEMETRY_FRAME_MAGIC,
+            .version = TELEMETRY_FRAME_VERSION,
+            .header_size = sizeof(telemetry_frame_header_t),
+            .count = (uint16_t)count,
+            .device_id = stream->device_id,
+            .session = stream->session,
+            .datagram_seq = stream->datagram_seq,
+            .first_seq = stream->next,
+            .timestamp_ms = timestamp_ms - after_ms,
+            .setpoint_q2 = setpoint_q2,
+        };
+        return telemetry_frame_size(&frame->header);
+    }
+}
+
+void telemetry_frame_commit(telemetry_frame_stream_t *stream, const telemetry_frame_t *frame)
+{
+    stream->next = frame->header.first_seq + frame->header.count;
+    stream->datagram_seq++;
+}
+
+size_t telemetry_frame_size(const telemetry_frame_header_t *header)
+{
+    return header->header_size + (size_t)header->count * sizeof(telemetry_record_t);
+}
@@ -0,0 +1,70 @@
+/*
+ * Telemetry Datagrams
+ *
+ * Fixed-layout, versioned frames of telemetry ring records for the UDP
+ * publisher (udp_telemetry.h) and its host receiver. A frame is a
+ * telemetry_frame_header_t followed by `count` packed telemetry records
+ * (telemetry.h), little-endian as on the ESP32.
+ *
+ * A stream walks the ring by sequence number. Every frame carries the
+ * telemetry sequence of its first record, so a receiver tells records lost
+ * in the network (datagram_seq gap) from records the ring overwrote before
+ * they could be sent (first_seq gap with consecutive datagrams). Building
+ * a frame does not move the stream; telemetry_frame_commit() does, after
+ * the frame was sent, so a failed send is retried with the same records.
+ */
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "telemetry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_FRAME_MAGIC        0x55435054  // "TPCU"
+#define TELEMETRY_FRAME_VERSION      1
+#define TELEMETRY_FRAME_MAX_RECORDS  64          // 544 bytes, one unfragmented datagram
+
+typedef struct {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t header_size;        // Bytes before the first record
+    uint16_t count;             // Records that follow
+    uint32_t device_id;         // Low 32 bits of the station MAC
+    uint32_t session;           // Random per boot
+    uint32_t datagram_seq;      // Per session, from 0
+    uint32_t first_seq;         // Telemetry sequence of the first record
+    uint32_t timestamp_ms;      // Uptime of the last record
+    uint16_t setpoint_q2;       // Setpoint when the frame was built, 0.25°C units
+    uint16_t reserved;
+} telemetry_frame_header_t;
+
+typedef struct {
+    telemetry_frame_header_t header;
+    telemetry_record_t records[TELEMETRY_FRAME_MAX_RECORDS];
+} telemetry_frame_t;
+
+typedef struct {
+    uint32_t device_id;
+    uint32_t session;
+    uint32_t datagram_seq;      // Of the next frame
+    uint32_t next;              // Telemetry sequence of the next record to send
+    uint32_t overwritten;       // Records the ring dropped before they were sent
+} telemetry_frame_stream_t;
+
+// Function prototypes
+void telemetry_frame_stream_init(telemetry_frame_stream_t *stream, uint32_t device_id, uint32_t session);
+size_t telemetry_frame_build(telemetry_frame_stream_t *stream, telemetry_frame_t *frame, size_t max_records,
+                             uint16_t setpoint_q2);
+void telemetry_frame_commit(telemetry_frame_stream_t *stream, const telemetry_frame_t *frame);
+size_t telemetry_frame_size(const telemetry_frame_header_t *header);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TELEMETRY_FRAME_H
@@ -0,0 +1,261 @@
+/*
+ * Temperature Sampler Implementation
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+#include "temp_sampler.h"
+#include "esp_log.h"
+#include "metrics.h"
+#include "boot_timeline.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "TEMP_SAMPLER";
+
+static TaskHandle_t s_task_handle = NULL;
+static volatile bool s_running = false;
+static const hal_sensor_t *s_temp_sensor = NULL;
+static size_t s_channel_count = 0;
+static TaskHandle_t volatile s_listener = NULL;   // Notified after every publish
+
+// Seqlock: odd while the single writer is updating s_samples
+static atomic_uint s_seqlock = 0;
+static temp_sample_t s_samples[TEMP_SAMPLER_MAX_CHANNELS];
+
+// Calibration, °C added to each channel; protected by s_offset_lock
+static portMUX_TYPE s_offset_lock = portMUX_INITIALIZER_UNLOCKED;
+static float s_offsets[TEMP_SAMPLER_MAX_CHANNELS];
+
+static void publish_samples(const temp_sample_t *samples, size_t count)
+{
+    unsigned seq = atomic_load_explicit(&s_seqlock, memory_order_relaxed);
+
+    atomic_store_explicit(&s_seqlock, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(s_samples, samples, count * sizeof(s_samples[0]));
+
+    atomic_store_explicit(&s_seqlock, seq + 2, memory_order_release);
+}
+
+// Copies channels [first, first + count) consistently, giving up after
+// attempts tries (0: never). A reader that can preempt the sampler on its
+// core must give up, or it spins while the writer it waits for cannot run.
+static bool read_samples_bounded(size_t first, temp_sample_t *samples, size_t count, uint32_t attempts)
+{
+    for (uint32_t n = 0; attempts == 0 || n < attempts; n++) {
+        unsigned begin = atomic_load_explicit(&s_seqlock, memory_order_acquire);
+        if (begin & 1) {
+            continue;  // Writer in progress
+        }
+        memcpy(samples, &s_samples[first], count * sizeof(s_samples[0]));
+        atomic_thread_fence(memory_order_acquire);
+        unsigned end = atomic_load_explicit(&s_seqlock, memory_order_relaxed);
+        if (begin == end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Readers below the sampler's priority, or on the other core
+static void read_samples(size_t first, temp_sample_t *samples, size_t count)
+{
+    read_samples_bounded(first, samples, count, 0);
+}
+
+static void temp_sampler_task(void *arg)
+{
+    const TickType_t period_ticks = pdMS_TO_TICKS(TEMP_SAMPLER_PERIOD_MS);
+    TickType_t last_wake = xTaskGetTickCount();
+    uint32_t sequence = 0;
+    temp_sample_t samples[TEMP_SAMPLER_MAX_CHANNELS];
+    hal_sensor_reading_t readings[TEMP_SAMPLER_MAX_CHANNELS];
+    float offsets[TEMP_SAMPLER_MAX_CHANNELS];
+
+    while (s_running) {
+        memset(readings, 0, s_channel_count * sizeof(readings[0]));
+
+        // All channels in one pass; per-channel status covers partial failures
+        esp_err_t ret = hal_sensor_read(s_temp_sensor, readings, s_channel_count);
+        int64_t now_us = esp_timer_get_time();
+        sequence++;
+
+        portENTER_CRITICAL(&s_offset_lock);
+        memcpy(offsets, s_offsets, sizeof(offsets));
+        portEXIT_CRITICAL(&s_offset_lock);
+
+        for (size_t i = 0; i < s_channel_count; i++) {
+            const hal_sensor_reading_t *reading = &readings[i];
+            bool has_status = (ret == ESP_OK) || (reading->status != ESP_OK);
+            samples[i] = (temp_sample_t) {
+                .temperature = reading->temperature + offsets[i],
+                .raw = reading->raw,
+                .fault = reading->fault,
+                .status = has_status ? reading->status : ret,
+                .timestamp_us = reading->timestamp_us ? reading->timestamp_us : now_us,
+                .sequence = sequence,
+            };
+            if (samples[i].status == ESP_ERR_INVALID_RESPONSE || samples[i].fault) {
+                metrics_count(METRICS_SENSOR_FAULT_OPEN);
+            } else if (samples[i].status != ESP_OK) {
+                metrics_count(METRICS_SENSOR_FAULT_BUS);
+            }
+        }
+
+        publish_samples(samples, s_channel_count);
+        TaskHandle_t listener = s_listener;
+        if (listener != NULL) {
+            xTaskNotifyGive(listener);
+        }
+        if (sequence == 1) {
+            boot_timeline_mark(BOOT_PHASE_FIRST_SAMPLE);
+        }
+
+        // Reading faster than the conversion time would restart the conversion
+        xTaskDelayUntil(&last_wake, period_ticks);
+    }
+
+    s_task_handle = NULL;
+    vTaskDelete(NULL);
+}
+
+esp_err_t temp_sampler_start(const hal_sensor_t *temp_sensor)
+{
+    if (temp_sensor == NULL) {
+        ESP_LOGE(TAG, "Handle is NULL");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_task_handle != NULL) {
+        ESP_LOGW(TAG, "Sampler already running");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_temp_sensor = temp_sensor;
+    s_channel_count = temp_sensor->channels;
+    if (s_channel_count > TEMP_SAMPLER_MAX_CHANNELS) {
+        ESP_LOGW(TAG, "Sensor has %u channels, sampling the first %d",
+                 (unsigned)s_channel_count, TEMP_SAMPLER_MAX_CHANNELS);
+        s_channel_count = TEMP_SAMPLER_MAX_CHANNELS;
+    }
+    s_running = true;
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? TEMP_SAMPLER_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(temp_sampler_task, "temp_sampler", TEMP_SAMPLER_STACK_SIZE,
+                                                 NULL, TEMP_SAMPLER_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create sampler task");
+        s_running = false;
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Sampler started on %s (%u channels), period %d ms",
+             temp_sensor->name, (unsigned)s_channel_count, TEMP_SAMPLER_PERIOD_MS);
+    return ESP_OK;
+}
+
+esp_err_t temp_sampler_stop(void)
+{
+    if (s_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    s_running = false;
+    while (s_task_handle != NULL) {
+        vTaskDelay(pdMS_TO_TICKS(TEMP_SAMPLER_PERIOD_MS));
+    }
+
+    ESP_LOGI(TAG, "Sampler stopped");
+    return ESP_OK;
+}
+
+esp_err_t temp_sampler_get_latest(temp_sample_t *sample)
+{
+    return temp_sampler_get_channel(0, sample);
+}
+
+esp_err_t temp_sampler_get_channel(size_t channel, temp_sample_t *sample)
+{
+    if (sample == NULL || channel >= TEMP_SAMPLER_MAX_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    read_samples(channel, sample, 1);
+
+    if (sample->sequence == 0) {
+        return ESP_ERR_INVALID_STATE;  // Nothing published yet, or no such channel
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t temp_sampler_get_all(temp_sample_t *samples, size_t max_samples, size_t *count)
+{
+    if (samples == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t n = s_channel_count < max_samples ? s_channel_count : max_samples;
+    *count = 0;
+    if (n == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    read_samples(0, samples, n);
+
+    if (samples[0].sequence == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *count = n;
+    return ESP_OK;
+}
+
+// For readers that can preempt the sampler (the safety supervisor):
+// ESP_ERR_TIMEOUT if a publish was in progress, try again on the next wake
+esp_err_t temp_sampler_try_get_all(temp_sample_t *samples, size_t max_samples, size_t *count)
+{
+    if (samples == NULL || count == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    size_t n = s_channel_count < max_samples ? s_channel_count : max_samples;
+    *count = 0;
+    if (n == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (!read_samples_bounded(0, samples, n, TEMP_SAMPLER_TRY_ATTEMPTS)) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    if (samples[0].sequence == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    *count = n;
+    return ESP_OK;
+}
+
+// Applied from the next read on
+void temp_sampler_set_offsets(const float *offsets, size_t count)
+{
+    if (offsets == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_offset_lock);
+    for (size_t i = 0; i < TEMP_SAMPLER_MAX_CHANNELS; i++) {
+        s_offsets[i] = (i < count) ? offsets[i] : 0.0f;
+    }
+    portEXIT_CRITICAL(&s_offset_lock);
+}
+
+void temp_sampler_set_listener(TaskHandle_t task)
+{
+    s_listener = task;
+}
@@ -0,0 +1,57 @@
+/*
+ * Temperature Sampler
+ *
+ * Single owner of the temperature sensor (the MAX6675 SPI bus on
+ * hardware). A dedicated task reads every channel once per conversion and
+ * publishes the results through a seqlock, so HTTP, logging and control
+ * read the latest samples in O(1) without touching the bus. Channel 0 is
+ * the control thermocouple. One listener task (the safety supervisor) can
+ * be notified of every publish instead of polling.
+ */
+
+#ifndef TEMP_SAMPLER_H
+#define TEMP_SAMPLER_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "hal_sensor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Task Configuration
+#define TEMP_SAMPLER_PERIOD_MS    250    // Longer than the MAX6675 conversion time (220 ms)
+#define TEMP_SAMPLER_STACK_SIZE   3072
+#define TEMP_SAMPLER_PRIORITY     (configMAX_PRIORITIES - 2)  // Above CONTROL_TASK_PRIORITY: a due read preempts the tick
+#define TEMP_SAMPLER_CORE         1       // Same core as the control task
+#define TEMP_SAMPLER_MAX_CHANNELS 8
+#define TEMP_SAMPLER_TRY_ATTEMPTS 4      // Seqlock reads before temp_sampler_try_get_all() gives up
+
+// Published Sample
+typedef struct {
+    float temperature;       // °C with the channel's calibration offset, valid only when status == ESP_OK
+    uint16_t raw;            // Raw 16-bit MAX6675 word
+    uint8_t fault;           // Fault bits (MAX6675_FAULT_OPEN layout)
+    esp_err_t status;        // Result of the read
+    int64_t timestamp_us;    // esp_timer time of the read
+    uint32_t sequence;       // Incremented on every published sample
+} temp_sample_t;
+
+// Function prototypes
+esp_err_t temp_sampler_start(const hal_sensor_t *temp_sensor);
+esp_err_t temp_sampler_stop(void);
+esp_err_t temp_sampler_get_latest(temp_sample_t *sample);
+esp_err_t temp_sampler_get_channel(size_t channel, temp_sample_t *sample);
+esp_err_t temp_sampler_get_all(temp_sample_t *samples, size_t max_samples, size_t *count);
+esp_err_t temp_sampler_try_get_all(temp_sample_t *samples, size_t max_samples, size_t *count);
+void temp_sampler_set_offsets(const float *offsets, size_t count);
+void temp_sampler_set_listener(TaskHandle_t task);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TEMP_SAMPLER_H
@@ -4,6 +4,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <inttypes.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
@@ -12,15 +13,43 @@
 #include "esp_flash.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "dlog.h"
 #include "max6675.h"
 #include "mosfet_pwm.h"
 #include "wifi_manager.h"
 #include "rest_server.h"
+#include "control_task.h"
+#include "settings.h"
+#include "recorder.h"
+#include "udp_telemetry.h"
+#include "modbus_tcp.h"
+#include "boot_timeline.h"
+#include "safety.h"
+#include "temp_sampler.h"
+#include "hal_max6675.h"
+#include "hal_mosfet_pwm.h"
 
 static const char *TAG = "TEMP_CONTROLLER";
 
+// Thermocouple chip selects on the shared MAX6675 bus; channel 0 closes the loop
+static const gpio_num_t s_thermocouple_cs_pins[] = {
+    MAX6675_CS_PIN,
+};
+
+// Heater zone MOSFET gates, phase-staggered on one LEDC timer; zone 0 is the control output
+static const gpio_num_t s_heater_zone_pins[] = {
+    MOSFET_PWM_PIN,
+};
+
 void app_main(void)
 {
+    boot_timeline_mark(BOOT_PHASE_APP_MAIN);
+
+    // First, so the hot-path logs of every later module are drained
+    if (dlog_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Deferred logging unavailable, hot-path logs will be dropped");
+    }
+
     ESP_LOGI(TAG, "Temperature PID Controller Starting on ESP32 DevKitC...");
     
     /* Print chip information */
@@ -59,93 +88,220 @@ void app_main(void)
     ESP_LOGI(TAG, "- Interface: Web server");
     ESP_LOGI(TAG, "- Status LED: Onboard blue LED (GPIO2)");
 
-    // Initialize MAX6675 temperature sensor
-    max6675_handle_t max6675_handle = {0};
-    esp_err_t ret = max6675_init(&max6675_handle);
+    // Initialize the MAX6675 bus and one device per thermocouple
+    static max6675_bus_t max6675_bus;
+    esp_err_t ret = max6675_bus_init(&max6675_bus, MAX6675_SPI_HOST);
+    for (size_t i = 0; ret == ESP_OK && i < sizeof(s_thermocouple_cs_pins) / sizeof(s_thermocouple_cs_pins[0]); i++) {
+        ret = max6675_bus_add_device(&max6675_bus, s_thermocouple_cs_pins[i], NULL);
+    }
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize MAX6675: %s", esp_err_to_name(ret));
         ESP_LOGE(TAG, "Please check SPI connections:");
         ESP_LOGE(TAG, "- MISO: GPIO%d", MAX6675_MISO_PIN);
         ESP_LOGE(TAG, "- MOSI: GPIO%d", MAX6675_MOSI_PIN);
         ESP_LOGE(TAG, "- CLK:  GPIO%d", MAX6675_CLK_PIN);
-        ESP_LOGE(TAG, "- CS:   GPIO%d", MAX6675_CS_PIN);
+        ESP_LOGE(TAG, "- CS:   GPIO%d (channel 0)", MAX6675_CS_PIN);
         return;
     }
 
-    ESP_LOGI(TAG, "MAX6675 initialized successfully");
+    ESP_LOGI(TAG, "MAX6675 initialized successfully (%u channels)", (unsigned)max6675_bus.device_count);
 
     // Initialize MOSFET PWM control
-    mosfet_pwm_handle_t mosfet_handle = {0};
-    ret = mosfet_pwm_init(&mosfet_handle);
+    static mosfet_pwm_handle_t mosfet_handle;
+    ret = mosfet_pwm_init_zones(&mosfet_handle, s_heater_zone_pins,
+                                sizeof(s_heater_zone_pins) / sizeof(s_heater_zone_pins[0]));
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to initialize MOSFET PWM: %s", esp_err_to_name(ret));
         ESP_LOGE(TAG, "Please check PWM pin connection: GPIO%d (GPIO2 reserved for onboard LED)", MOSFET_PWM_PIN);
         return;
     }
 
+    // Sub-count duty resolution near setpoint instead of limit cycling between LEDC steps
+    ret = mosfet_pwm_set_dither(&mosfet_handle, true);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "PWM dithering unavailable: %s", esp_err_to_name(ret));
+    }
+
     ESP_LOGI(TAG, "MOSFET PWM initialized successfully");
+    boot_timeline_mark(BOOT_PHASE_HARDWARE);
 
-    // Initialize WiFi
-    ret = wifi_init();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize WiFi: %s", esp_err_to_name(ret));
+    // Consumers only see the hardware through the sensor/actuator interfaces
+    hal_sensor_t temp_sensor;
+    hal_actuator_t heater;
+    hal_max6675_bind_bus(&temp_sensor, &max6675_bus);
+    hal_mosfet_pwm_bind(&heater, &mosfet_handle);
+
+    // Everything persisted, read in one pass before anything uses it
+    settings_t *settings = calloc(1, sizeof(settings_t));
+    if (settings == NULL) {
+        ESP_LOGE(TAG, "Out of memory");
         return;
     }
+    ret = settings_init();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "NVS unavailable (%s), settings will not be saved", esp_err_to_name(ret));
+    }
+    settings_get(settings);
+    boot_timeline_mark(BOOT_PHASE_SETTINGS);
+    temp_sampler_set_offsets(settings->calibration.offset, TEMP_SAMPLER_MAX_CHANNELS);
 
-    ret = wifi_connect();
+    // Flight recorder first, so the boot and everything after it is on flash
+    ret = recorder_init();
+    if (ret == ESP_OK) {
+        ret = recorder_start();
+    }
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to connect to WiFi: %s", esp_err_to_name(ret));
-        return;
+        ESP_LOGW(TAG, "Flight recorder unavailable: %s", esp_err_to_name(ret));
     }
 
-    ESP_LOGI(TAG, "WiFi connected successfully");
+    // The sampler owns the sensor from here on; everyone else reads its snapshot
+    ret = temp_sampler_start(&temp_sensor);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start temperature sampler: %s", esp_err_to_name(ret));
+        return;
+    }
 
-    // Initialize REST server
-    ret = rest_server_init(&max6675_handle, &mosfet_handle);
+    // No heating without the interlock watching: it runs before the control loop
+    ret = safety_start(&heater, temp_sensor.channels);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize REST server: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to start safety supervisor: %s", esp_err_to_name(ret));
         return;
     }
 
-    ret = rest_server_start();
+    // Start the closed-loop control task before networking so WiFi cannot delay it
+    control_config_t control_config = CONTROL_CONFIG_DEFAULT();
+    control_config.kp = settings->gains.kp;
+    control_config.ki = settings->gains.ki;
+    control_config.kd = settings->gains.kd;
+    control_config.setpoint = settings->control.setpoint;
+    ret = control_task_start(&heater, &control_config);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to start REST server: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Failed to start control task: %s", esp_err_to_name(ret));
         return;
     }
+    if (SETTINGS_RESUME_OUTPUT && settings->control.mode == CONTROL_MODE_AUTO) {
+        control_task_set_mode(CONTROL_MODE_AUTO);
+    } else if (SETTINGS_RESUME_OUTPUT && settings->control.power > 0.0f) {
+        control_task_set_manual_power(settings->control.power);
+    }
+
+    ret = settings_start();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Settings writer unavailable, changes will not be saved");
+    }
+    if (settings->network.ssid[0] != '\0') {
+        wifi_set_credentials(settings->network.ssid, settings->network.password);
+    }
+    free(settings);
 
-    esp_ip4_addr_t ip = wifi_get_ip();
-    ESP_LOGI(TAG, "REST server started successfully");
-    ESP_LOGI(TAG, "Web interface available at: http://" IPSTR, IP2STR(&ip));
+    // Control is already running; the network comes up in the background and
+    // nothing below waits for it or gives up on it
+    ret = wifi_init();
+    if (ret == ESP_OK) {
+        ret = wifi_start();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "WiFi unavailable: %s", esp_err_to_name(ret));
+    } else {
+        boot_timeline_mark(BOOT_PHASE_WIFI_START);
+    }
+
+    // The servers listen on every interface and serve as soon as there is an IP
+    ret = rest_server_init(&heater);
+    if (ret == ESP_OK) {
+        ret = rest_server_start();
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "REST server unavailable: %s", esp_err_to_name(ret));
+    } else {
+        boot_timeline_mark(BOOT_PHASE_HTTP);
+    }
+
+    // Optional binary stream of every control tick
+    if (UDP_TELEMETRY_HOST[0] != '\0') {
+        ret = udp_telemetry_start(UDP_TELEMETRY_HOST, UDP_TELEMETRY_PORT);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "UDP telemetry unavailable: %s", esp_err_to_name(ret));
+        }
+    }
+
+    // Register access for PLC/SCADA masters
+    if (MODBUS_TCP_ENABLED) {
+        ret = modbus_tcp_start(&heater, MODBUS_TCP_PORT);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Modbus TCP unavailable: %s", esp_err_to_name(ret));
+        }
+    }
+
+    ESP_LOGI(TAG, "Web interface on port %d, address logged once WiFi connects", REST_SERVER_PORT);
     ESP_LOGI(TAG, "API endpoints:");
     ESP_LOGI(TAG, "  GET  /api/temperature - Read temperature");
     ESP_LOGI(TAG, "  POST /api/power      - Set power (0-100%%)");
+    ESP_LOGI(TAG, "  POST /api/setpoint   - Set setpoint and enable PID");
+    ESP_LOGI(TAG, "  GET  /api/control    - Control loop status");
+    ESP_LOGI(TAG, "  GET  /api/history    - Control loop history (?since=<seq>&format=bin)");
+    ESP_LOGI(TAG, "  GET  /api/stream     - Live samples, Server-Sent Events (?decimation=<ticks>)");
+    ESP_LOGI(TAG, "  POST /api/profile    - Run a ramp/soak profile (GET progress, DELETE abort)");
+    ESP_LOGI(TAG, "  POST /api/autotune   - Relay autotune (GET progress, DELETE abort)");
+    ESP_LOGI(TAG, "  GET  /api/metrics    - Runtime metrics, Prometheus text format");
+    ESP_LOGI(TAG, "  GET  /api/recorder   - Flight recorder dump (host/recorder_decode for CSV)");
+    ESP_LOGI(TAG, "  GET  /api/config     - Stored settings (POST gains, offsets, WiFi)");
+    ESP_LOGI(TAG, "  GET  /api/system     - Boot timeline, reset reason and WiFi state");
+    ESP_LOGI(TAG, "  GET  /api/safety     - Safety interlock (POST acknowledge or test)");
+    if (MODBUS_TCP_ENABLED) {
+        ESP_LOGI(TAG, "Modbus TCP on port %d (register map in modbus.h)", MODBUS_TCP_PORT);
+    }
 
     // Main application loop - monitor system status
-    int reading_count = 0;
-    float temperature = 0.0f;
+    // The sensor is owned by the sampler and the heater by the control task;
+    // only their status is reported here
+    control_status_t status;
     
     while (1) {
-        reading_count++;
-        
-        // Read temperature from MAX6675
-        ret = max6675_read_temperature(&max6675_handle, &temperature);
-        if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "Reading #%d: Temperature = %.2f°C", reading_count, temperature);
-        } else if (ret == ESP_ERR_INVALID_RESPONSE) {
-            ESP_LOGW(TAG, "Reading #%d: Thermocouple not connected!", reading_count);
+        control_task_get_status(&status);
+        if (status.sensor_ok) {
+            DLOGI(TAG, "Tick #%" PRIu32 ": Temperature = %.2f°C, Setpoint = %.2f°C, Output = %.1f%% (%s)",
+                  status.tick_count, status.temperature, status.setpoint, status.output,
+                  status.mode == CONTROL_MODE_AUTO ? "auto" : "manual");
         } else {
-            ESP_LOGE(TAG, "Reading #%d: Failed to read temperature: %s", 
-                     reading_count, esp_err_to_name(ret));
+            DLOGW(TAG, "Tick #%" PRIu32 ": Temperature read failed, output = %.1f%%",
+                  status.tick_count, status.output);
+        }
+        DLOGI(TAG, "Control step: %" PRIu32 " us, overruns: %" PRIu32,
+              status.last_step_us, status.overrun_count);
+
+        safety_status_t safety;
+        safety_get_status(&safety);
+        if (safety.tripped) {
+            DLOGE(TAG, "Heater held off by the safety interlock (faults 0x%02" PRIx32 "), see /api/safety",
+                  safety.faults);
+        }
+
+        mosfet_pwm_overlap_t overlap;
+        if (mosfet_pwm_get_overlap(&mosfet_handle, &overlap) == ESP_OK && mosfet_handle.zone_count > 1) {
+            DLOGI(TAG, "Heater zones: peak %" PRIu32 " on together for %" PRIu32 "/%d counts",
+                  overlap.max_zones_on, overlap.max_on_counts, MOSFET_PWM_PERIOD_COUNTS);
         }
         
-        // Check WiFi connection status
-        if (!wifi_is_connected()) {
-            ESP_LOGW(TAG, "WiFi disconnected, attempting to reconnect...");
-            wifi_connect();
+        // Autotune results go to the settings store, which writes them in the background
+        autotune_result_t tuned;
+        if (control_task_take_tuned_gains(&tuned)) {
+            settings_set_gains(tuned.kp, tuned.ki, tuned.kd);
+        }
+
+        // Reconnection is the WiFi manager's job, only its state is reported here
+        wifi_status_t wifi;
+        wifi_get_status(&wifi);
+        if (wifi.state == WIFI_STATE_CONNECTED) {
+            DLOGI(TAG, "WiFi connected, %" PRIu32 " reconnect(s) since boot", wifi.connects - 1);
+        } else {
+            DLOGW(TAG, "WiFi %s, attempt %" PRIu32, wifi_state_name(wifi.state), wifi.attempt);
         }
         
-        ESP_LOGI(TAG, "System running - Web interface available");
-        ESP_LOGI(TAG, "Free heap: %" PRIu32 " bytes", esp_get_free_heap_size());
+        dlog_stats_t log_stats;
+        dlog_get_stats(&log_stats);
+        DLOGI(TAG, "Free heap: %" PRIu32 " bytes, log events: %" PRIu32 " (%" PRIu32 " dropped)",
+              esp_get_free_heap_size(), log_stats.written, log_stats.dropped);
         
         // Wait 10 seconds before next status check
         vTaskDelay(10000 / portTICK_PERIOD_MS);
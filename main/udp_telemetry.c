@@ -0,0 +1,149 @@
+/*
+ * UDP Telemetry Publisher Implementation
+ */
+
+#include <errno.h>
+#include <string.h>
+#include "udp_telemetry.h"
+#include "telemetry_frame.h"
+#include "control_task.h"
+#include "wifi_manager.h"
+#include "esp_log.h"
+#include "dlog.h"
+#include "esp_mac.h"
+#include "esp_random.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "freertos/task.h"
+
+static const char *TAG = "UDP_TELEMETRY";
+
+static TaskHandle_t s_task_handle = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static udp_telemetry_status_t s_status;     // Protected by s_lock
+
+// Publisher task only
+static char s_host[64];
+static uint16_t s_port;
+static int s_socket = -1;
+static struct sockaddr_in s_dest;
+static telemetry_frame_t s_frame;
+
+// Function prototypes
+static void udp_telemetry_task(void *arg);
+
+// Resolves the host and opens the socket; DNS only ever blocks this task
+static esp_err_t open_socket(void)
+{
+    const struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo *result = NULL;
+    if (getaddrinfo(s_host, NULL, &hints, &result) != 0 || result == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    memcpy(&s_dest, result->ai_addr, sizeof(s_dest));
+    s_dest.sin_port = htons(s_port);
+    freeaddrinfo(result);
+
+    s_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    return (s_socket >= 0) ? ESP_OK : ESP_FAIL;
+}
+
+static void udp_telemetry_task(void *arg)
+{
+    uint8_t mac[6] = { 0 };
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    uint32_t device_id = ((uint32_t)mac[2] << 24) | ((uint32_t)mac[3] << 16) | ((uint32_t)mac[4] << 8) | mac[5];
+
+    telemetry_frame_stream_t stream;
+    telemetry_frame_stream_init(&stream, device_id, esp_random());
+    bool failing = false;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(UDP_TELEMETRY_INTERVAL_MS));
+
+        // Offline the records stay in the ring until the next try
+        if (!wifi_is_connected()) {
+            continue;
+        }
+        if (s_socket < 0 && open_socket() != ESP_OK) {
+            if (!failing) {
+                DLOGW(TAG, "Cannot reach the telemetry host, retrying");
+                failing = true;
+            }
+            continue;
+        }
+
+        control_status_t control;
+        control_task_get_status(&control);
+        uint16_t setpoint_q2 = (uint16_t)controller_celsius_to_units(control.setpoint);
+
+        size_t len;
+        while ((len = telemetry_frame_build(&stream, &s_frame, UDP_TELEMETRY_RECORDS, setpoint_q2)) > 0) {
+            int sent = sendto(s_socket, &s_frame, len, MSG_DONTWAIT, (const struct sockaddr *)&s_dest, sizeof(s_dest));
+            if (sent != (int)len) {
+                portENTER_CRITICAL(&s_lock);
+                s_status.send_errors++;
+                portEXIT_CRITICAL(&s_lock);
+                if (!failing) {
+                    DLOGW(TAG, "Send failed (errno %d), retrying", errno);
+                    failing = true;
+                }
+                break;
+            }
+            telemetry_frame_commit(&stream, &s_frame);
+            failing = false;
+
+            portENTER_CRITICAL(&s_lock);
+            s_status.datagrams++;
+            s_status.records += s_frame.header.count;
+            portEXIT_CRITICAL(&s_lock);
+        }
+
+        portENTER_CRITICAL(&s_lock);
+        s_status.overwritten = stream.overwritten;
+        portEXIT_CRITICAL(&s_lock);
+    }
+}
+
+esp_err_t udp_telemetry_start(const char *host, uint16_t port)
+{
+    if (host == NULL || host[0] == '\0' || strlen(host) >= sizeof(s_host) || port == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_task_handle != NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    strcpy(s_host, host);
+    s_port = port;
+
+    BaseType_t core = (portNUM_PROCESSORS > 1) ? UDP_TELEMETRY_CORE : 0;
+    BaseType_t created = xTaskCreatePinnedToCore(udp_telemetry_task, "udp_telemetry", UDP_TELEMETRY_STACK_SIZE,
+                                                 NULL, UDP_TELEMETRY_PRIORITY, &s_task_handle, core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create publisher task");
+        s_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_status.running = true;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_LOGI(TAG, "Publishing telemetry to %s:%u every %d ms", host, port, UDP_TELEMETRY_INTERVAL_MS);
+    return ESP_OK;
+}
+
+void udp_telemetry_get_status(udp_telemetry_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
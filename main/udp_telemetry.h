@@ -0,0 +1,55 @@
+/*
+ * UDP Telemetry Publisher
+ *
+ * Optional binary stream of every control tick for data collection from
+ * many controllers: a low-priority task reads new records from the
+ * telemetry ring (telemetry.h) every UDP_TELEMETRY_INTERVAL_MS and sends
+ * them in frames of up to UDP_TELEMETRY_RECORDS records
+ * (telemetry_frame.h) to one host. The control task is not involved
+ * beyond its usual lock-free ring push: nothing here allocates after
+ * start, and sends never block (MSG_DONTWAIT). While the network is down
+ * the records wait in the ring and are sent once it is back; what the
+ * ring overwrote in the meantime shows up as a gap at the receiver.
+ *
+ * host/udp_receiver.c receives, checks for loss and writes to disk.
+ */
+
+#ifndef UDP_TELEMETRY_H
+#define UDP_TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Destination; an empty host leaves the publisher off
+#define UDP_TELEMETRY_HOST          ""
+#define UDP_TELEMETRY_PORT          5005
+
+#define UDP_TELEMETRY_INTERVAL_MS   1000    // Records are batched for this long (4 at 4 Hz)
+#define UDP_TELEMETRY_RECORDS       32      // Most records per datagram, catching up after an outage
+#define UDP_TELEMETRY_STACK_SIZE    3072
+#define UDP_TELEMETRY_PRIORITY      (tskIDLE_PRIORITY + 2)
+#define UDP_TELEMETRY_CORE          0       // Away from the control task
+
+typedef struct {
+    bool running;
+    uint32_t datagrams;             // Sent
+    uint32_t records;               // Sent
+    uint32_t send_errors;           // Failed sends, retried on the next interval
+    uint32_t overwritten;           // Records the ring dropped before they were sent
+} udp_telemetry_status_t;
+
+// Function prototypes
+esp_err_t udp_telemetry_start(const char *host, uint16_t port);
+void udp_telemetry_get_status(udp_telemetry_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UDP_TELEMETRY_H
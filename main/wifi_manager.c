@@ -2,46 +2,160 @@
  * WiFi Manager Implementation
  */
 
+#include <inttypes.h>
+#include <string.h>
 #include "wifi_manager.h"
 #include "esp_log.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "metrics.h"
+#include "boot_timeline.h"
 #include "esp_event.h"
 #include "nvs_flash.h"
 #include "freertos/FreeRTOS.h"
-#include "freertos/event_groups.h"
 
 static const char *TAG = "WIFI_MANAGER";
 
-// WiFi event group
-static EventGroupHandle_t s_wifi_event_group;
-#define WIFI_CONNECTED_BIT BIT0
-#define WIFI_FAIL_BIT      BIT1
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static wifi_status_t s_status;          // Protected by s_lock
 
-static int s_retry_num = 0;
-static bool s_wifi_connected = false;
-static esp_ip4_addr_t s_ip_addr = {0};
+// Retry in WIFI_STATE_BACKOFF, attempt timeout in CONNECTING/WAITING_IP
+static esp_timer_handle_t s_timer = NULL;
+static bool s_driver_started = false;
+static char s_ssid[33] = WIFI_SSID;
+static char s_password[65] = WIFI_PASSWORD;
+
+// Function prototypes
+static void start_attempt(void);
+
+// WIFI_BACKOFF_MIN_MS << (attempt - 1), capped, times a random factor in
+// [100 - WIFI_BACKOFF_JITTER_PCT, 100 + WIFI_BACKOFF_JITTER_PCT] %
+static uint32_t backoff_ms(uint32_t attempt)
+{
+    uint32_t shift = (attempt > 1) ? attempt - 1 : 0;
+    uint64_t delay_ms = (uint64_t)WIFI_BACKOFF_MIN_MS << (shift < 16 ? shift : 16);
+    if (delay_ms > WIFI_BACKOFF_MAX_MS) {
+        delay_ms = WIFI_BACKOFF_MAX_MS;
+    }
+    uint32_t percent = 100 - WIFI_BACKOFF_JITTER_PCT + esp_random() % (2 * WIFI_BACKOFF_JITTER_PCT + 1);
+    return (uint32_t)(delay_ms * percent / 100);
+}
+
+static void arm_timer(uint32_t delay_ms)
+{
+    esp_timer_stop(s_timer);    // Not running is fine
+    esp_timer_start_once(s_timer, (uint64_t)delay_ms * 1000);
+}
+
+// The connection or the attempt failed: wait out the backoff, then try again
+static void schedule_retry(uint8_t reason)
+{
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&s_lock);
+    // Stopped on purpose, or already waiting (a late event for an abandoned attempt)
+    bool retry = (s_status.state != WIFI_STATE_STOPPED && s_status.state != WIFI_STATE_BACKOFF);
+    bool was_connected = (s_status.state == WIFI_STATE_CONNECTED);
+    uint32_t attempt = s_status.attempt + 1;
+    uint32_t delay_ms = backoff_ms(attempt);
+    if (retry) {
+        s_status.state = WIFI_STATE_BACKOFF;
+        s_status.attempt = attempt;
+        s_status.retry_delay_ms = delay_ms;
+        s_status.retry_at_us = now_us + (int64_t)delay_ms * 1000;
+        s_status.disconnects++;
+        s_status.last_reason = reason;
+        s_status.ip.addr = 0;
+    }
+    portEXIT_CRITICAL(&s_lock);
+
+    if (!retry) {
+        return;
+    }
+    arm_timer(delay_ms);
+    metrics_count(METRICS_WIFI_DISCONNECTS);
+    if (was_connected) {
+        ESP_LOGW(TAG, "Connection lost (reason %u), reconnecting in %" PRIu32 " ms", reason, delay_ms);
+    } else {
+        ESP_LOGW(TAG, "Attempt %" PRIu32 " failed (reason %u), retrying in %" PRIu32 " ms",
+                 attempt, reason, delay_ms);
+    }
+}
+
+static void start_attempt(void)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_status.state = WIFI_STATE_CONNECTING;
+    portEXIT_CRITICAL(&s_lock);
+
+    arm_timer(WIFI_ATTEMPT_TIMEOUT_MS);
+    esp_err_t ret = esp_wifi_connect();
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "esp_wifi_connect failed: %s", esp_err_to_name(ret));
+        schedule_retry(0);
+    }
+}
+
+// esp_timer task: runs the pending retry, or gives up on a stuck attempt
+static void wifi_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&s_lock);
+    wifi_state_t state = s_status.state;
+    portEXIT_CRITICAL(&s_lock);
+
+    if (state == WIFI_STATE_BACKOFF) {
+        metrics_count(METRICS_WIFI_RETRIES);
+        start_attempt();
+    } else if (state == WIFI_STATE_CONNECTING || state == WIFI_STATE_WAITING_IP) {
+        ESP_LOGW(TAG, "No IP after %d ms, abandoning the attempt", WIFI_ATTEMPT_TIMEOUT_MS);
+        schedule_retry(0);
+        esp_wifi_disconnect();
+    }
+}
 
 static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                               int32_t event_id, void* event_data)
 {
     if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_START) {
-        esp_wifi_connect();
-    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
-        if (s_retry_num < WIFI_MAXIMUM_RETRY) {
-            esp_wifi_connect();
-            s_retry_num++;
-            ESP_LOGI(TAG, "Retry to connect to the AP");
-        } else {
-            xEventGroupSetBits(s_wifi_event_group, WIFI_FAIL_BIT);
-            ESP_LOGE(TAG, "Connect to the AP failed");
+        start_attempt();
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_CONNECTED) {
+        portENTER_CRITICAL(&s_lock);
+        if (s_status.state == WIFI_STATE_CONNECTING) {
+            s_status.state = WIFI_STATE_WAITING_IP;
         }
-        s_wifi_connected = false;
+        portEXIT_CRITICAL(&s_lock);
+        boot_timeline_mark(BOOT_PHASE_WIFI_ASSOCIATED);
+    } else if (event_base == WIFI_EVENT && event_id == WIFI_EVENT_STA_DISCONNECTED) {
+        wifi_event_sta_disconnected_t *event = (wifi_event_sta_disconnected_t *)event_data;
+        schedule_retry(event->reason);
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        s_ip_addr = event->ip_info.ip;
-        ESP_LOGI(TAG, "Got IP:" IPSTR, IP2STR(&s_ip_addr));
-        s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
-        s_wifi_connected = true;
+        esp_timer_stop(s_timer);
+
+        portENTER_CRITICAL(&s_lock);
+        s_status.state = WIFI_STATE_CONNECTED;
+        s_status.attempt = 0;
+        s_status.connects++;
+        s_status.connected_us = esp_timer_get_time();
+        s_status.ip = event->ip_info.ip;
+        portEXIT_CRITICAL(&s_lock);
+
+        boot_timeline_mark(BOOT_PHASE_NETWORK);
+        metrics_count(METRICS_WIFI_CONNECTS);
+        ESP_LOGI(TAG, "Connected to %s, IP " IPSTR, s_ssid, IP2STR(&event->ip_info.ip));
+    } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_LOST_IP) {
+        // Still associated: give DHCP one attempt timeout to renew
+        portENTER_CRITICAL(&s_lock);
+        bool lost = (s_status.state == WIFI_STATE_CONNECTED);
+        if (lost) {
+            s_status.state = WIFI_STATE_WAITING_IP;
+            s_status.ip.addr = 0;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (lost) {
+            arm_timer(WIFI_ATTEMPT_TIMEOUT_MS);
+            ESP_LOGW(TAG, "IP address lost");
+        }
     }
 }
 
@@ -55,8 +169,14 @@ esp_err_t wifi_init(void)
     }
     ESP_ERROR_CHECK(ret);
 
-    // Create event group
-    s_wifi_event_group = xEventGroupCreate();
+    const esp_timer_create_args_t timer_args = {
+        .callback = wifi_timer_cb,
+        .name = "wifi_retry",
+    };
+    ret = esp_timer_create(&timer_args, &s_timer);
+    if (ret != ESP_OK) {
+        return ret;
+    }
 
     // Initialize TCP/IP adapter
     ESP_ERROR_CHECK(esp_netif_init());
@@ -71,17 +191,17 @@ esp_err_t wifi_init(void)
 
     // Register event handlers
     esp_event_handler_instance_t instance_any_id;
-    esp_event_handler_instance_t instance_got_ip;
+    esp_event_handler_instance_t instance_any_ip;
     ESP_ERROR_CHECK(esp_event_handler_instance_register(WIFI_EVENT,
                                                         ESP_EVENT_ANY_ID,
                                                         &wifi_event_handler,
                                                         NULL,
                                                         &instance_any_id));
     ESP_ERROR_CHECK(esp_event_handler_instance_register(IP_EVENT,
-                                                        IP_EVENT_STA_GOT_IP,
+                                                        ESP_EVENT_ANY_ID,
                                                         &wifi_event_handler,
                                                         NULL,
-                                                        &instance_got_ip));
+                                                        &instance_any_ip));
 
     // Set WiFi mode to station
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
@@ -90,13 +210,25 @@ esp_err_t wifi_init(void)
     return ESP_OK;
 }
 
-esp_err_t wifi_connect(void)
+// Used from the next wifi_start()
+esp_err_t wifi_set_credentials(const char *ssid, const char *password)
+{
+    if (ssid == NULL || password == NULL || ssid[0] == '\0' ||
+        strlen(ssid) >= sizeof(s_ssid) || strlen(password) >= sizeof(s_password)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    strcpy(s_ssid, ssid);
+    strcpy(s_password, password);
+    return ESP_OK;
+}
+
+// Returns at once; the connection comes up (and is kept up) in the background
+esp_err_t wifi_start(void)
 {
     // Configure WiFi station
     wifi_config_t wifi_config = {
         .sta = {
-            .ssid = WIFI_SSID,
-            .password = WIFI_PASSWORD,
             .threshold.authmode = WIFI_AUTH_WPA2_PSK,
             .pmf_cfg = {
                 .capable = true,
@@ -104,37 +236,44 @@ esp_err_t wifi_connect(void)
             },
         },
     };
+    memcpy(wifi_config.sta.ssid, s_ssid, sizeof(s_ssid) - 1);
+    memcpy(wifi_config.sta.password, s_password, sizeof(s_password) - 1);
 
-    ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifi_config));
-    ESP_ERROR_CHECK(esp_wifi_start());
+    esp_err_t ret = esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    if (ret != ESP_OK) {
+        return ret;
+    }
 
-    ESP_LOGI(TAG, "Connecting to WiFi SSID:%s password:%s", WIFI_SSID, WIFI_PASSWORD);
+    portENTER_CRITICAL(&s_lock);
+    s_status.state = WIFI_STATE_CONNECTING;
+    s_status.attempt = 0;
+    portEXIT_CRITICAL(&s_lock);
 
-    // Wait for connection
-    EventBits_t bits = xEventGroupWaitBits(s_wifi_event_group,
-                                           WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
-                                           pdFALSE,
-                                           pdFALSE,
-                                           portMAX_DELAY);
+    ESP_LOGI(TAG, "Connecting to WiFi SSID:%s", s_ssid);
 
-    if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(TAG, "Connected to WiFi SSID:%s", WIFI_SSID);
-        ESP_LOGI(TAG, "IP address:" IPSTR, IP2STR(&s_ip_addr));
+    // The first attempt starts from WIFI_EVENT_STA_START; later starts directly
+    if (s_driver_started) {
+        start_attempt();
         return ESP_OK;
-    } else if (bits & WIFI_FAIL_BIT) {
-        ESP_LOGE(TAG, "Failed to connect to WiFi SSID:%s", WIFI_SSID);
-        return ESP_FAIL;
-    } else {
-        ESP_LOGE(TAG, "Unexpected event");
-        return ESP_FAIL;
     }
+    ret = esp_wifi_start();
+    if (ret == ESP_OK) {
+        s_driver_started = true;
+    }
+    return ret;
 }
 
+// Stays disconnected, without retries, until the next wifi_start()
 esp_err_t wifi_disconnect(void)
 {
+    portENTER_CRITICAL(&s_lock);
+    s_status.state = WIFI_STATE_STOPPED;
+    s_status.ip.addr = 0;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_timer_stop(s_timer);
     esp_err_t ret = esp_wifi_disconnect();
     if (ret == ESP_OK) {
-        s_wifi_connected = false;
         ESP_LOGI(TAG, "Disconnected from WiFi");
     }
     return ret;
@@ -142,10 +281,38 @@ esp_err_t wifi_disconnect(void)
 
 bool wifi_is_connected(void)
 {
-    return s_wifi_connected;
+    portENTER_CRITICAL(&s_lock);
+    bool connected = (s_status.state == WIFI_STATE_CONNECTED);
+    portEXIT_CRITICAL(&s_lock);
+    return connected;
 }
 
 esp_ip4_addr_t wifi_get_ip(void)
 {
-    return s_ip_addr;
+    portENTER_CRITICAL(&s_lock);
+    esp_ip4_addr_t ip = s_status.ip;
+    portEXIT_CRITICAL(&s_lock);
+    return ip;
+}
+
+void wifi_get_status(wifi_status_t *status)
+{
+    if (status == NULL) {
+        return;
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    *status = s_status;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+const char *wifi_state_name(wifi_state_t state)
+{
+    switch (state) {
+    case WIFI_STATE_CONNECTING: return "connecting";
+    case WIFI_STATE_WAITING_IP: return "waiting_ip";
+    case WIFI_STATE_CONNECTED:  return "connected";
+    case WIFI_STATE_BACKOFF:    return "backoff";
+    default:                    return "stopped";
+    }
 }
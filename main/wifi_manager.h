@@ -1,11 +1,22 @@
 /*
  * WiFi Manager for Temperature PID Controller
  * Handles WiFi connection and configuration
+ *
+ * Event-driven and non-blocking: wifi_start() returns at once and the
+ * connection is made and kept by the WiFi event handler and one esp_timer.
+ * A failed attempt or a lost connection waits an exponentially growing,
+ * jittered backoff before the next one, and retries never stop. An
+ * attempt that has no IP after WIFI_ATTEMPT_TIMEOUT_MS (AP silent, DHCP
+ * not answering) is abandoned and retried the same way. Nothing here
+ * waits on the network, so boot, the control loop and the servers never
+ * depend on the AP being reachable.
  */
 
 #ifndef WIFI_MANAGER_H
 #define WIFI_MANAGER_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "esp_err.h"
 #include "esp_wifi.h"
 #include "esp_event.h"
@@ -14,17 +25,47 @@
 extern "C" {
 #endif
 
-// WiFi Configuration
+// WiFi Configuration, defaults until credentials are stored (see settings.h)
 #define WIFI_SSID "AP_E109"
 #define WIFI_PASSWORD "Ja170493!"
-#define WIFI_MAXIMUM_RETRY 5
+
+// Reconnect backoff: WIFI_BACKOFF_MIN_MS doubling per failed attempt up to
+// WIFI_BACKOFF_MAX_MS, each delay spread by ±WIFI_BACKOFF_JITTER_PCT so
+// controllers that lost the same AP do not retry in lockstep
+#define WIFI_BACKOFF_MIN_MS      500
+#define WIFI_BACKOFF_MAX_MS      60000
+#define WIFI_BACKOFF_JITTER_PCT  25
+#define WIFI_ATTEMPT_TIMEOUT_MS  20000
+
+typedef enum {
+    WIFI_STATE_STOPPED = 0,     // Not started, or stopped by wifi_disconnect()
+    WIFI_STATE_CONNECTING,      // Association in progress
+    WIFI_STATE_WAITING_IP,      // Associated, DHCP running
+    WIFI_STATE_CONNECTED,       // Got an IP
+    WIFI_STATE_BACKOFF,         // Waiting to retry
+} wifi_state_t;
+
+typedef struct {
+    wifi_state_t state;
+    uint32_t attempt;           // Consecutive failed attempts, 0 while connected
+    uint32_t retry_delay_ms;    // Backoff before the pending retry
+    int64_t retry_at_us;        // esp_timer time of the pending retry
+    uint32_t connects;          // IP acquired, since boot
+    uint32_t disconnects;       // Connections lost or attempts failed, since boot
+    uint8_t last_reason;        // wifi_err_reason_t of the last disconnect
+    int64_t connected_us;       // esp_timer time of the last connect
+    esp_ip4_addr_t ip;
+} wifi_status_t;
 
 // Function prototypes
 esp_err_t wifi_init(void);
-esp_err_t wifi_connect(void);
+esp_err_t wifi_set_credentials(const char *ssid, const char *password);
+esp_err_t wifi_start(void);
 esp_err_t wifi_disconnect(void);
 bool wifi_is_connected(void);
 esp_ip4_addr_t wifi_get_ip(void);
+void wifi_get_status(wifi_status_t *status);
+const char *wifi_state_name(wifi_state_t state);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,88 @@
+let stream;
+const powerSlider = document.getElementById('powerSlider');
+const powerValue = document.getElementById('powerValue');
+const temperature = document.getElementById('temperature');
+const power = document.getElementById('power');
+const status = document.getElementById('status');
+
+powerSlider.oninput = function() {
+    powerValue.textContent = this.value + '%';
+};
+
+function setPower() {
+    const powerLevel = powerSlider.value;
+    fetch('/api/power', {
+        method: 'POST',
+        headers: { 'Content-Type': 'application/json' },
+        body: JSON.stringify({power: parseInt(powerLevel)})
+    })
+    .then(response => response.json())
+    .then(data => {
+        if (data.success) {
+            power.textContent = powerLevel + '%';
+            status.textContent = 'Power set successfully';
+            status.className = 'value success';
+        } else {
+            status.textContent = 'Error: ' + data.error;
+            status.className = 'value error';
+        }
+    })
+    .catch(error => {
+        status.textContent = 'Error: ' + error;
+        status.className = 'value error';
+    });
+}
+
+function stopPower() {
+    powerSlider.value = 0;
+    powerValue.textContent = '0%';
+    setPower();
+}
+
+function getTemperature() {
+    fetch('/api/temperature')
+    .then(response => response.json())
+    .then(data => {
+        if (data.success) {
+            temperature.textContent = data.temperature.toFixed(2) + '°C';
+            status.textContent = 'Temperature updated';
+            status.className = 'value success';
+        } else {
+            status.textContent = 'Error: ' + data.error;
+            status.className = 'value error';
+        }
+    })
+    .catch(error => {
+        status.textContent = 'Error: ' + error;
+        status.className = 'value error';
+    });
+}
+
+function startAutoUpdate() {
+    if (stream) stream.close();
+    stream = new EventSource('/api/stream?decimation=' + document.getElementById('rate').value);
+    stream.onmessage = function(event) {
+        const data = JSON.parse(event.data);
+        temperature.textContent = data.sensor_ok ? data.temperature.toFixed(2) + '°C' : 'sensor fault';
+        power.textContent = data.output.toFixed(1) + '%';
+    };
+    stream.onerror = function() {
+        status.textContent = 'Stream reconnecting...';
+        status.className = 'value error';
+    };
+    status.textContent = 'Auto update started';
+    status.className = 'value success';
+}
+
+function stopAutoUpdate() {
+    if (stream) stream.close();
+    stream = null;
+    status.textContent = 'Auto update stopped';
+    status.className = 'value success';
+}
+
+// Start the live stream on page load
+window.onload = function() {
+    getTemperature();
+    startAutoUpdate();
+};
@@ -0,0 +1,29 @@
+#!/usr/bin/env python
+"""Gzip a web asset for embedding in the firmware.
+
+Usage: gzip_asset.py <input> <output.gz>
+
+Output is reproducible (no file name, zero mtime) so the same input always
+produces the same bytes and the ETag computed from it stays stable.
+"""
+import gzip
+import sys
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        return 2
+
+    with open(sys.argv[1], 'rb') as src:
+        data = src.read()
+
+    with open(sys.argv[2], 'wb') as raw:
+        with gzip.GzipFile(filename='', mode='wb', fileobj=raw, compresslevel=9, mtime=0) as dst:
+            dst.write(data)
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())